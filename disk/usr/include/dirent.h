@@ -26,6 +26,12 @@ struct dirent {			/* data from getdents()/readdir() */
   char d_name[1];		/* name of file plus a 0 byte */
 };
 
+/* The size of the struct dirent that getdents() makes for a name of n
+ * characters: the name and its 0 byte, rounded up to a whole long.
+ */
+#define _DIRENTSIZ(n)	((((struct dirent *) 0)->d_name - (char *) 0 + \
+			  (n) + sizeof(long)) / sizeof(long) * sizeof(long))
+
 /* Function Prototypes. */
 #ifndef _ANSI_H
 #include <ansi.h>
@@ -22,6 +22,19 @@
 
 extern message _M;
 
+/* The memory and string routines move a long at a time between addresses
+ * that agree in the bits of _LMASK; the 68000 fetches a long from any even
+ * address.  _HASZERO(x) is nonzero iff one of the bytes of the unsigned long
+ * x is zero.
+ */
+#if (CHIP == M68000)
+#define _LMASK             1
+#else
+#define _LMASK   (sizeof(long) - 1)
+#endif
+#define _LONES   ((unsigned long) ~0L / 255)
+#define _HASZERO(x)  (((x) - _LONES) & ~(x) & (_LONES << 7))
+
 #define MM                 0
 #define FS                 1
 
@@ -0,0 +1,23 @@
+/* The <malloc.h> header describes the statistics call of the memory
+ * allocator.  Malloc() and its friends are declared in <stdlib.h>.
+ */
+
+#ifndef _MALLOC_H
+#define _MALLOC_H
+
+struct mallinfo {
+  long arena;			/* bytes obtained with brk() */
+  long ordblks;			/* slots on the free list */
+  long smblks;			/* small slots kept in the bins */
+  long uordblks;		/* bytes in slots in use */
+  long fordblks;		/* bytes in slots on the free list */
+  long fsmblks;			/* bytes in small slots in the bins */
+};
+
+#ifndef _ANSI_H
+#include <ansi.h>
+#endif
+
+_PROTOTYPE( struct mallinfo mallinfo, (void)				);
+
+#endif /* _MALLOC_H */
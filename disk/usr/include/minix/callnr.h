@@ -46,6 +46,8 @@
 #define EXEC		  59
 #define UMASK		  60 
 #define CHROOT		  61 
+#define GETDENTS	  62
+#define STATAT		  63
 
 /* The following are not system calls, but are processed like them. */
 #define KSIG		  64	/* kernel detected a signal */
@@ -74,6 +74,7 @@
 #	define SET_ALARM   1	/* fcn code to CLOCK, set up alarm */
 #	define GET_TIME	   3	/* fcn code to CLOCK, get real time */
 #	define SET_TIME	   4	/* fcn code to CLOCK, set real time */
+#	define GET_UPTIME  5	/* fcn code to CLOCK, get ticks since boot */
 #	define REAL_TIME   1	/* reply from CLOCK: here is real time */
 
 #define SYSTASK           -2	/* internal functions */
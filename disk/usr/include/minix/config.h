@@ -29,7 +29,10 @@
 #define HAVE_SCATTERED_IO  1
 
 
-/* The buffer cache should be made as large as you can afford. */
+/* The buffer cache should be made as large as you can afford.  The cache
+ * simulator in fs/sim sets the size on the compiler command line.
+ */
+#ifndef NR_BUFS
 #if INTEL_32BITS
 #define NR_BUFS          320	/* # blocks in the buffer cache */
 #define NR_BUF_HASH      512	/* size of buf hash table; MUST BE POWER OF 2*/
@@ -37,6 +40,7 @@
 #define NR_BUFS           30	/* # blocks in the buffer cache */
 #define NR_BUF_HASH       32	/* size of buf hash table; MUST BE POWER OF 2*/
 #endif
+#endif
 
 
 /* Defines for kernel configuration. */
@@ -47,6 +51,8 @@
 #define NO_HANDSHAKE       1	/* rs232.c - don't use CTS/RTS handshaking */
 
 /* These configuration defines control debugging and unfinished code. */
+#define BOOT_TIMING        1	/* fs/main.c - report time taken by boot phases */
+#define CACHE_TRACE        0	/* fs/cache.c - print block accesses for fs/sim */
 #define FLOPPY_TIMING      0	/* floppy.c - for fine tuning floppy driver */
 #define MONITOR		   0	/* xt_wini.c - monitor loop in w_wait_int */
 #define RECORD_FLOPPY_SKEW 0	/* floppy.c - for deciding nr_sectors */
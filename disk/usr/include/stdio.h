@@ -145,8 +145,24 @@ _PROTOTYPE( void prints, (const char *fmt __STDIO_VA__)			);
 
 #define getchar() 		getc(stdin)
 #define putchar(c) 		putc(c,stdout)
-#define getc(f)			fgetc(f)
-#define putc(c,f)		fputc(c,f)
+
+/* Getc and putc work on the buffer directly and call fgetc or fputc only to
+ * refill or flush it, or when the stream is unbuffered, in error or in an
+ * unusual mode.  On a reading stream _count is the number of characters left
+ * in the buffer; on a writing stream it is the number already in it.  Putc
+ * leaves the first character after a flush to fputc, which arms the cleanup
+ * that flushes at exit, and stops short of filling the buffer.
+ */
+#define _RWMASK			(READMODE | WRITEMODE | UNBUFF | _EOF | _ERR)
+#define getc(f)			((f)->_count > 0 && \
+				 ((f)->_flags & _RWMASK) == READMODE ? \
+				 ((f)->_count--, *(f)->_ptr++ & CMASK) : \
+				 fgetc(f))
+#define putc(c,f)		((f)->_count > 0 && \
+				 (f)->_count < BUFSIZ - 1 && \
+				 ((f)->_flags & _RWMASK) == WRITEMODE ? \
+				 (((f)->_count++, *(f)->_ptr++ = (c)) & CMASK) : \
+				 fputc(c,f))
 #define feof(p) 		(((p)->_flags & _EOF) != 0)
 #define ferror(p) 		(((p)->_flags & _ERR) != 0)
 #define clearerr(p) 		((p)->_flags &= ~(_ERR))
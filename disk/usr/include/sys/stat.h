@@ -72,4 +72,8 @@ _PROTOTYPE( int mkfifo, (const char *_path, int _mode)			);
 _PROTOTYPE( int stat , (const char *_path, struct stat *_buf)		);
 _PROTOTYPE( mode_t umask, (int _cmask)					);
 
+#ifdef _MINIX
+_PROTOTYPE( int statat, (int _fildes, const char *_path, struct stat *_buf));
+#endif
+
 #endif /* _STAT_H */
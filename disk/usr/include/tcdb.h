@@ -0,0 +1,59 @@
+/* The <tcdb.h> header describes the compiled termcap made by tic(1) and read
+ * by tgetent(3).  The compiled form of a termcap file "f" is "f.db".
+ *
+ * The file is a header, a hash index of terminal names and the entries.
+ * Each entry is the text that tgetent() would have put in the caller's
+ * buffer, a '\0', and a table of its capabilities, already decoded; the
+ * whole entry is at most TC_BUFSIZE bytes, so it is read straight into that
+ * buffer with one read().  Numbers are kept high byte first and are fetched
+ * a byte at a time, since the buffer may be at any address.
+ */
+
+#ifndef _TCDB_H
+#define _TCDB_H
+
+#define TC_MAGIC	0x7463	/* "tc" */
+#define TC_BUFSIZE	1024	/* the size of a tgetent() buffer */
+#define TC_NAMELEN	14	/* longest terminal name in the index */
+
+/* The header. */
+#define TC_HMAGIC	0	/* 2 bytes: TC_MAGIC */
+#define TC_HNSLOT	2	/* 2 bytes: slots in the index, a power of 2 */
+#define TC_HMTIME	4	/* 4 bytes: st_mtime of the termcap file */
+#define TC_HSIZE	8
+
+/* A slot of the index.  The slot for a name is found by probing on from
+ * slot tchash(name) & (nslot - 1); a name starting with '\0' is an empty
+ * slot, which ends the search.
+ */
+#define TC_SNAME	0	/* TC_NAMELEN bytes: the name, '\0' padded */
+#define TC_SLEN		14	/* 2 bytes: the length of the entry, or 0
+				 * if it is too big and only in the text */
+#define TC_SOFFSET	16	/* 4 bytes: its offset in the file */
+#define TC_SSIZE	20
+
+/* After the text of an entry and its '\0' comes the number of capabilities,
+ * then a record for each, in order of id and type, then the strings.  Of
+ * several capabilities with the same id and type, only the first is kept.
+ */
+#define TC_CNUM		0	/* 1 byte: capabilities */
+#define TC_CSIZE	1
+#define TC_RID		0	/* 2 bytes: the id */
+#define TC_RTYPE	2	/* 1 byte: '#', '=', or TC_FLAG */
+#define TC_RLEN		3	/* 1 byte: length of the string, with '\0' */
+#define TC_RVALUE	4	/* 2 bytes: the number, or the offset of the
+				 * string from the number of capabilities */
+#define TC_RSIZE	6
+
+#define TC_FLAG		'!'	/* any capability that is not '#' or '=' */
+
+#define tcget2(p)	((((p)[0] & 0377) << 8) | ((p)[1] & 0377))
+#define tcget4(p)	(((long) tcget2(p) << 16) | tcget2((p) + 2))
+#define tcput2(p, v)	((p)[0] = (v) >> 8, (p)[1] = (v))
+#define tcput4(p, v)	(tcput2(p, (int) ((v) >> 16)), tcput2((p) + 2, (int) (v)))
+
+#define tchash(n, h)	{ register char *_p = (n); \
+			  for ((h) = 0; *_p != '\0'; _p++) \
+				(h) = (h) * 31 + (*_p & 0377); }
+
+#endif /* _TCDB_H */
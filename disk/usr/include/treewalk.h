@@ -0,0 +1,35 @@
+/* The <treewalk.h> header is for programs that walk a file tree, such as du,
+ * find and ls.  It needs <sys/types.h> and <sys/stat.h>.
+ */
+
+#ifndef _TREEWALK_H
+#define _TREEWALK_H
+
+struct twent {			/* one entry of a directory */
+  char *tw_name;		/* name of the entry */
+  ino_t tw_ino;			/* inode number from the directory */
+  int tw_errno;			/* 0, or why statat() failed */
+  struct stat tw_stat;		/* status, if TW_STAT was given */
+};
+
+struct twdir {			/* a whole directory, from tw_read() */
+  int tw_count;			/* number of entries */
+  struct twent *tw_ent;		/* the entries, in directory order */
+  char *tw_names;		/* space for the names */
+};
+
+#define TW_DOTS		1	/* include "." and ".." */
+#define TW_STAT		2	/* stat each entry */
+
+/* Function Prototypes. */
+#ifndef _ANSI_H
+#include <ansi.h>
+#endif
+
+_PROTOTYPE( int tw_read, (struct twdir *_tdp, char *_path, int _flags)	);
+_PROTOTYPE( void tw_free, (struct twdir *_tdp)				);
+_PROTOTYPE( int tw_seen, (int _dev, int _ino)				);
+_PROTOTYPE( char *tw_user, (int _uid)					);
+_PROTOTYPE( char *tw_group, (int _gid)					);
+
+#endif /* _TREEWALK_H */
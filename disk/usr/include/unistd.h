@@ -116,6 +116,10 @@ _PROTOTYPE( int write, (int _fd, char *_buf, unsigned int _n)		);
 _PROTOTYPE( char *brk, (char *_addr)					);
 _PROTOTYPE( char *mktemp, (char *_template)				);
 _PROTOTYPE( char *sbrk, (int _incr)					);
+_PROTOTYPE( char *streambuf, (unsigned *_size)				);
+_PROTOTYPE( int streamopen, (int _fd, unsigned _recsize)			);
+_PROTOTYPE( int streamclose, (int _fd)					);
+_PROTOTYPE( long streamcopy, (int _in, int _out, char *_buf, unsigned _size)	);
 #endif
 
 #endif /* _UNISTD_H */
@@ -17,13 +17,17 @@
  * Algorithm from "A Technique for High Performance Data Compression",
  * Terry A. Welch, IEEE Computer Vol 17, No 6 (June 1984), pp 8-19.
  *
- * Usage: compress [-dfvc] [-b bits] [file ...]
+ * Usage: compress [-dfvcl] [-b bits] [file ...]
  * Inputs:
  *	-d:	    If given, decompression is done instead.
  *
  *      -c:         Write output on stdout.
  *
- *      -b:         Parameter limits the max number of bits/code.
+ *      -b:         Parameter limits the max number of bits/code (9 to 16).
+ *
+ *      -l:         Use the LZ77 format (see lz_compress) instead of LZW.
+ *		    It is faster, and needs less memory, but the file can
+ *		    only be read back by this compress.
  *
  *	-f:	    Forces output file to be generated, even if one already
  *		    exists, and even if no space is saved by compressing.
@@ -74,11 +78,16 @@
 
 #ifdef AZTEC86 
 void prratio(),cl_block(),cl_hash(),output(),decompress(),
-copystat(),writeerr(),compress(),Usage(),version();
+copystat(),writeerr(),compress(),Usage(),version(),
+lz_compress(),lz_decompress(),report(),flushout();
+/* The tables are allocated for the bits asked for, so any BITS will do; the
+ * default stays small enough for small machines and old decompressors.
+ */
+# define BITS 16
 #ifdef AZTECBITS
-# define BITS   AZTECBITS
+# define DEF_BITS   AZTECBITS
 #else
-# define BITS 13
+# define DEF_BITS 13
 #endif
 # undef USERMEM
 #endif /* AZTEC86 */
@@ -109,23 +118,22 @@ copystat(),writeerr(),compress(),Usage(),version();
 #  define BITS PBITS
 # endif
 #endif /* PBITS */
-
-#if BITS == 16
-# define HSIZE	69001		/* 95% occupancy */
-#endif
-#if BITS == 15
-# define HSIZE	35023		/* 94% occupancy */
-#endif
-#if BITS == 14
-# define HSIZE	18013		/* 91% occupancy */
-#endif
-#if BITS == 13
-# define HSIZE	9001		/* 91% occupancy */
-#endif
-#if BITS <= 12
-# define HSIZE	5003		/* 80% occupancy */
+#ifndef DEF_BITS
+# define DEF_BITS BITS
 #endif
 
+/*
+ * Hash table size for codes of up to 12 .. 16 bits.  Each is a prime a bit
+ * over 2**bits, so that the xor hash below always lands in the table.
+ */
+long hsizes[] = {
+	5003,			/* 80% occupancy */
+	9001,			/* 91% occupancy */
+	18013,			/* 91% occupancy */
+	35023,			/* 94% occupancy */
+	69001			/* 95% occupancy */
+};
+
 
 /*
  * a code_int must be able to hold 2**BITS values of type int, and also -1
@@ -149,6 +157,8 @@ typedef long int	  count_int;
  typedef	unsigned char	char_type;
 #endif /* UCHAR */
 char_type magic_header[] = { "\037\235" };	/* 1F 9D */
+#define LZ_MAGIC	0234		/* 1F 9C: LZ77 format */
+#define LZ_WBITS	12		/* third byte: bits of LZ77 window */
 
 /* Defines for third byte of header */
 #define BIT_MASK	0x1f
@@ -163,35 +173,47 @@ char_type magic_header[] = { "\037\235" };	/* 1F 9D */
 #include <fcntl.h>
 #include <ctype.h>
 #include <signal.h>
+#include <string.h>
+#include <unistd.h>
 #include <stdio.h>
 
 #define ARGVAL() (*++(*argv) || (--argc && *++argv))
 
 int n_bits;				/* number of bits/code */
-int maxbits = BITS;			/* user settable max # bits/code */
+int maxbits = DEF_BITS;			/* user settable max # bits/code */
 code_int maxcode;			/* maximum code, given n_bits */
-code_int maxmaxcode = 1 << BITS;	/* should NEVER generate this code */
+code_int maxmaxcode = (code_int)1 << DEF_BITS;	/* should NEVER generate this code */
 #ifdef COMPATIBLE		/* But wrong! */
 # define MAXCODE(n_bits)	(1 << (n_bits) - 1)
 #else
-# define MAXCODE(n_bits)	((1 << (n_bits)) - 1)
+# define MAXCODE(n_bits)	(((code_int)1 << (n_bits)) - 1)
 #endif /* COMPATIBLE */
 
-#ifndef AZTEC86
-	count_int htab [HSIZE];
-	unsigned short codetab [HSIZE];
-#else
-	count_int *htab;
-	unsigned short *codetab;
-#	define HTABSIZE ((unsigned)(HSIZE*sizeof(count_int)))
-#	define CODETABSIZE ((unsigned)(HSIZE*sizeof(unsigned short)))
-
+/*
+ * The tables are taken from the heap when the number of bits is known, by
+ * gettabs(); for 16 bits they need some 400K, more than malloc() can give in
+ * one piece on a machine with 16-bit ints.
+ */
+count_int *htab;
+unsigned short *codetab;
+long tabsize = 0;			/* entries the tables have room for */
 
 #define htabof(i)	htab[i]
 #define codetabof(i)	codetab[i]
-#endif	/* XENIX_16 */
-code_int hsize = HSIZE;			/* for dynamic table sizing */
-count_int fsize;
+code_int hsize;				/* for dynamic table sizing */
+count_int fsize;			/* size of input file; 0 if unknown */
+
+/*
+ * Input and output go through buffers of our own, rather than through
+ * getc() and putc() a byte at a time.
+ */
+#define IOSIZE	8192
+char_type inbuf[IOSIZE], outbuf[IOSIZE + 32];	/* room for a group of codes */
+char_type *inptr = inbuf, *inend = inbuf;	/* next and last byte read */
+char_type *outptr = outbuf;			/* next free byte */
+#define getbyte()	(inptr < inend ? *inptr++ : fillbuf())
+#define putbyte(c)	{ if (outptr >= outbuf + IOSIZE) flushout(); \
+			  *outptr++ = (c); }
 
 /*
  * To save much memory, we overlay the table used by compress() with those
@@ -208,7 +230,7 @@ count_int fsize;
 # define de_stack		((char_type *)(htab2))
 #else	/* Normal machine */
 # define tab_suffixof(i)	((char_type *)(htab))[i]
-# define de_stack		((char_type *)&tab_suffixof(1<<BITS))
+# define de_stack		((char_type *)&tab_suffixof(maxmaxcode))
 #endif	/* XENIX_16 */
 
 code_int free_ent = 0;			/* first unused entry */
@@ -218,16 +240,17 @@ code_int getcode();
 
 void Usage() {
 #ifdef DEBUG
-fprintf(stderr,"Usage: compress [-dDVfc] [-b maxbits] [file ...]\n");
+fprintf(stderr,"Usage: compress [-dDVfcl] [-b maxbits] [file ...]\n");
 }
 int debug = 0;
 #else
-fprintf(stderr,"Usage: compress [-dfvcV] [-b maxbits] [file ...]\n");
+fprintf(stderr,"Usage: compress [-dfvcVl] [-b maxbits] [file ...]\n");
 }
 #endif /* DEBUG */
 int nomagic = 0;	/* Use a 3-byte magic number header, unless old file */
 int zcat_flg = 0;	/* Write output on stdout, suppress messages */
 int quiet = 0;		/* don't tell me about compression */
+int lz_flg = 0;		/* LZ77 instead of LZW */
 
 /*
  * block compression parameters -- after all codes are used up,
@@ -285,16 +308,6 @@ REGISTER int argc; char **argv;
 	_setmode(stdout,_BINARY);
 	_setmode(stderr,_TEXT);
 #endif
-	if (NULL == (htab = (count_int *)malloc(HTABSIZE)))
-	{
-		fprintf(stderr,"Can't allocate htab\n");
-		exit(1);
-	}
-	if (NULL == (codetab = (unsigned short *)malloc(CODETABSIZE)))
-	{
-		fprintf(stderr,"Can't allocate codetab\n");
-		exit(1);
-	}
 #endif
 #ifdef COMPATIBLE
     nomagic = 1;	/* Original didn't have a magic number */
@@ -332,6 +345,7 @@ REGISTER int argc; char **argv;
      *	    given also.
      * -c => cat all output to stdout
      * -C => generate output compatible with compress 2.0.
+     * -l => LZ77 format
      * if a string is left, must be an input filename.
      */
     for (argc--, argv++; argc > 0; argc--, argv++) 
@@ -387,6 +401,9 @@ REGISTER int argc; char **argv;
 			    case 'q':
 					quiet = 1;
 					break;
+			    case 'l':
+					lz_flg = 1;
+					break;
 			    default:
 					fprintf(stderr, "Unknown flag: '%c'; ", **argv);
 					Usage();
@@ -405,7 +422,7 @@ REGISTER int argc; char **argv;
 
     if(maxbits < INIT_BITS) maxbits = INIT_BITS;
     if (maxbits > BITS) maxbits = BITS;
-    maxmaxcode = 1 << maxbits;
+    maxmaxcode = (code_int)1 << maxbits;
 
     if (*filelist != NULL) 
 	{
@@ -451,30 +468,12 @@ REGISTER int argc; char **argv;
 				{
 					perror(*fileptr); continue;
 				}
+				inptr = inend = inbuf;
 				/* Check the magic number */
-				if (nomagic == 0) 
-				{
-					unsigned magic1, magic2;
-				    if (((magic1 = getc(stdin)) != (magic_header[0] & 0xFF))
-				     || ((magic2 = getc(stdin)) != (magic_header[1] & 0xFF))) 
-					{
-						fprintf(stderr, 
-						"%s: not in compressed format %x %x\n",
-					    *fileptr,magic1,magic2);
-					    continue;
-				    }
-				    maxbits = getc(stdin);	/* set -b from file */
-				    block_compress = maxbits & BLOCK_MASK;
-				    maxbits &= BIT_MASK;
-				    maxmaxcode = 1 << maxbits;
-				    if(maxbits > BITS) 
-					{
-						fprintf(stderr,
-					"%s: compressed with %d bits, can only handle %d bits\n",
-						*fileptr, maxbits, BITS);
-						continue;
-				    }
-				}
+				if (nomagic == 0 && !getmagic(*fileptr))
+					continue;
+				if (!lz_flg && !gettabs(maxbits, *fileptr))
+					continue;
 				/* Generate output filename */
 				strcpy(ofname, *fileptr);
 #ifndef PCDOS
@@ -526,24 +525,11 @@ REGISTER int argc; char **argv;
 				{
 				    perror(*fileptr); continue;
 				}
+				inptr = inend = inbuf;
 				(void)stat( *fileptr, &statbuf );
 				fsize = (long) statbuf.st_size;
-				/*
-				 * tune hash table size for small files -- ad hoc,
-				 * but the sizes match earlier #defines, which
-				 * serve as upper bounds on the number of output codes. 
-				 */
-				hsize = HSIZE; /*lint -e506 -e712 */
-				if ( fsize < (1 << 12) )
-				    hsize = min ( 5003, HSIZE );
-				else if ( fsize < (1 << 13) )
-				    hsize = min ( 9001, HSIZE );
-				else if ( fsize < (1 << 14) )
-				    hsize = min ( 18013, HSIZE );
-				else if ( fsize < (1 << 15) )
-				    hsize = min ( 35023, HSIZE );
-				else if ( fsize < 47000 )
-				    hsize = min ( 50021, HSIZE ); /*lint +e506 +e712 */
+				if (!lz_flg && !gettabs(maxbits, *fileptr))
+					continue;
 
 				/* Generate output filename */
 				strcpy(ofname, *fileptr);
@@ -627,8 +613,12 @@ REGISTER int argc; char **argv;
 		    }
 
 		    /* Actually do the compression/decompression */
-		    if (do_decomp == 0)	
+		    if (do_decomp == 0 && lz_flg)
+				lz_compress();
+		    else if (do_decomp == 0)
 				compress();
+		    else if (lz_flg)
+				lz_decompress();
 #ifndef DEBUG
 		    else			
 				decompress();
@@ -651,7 +641,12 @@ REGISTER int argc; char **argv;
 	{		/* Standard input */
 		if (do_decomp == 0) 
 		{
-			compress();
+			if (lz_flg)
+				lz_compress();
+			else if (gettabs(maxbits, "stdin"))
+				compress();
+			else
+				exit(1);
 #ifdef DEBUG
 			if(verbose)		dump_tab();
 #endif /* DEBUG */
@@ -660,31 +655,16 @@ REGISTER int argc; char **argv;
 		} else 
 		{
 		    /* Check the magic number */
-		    if (nomagic == 0) 
-			{
-				if ((getc(stdin)!=(magic_header[0] & 0xFF))
-				 || (getc(stdin)!=(magic_header[1] & 0xFF))) 
-				{
-				    fprintf(stderr, "stdin: not in compressed format\n");
-				    exit(1);
-				}
-				maxbits = getc(stdin);	/* set -b from file */
-				block_compress = maxbits & BLOCK_MASK;
-				maxbits &= BIT_MASK;
-				maxmaxcode = 1 << maxbits;
-				fsize = 100000;		/* assume stdin large for USERMEM */
-				if(maxbits > BITS) 
-				{
-					fprintf(stderr,
-					"stdin: compressed with %d bits, can only handle %d bits\n",
-					maxbits, BITS);
-					exit(1);
-				}
-		    }
+		    if (nomagic == 0 && !getmagic("stdin"))
+			exit(1);
+		    if (!lz_flg && !gettabs(maxbits, "stdin"))
+			exit(1);
 #ifndef DEBUG
-		    decompress();
+		    if (lz_flg)		lz_decompress();
+		    else		decompress();
 #else
-		    if (debug == 0)	decompress();
+		    if (lz_flg)		lz_decompress();
+		    else if (debug == 0)	decompress();
 		    else		printcodes();
 		    if (verbose)	dump_tab();
 #endif /* DEBUG */
@@ -693,11 +673,126 @@ REGISTER int argc; char **argv;
     exit(exit_stat);
 }
 
-static int offset;
 long int in_count = 1;			/* length of input */
 long int bytes_out;			/* length of compressed output */
 long int out_count = 0;			/* # of codes output (for debugging) */
 
+/*
+ * Codes are packed into acc from the right, and taken out a byte at a time
+ * as soon as there are eight bits.  A group of 8 codes therefore fills
+ * n_bits bytes exactly; ncodes counts the codes in the current group.
+ */
+static long acc;			/* bits not yet put out or used */
+static int accbits;			/* number of them */
+static int ncodes;			/* codes so far in this group */
+static int gbytes;			/* bytes read so far in this group */
+
+/*
+ * Fillbuf() reads the next block of input, and returns its first byte, or
+ * EOF.  Flushout() writes what is in the output buffer.
+ */
+int fillbuf()
+{
+    REGISTER int n;
+
+    if ((n = read(fileno(stdin), (char *)inbuf, IOSIZE)) <= 0) {
+	inptr = inend = inbuf;
+	return EOF;
+    }
+    inptr = inbuf + 1;
+    inend = inbuf + n;
+    return inbuf[0];
+}
+
+void flushout()
+{
+    REGISTER int n = outptr - outbuf;
+
+    if (n > 0 && write(fileno(stdout), (char *)outbuf, n) != n)
+	writeerr();
+    bytes_out += n;
+    outptr = outbuf;
+}
+
+/*
+ * Getmagic() reads the header of a compressed file, and sets maxbits and
+ * block_compress, or lz_flg, from it.
+ */
+int getmagic(name)
+char *name;
+{
+    int magic1, magic2;
+
+    magic1 = getbyte();
+    magic2 = getbyte();
+    if (magic1 != (magic_header[0] & 0xFF) ||
+	(magic2 != (magic_header[1] & 0xFF) && magic2 != LZ_MAGIC)) {
+	fprintf(stderr, "%s: not in compressed format %x %x\n",
+	    name, magic1, magic2);
+	return 0;
+    }
+    lz_flg = (magic2 == LZ_MAGIC);
+    maxbits = getbyte();	/* set -b from file */
+    if (lz_flg) {
+	if (maxbits != LZ_WBITS) {
+	    fprintf(stderr, "%s: unknown LZ77 window of %d bits\n",
+		name, maxbits);
+	    return 0;
+	}
+	return 1;
+    }
+    block_compress = maxbits & BLOCK_MASK;
+    maxbits &= BIT_MASK;
+    maxmaxcode = (code_int)1 << maxbits;
+    if (maxbits > BITS) {
+	fprintf(stderr, "%s: compressed with %d bits, can only handle %d bits\n",
+	    name, maxbits, BITS);
+	return 0;
+    }
+    return 1;
+}
+
+/*
+ * Gettabs() sets hsize for codes of up to bits bits, and makes sure the
+ * tables are that big.  When compressing a small file, fewer codes can turn
+ * up, and a smaller table, which is quicker to clear, will do.  The heap is
+ * grown a piece at a time; what a smaller table had is simply left behind.
+ */
+int gettabs(bits, name)
+int bits;
+char *name;
+{
+    REGISTER int b;
+    REGISTER long n;
+    char *p, *sbrk();
+    int piece;
+
+    b = bits;
+    if (do_decomp == 0 && fsize > 0)
+	while (b > 12 && fsize + FIRST < ((long)1 << (b - 1)))
+	    b--;
+    hsize = hsizes[(b < 12 ? 12 : b) - 12];
+    if (hsize <= tabsize)
+	return 1;
+
+    p = sbrk(0);
+    if ((long)p & 3)			/* align the longs in htab */
+	p = sbrk(4 - (int)((long)p & 3)) + (4 - (int)((long)p & 3));
+    for (n = hsize * (sizeof(count_int) + sizeof(unsigned short)); n > 0;
+								n -= piece) {
+	piece = n > 16384 ? 16384 : (int)n;
+	if (sbrk(piece) == (char *)-1) {
+	    fprintf(stderr, "%s: not enough memory for %d bits\n", name, bits);
+	    exit_stat = 1;
+	    return 0;
+	}
+    }
+    htab = (count_int *)p;
+    codetab = (unsigned short *)(p + hsize * sizeof(count_int));
+    tabsize = hsize;
+    return 1;
+}
+
 /*
  * compress stdin to stdout
  *
@@ -712,6 +807,9 @@ long int out_count = 0;			/* # of codes output (for debugging) */
  * for the decompressor.  Late addition:  construct the table according to
  * file size for noticeable speed improvement on small files.  Please direct
  * questions about this implementation to ames!jaw.
+ *
+ * The input is taken a buffer at a time through a pointer in a register;
+ * in_count is only worked out when cl_block() needs it.
  */
 
 void compress() 
@@ -720,54 +818,56 @@ void compress()
     REGISTER code_int i = 0;
     REGISTER int c;
     REGISTER code_int ent;
-#ifdef XENIX_16
     REGISTER code_int disp;
-#else	/* Normal machine */
-    REGISTER int disp;
-#endif
     REGISTER code_int hsize_reg;
     REGISTER int hshift;
+    REGISTER char_type *ip;
+    char_type *iend;
+    long in_done;		/* bytes in the buffers before this one */
 
+    outptr = outbuf;
+    bytes_out = 0;
 #ifndef COMPATIBLE
     if (nomagic == 0) 
 	{
-		putc(magic_header[0],stdout); 
-		putc(magic_header[1],stdout);
-		putc((char)(maxbits | block_compress),stdout);
-		if(ferror(stdout))
-			writeerr();
+		*outptr++ = magic_header[0];
+		*outptr++ = magic_header[1];
+		*outptr++ = (char)(maxbits | block_compress);
     }
 #endif /* COMPATIBLE */
 
-    offset = 0;
-    bytes_out = 3;		/* includes 3-byte header mojo */
+    acc = 0;
+    accbits = ncodes = 0;
     out_count = 0;
     clear_flg = 0;
     ratio = 0;
-    in_count = 1;
     checkpoint = CHECK_GAP;
     maxcode = MAXCODE(n_bits = INIT_BITS);
     free_ent = ((block_compress) ? FIRST : 256 );
 
-    ent = getc(stdin);
-
-    hshift = 0;
-    for ( fcode = (long) hsize;  fcode < 65536L; fcode *= 2L )
-    	hshift++;
-    hshift = 8 - hshift;		/* set hash code range bound */
-
-    hsize_reg = hsize;
-    cl_hash( (count_int) hsize_reg);		/* clear hash table */
-
-#ifdef SIGNED_COMPARE_SLOW
-    while ( (c = getc(stdin)) != (unsigned) EOF )
-#else
-    while ( (c = getc(stdin)) != EOF )
-#endif
-	{
-		in_count++;
+    if ((ent = getbyte()) != EOF) {
+	hshift = 0;
+	for ( fcode = (long) hsize;  fcode < 65536L; fcode *= 2L )
+	    hshift++;
+	hshift = 8 - hshift;		/* set hash code range bound */
+
+	hsize_reg = hsize;
+	cl_hash( (count_int) hsize_reg);		/* clear hash table */
+
+	ip = inptr;
+	iend = inend;
+	in_done = 0;
+	for (;;) {
+		if (ip >= iend) {
+		    in_done += iend - inbuf;
+		    if ((c = fillbuf()) == EOF)
+			break;
+		    ip = inptr;
+		    iend = inend;
+		} else
+		    c = *ip++;
 		fcode = (long) (((long) c << maxbits) + ent);
-	 	i = ((c << hshift) ^ ent);	/* xor hashing */
+	 	i = (((code_int) c << hshift) ^ ent);	/* xor hashing */
 
 		if ( htabof (i) == fcode ) 
 		{
@@ -802,19 +902,27 @@ nomatch:
 	 	    codetabof (i) = free_ent++;	/* code -> hashtable */
 		    htabof (i) = fcode;
 		}
-		else if ( (count_int)in_count >= checkpoint && block_compress )
+		else if ( block_compress &&
+		    (count_int)(in_count = in_done + (ip - inbuf)) >= checkpoint)
 		    cl_block ();
-    }
-    /*
-     * Put out the final code.
-     */
-    output( (code_int)ent );
-    out_count++;
+	}
+	in_count = in_done;
+	/*
+	 * Put out the final code.
+	 */
+	output( (code_int)ent );
+	out_count++;
+    } else
+	in_count = 0;
     output( (code_int)-1 );
+    report();
+}
 
-    /*
-     * Print out stats on stderr
-     */
+/*
+ * Print out stats on stderr
+ */
+void report()
+{
     if(zcat_flg == 0 && !quiet) 
 	{
 #ifdef DEBUG
@@ -835,7 +943,6 @@ nomatch:
     }
     if(bytes_out > in_count)	/* exit(2) if no savings */
 		exit_stat = 2;
-    return;
 }
 
 /*****************************************************************
@@ -850,99 +957,44 @@ nomatch:
  * Assumptions:
  *	Chars are 8 bits long.
  * Algorithm:
- * 	Maintain a BITS character long buffer (so that 8 codes will
- * fit in it exactly).  Use the VAX insv instruction to insert each
- * code in turn.  When the buffer fills up empty it and start over.
+ * 	The code is added to the left of the bits in acc, and the bytes that
+ * are then full are moved to the output buffer.  With fewer than 8 bits left
+ * over and at most 16 added, that is one byte or two, so the loop is written
+ * out.  When the code size changes, the group of 8 codes is padded out,
+ * because the input side reads a group at a time.
  */
 
-static char buf[BITS];
-
-#ifndef vax
-char_type lmask[9] = {0xff, 0xfe, 0xfc, 0xf8, 0xf0, 0xe0, 0xc0, 0x80, 0x00};
-char_type rmask[9] = {0x00, 0x01, 0x03, 0x07, 0x0f, 0x1f, 0x3f, 0x7f, 0xff};
-#endif /* vax */
 void output( code )
 code_int  code;
 {
+    REGISTER long a;
+    REGISTER int bits;
+    REGISTER char_type *op;
 #ifdef DEBUG
     static int col = 0;
-#endif /* DEBUG */
 
-    /*
-     * On the VAX, it is important to have the REGISTER declarations
-     * in exactly the order given, or the asm will break.
-     */
-    REGISTER int r_off = offset, bits= n_bits;
-    REGISTER char * bp = buf;
-#ifndef BREAKHIGHC
-#ifdef METAWARE
-	int temp;
-#endif
-#endif
-#ifdef DEBUG
 	if ( verbose )
 	    fprintf( stderr, "%5d%c", code,
 		    (col+=6) >= 74 ? (col = 0, '\n') : ' ' );
 #endif /* DEBUG */
+    if (outptr >= outbuf + IOSIZE)
+	flushout();
+    op = outptr;
     if ( code >= 0 ) 
 	{
-#ifdef vax
-	/* VAX DEPENDENT!! Implementation on other machines is below.
-	 *
-	 * Translation: Insert BITS bits from the argument starting at
-	 * offset bits from the beginning of buf.
-	 */
-	0;	/* Work around for pcc -O bug with asm and if stmt */
-	asm( "insv	4(ap),r11,r10,(r9)" );
-#else /* not a vax */
-/* 
- * byte/bit numbering on the VAX is simulated by the following code
- */
-	/*
-	 * Get to the first byte.
-	 */
-	bp += (r_off >> 3);
-	r_off &= 7;
-	/*
-	 * Since code is always >= 8 bits, only need to mask the first
-	 * hunk on the left.
-	 */
-#ifndef BREAKHIGHC
-#ifdef METAWARE
-	*bp &= rmask[r_off];
-	temp = (code << r_off) & lmask[r_off];
-	*bp |= temp;
-#else
-	*bp = (*bp & rmask[r_off]) | (code << r_off) & lmask[r_off];
-#endif
-#else
-	*bp = (*bp & rmask[r_off]) | (code << r_off) & lmask[r_off];
-#endif
-	bp++;
-	bits -= (8 - r_off);
-	code >>= (8 - r_off);
-	/* Get any 8 bit parts in the middle (<=1 for up to 16 bits). */
-	if ( bits >= 8 ) 
-	{
-	    *bp++ = code;
-	    code >>= 8;
+	a = acc | ((long) code << accbits);
+	bits = accbits + n_bits;
+	*op++ = a;
+	a >>= 8;
+	bits -= 8;
+	if (bits >= 8) {
+	    *op++ = a;
+	    a >>= 8;
 	    bits -= 8;
 	}
-	/* Last bits. */
-	if(bits)
-	    *bp = code;
-#endif /* vax */
-	offset += n_bits;
-	if ( offset == (n_bits << 3) ) 
-	{
-	    bp = buf;
-	    bits = n_bits;
-	    bytes_out += bits;
-	    do
-		putc(*bp++,stdout);
-	    while(--bits);
-	    offset = 0;
-	}
+	acc = a;
+	accbits = bits;
+	ncodes = (ncodes + 1) & 7;
 
 	/*
 	 * If the next entry is going to be too big for the code size,
@@ -951,16 +1003,19 @@ code_int  code;
 	if ( free_ent > maxcode || (clear_flg > 0))
 	{
 	    /*
-	     * Write the whole buffer, because the input side won't
+	     * Fill out the group, because the input side won't
 	     * discover the size increase until after it has read it.
 	     */
-	    if ( offset > 0 ) 
+	    if ( ncodes > 0 ) 
 		{
-			if( fwrite( buf, 1, n_bits, stdout ) != n_bits)
-				writeerr();
-			bytes_out += n_bits;
+			bits = n_bits - (ncodes * n_bits + 7) / 8;
+			if (accbits > 0)
+				*op++ = acc;
+			while (bits-- > 0)
+				*op++ = 0;
 	    }
-	    offset = 0;
+	    acc = 0;
+	    accbits = ncodes = 0;
 
 	    if ( clear_flg ) 
 		{
@@ -983,22 +1038,22 @@ code_int  code;
 	    }
 #endif /* DEBUG */
 	}
+	outptr = op;
     } else 
 	{
 	/*
 	 * At EOF, write the rest of the buffer.
 	 */
-	if ( offset > 0 )
-	    fwrite( buf, 1, (offset + 7) / 8, stdout );
-	bytes_out += (offset + 7) / 8;
-	offset = 0;
-	fflush( stdout );
+	if ( accbits > 0 )
+	    *op++ = acc;
+	acc = 0;
+	accbits = ncodes = 0;
+	outptr = op;
+	flushout();
 #ifdef DEBUG
 	if ( verbose )
 	    fprintf( stderr, "\n" );
 #endif /* DEBUG */
-	if( ferror( stdout ) )
-		writeerr();
     }
 }
 /*
@@ -1016,6 +1071,10 @@ void decompress() {
     /*
      * As above, initialize the first 256 entries in the table.
      */
+    outptr = outbuf;
+    acc = 0;
+    accbits = ncodes = gbytes = 0;
+    clear_flg = 0;
     maxcode = MAXCODE(n_bits = INIT_BITS);
     for ( code = 255; code >= 0; code-- ) {
 	tab_prefixof(code) = 0;
@@ -1026,9 +1085,7 @@ void decompress() {
     finchar = oldcode = getcode();
     if(oldcode == -1)	/* EOF already? */
 	return;			/* Get out of here */
-    putc( (char)finchar,stdout );		/* first code must be 8 bits = char */
-    if(ferror(stdout))		/* Crash if can't write */
-	writeerr();
+    putbyte( (char)finchar );		/* first code must be 8 bits = char */
     stackp = de_stack;
 
     while ( (code = getcode()) > -1 ) {
@@ -1066,9 +1123,9 @@ void decompress() {
 	/*
 	 * And put them out in forward order
 	 */
-	do
-	    putc ( *--stackp ,stdout);
-	while ( stackp > de_stack );
+	do {
+	    putbyte( *--stackp );
+	} while ( stackp > de_stack );
 
 	/*
 	 * Generate the new entry.
@@ -1084,9 +1141,7 @@ void decompress() {
 	 */
 	oldcode = incode;
     }
-    fflush( stdout );
-    if(ferror(stdout))
-	writeerr();
+    flushout();
 }
 
 /*****************************************************************
@@ -1102,23 +1157,24 @@ void decompress() {
 code_int
 getcode() 
 {
-    /*
-     * On the VAX, it is important to have the REGISTER declarations
-     * in exactly the order given, or the asm will break.
-     */
-    REGISTER code_int code;
-    static int offset = 0, size = 0;
-    static char_type buf[BITS];
-    REGISTER int r_off, bits;
-    REGISTER char_type *bp = buf;
+    REGISTER long a = acc;
+    REGISTER int bits = accbits;
+    REGISTER int c;
+    code_int code;
 
-    if ( clear_flg > 0 || offset >= size || free_ent > maxcode ) 
+    if ( clear_flg > 0 || free_ent > maxcode ) 
 	{
 		/*
 		 * If the next entry will be too big for the current code
-		 * size, then we must increase the size.  This implies reading
-		 * a new buffer full, too.
+		 * size, then we must increase the size.  The rest of the
+		 * group of codes is skipped, as output() padded it.
 		 */
+		if ( ncodes > 0 )
+		    for (c = n_bits - gbytes; c > 0; c--)
+			if (getbyte() == EOF)
+			    return -1;
+		a = 0;
+		bits = ncodes = gbytes = 0;
 		if ( free_ent > maxcode ) 
 		{
 		    n_bits++;
@@ -1132,50 +1188,197 @@ getcode()
     	    maxcode = MAXCODE (n_bits = INIT_BITS);
 		    clear_flg = 0;
 		}
-		size = fread( buf, 1, n_bits, stdin );
-		if ( size <= 0 )
-		    return -1;			/* end of file */
-		offset = 0;
-		/* Round size down to integral number of codes */
-		size = (size << 3) - (n_bits - 1);
     }
-    r_off = offset;
-    bits = n_bits;
-#ifdef vax
-    asm( "extzv   r10,r9,(r8),r11" );
-#else /* not a vax */
-	/*
-	 * Get to the first byte.
-	 */
-	bp += (r_off >> 3);
-	r_off &= 7;
-	/* Get first part (low order bits) */
-#ifdef NO_UCHAR
-	code = ((*bp++ >> r_off) & rmask[8 - r_off]) & 0xff;
-#else
-	code = (*bp++ >> r_off);
-#endif /* NO_UCHAR */
-	bits -= (8 - r_off);
-	r_off = 8 - r_off;		/* now, offset into code word */
-	/* Get any 8 bit parts in the middle (<=1 for up to 16 bits). */
-	if ( bits >= 8 ) 
-	{
-#ifdef NO_UCHAR
-	    code |= (*bp++ & 0xff) << r_off;
-#else
-	    code |= *bp++ << r_off;
-#endif /* NO_UCHAR */
-	    r_off += 8;
-	    bits -= 8;
+    /* At most two more bytes are needed, as n_bits <= 16 */
+    if (bits < n_bits) {
+	if ((c = getbyte()) == EOF)
+	    return -1;			/* end of file */
+	a |= (long) c << bits;
+	bits += 8;
+	gbytes++;
+	if (bits < n_bits) {
+	    if ((c = getbyte()) == EOF)
+		return -1;
+	    a |= (long) c << bits;
+	    bits += 8;
+	    gbytes++;
 	}
-	/* high order bits. */
-	code |= (*bp & rmask[bits]) << r_off;
-#endif /* vax */
-    offset += n_bits;
-
+    }
+    code = a & (((long)1 << n_bits) - 1);
+    acc = a >> n_bits;
+    accbits = bits - n_bits;
+    if (++ncodes == 8)
+	ncodes = gbytes = 0;
     return code;
 }
 
+/*
+ * LZ77 mode.  Instead of LZW codes, the output is a series of literal bytes
+ * and (distance, length) pairs that repeat a string from the last LZ_WSIZE
+ * bytes.  The strings are found through hash chains on their first three
+ * bytes, as in LZSS and its descendants.  Each eight items are preceded by a
+ * byte of flags, one bit per item from the low end, set for a literal.  A
+ * pair takes two bytes: the length less LZ_MIN in the top four bits, and the
+ * distance less one in the other twelve.  Decompressing is little more than
+ * copying bytes.
+ */
+#define LZ_WSIZE	(1 << LZ_WBITS)	/* window of 4K */
+#define LZ_WMASK	(LZ_WSIZE - 1)
+#define LZ_MIN		3		/* shortest string worth a pair */
+#define LZ_MAX		(LZ_MIN + 15)	/* longest string in a pair */
+#define LZ_HSIZE	4096		/* hash chain heads */
+#define LZ_CHAIN	32		/* longest chain followed */
+#define LZ_HASH(p)	((((p)[0] << 8) ^ ((p)[1] << 4) ^ (p)[2]) & (LZ_HSIZE - 1))
+
+/*
+ * The text is kept in lz_win, which holds two windows.  When the next string
+ * gets near its end, the upper window is moved down, and the positions in
+ * the chains with it.  lz_head[h] is the last position with hash h, and
+ * lz_prev[pos & LZ_WMASK] the one before pos with the same hash, or -1.
+ */
+char_type lz_win[2 * LZ_WSIZE];
+int lz_head[LZ_HSIZE];
+int lz_prev[LZ_WSIZE];
+
+void lz_compress()
+{
+    REGISTER char_type *p, *q;
+    REGISTER int m, len;
+    int pos, end, best, dist, chain, limit, maxlen, n, k;
+    int eof = 0;
+    char_type *flagp;
+    int mask = 0;
+
+    outptr = outbuf;
+    bytes_out = 0;
+    *outptr++ = magic_header[0];
+    *outptr++ = LZ_MAGIC;
+    *outptr++ = LZ_WBITS;
+    for (m = 0; m < LZ_HSIZE; m++)
+	lz_head[m] = -1;
+    in_count = 0;
+    pos = end = 0;
+
+    for (;;) {
+	/* Keep LZ_MAX bytes ahead of pos, if there are that many */
+	if (!eof && end - pos < LZ_MAX) {
+	    if (end == 2 * LZ_WSIZE) {
+		memcpy((char *)lz_win, (char *)lz_win + LZ_WSIZE, LZ_WSIZE);
+		pos -= LZ_WSIZE;
+		end -= LZ_WSIZE;
+		for (m = 0; m < LZ_HSIZE; m++)
+		    lz_head[m] = lz_head[m] >= LZ_WSIZE ?
+					lz_head[m] - LZ_WSIZE : -1;
+		for (m = 0; m < LZ_WSIZE; m++)
+		    lz_prev[m] = lz_prev[m] >= LZ_WSIZE ?
+					lz_prev[m] - LZ_WSIZE : -1;
+	    }
+	    n = read(fileno(stdin), (char *)lz_win + end, 2 * LZ_WSIZE - end);
+	    if (n <= 0)
+		eof = 1;
+	    else {
+		end += n;
+		in_count += n;
+		continue;
+	    }
+	}
+	if (pos >= end)
+	    break;
+
+	/* Find the longest string before pos that matches */
+	best = 0;
+	maxlen = end - pos < LZ_MAX ? end - pos : LZ_MAX;
+	if (maxlen >= LZ_MIN) {
+	    q = lz_win + pos;
+	    k = LZ_HASH(q);
+	    limit = pos - LZ_WSIZE;
+	    chain = LZ_CHAIN;
+	    for (m = lz_head[k]; m > limit && m >= 0 && chain-- > 0;
+						m = lz_prev[m & LZ_WMASK]) {
+		p = lz_win + m;
+		if (p[best] != q[best] || p[0] != q[0])
+		    continue;
+		for (len = 1; len < maxlen && p[len] == q[len]; len++)
+		    ;
+		if (len > best) {
+		    best = len;
+		    dist = pos - m;
+		    if (len == maxlen)
+			break;
+		}
+	    }
+	    lz_prev[pos & LZ_WMASK] = lz_head[k];
+	    lz_head[k] = pos;
+	}
+
+	/* Start a new group of eight items if need be */
+	if (mask == 0) {
+	    if (outptr > outbuf + IOSIZE - 17)
+		flushout();
+	    flagp = outptr++;
+	    *flagp = 0;
+	    mask = 1;
+	}
+	if (best >= LZ_MIN) {
+	    dist--;
+	    *outptr++ = ((best - LZ_MIN) << 4) | (dist >> 8);
+	    *outptr++ = dist;
+	    /* The strings starting inside this one go into the chains too */
+	    for (len = 1; len < best; len++)
+		if (pos + len + LZ_MIN <= end) {
+		    k = LZ_HASH(lz_win + pos + len);
+		    lz_prev[(pos + len) & LZ_WMASK] = lz_head[k];
+		    lz_head[k] = pos + len;
+		}
+	    pos += best;
+	} else {
+	    *flagp |= mask;
+	    *outptr++ = lz_win[pos++];
+	}
+	mask = (mask << 1) & 0xFF;
+    }
+    flushout();
+    report();
+}
+
+void lz_decompress()
+{
+    REGISTER int c, len, from, to;
+    int flags, mask;
+    char_type *win = lz_win;	/* a single window will do */
+
+    outptr = outbuf;
+    to = 0;
+    while ((flags = getbyte()) != EOF) {
+	for (mask = 1; mask & 0xFF; mask <<= 1) {
+	    if ((c = getbyte()) == EOF)
+		break;
+	    if (flags & mask) {
+		putbyte(c);
+		win[to] = c;
+		to = (to + 1) & LZ_WMASK;
+		continue;
+	    }
+	    len = (c >> 4) + LZ_MIN;
+	    from = (c & 0x0F) << 8;
+	    if ((c = getbyte()) == EOF) {
+		fprintf(stderr, "uncompress: corrupt input\n");
+		exit_stat = 1;
+		break;
+	    }
+	    from = (to - (from | c) - 1) & LZ_WMASK;
+	    do {
+		c = win[from];
+		from = (from + 1) & LZ_WMASK;
+		win[to] = c;
+		to = (to + 1) & LZ_WMASK;
+		putbyte(c);
+	    } while (--len > 0);
+	}
+    }
+    flushout();
+}
+
 #ifndef AZTEC86
 char *
 strrchr(s, c)		/* For those who don't have it in libc.a */
@@ -1446,25 +1649,26 @@ void oops ( )	/* wild pointer -- assume bad input */
 void cl_block ()		/* table clear for block compress */
 {
     REGISTER long int rat;
+    long int out = bytes_out + (outptr - outbuf);
 
     checkpoint = in_count + CHECK_GAP;
 #ifdef DEBUG
 	if ( debug ) {
     		fprintf ( stderr, "count: %ld, ratio: ", in_count );
-     		prratio ( stderr, in_count, bytes_out );
+     		prratio ( stderr, in_count, out );
 		fprintf ( stderr, "\n");
 	}
 #endif /* DEBUG */
 
     if(in_count > 0x007fffff) {	/* shift will overflow */
-	rat = bytes_out >> 8;
+	rat = out >> 8;
 	if(rat == 0) {		/* Don't divide by zero */
 	    rat = 0x7fffffff;
 	} else {
 	    rat = in_count / rat;
 	}
     } else {
-	rat = (in_count << 8) / bytes_out;	/* 8 fractional bits */
+	rat = (in_count << 8) / out;	/* 8 fractional bits */
     }
     if ( rat > ratio ) {
 	ratio = rat;
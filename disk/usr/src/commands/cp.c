@@ -3,10 +3,10 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <unistd.h>
 
-#define TRANSFER_UNIT    16384
-char cpbuf[TRANSFER_UNIT];
-int isfloppy;			/* set to 1 for cp x /dev/fd? */
+char *cpbuf;			/* as big as memory allows; see streambuf() */
+unsigned cpsize;
 
 
 main(argc, argv)
@@ -14,9 +14,13 @@ int argc;
 char *argv[];
 {
   int fd1, fd2, m, s;
-  struct stat sbuf, sbuf2;
+  struct stat sbuf;
 
   if (argc < 3) usage();
+  if ((cpbuf = streambuf(&cpsize)) == (char *) 0) {
+	std_err("cp: not enough memory\n");
+	exit(1);
+  }
 
   /* Get the status of the last named file.  See if it is a directory. */
   s = stat(argv[argc - 1], &sbuf);
@@ -51,8 +55,6 @@ char *argv[];
 		stderr3("cannot create ", argv[2], "\n");
 		exit(2);
 	}
-	fstat(fd2, &sbuf2);
-	if ((sbuf2.st_mode & S_IFMT) == S_IFBLK) isfloppy = 1;
 	copyfile(fd1, fd2, argv[2]);
   } else {
 	stderr3("cannot copy to ", argv[2], "\n");
@@ -121,31 +123,24 @@ copyfile(fd1, fd2, name)
 int fd1, fd2;
 char *name;
 {
-  int n, m, mode;
+/* A device or pipe gets a writer process of its own (see streamopen()), so
+ * that reading the next buffer overlaps writing this one.  It also syncs a
+ * block device, such as a floppy, a buffer at a time.
+ */
+  int mode;
   struct stat sbuf;
 
-  do {
-	n = read(fd1, cpbuf, TRANSFER_UNIT);
-	if (n < 0) {
-		std_err("cp: read error\n");
-		break;
-	}
-	if (n > 0) {
-		m = write(fd2, cpbuf, n);
-		if (m != n) {
-			/* Write failed.  Don't keep truncated
-			 * regular file. */
-			perror("cp");
-			fstat(fd2, &sbuf);	/* check for special files */
-			mode = sbuf.st_mode & S_IFMT;
-			if (mode == S_IFREG) unlink(name);
-			exit(1);
-		}
-		if (isfloppy) sync();	/* purge the cache all at once */
-	}
-  } while (n == TRANSFER_UNIT);
+  fstat(fd2, &sbuf);		/* check for special files */
+  mode = sbuf.st_mode & S_IFMT;
+  fd2 = streamopen(fd2, 0);
+  /* If the writer failed, streamclose() tells why. */
+  if ((streamcopy(fd1, fd2, cpbuf, cpsize) < 0) | (streamclose(fd2) < 0)) {
+	/* Copy failed.  Don't keep truncated regular file. */
+	perror("cp");
+	if (mode == S_IFREG) unlink(name);
+	exit(1);
+  }
   close(fd1);
-  close(fd2);
 }
 
 usage()
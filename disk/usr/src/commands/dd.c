@@ -1,9 +1,11 @@
 /* dd - disk dumper */
 
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <signal.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <string.h>
 #include <stdio.h>
 
 #define EOS '\0'
@@ -116,6 +118,8 @@ char *argv[];
   int (*convert)();
   char *iptr;
   int i,j;
+  unsigned n;
+  struct stat st;
 
   convert = null;
   argc--;
@@ -239,14 +243,25 @@ char *argv[];
 	fprintf(stderr, "dd: not enough memory\n");
 	exit(1);
   }
+  /* Seek= is done on the output itself, before it can become a pipe. */
+  for (; nseek; nseek--)
+	if (lseek(ofd, (long) obs, SEEK_CUR) == -1L) {
+		fprintf(stderr, "dd: seek error\n");
+		exit(1);
+	}
+
+  /* Let a child write to a device or pipe while the next records are read.
+   * A copy with bs= from a tape keeps the size of each record, which the pipe
+   * to the child would lose, so that is written here.
+   */
+  if (!flag || fstat(ifd, &st) < 0 || (st.st_mode & S_IFMT) != S_IFCHR)
+	ofd = streamopen(ofd, obs);
   ibc = obc = cbc = 0;
   op = obuf;
   if (signal(SIGINT, SIG_IGN) != SIG_IGN)
 	signal(SIGINT, over);
   for (; skip; skip--)
 	read(ifd, ibuf, ibs);
-  for (; nseek; nseek--)
-	lseek(ofd, (long) obs, SEEK_CUR);
 outputall:
   if (ibc-- == 0) {
 	ibc = 0;
@@ -294,6 +309,19 @@ outputall:
 	}
 	goto outputall;
   }       
+  if (convert == null) {	/* no conversion: move as much as fits */
+	n = ibc + 1;
+	if (n > obs - obc) n = obs - obc;
+	memcpy(op, iptr, n);
+	op += n;
+	iptr += n;
+	ibc -= n - 1;
+	if ((obc += n) >= obs) {
+		puto();
+		op = obuf;
+	}
+	goto outputall;
+  }
   i = *iptr++ & 0377;
   (*convert)(i);
   goto outputall;
@@ -341,6 +369,11 @@ extra()
 
 void over()
 {
+  if (streamclose(ofd) < 0) {
+	fprintf(stderr, "dd: write error\n");
+	statistics();
+	exit(1);
+  }
   statistics();
   exit(0);
 }
@@ -2,21 +2,29 @@
 
 /* Poor man's implementation of diff(1)
  - no options available
- - may give more output than other diffs, due to the straight-forward algorithm
- - runs out of memory if the differing chunks become too large
- - input line length should not exceed LINELEN; longer lines are truncated,
-   while only the first LINELEN characters are compared
+ - both files are kept in memory; runs out of memory if they are too large
 
  - Bug fixes by Rick Thomas Sept. 1989
 
+ The lines of both files are read in, and each is hashed once and given an
+ equivalence class number, so that equal lines have equal numbers.  From
+ then on only the numbers are compared.  The shortest edit script is found
+ with the O(ND) algorithm of E. W. Myers ("An O(ND) Difference Algorithm and
+ Its Variations", Algorithmica 1, 1986), in its linear space form: find the
+ middle snake of the shortest path, and do the two halves on either side of
+ it the same way.  Lines that are not on the path are marked as changed, and
+ the runs of marked lines are printed as ed-style hunks.
+
  Please report bugs and suggestions to erikb@cs.vu.nl
 */
 
 #include <stdio.h>
 
-#define LINELEN 128
+#define HASH_MUL	31	/* line hash is h * HASH_MUL + c */
+#define MAX_LINES	8000	/* per file; keeps every table under 64K */
+#define BIG		32767	/* more lines than a file can have */
 
-FILE *fopen();
+char *malloc(), *realloc();
 
 char *prog;
 int diffs = 0;
@@ -49,187 +57,219 @@ char *fmt, *s;
   exit(2);
 }
 
-/* The line module */
-char *malloc();
-char *fgets();
-
-struct line {
-  struct line *l_next;
-  char l_text[LINELEN + 2];
-  char l_eof;
-};
-
-struct line *freelist = 0;
-#define stepup(ll) ( ((ll) && ((ll)->l_eof==0)) ? (ll)->l_next : (ll) )
-
-struct line *
- new_line()
+char *alloc(n)
+unsigned n;
 {
-  register struct line *l;
+  register char *p;
 
-  if (l = freelist)
-	freelist = freelist->l_next;
-  else if ((l = (struct line *) malloc(sizeof(struct line))) == 0)
-	fatal("out of memory");
-  return l;
+  if ((p = malloc(n)) == NULL) fatal("out of memory");
+  return p;
 }
 
-free_line(l)
-register struct line *l;
-{
-  l->l_next = freelist;
-  freelist = l;
-}
+/* The file module */
+struct file {
+  char **f_text;		/* the lines, each with its '\n' */
+  unsigned *f_hash;		/* hash of each line */
+  int *f_class;			/* equivalence class of each line */
+  char *f_changed;		/* set for lines not in the common part */
+  int f_len;			/* nr of lines */
+};
 
-int equal_line(l1, l2)
-struct line *l1, *l2;
-{
-  if (l1 == 0 || l2 == 0)
-	return(0);
-  else if (l1->l_eof || l2->l_eof)
-	return(l1->l_eof == l2->l_eof);
-  else
-	return(strcmp(l1->l_text, l2->l_text) == 0);
-}
+struct file file[2];
+char *linebuf;			/* line being read */
+unsigned linesize;		/* allocated size of linebuf */
 
-int equal_3(l1, l2)
-struct line *l1, *l2;
+/* Read_line () reads a line of any length into linebuf and returns its
+ * length, or -1 at end of file.
+ */
+int read_line(fp, hash)
+register FILE *fp;
+unsigned *hash;
 {
-  register int i, ansr;
-
-  ansr = 1;
-#ifdef DEBUG
-  if (l1 == 0)
-	fprintf(stderr, "\t(null)\n");
-  else if (l1->l_eof)
-	fprintf(stderr, "\t(eof)\n");
-  else
-	fprintf(stderr, "\t%s", l1->l_text);
-  if (l2 == 0)
-	fprintf(stderr, "\t(null)\n");
-  else if (l2->l_eof)
-	fprintf(stderr, "\t(eof)\n");
-  else
-	fprintf(stderr, "\t%s", l2->l_text);
-#endif
-  for (i = 0; i < 3; ++i) {
-	if (!equal_line(l1, l2)) {
-		ansr = 0;
-		break;
+  register int c, n = 0;
+  register unsigned h = 0;
+
+  while ((c = getc(fp)) != EOF) {
+	if (n + 2 > linesize) {
+		linesize *= 2;
+		if ((linebuf = realloc(linebuf, linesize)) == NULL)
+			fatal("out of memory");
 	}
-	l1 = stepup(l1);
-	l2 = stepup(l2);
+	linebuf[n++] = c;
+	h = h * HASH_MUL + (c & 0377);
+	if (c == '\n') break;
   }
-#ifdef DEBUG
-  fprintf(stderr, "\t%d\n", ansr);
-#endif
-  return(ansr);
+  if (n == 0) return(-1);
+  linebuf[n] = '\0';
+  *hash = h;
+  return(n);
 }
 
-struct line *
- read_line(fp)
+read_file(f, fp)
+register struct file *f;
 FILE *fp;
 {
-  register struct line *l = new_line();
-  register char *p;
-  register int c;
-
-  (p = &(l->l_text[LINELEN]))[1] = '\377';
-  l->l_eof = 0;
-  if (fgets(l->l_text, LINELEN + 2, fp) == NULL) {
-	l->l_eof = 1;
-	l->l_text[0] = 0;
-  } else if ((p[1] & 0377) != 0377 && *p != '\n') {
-	while ((c = fgetc(fp)) != '\n' && c != EOF) {
+  register int n;
+  int max = 64;
+  unsigned h;
+
+  f->f_text = (char **) alloc(max * sizeof(char *));
+  f->f_hash = (unsigned *) alloc(max * sizeof(unsigned));
+  f->f_len = 0;
+  while ((n = read_line(fp, &h)) >= 0) {
+	if (f->f_len == max) {
+		if (max == MAX_LINES) fatal("too many lines");
+		max = (max > MAX_LINES / 2) ? MAX_LINES : max * 2;
+		f->f_text = (char **) realloc((char *) f->f_text,
+					      max * sizeof(char *));
+		f->f_hash = (unsigned *) realloc((char *) f->f_hash,
+						 max * sizeof(unsigned));
+		if (f->f_text == NULL || f->f_hash == NULL)
+			fatal("out of memory");
 	}
-	*p++ = '\n';
-	*p = '\0';
+	f->f_text[f->f_len] = alloc(n + 1);
+	strcpy(f->f_text[f->f_len], linebuf);
+	f->f_hash[f->f_len++] = h;
   }
-  l->l_next = 0;
-  return l;
+  f->f_class = (int *) alloc((f->f_len + 1) * sizeof(int));
+  f->f_changed = alloc(f->f_len + 1);
+  for (n = 0; n < f->f_len; n++) f->f_changed[n] = 0;
 }
 
-/* File window handler */
-struct f {
-  struct line *f_bwin, *f_ewin;
-  struct line *f_aside;
-  int f_linecnt;		/* line number in file of last advanced line */
-  FILE *f_fp;
-};
-
-advance(f)
-register struct f *f;
+/* Classify () gives every line of both files the number of its equivalence
+ * class.  Lines go into a hash table on their hash; a line's text is
+ * compared only with that of earlier lines in the same chain whose hash is
+ * the same.
+ */
+classify()
 {
-  register struct line *l;
-
-  if (l = f->f_bwin) {
-	if (f->f_ewin == l)
-		f->f_bwin = f->f_ewin = 0;
-	else
-		f->f_bwin = l->l_next;
-	free_line(l);
-	(f->f_linecnt)++;
+  register int i, c;
+  register struct file *f;
+  int *bucket, *chain, nbuckets, nclass = 0;
+  char **text;			/* text of the first line of each class */
+  unsigned *hash;		/* and its hash */
+
+  nbuckets = 1;
+  while (nbuckets < file[0].f_len + file[1].f_len) nbuckets <<= 1;
+  bucket = (int *) alloc(nbuckets * sizeof(int));
+  chain = (int *) alloc((file[0].f_len + file[1].f_len + 1) * sizeof(int));
+  text = (char **) alloc((file[0].f_len + file[1].f_len + 1) * sizeof(char *));
+  hash = (unsigned *) alloc((file[0].f_len + file[1].f_len + 1) * sizeof(unsigned));
+  for (i = 0; i < nbuckets; i++) bucket[i] = -1;
+
+  for (f = &file[0]; f <= &file[1]; f++) {
+	for (i = 0; i < f->f_len; i++) {
+		for (c = bucket[f->f_hash[i] & (nbuckets - 1)]; c >= 0;
+								c = chain[c])
+			if (hash[c] == f->f_hash[i] &&
+			    strcmp(text[c], f->f_text[i]) == 0)
+				break;
+		if (c < 0) {		/* new class */
+			c = nclass++;
+			text[c] = f->f_text[i];
+			hash[c] = f->f_hash[i];
+			chain[c] = bucket[hash[c] & (nbuckets - 1)];
+			bucket[hash[c] & (nbuckets - 1)] = c;
+		}
+		f->f_class[i] = c;
+	}
+	free((char *) f->f_hash);
   }
+  free((char *) bucket);
+  free((char *) chain);
+  free((char *) text);
+  free((char *) hash);
 }
 
-aside(f, l)
-struct f *f;
-struct line *l;
+/* The Myers module */
+int *xv, *yv;			/* classes of the lines of the two files */
+int *fdiag, *bdiag;		/* furthest x reached on each diagonal */
+
+/* Midsnake () finds the middle snake of the shortest edit script for
+ * xv[xoff..xlim) and yv[yoff..ylim), and returns in *px, *py a point on it.
+ * Diagonal k holds the points with x - y == k.  The forward search starts
+ * from the top left, the backward search from the bottom right, each going
+ * one edit further per turn, until the two meet.
+ */
+midsnake(xoff, xlim, yoff, ylim, px, py)
+int xoff, xlim, yoff, ylim;
+int *px, *py;
 {
-  register struct line *ll;
-
-  if (l == 0) return;
-  if (ll = l->l_next) {
-	while (ll->l_next) ll = ll->l_next;
-	ll->l_next = f->f_aside;
-	f->f_aside = l->l_next;
-	l->l_next = 0;
-	f->f_ewin = l;
-  }
-}
+  register int *fd = fdiag, *bd = bdiag;
+  register int x, y, k;
+  int dmin = xoff - ylim, dmax = xlim - yoff;
+  int fmid = xoff - yoff, bmid = xlim - ylim;
+  int fmin = fmid, fmax = fmid, bmin = bmid, bmax = bmid;
+  int odd = (fmid - bmid) & 1;
+
+  fd[fmid] = xoff;
+  bd[bmid] = xlim;
+  for (;;) {
+	/* One more edit forward */
+	if (fmin > dmin)
+		fd[--fmin - 1] = -1;
+	else
+		++fmin;
+	if (fmax < dmax)
+		fd[++fmax + 1] = -1;
+	else
+		--fmax;
+	for (k = fmax; k >= fmin; k -= 2) {
+		x = (fd[k - 1] >= fd[k + 1]) ? fd[k - 1] + 1 : fd[k + 1];
+		y = x - k;
+		while (x < xlim && y < ylim && xv[x] == yv[y]) x++, y++;
+		fd[k] = x;
+		if (odd && bmin <= k && k <= bmax && bd[k] <= x) {
+			*px = x;
+			*py = y;
+			return;
+		}
+	}
 
-struct line *
- next(f)
-register struct f *f;
-{
-  register struct line *l;
-
-  if (l = f->f_aside) {
-	f->f_aside = l->l_next;
-	l->l_next = 0;
-  } else
-	l = read_line(f->f_fp);
-  if (l) {
-	if (f->f_bwin == 0)
-		f->f_bwin = f->f_ewin = l;
-	else {
-		if (f->f_ewin->l_eof && l->l_eof) {
-			free_line(l);
-			return(f->f_ewin);
+	/* One more edit backward */
+	if (bmin > dmin)
+		bd[--bmin - 1] = BIG;
+	else
+		++bmin;
+	if (bmax < dmax)
+		bd[++bmax + 1] = BIG;
+	else
+		--bmax;
+	for (k = bmax; k >= bmin; k -= 2) {
+		x = (bd[k - 1] < bd[k + 1]) ? bd[k - 1] : bd[k + 1] - 1;
+		y = x - k;
+		while (x > xoff && y > yoff && xv[x - 1] == yv[y - 1]) x--, y--;
+		bd[k] = x;
+		if (!odd && fmin <= k && k <= fmax && x <= fd[k]) {
+			*px = x;
+			*py = y;
+			return;
 		}
-		f->f_ewin->l_next = l;
-		f->f_ewin = l;
 	}
   }
-  return l;
 }
 
-init_f(f, fp)
-register struct f *f;
-FILE *fp;
+/* Compare () marks the lines of xv[xoff..xlim) and yv[yoff..ylim) that are
+ * not in a longest common subsequence of the two.
+ */
+compare(xoff, xlim, yoff, ylim)
+register int xoff, xlim, yoff, ylim;
 {
-  f->f_bwin = f->f_ewin = f->f_aside = 0;
-  f->f_linecnt = 0;
-  f->f_fp = fp;
-}
-
-update(f, s)
-register struct f *f;
-char *s;
-{
-  while (f->f_bwin && f->f_bwin != f->f_ewin) {
-	printf("%s%s", s, f->f_bwin->l_text);
-	advance(f);
+  int x, y;
+
+  /* Common lines at either end are in it */
+  while (xoff < xlim && yoff < ylim && xv[xoff] == yv[yoff]) xoff++, yoff++;
+  while (xlim > xoff && ylim > yoff && xv[xlim - 1] == yv[ylim - 1])
+	xlim--, ylim--;
+
+  if (xoff == xlim)
+	while (yoff < ylim) file[1].f_changed[yoff++] = 1;
+  else if (yoff == ylim)
+	while (xoff < xlim) file[0].f_changed[xoff++] = 1;
+  else {
+	midsnake(xoff, xlim, yoff, ylim, &x, &y);
+	compare(xoff, x, yoff, y);
+	compare(x, xlim, y, ylim);
   }
 }
 
@@ -237,106 +277,74 @@ char *s;
 diff(fp1, fp2)
 FILE *fp1, *fp2;
 {
-  struct f f1, f2;
-  struct line *l1, *s1, *b1, *l2, *s2, *b2;
-  register struct line *ll;
-
-  init_f(&f1, fp1);
-  init_f(&f2, fp2);
-  l1 = next(&f1);
-  l2 = next(&f2);
-  while ((l1->l_eof == 0) || (l2->l_eof == 0)) {
-	if (equal_line(l1, l2)) {
-  equal:
-		advance(&f1);
-		advance(&f2);
-		l1 = next(&f1);
-		l2 = next(&f2);
+  register int i, j;
+  int i0, j0, ndiags;
+
+  linesize = 128;
+  linebuf = alloc(linesize);
+  read_file(&file[0], fp1);
+  read_file(&file[1], fp2);
+  classify();
+
+  /* Diagonals run from -(lines of file 2) - 1 to (lines of file 1) + 1 */
+  xv = file[0].f_class;
+  yv = file[1].f_class;
+  ndiags = file[0].f_len + file[1].f_len + 3;
+  fdiag = (int *) alloc(ndiags * sizeof(int)) + file[1].f_len + 1;
+  bdiag = (int *) alloc(ndiags * sizeof(int)) + file[1].f_len + 1;
+  compare(0, file[0].f_len, 0, file[1].f_len);
+
+  /* Print the runs of changed lines */
+  i = j = 0;
+  while (i < file[0].f_len || j < file[1].f_len) {
+	if (i < file[0].f_len && j < file[1].f_len &&
+	    !file[0].f_changed[i] && !file[1].f_changed[j]) {
+		i++;
+		j++;
 		continue;
 	}
-	s1 = b1 = l1;
-	s2 = b2 = l2;
-	/* Read several more lines */
-	next(&f1);
-	next(&f1);
-	next(&f2);
-	next(&f2);
-	/* Start searching */
-search:
-	next(&f2);
-	ll = s1;
-	do {
-		if (equal_3(ll, b2)) {
-			l1 = ll;
-			l2 = b2;
-			aside(&f1, ll);
-			aside(&f2, b2);
-			differ(&f1, &f2);
-			goto equal;
-		}
-		if (ll->l_eof) break;
-		ll = stepup(ll);
-	} while (ll);
-	b2 = stepup(b2);
-
-	next(&f1);
-	ll = s2;
-	do {
-		if (equal_3(b1, ll)) {
-			l1 = b1;
-			l2 = ll;
-			aside(&f2, ll);
-			aside(&f1, b1);
-			differ(&f1, &f2);
-			goto equal;
-		}
-		if (ll->l_eof) break;
-		ll = stepup(ll);
-	} while (ll);
-	b1 = stepup(b1);
-
-	goto search;
+	i0 = i;
+	j0 = j;
+	while (i < file[0].f_len && file[0].f_changed[i]) i++;
+	while (j < file[1].f_len && file[1].f_changed[j]) j++;
+	differ(i0, i - i0, j0, j - j0);
   }
-
-  /* Both of the files reached EOF */
 }
 
-differ(f1, f2)
-register struct f *f1, *f2;
+differ(cnt1, len1, cnt2, len2)
+int cnt1, len1, cnt2, len2;
 {
-  int cnt1 = f1->f_linecnt, len1 = wlen(f1), cnt2 = f2->f_linecnt, len2 = wlen(f2);
-
-  if ((len1 = wlen(f1)) || (len2 = wlen(f2))) {
-	if (len1 == 0) {
-		printf("%da", cnt1);
-		range(cnt2 + 1, cnt2 + len2);
-	} else if (len2 == 0) {
-		range(cnt1 + 1, cnt1 + len1);
-		printf("d%d", cnt2);
-	} else {
-		range(cnt1 + 1, cnt1 + len1);
-		putchar('c');
-		range(cnt2 + 1, cnt2 + len2);
-	}
-	putchar('\n');
-	if (len1) update(f1, "< ");
-	if (len1 && len2) printf("---\n");
-	if (len2) update(f2, "> ");
-	diffs++;
+  if (len1 == 0) {
+	printf("%da", cnt1);
+	range(cnt2 + 1, cnt2 + len2);
+  } else if (len2 == 0) {
+	range(cnt1 + 1, cnt1 + len1);
+	printf("d%d", cnt2);
+  } else {
+	range(cnt1 + 1, cnt1 + len1);
+	putchar('c');
+	range(cnt2 + 1, cnt2 + len2);
   }
+  putchar('\n');
+  if (len1) update(&file[0], cnt1, len1, "< ");
+  if (len1 && len2) printf("---\n");
+  if (len2) update(&file[1], cnt2, len2, "> ");
+  diffs++;
 }
 
-wlen(f)
-struct f *f;
+update(f, cnt, len, s)
+register struct file *f;
+int cnt, len;
+char *s;
 {
-  register cnt = 0;
-  register struct line *l = f->f_bwin, *e = f->f_ewin;
+  register char *p;
 
-  while (l && l != e) {
-	cnt++;
-	l = l->l_next;
+  while (len-- > 0) {
+	p = f->f_text[cnt++];
+	fputs(s, stdout);
+	fputs(p, stdout);
+	if (p[strlen(p) - 1] != '\n') putchar('\n');
   }
-  return cnt;
 }
 
 range(a, b)
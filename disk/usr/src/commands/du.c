@@ -21,8 +21,8 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
-#include <fcntl.h>
 #include <blocksize.h>
+#include <treewalk.h>
 #include <stdio.h>
 
 char *prog;			/* program name */
@@ -34,23 +34,6 @@ int levels = 255;		/* # of directory levels to print */
 
 #define	LINELEN 256
 
-#define DIRNAMELEN 14
-#define	LSTAT stat
-typedef struct _dirstr {
-  ino_t inum;
-  char d_name[DIRNAMELEN];
-} DIR;
-DIR dir;
-
-typedef struct _alstr {
-  int al_dev;
-  ino_t al_inum;
-} ALREADY;
-
-#define	MAXALREADY	50
-ALREADY already[MAXALREADY];
-int alc = 0;
-
 /*
  *	myindex - stop the scanf bug
  */
@@ -142,66 +125,44 @@ int outlen;
   return(1);
 }
 
-/*
- *	done - have we encountered (dev, inum) before? Returns 1 for yes,
- *	0 for no, and remembers (dev, inum).
- */
-int done(dev, inum)
-int dev;
-ino_t inum;
-{
-  register ALREADY *ap;
-  register int i;
-  int ret = 0;
-
-  for (i = 0, ap = already; i < alc; ap++, i++)
-	if (ap->al_dev == dev && ap->al_inum == inum) {
-		ret = 1;
-		break;
-	}
-  if (alc < MAXALREADY) {
-	already[alc].al_dev = dev;
-	already[alc++].al_inum = inum;
-  }
-  return(ret);
-}
-
 /*
  *	dodir - process the directory d. Return the long size (in blocks)
- *	of d and its descendants.
+ *	of d and its descendants.  The entries are stat'ed by tw_read(),
+ *	in inode order.  A file with more than one link is counted the
+ *	first time it is met; directories cannot have extra links.
  */
 long dodir(d, thislev)
 char *d;
 int thislev;
 {
-  struct stat s;
+  struct twdir td;
+  register struct twent *tp;
+  register struct stat *sp;
   long total = 0L;
   char dent[LINELEN];
-  int fd;
 
-  if ((fd = open(d, O_RDONLY)) < 0) return(0L);
-  while (read(fd, &dir, sizeof(dir)) > 0) {
-	if (strcmp(dir.d_name, ".") == 0 ||
-	    strcmp(dir.d_name, "..") == 0)
+  if (tw_read(&td, d, TW_STAT) < 0) return(0L);
+  for (tp = td.tw_ent; tp < td.tw_ent + td.tw_count; tp++) {
+	if (tp->tw_errno != 0) continue;
+	if (!makedname(d, tp->tw_name, dent, sizeof(dent))) continue;
+	sp = &tp->tw_stat;
+	if ((sp->st_mode & S_IFMT) != S_IFDIR && sp->st_nlink > 1 &&
+	    tw_seen(sp->st_dev, sp->st_ino))
 		continue;
-	if (dir.inum == 0) continue;
-	if (!makedname(d, dir.d_name, dent, sizeof(dent))) continue;
-	if (LSTAT(dent, &s) < 0) continue;
-	if (s.st_nlink > 1 && done(s.st_dev, s.st_ino)) continue;
-	if ((s.st_mode & S_IFMT) == S_IFDIR)
+	if ((sp->st_mode & S_IFMT) == S_IFDIR)
 		total += dodir(dent, thislev - 1);
-	switch (s.st_mode & S_IFMT) {
+	switch (sp->st_mode & S_IFMT) {
 	    case S_IFREG:
 	    case S_IFDIR:
-		total += (s.st_size + BLOCK_SIZE) / BLOCK_SIZE;
+		total += (sp->st_size + BLOCK_SIZE) / BLOCK_SIZE;
 		break;
 	}
-	if (all && (s.st_mode & S_IFMT) != S_IFDIR)
+	if (all && (sp->st_mode & S_IFMT) != S_IFDIR)
 		if (thislev > 0)	/* this is correct - file in subdir */
 			printf("%ld\t%s\n",
-				(s.st_size + BLOCK_SIZE) / BLOCK_SIZE, dent);
+				(sp->st_size + BLOCK_SIZE) / BLOCK_SIZE, dent);
   }
-  close(fd);
+  tw_free(&td);
   if (!silent)
 	if (thislev >= 0)	/* this is correct - subdir itself */
 		printf("%ld\t%s\n", total, d);
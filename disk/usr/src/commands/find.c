@@ -16,13 +16,13 @@
 #include <sys/types.h>
 #include <fcntl.h>
 #include <sys/stat.h>
+#include <treewalk.h>
 #include <stdio.h>
 
 #define SHELL "/usr/bin/sh"
 
 #define PLEN	256		/* maximum path length; overflows are not
 			 * detected */
-#define DIRSIZ	16		/* size of a directory entry */
 #define MAXARG	256		/* maximum length for an argv */
 #define NPATHS	256		/* maximum number of paths in path-list */
 #define BSIZE  1024		/* bytes per block */
@@ -151,54 +151,60 @@ find(path, pred, last)
 char *path, *last;
 struct node *pred;
 {
-  char spath[PLEN], ent[DIRSIZ + 1];
   struct stat st;
-  register char *send = spath;
-  FILE *fp, *fopen();
 
-  if (path[1] == '\0' && *path == '/') {
-	*send++ = '/';
-	*send = '\0';
-  } else
-	while (*send++ = *path++) {
-	}
+  if (stat(path, &st) == -1)
+	nonfatal("can't get status of ", path);
+  else
+	visit(path, &st, pred, last);
+}
 
-  if (stat(spath, &st) == -1)
-	nonfatal("can't get status of ", spath);
-  else {
-	switch (xdev_flag) {
-	    case 0:
-		break;
-	    case 1:
-		if (st.st_dev != devnr) return;
-		break;
-	    case 2:		/* set current device number */
-		xdev_flag = 1;
-		devnr = st.st_dev;
-		break;
-	}
+/* Visit the file path, whose status is st.  If it is a directory, go through
+ * its entries.  They are stat'ed by tw_read() all at once, in inode order,
+ * but are visited in the order of the directory.
+ */
+visit(path, st, pred, last)
+char *path, *last;
+register struct stat *st;
+struct node *pred;
+{
+  char spath[PLEN];
+  struct twdir td;
+  register struct twent *tp;
+  register char *send = spath;
 
-	(void) check(spath, &st, pred, last);
-	if ((st.st_mode & S_IFMT) == S_IFDIR) {
-		if ((fp = fopen(spath, "r")) == NULL) {
-			nonfatal("can't read directory ", spath);
-			return;
-		}
-		send[-1] = '/';
-		ent[DIRSIZ] = '\0';
-		while (fread(ent, DIRSIZ, 1, fp) == 1) {
-			if (!((*ent == '\0' && ent[1] == '\0')
-			      || (ent[2] == '.') &&
-			      (ent[3] == '\0'
-			       || (ent[3] == '.' && ent[4] == '\0'))
-			      )) {
-				strcpy(send, ent + 2);
-				find(spath, pred, ent + 2);
-			}
-		}
-		fclose(fp);
+  switch (xdev_flag) {
+      case 0:
+	break;
+      case 1:
+	if (st->st_dev != devnr) return;
+	break;
+      case 2:			/* set current device number */
+	xdev_flag = 1;
+	devnr = st->st_dev;
+	break;
+  }
+
+  (void) check(path, st, pred, last);
+  if ((st->st_mode & S_IFMT) != S_IFDIR) return;
+  if (tw_read(&td, path, TW_STAT) < 0) {
+	nonfatal("can't read directory ", path);
+	return;
+  }
+  if (path[1] == '\0' && *path == '/')
+	send++;
+  else
+	while (*send++ = *path++) {
 	}
+  send[-1] = '/';
+  for (tp = td.tw_ent; tp < td.tw_ent + td.tw_count; tp++) {
+	strcpy(send, tp->tw_name);
+	if (tp->tw_errno != 0)
+		nonfatal("can't get status of ", spath);
+	else
+		visit(spath, &tp->tw_stat, pred, tp->tw_name);
   }
+  tw_free(&td);
 }
 
 check(path, st, n, last)
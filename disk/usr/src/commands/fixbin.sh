@@ -64,12 +64,12 @@ chmem =50000 $dst/ar
 chmem =10000 $dst/cgrep
 chmem =16000 $dst/cp
 chmem =55000 $dst/cdiff
-chmem =64000 $dst/compress
+chmem =480000 $dst/compress
 chmem =64000 $dst/cpdir
 chmem =64000 $dst/cron
 chmem =30000 $dst/de
 chmem =40000 $dst/dd
-chmem =32000 $dst/du
+chmem =50000 $dst/du
 chmem =55000 $dst/diff
 chmem =60000 $dst/ed
 chmem =50000 $dst/file
@@ -81,7 +81,7 @@ chmem =10000 $dst/last
 chmem =20000 $dst/make
 chmem =10000 $dst/man
 chmem =64000 $dst/mined
-chmem =40000 $dst/mkfs
+chmem =60000 $dst/mkfs
 chmem =40000 $dst/mkproto
 chmem =15000 $dst/mref
 chmem =16000 $dst/nm
@@ -15,11 +15,13 @@
 */
 
 #include <sys/types.h>
+#include <sys/times.h>
 #include <ctype.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <limits.h>
 #include <stdlib.h>
+#include <time.h>
 #include <unistd.h>
 #include <minix/config.h>
 #include <minix/const.h>
@@ -42,6 +44,11 @@
 #define MAXDIRSIZE     5000	/* max. size of a reasonable directory */
 #define CINDIR		128	/* number of indirect zno's read at a time */
 #define CDIRECT		 16	/* number of dir entries read at a time */
+#define NR_CACHE	 32	/* max. number of blocks in the cache */
+#define NR_HASH		 32	/* number of hash chains (a power of 2) */
+#define NR_AHEAD	  8	/* max. number of blocks read ahead */
+#define NR_BULK		 16	/* max. number of blocks per read/write */
+#define NR_PHASES	  6	/* number of phases timed with -t */
 #define BITMASK		((1 << BITSHIFT) - 1)
 #define setbit(w, b)	(w[(b) >> BITSHIFT] |= 1 << ((b) & BITMASK))
 #define clrbit(w, b)	(w[(b) >> BITSHIFT] &= ~(1 << ((b) & BITMASK)))
@@ -102,8 +109,7 @@ int firstcnterr;		/* is this the first inode ref cnt error? */
 unsigned *imap, *spec_imap;	/* inode bit maps */
 unsigned *zmap, *spec_zmap;	/* zone bit maps */
 unsigned *dirmap;		/* directory (inode) bit map */
-char rwbuf[BLOCK_SIZE];		/* one block buffer cache */
-block_nr thisblk;		/* block in buffer cache */
+char rwbuf[BLOCK_SIZE];		/* cache buffer until the cache is allocated */
 char nullbuf[BLOCK_SIZE];	/* null buffer */
 nlink_t *count;			/* inode count */
 int changed;			/* has the diskette been written to? */
@@ -115,6 +121,30 @@ struct stack {
 
 int dev;			/* file descriptor of the device */
 
+/* The block cache.  Buffers are kept in LRU order, most recently used at the
+ * front, and are found by block number through hash chains.  Writes go
+ * straight through to the disk, so a buffer can always be reused.
+ */
+struct buf {
+  block_nr b_bno;		/* block in this buffer, or NO_BLOCK */
+  struct buf *b_next, *b_prev;	/* LRU chain */
+  struct buf *b_hash;		/* next buffer on the same hash chain */
+  char *b_data;			/* the block itself */
+} onebuf, *bufs, *front, *rear, *hashtab[NR_HASH];
+int nbuf;			/* number of buffers in the cache */
+char *ahead;			/* read ahead buffer */
+int nahead;			/* blocks in it; no read ahead if < 2 */
+long nlookups, nhits;		/* cache statistics */
+long nios, nioblocks;		/* reads and writes, and blocks moved */
+
+/* Times taken by the phases of the check, kept if `timing' is set. */
+char *phname[NR_PHASES];	/* name of each phase */
+long phreal[NR_PHASES];		/* real time in seconds */
+clock_t phcpu[NR_PHASES];	/* user + system time in ticks */
+int nphase;			/* number of phases started */
+long lastreal;			/* real time at start of the current phase */
+clock_t lastcpu;		/* and cpu time */
+
 #define DOT	1
 #define DOTDOT	2
 
@@ -122,7 +152,7 @@ int dev;			/* file descriptor of the device */
 int nfreeinode, nregular, ndirectory, nblkspec, ncharspec, nbadinode;
 int npipe, nfreezone, ztype[NLEVEL];
 
-int repair, automatic, listing, listsuper;	/* flags */
+int repair, automatic, listing, listsuper, timing;	/* flags */
 int firstlist;			/* has the listing header been printed? */
 unsigned part_offset;		/* sector offset for this partition */
 char answer[] = {"Answer questions with y or n.  Then hit RETURN"};
@@ -135,7 +165,9 @@ initvars()
   nregular = ndirectory = nblkspec = ncharspec = nbadinode = npipe = 0;
   for (level = 0; level < NLEVEL; level++) ztype[level] = 0;
   changed = 0;
-  thisblk = NO_BLOCK;
+  initcache(&onebuf, rwbuf, 1, 0);
+  nlookups = nhits = nios = nioblocks = 0;
+  nphase = 0;
   firstlist = 1;
   firstcnterr = 1;
 }
@@ -288,34 +320,202 @@ devclose()
   }
 }
 
-/* Read or write a block. */
-devio(bno, dir)
+/* Read or write `nblk' blocks starting at block `bno', in as few pieces as
+ * NR_BULK allows.
+ */
+devio(bno, buf, nblk, dir)
 block_nr bno;
+char *buf;
 {
-  if (dir == READING && bno == thisblk) return;
-  thisblk = bno;
+  register n;
 
-  lseek(dev, btoa(bno), SEEK_SET);
-  if (dir == READING) {
-	if (read(dev, rwbuf, BLOCK_SIZE) == BLOCK_SIZE)
-		return;
-  } else {
-	if (write(dev, rwbuf, BLOCK_SIZE) == BLOCK_SIZE)
-		return;
+  while (nblk > 0) {
+	n = nblk > NR_BULK ? NR_BULK : nblk;
+	nios++;
+	nioblocks += n;
+	lseek(dev, btoa(bno), SEEK_SET);
+	if (dir == READING) {
+		if (read(dev, buf, n * BLOCK_SIZE) != n * BLOCK_SIZE) break;
+	} else {
+		if (write(dev, buf, n * BLOCK_SIZE) != n * BLOCK_SIZE) break;
+	}
+	bno += n;
+	buf += n * BLOCK_SIZE;
+	nblk -= n;
   }
+  if (nblk == 0) return;
 
   printf("%s: can't %s block %ld (error = 0x%x)\n", prog,
          dir == READING ? "read" : "write", (long) bno, errno);
   fatal("");
 }
 
+/* Make a cache of the `n' buffers `bp' holding the blocks at `data', with
+ * `nra' blocks after them to read ahead into.
+ */
+initcache(bp, data, n, nra)
+register struct buf *bp;
+char *data;
+{
+  register i;
+
+  bufs = bp;
+  nbuf = n;
+  ahead = data + (unsigned) n * BLOCK_SIZE;
+  nahead = nra;
+  for (i = 0; i < NR_HASH; i++) hashtab[i] = 0;
+  for (i = 0; i < n; i++, bp++) {
+	bp->b_bno = NO_BLOCK;
+	bp->b_data = data + i * BLOCK_SIZE;
+	bp->b_next = bp + 1;
+	bp->b_prev = bp - 1;
+  }
+  front = bufs;
+  rear = bp - 1;
+  front->b_prev = rear->b_next = 0;
+}
+
+/* Replace the one buffer cache by as big a cache as memory allows, with a
+ * read ahead buffer a quarter of its size.  The bitmaps and the count array
+ * have been allocated by now, so the cache gets what is left.
+ */
+getcache()
+{
+  register n = NR_CACHE, nra;
+  char *p;
+
+  for (;;) {
+	nra = n / 4 > NR_AHEAD ? NR_AHEAD : n / 4;
+	p = malloc((unsigned) (n + nra) * (BLOCK_SIZE + sizeof(struct buf)));
+	if (p != 0) break;
+	if ((n >>= 1) == 1) return;
+  }
+  initcache((struct buf *) (p + (unsigned) (n + nra) * BLOCK_SIZE), p, n, nra);
+}
+
+/* Go back to the one buffer cache. */
+putcache()
+{
+  if (bufs != &onebuf) free(bufs[0].b_data);
+  initcache(&onebuf, rwbuf, 1, 0);
+}
+
+/* Find block `bno' in the cache. */
+struct buf *lookup(bno)
+register block_nr bno;
+{
+  register struct buf *bp;
+
+  for (bp = hashtab[bno & (NR_HASH - 1)]; bp != 0; bp = bp->b_hash)
+	if (bp->b_bno == bno) return(bp);
+  return(0);
+}
+
+/* Take `bp' off its hash chain; it no longer holds a block. */
+unhash(bp)
+register struct buf *bp;
+{
+  register struct buf **pp;
+
+  if (bp->b_bno == NO_BLOCK) return;
+  for (pp = &hashtab[bp->b_bno & (NR_HASH - 1)]; *pp != bp; pp = &(*pp)->b_hash);
+  *pp = bp->b_hash;
+  bp->b_bno = NO_BLOCK;
+}
+
+/* Move `bp' to the front of the LRU chain. */
+touch(bp)
+register struct buf *bp;
+{
+  if (bp == front) return;
+  bp->b_prev->b_next = bp->b_next;
+  if (bp == rear)
+	rear = bp->b_prev;
+  else
+	bp->b_next->b_prev = bp->b_prev;
+  bp->b_prev = 0;
+  bp->b_next = front;
+  front->b_prev = bp;
+  front = bp;
+}
+
+/* Get a buffer for block `bno'.  If the block is not in the cache, the least
+ * recently used buffer is given to it; its contents are up to the caller.
+ */
+struct buf *getbuf(bno)
+block_nr bno;
+{
+  register struct buf *bp;
+
+  if ((bp = lookup(bno)) == 0) {
+	bp = rear;
+	unhash(bp);
+	bp->b_bno = bno;
+	bp->b_hash = hashtab[bno & (NR_HASH - 1)];
+	hashtab[bno & (NR_HASH - 1)] = bp;
+  }
+  touch(bp);
+  return(bp);
+}
+
+/* Read the `n' blocks starting at block `bno' into the cache with one read.
+ * None of them may be in the cache yet.
+ */
+fetch(bno, n)
+block_nr bno;
+{
+  register i;
+
+  if (n == 1) {
+	devio(bno, getbuf(bno)->b_data, 1, READING);
+	return;
+  }
+  devio(bno, ahead, n, READING);
+  for (i = n - 1; i >= 0; i--)
+	memmove(getbuf(bno + i)->b_data, ahead + i * BLOCK_SIZE, BLOCK_SIZE);
+}
+
+/* Forget what the cache knows about the `n' blocks starting at `bno'. */
+forget(bno, n)
+block_nr bno;
+{
+  register struct buf *bp;
+
+  while (n-- > 0)
+	if ((bp = lookup(bno++)) != 0) unhash(bp);
+}
+
+/* Return block `bno', from the cache if it is there.  When the inode list
+ * is read, the blocks after the one asked for come along, so the whole list
+ * is read in a few large pieces during the tree walk.
+ */
+char *getblock(bno)
+block_nr bno;
+{
+  register struct buf *bp;
+  register n = 1;
+
+  nlookups++;
+  if ((bp = lookup(bno)) != 0) {
+	nhits++;
+	touch(bp);
+	return(bp->b_data);
+  }
+  if (bno >= BLK_ILIST && bno < BLK_ILIST + N_ILIST)
+	while (n < nahead && bno + n < BLK_ILIST + N_ILIST &&
+	       lookup((block_nr) (bno + n)) == 0)
+		n++;
+  fetch(bno, n);
+  return(front->b_data);
+}
+
 /* Read `size' bytes from the disk starting at byte `offset'. */
 devread(offset, buf, size)
 long offset;
 char *buf;
 {
-  devio((block_nr) (offset / BLOCK_SIZE), READING);
-  memmove(buf, &rwbuf[(int) (offset % BLOCK_SIZE)], size);
+  memmove(buf, getblock((block_nr) (offset / BLOCK_SIZE)) +
+	(int) (offset % BLOCK_SIZE), size);
 }
 
 /* Write `size' bytes to the disk starting at byte `offset'. */
@@ -323,13 +523,39 @@ devwrite(offset, buf, size)
 long offset;
 char *buf;
 {
+  block_nr bno = offset / BLOCK_SIZE;
+  char *data;
+
   if (!repair) fatal("internal error (devwrite)");
-  if (size != BLOCK_SIZE) devio((block_nr) (offset / BLOCK_SIZE), READING);
-  memmove(&rwbuf[(int) (offset % BLOCK_SIZE)], buf, size);
-  devio((block_nr) (offset / BLOCK_SIZE), WRITING);
+  data = size != BLOCK_SIZE ? getblock(bno) : getbuf(bno)->b_data;
+  memmove(data + (int) (offset % BLOCK_SIZE), buf, size);
+  devio(bno, data, 1, WRITING);
   changed = 1;
 }
 
+/* End the phase of the check that is under way, if any, and start the one
+ * called `name', or none if `name' is 0.
+ */
+phase(name)
+char *name;
+{
+  struct tms tms;
+  long now;
+  clock_t cpu;
+
+  if (!timing) return;
+  time(&now);
+  times(&tms);
+  cpu = tms.tms_utime + tms.tms_stime;
+  if (nphase > 0) {
+	phreal[nphase - 1] = now - lastreal;
+	phcpu[nphase - 1] = cpu - lastcpu;
+  }
+  if (name != 0) phname[nphase++] = name;
+  lastreal = now;
+  lastcpu = cpu;
+}
+
 /* Print a string with either a singular or a plural pronoun. */
 pr(fmt, cnt, s, p)
 char *fmt, *s, *p;
@@ -515,17 +741,12 @@ unsigned *allocbitmap(nblk)
   return(bitmap);
 }
 
-/* Load the bitmap starting at block `bno' from disk. */
+/* Load the bitmap starting at block `bno' from disk, in one go. */
 loadbitmap(bitmap, bno, nblk)
 unsigned *bitmap;
 block_nr bno;
 {
-  register i;
-  register unsigned *p;
-
-  p = bitmap;
-  for (i = 0; i < nblk; i++, bno++, p += INTS_PER_BLOCK)
-	devread(btoa(bno), (char *) p, BLOCK_SIZE);
+  devio(bno, (char *) bitmap, nblk, READING);
   *bitmap |= 1;
 }
 
@@ -534,11 +755,10 @@ dumpbitmap(bitmap, bno, nblk)
 unsigned *bitmap;
 block_nr bno;
 {
-  register i;
-  register unsigned *p = bitmap;
-
-  for (i = 0; i < nblk; i++, bno++, p += INTS_PER_BLOCK)
-	devwrite(btoa(bno), (char *) p, BLOCK_SIZE);
+  if (!repair) fatal("internal error (dumpbitmap)");
+  forget(bno, nblk);
+  devio(bno, (char *) bitmap, nblk, WRITING);
+  changed = 1;
 }
 
 /* Initialize the given bitmap by setting all the bits starting at `bit'. */
@@ -1078,6 +1298,43 @@ zone_nr zno;
 	return chkindzone(ino, ip, pos, zno, level);
 }
 
+/* Bring the zones in `zlist' that chkzones will read into the cache, in
+ * the order of their zone numbers rather than of the list, so that the disk
+ * is crossed once instead of going back and forth.  Adjacent blocks are read
+ * together.  Zones past the end of the file are skipped, and at most half of
+ * the cache is filled.  Bad zone numbers are left to markzone.
+ */
+prefetch(ip, pos, zlist, len, level)
+d_inode *ip;
+off_t pos;
+zone_nr *zlist;
+{
+  zone_nr sorted[CINDIR];
+  register i, j, run = 0;
+  register zone_nr z;
+  block_nr b, start;
+  int n = 0, max = nbuf / 2 / SCALE;
+
+  if (nahead < 2) return;
+  for (i = 0; i < len && pos < ip->i_size && n < max; i++) {
+	pos += jump(level);
+	if ((z = zlist[i]) < FIRST || z >= sb.s_nzones) continue;
+	for (j = n++; j > 0 && sorted[j - 1] > z; j--) sorted[j] = sorted[j - 1];
+	sorted[j] = z;
+  }
+  for (i = 0; i < n; i++)
+	for (b = ztob(sorted[i]), j = 0; j < SCALE; b++, j++) {
+		if (run > 0 && b >= start && b < start + run) continue;
+		if (lookup(b) != 0) continue;
+		if (run > 0 && (b != start + run || run == nahead)) {
+			fetch(start, run);
+			run = 0;
+		}
+		if (run++ == 0) start = b;
+	}
+  if (run > 0) fetch(start, run);
+}
+
 /* Check a list of zones given by `zlist'. */
 chkzones(ino, ip, pos, zlist, len, level)
 ino_t ino;
@@ -1087,6 +1344,8 @@ zone_nr *zlist;
 {
   register ok = 1, i;
 
+  if (level > 0 || (ip->i_mode & I_TYPE) == I_DIRECTORY)
+	prefetch(ip, *pos, zlist, len, level);
   for (i = 0; i < len && *pos < ip->i_size; i++)
 	if (zlist[i] == NO_ZONE)
 		*pos += jump(level);
@@ -1270,6 +1529,20 @@ printtotal()
   pr("%6u    Free zone%s\n", nfreezone, "", "s");
 }
 
+/* Print the time each phase took, and how well the cache did. */
+printtimes()
+{
+  register i;
+
+  printf("\n   real      cpu  phase\n");
+  for (i = 0; i < nphase; i++)
+	printf("%6lds %5ld.%02lds  %s\n", phreal[i],
+	       phcpu[i] / CLOCKS_PER_SEC,
+	       phcpu[i] % CLOCKS_PER_SEC * 100 / CLOCKS_PER_SEC, phname[i]);
+  printf("%ld transfers of %ld blocks, ", nios, nioblocks);
+  printf("%ld of %ld lookups hit the %d block cache\n", nhits, nlookups, nbuf);
+}
+
 /* Check the device which name is given by `f'.  The inodes listed by `clist'
  * should be listed separately, and the inodes listed by `ilist' and the zones
  * listed by `zlist' should be watched for while checking the file system.
@@ -1284,6 +1557,7 @@ char *f, **clist, **ilist, **zlist;
 
   devopen();
 
+  phase("super block");
   getsuper();
   chksuper();
 
@@ -1297,15 +1571,24 @@ char *f, **clist, **ilist, **zlist;
   fillbitmap(spec_zmap, (bit_nr) FIRST, (bit_nr) sb.s_nzones, zlist);
 
   getcount();
+  getcache();
+  phase("tree");
   chktree();
+  phase("zone map");
   chkmap(zmap, spec_zmap, (bit_nr) FIRST - 1, BLK_ZMAP, N_ZMAP,
          (bit_nr) sb.s_nzones, "zone");
+  phase("link counts");
   chkcount();
+  phase("inode map");
   chkmap(imap, spec_imap, (bit_nr) 0, BLK_IMAP, N_IMAP,
          (bit_nr) sb.s_ninodes + 1, "inode");
+  phase("inode list");
   chkilist();
+  phase((char *) 0);
   printtotal();
+  if (timing) printtimes();
 
+  putcache();
   putbitmaps();
   freecount();
   devclose();
@@ -1343,6 +1626,7 @@ char **argv;
 		    case 'r':	repair ^= 1;	break;
 		    case 'l':	listing ^= 1;	break;
 		    case 's':	listsuper ^= 1;	break;
+		    case 't':	timing ^= 1;	break;
 		    default:
 			printf("%s: unknown flag '%s'\n", prog, arg);
 		}
@@ -1354,7 +1638,7 @@ char **argv;
 		devgiven = 1;
 	}
   if (!devgiven) {
-	printf("Usage: fsck [-acilrsz] file\n");
+	printf("Usage: fsck [-acilrstz] file\n");
 	exit(1);
   }
   return(0);
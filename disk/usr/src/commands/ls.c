@@ -41,6 +41,7 @@
  */
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <treewalk.h>
 #include <errno.h>
 #include <limits.h>
 #include <dirent.h>
@@ -254,7 +255,7 @@ char stringerr[] = "ls: out of string space\n";
 
 /*@ These are the forward declarations for the files table section. */
 void add_file(			/* char *filename, struct lsfile *parent,
-            ino_t inum, int savename */ );
+            ino_t inum, int savename, struct stat *stp */ );
 char *pathname( 	/* struct lsfile *entry */ );
 
 /*@ The |add_args()| function is used to add the files specified
@@ -266,52 +267,59 @@ int argc;
 char *argv[];
 {
   if (argc == 1)
-	add_file(".", (struct lsfile *) NULL, 0, 0);
+	add_file(".", (struct lsfile *) NULL, 0, 0, (struct stat *) NULL);
   else
 	while (++argv, --argc) {
-		add_file(*argv, (struct lsfile *) NULL, 0, 0);
+		add_file(*argv, (struct lsfile *) NULL, 0, 0,
+			 (struct stat *) NULL);
 	}
 }
 
 
-/*@ |add_dir()| opens a directory and adds the files it contains to the
+/*@ |add_dir()| reads a directory and adds the files it contains to the
  * files table. If "dot-files" are not being listed, they will be
- * omitted.
+ * omitted. When the files have to be |stat()|ed, |tw_read()| does it
+ * for the whole directory at once, in the order of the inode numbers.
  */
 void add_dir(entry)
 struct lsfile *entry;
 {
-  DIR *dirp;
-  struct dirent *dp;
+  struct twdir td;
+  register struct twent *tp;
   struct lsfile *parent = NULL;
 
   if (strcmp(entry->f_name, ".") != 0)	/* "./" is redundant */
 	parent = entry;
 
-  if ((dirp = opendir(pathname(entry))) == NULL) {
+  if (tw_read(&td, pathname(entry), (flags_a ? TW_DOTS : 0) |
+					(stateach ? TW_STAT : 0)) < 0) {
 	fprintf(stderr, "ls: can't open directory %s\n", pathname(entry));
 	perror("ls");
 	return;
   }
-  while ((dp = readdir(dirp)) != NULL) {
-	if (dp->d_name[0] == '.' && !(flags_A || flags_a)) continue;
-	if (DOTDIR(dp->d_name) && !flags_a) continue;
-	add_file(dp->d_name, parent, (ino_t) dp->d_ino, 1);
+  for (tp = td.tw_ent; tp < td.tw_ent + td.tw_count; tp++) {
+	if (tp->tw_name[0] == '.' && !(flags_A || flags_a)) continue;
+	if (DOTDIR(tp->tw_name) && !flags_a) continue;
+	add_file(tp->tw_name, parent, tp->tw_ino, 1,
+		 stateach && tp->tw_errno == 0 ? &tp->tw_stat
+					       : (struct stat *) NULL);
   }
 
-  (void) closedir(dirp);
+  tw_free(&td);
 }
 
 /*@ |add_file()| does the actual work of entering files into the table.
  * If it is necessary to save the name in the string table, this is
- * done. Also, if it is necessary to |stat()| the file, we do it here.
+ * done. Also, if it is necessary to |stat()| the file, we do it here,
+ * unless the caller already has the status in |stp|.
  */
 
-void add_file(filename, parent, inum, savename)
+void add_file(filename, parent, inum, savename, stp)
 char *filename;
 struct lsfile *parent;
 ino_t inum;
 int savename;
+struct stat *stp;
 {
   if (filep - files >= NFILE) {
 	fprintf(stderr, "ls: too many files\n");
@@ -335,7 +343,9 @@ int savename;
 
   sortindex[filep - files] = filep;
 
-  if (stateach)
+  if (stp != NULL)
+	filep->f_stat = *stp;
+  else if (stateach)
 	if (stat(pathname(filep), &filep->f_stat) < 0) {
 		int saverrno = errno;
 		fprintf(stderr, "ls: cannot stat %s", pathname(filep));
@@ -709,41 +719,20 @@ struct lsfile **two;
 
 /*@*User and group id's.
  * |owner()| and |groupname()| are used to translate user and group
- * id's to names for the long-format listing. The last id translated
- * is cached.
+ * id's to names for the long-format listing. The password and group
+ * files are read once by |tw_user()| and |tw_group()|, which keep all
+ * the names.
  */
 char *owner(uid)
 int uid;
 {
-  static int ouid = -1;
-  static char uname[16];
-  struct passwd *pw, *getpwuid( /* int uid */ );
-
-  if (uid == ouid) return uname;
-
-  if ((pw = getpwuid(uid)) == NULL)
-	sprintf(uname, "%d", uid);
-  else
-	strcpy(uname, pw->pw_name);
-
-  return uname;
+  return tw_user(uid);
 }
 
 char *groupname(gid)
 int gid;
 {
-  static int ogid = -1;
-  static char gname[16];
-  struct group *gr, *getgrgid( 	/* int gid */ );
-
-  if (gid == ogid) return gname;
-
-  if ((gr = getgrgid(gid)) == NULL)
-	sprintf(gname, "%d", gid);
-  else
-	strcpy(gname, gr->gr_name);
-
-  return gname;
+  return tw_group(gid);
 }
 
 /*@*Date and time. |prdate()| prints the specified time in the format used by
@@ -33,13 +33,14 @@ void prt()
 
   register int   		i;
 
-  for (mp = macrohead; mp; mp = mp->m_next)
-	printf("%s = %s\n", mp->m_name, mp->m_val);
+  for (i = 0; i < NHASH; i++)
+	for (mp = macrotab[i]; mp; mp = mp->m_next)
+		printf("%s = %s\n", mp->m_name, mp->m_val);
 
   putchar('\n');
 
-  for (i = 0; i <= maxsuffarray ; i++)
-	    for (np = suffparray[i]->n_next; np; np = np->n_next)
+  for (i = 0; i < NHASH; i++)
+	    for (np = nametab[i]; np; np = np->n_next)
 	    {
 		if (np->n_flag & N_DOUBLE)
 			printf("%s::\n", np->n_name);
@@ -68,7 +69,8 @@ void prt()
 
 
 /*
- *	Recursive routine that does the actual checking.
+ *	Recursive routine that does the actual checking.  A name
+ *	found to lead to no circle is not gone through again.
  */
 void check(np)
 struct name *np;
@@ -77,6 +79,8 @@ struct name *np;
   register struct line   *lp;
 
 
+	if (np->n_state & S_CHECK)
+		return;
 	if (np->n_flag & N_MARK)
 		fatal("Circular dependency from %s", np->n_name,0);
 
@@ -87,6 +91,7 @@ struct name *np;
 			check(dp->d_name);
 
 	np->n_flag &= ~N_MARK;
+	np->n_state |= S_CHECK;
 }
 
 
@@ -103,8 +108,8 @@ void circh()
   register int          i;
 
 
-  for (i = 0; i <= maxsuffarray ; i++)
-	   for (np = suffparray[i]->n_next; np; np = np->n_next)
+  for (i = 0; i < NHASH; i++)
+	   for (np = nametab[i]; np; np = np->n_next)
 		check(np);
 }
 
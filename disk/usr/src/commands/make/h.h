@@ -112,6 +112,8 @@ struct DOSTIME {short time,date; };     /* time structure of TOS */
 #define LZ1	(2048)		/*  Initial input/expand string size  */
 #define LZ2	(256)		/*  Initial input/expand string size  */
 
+#define NHASH	(128)		/*  Hash chains for names and macros  */
+
 
 
 /*
@@ -120,11 +122,14 @@ struct DOSTIME {short time,date; };     /* time structure of TOS */
 
 struct name
 {
-  struct name  *n_next;		/* Next in the list of names */
+  struct name  *n_next;		/* Next in its hash chain */
   char         *n_name;		/* Called */
   struct line  *n_line;		/* Dependencies */
   time_t        n_time;		/* Modify time of this name */
   uchar         n_flag;		/* Info about the name */
+  uchar         n_state;	/* How far make() got with it */
+  char         *n_base;		/* $* while it waits for jobs */
+  char         *n_input;	/* $< while it waits for jobs */
 };
 
 #define N_MARK    0x01			/* For cycle check */
@@ -136,6 +141,13 @@ struct name
 #define N_ERROR   0x40			/* Error occured */
 #define N_EXEC    0x80			/* Commands executed */
 
+#define S_SEEN    0x01			/* Looked at by make() before */
+#define S_RUN     0x02			/* Its commands are running */
+#define S_TIME    0x04			/* modtime() done */
+#define S_CHECK   0x08			/* No circle from here */
+
+#define MAXJOBS   8			/* Most jobs at once (-j) */
+
 /*
  *	Definition of a target line.
  */
@@ -172,7 +184,7 @@ struct	cmd
  */
 struct	macro
 {
-  struct macro *m_next;	/* Next variable */
+  struct macro *m_next;	/* Next in its hash chain */
   char *m_name;		/* Called ... */
   char *m_val;		/* Its value */
   uchar m_flag;		/* Infinite loop check */
@@ -219,15 +231,14 @@ EXTERN bool  quest    INIT(FALSE); /*  Question up-to-dateness of file  */
 EXTERN bool  useenv   INIT(FALSE); /*  Env. macro def. overwrite makefile def.*/
 EXTERN bool  dbginfo  INIT(FALSE); /*  Print lot of debugging information */
 EXTERN bool  ambigmac INIT(FALSE); /*  guess undef. ambiguous macros (*,<) */
+EXTERN int   jobs     INIT(1);     /*  Commands run at once (-j)  */
 EXTERN struct name  *firstname;
 EXTERN char         *str1;
 EXTERN char         *str2;
 EXTERN struct str    str1s;
 EXTERN struct str    str2s;
-EXTERN struct name **suffparray; /* ptr. to array of ptrs. to name chains */
-EXTERN int           sizesuffarray INIT(20); /* size of suffarray */
-EXTERN int           maxsuffarray INIT(0);   /* last used entry in suffarray */
-EXTERN struct macro *macrohead;
+EXTERN struct name  *nametab[NHASH];  /* names, by hash() of name */
+EXTERN struct macro *macrotab[NHASH]; /* macros, by hash() of name */
 EXTERN bool          expmake; /* TRUE if $(MAKE) has been expanded */
 EXTERN int           lineno;
 
@@ -289,6 +300,8 @@ void           precious PARMS (());
 /* input.c */
 void           init PARMS (());
 void           strrealloc PARMS (( struct str *));
+unsigned       hash PARMS (( char *));
+struct name   *findname PARMS (( char *));
 struct name   *newname  PARMS (( char *));
 struct name   *testname PARMS (( char *));
 struct depend *newdep PARMS (( struct name *, struct depend *));
@@ -319,6 +332,9 @@ void           modtime PARMS (( struct name *));
 void           touch PARMS (( struct name *));
 int            make PARMS (( struct name *, int));
 void           make1 PARMS (( struct name *, struct line *, struct depend *,char *, char *));
+int            maketop PARMS (( struct name *));
+void           startjob PARMS (( struct name *, struct line *));
+void           waitjob PARMS (());
 void           implmacros PARMS (( struct name *, struct line *, char **,char **));
 void           dbgprint PARMS (( int, struct name *, char *));
 /* reader.c */
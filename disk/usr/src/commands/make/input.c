@@ -22,19 +22,11 @@
 #include "h.h"
 
 
-static struct name *lastrrp;
-static struct name *freerp = (struct name *)NULL;
+static struct name **lastrrp;	/* Where newname() put a new name */
+static struct name  *freerp = (struct name *)NULL;
 
 void init()
 {
-  if( (suffparray = (struct name **) malloc( sizesuffarray *
-           sizeof(struct name *)))  == (struct name **) NULL)
-     fatal("No memory for suffarray",(char *)0,0);
-  if ((*suffparray = (struct name *)malloc(sizeof (struct name)))
-                          == (struct name *)0)
-     fatal("No memory for name",(char *)0,0);
-  (*suffparray)->n_next = (struct name *)0;
-
   if ((str1 = malloc(LZ1)) == (char *)0)
      fatal("No memory for str1",(char *)0,0);
   str1s.ptr = &str1;
@@ -53,47 +45,45 @@ struct str *strs;
        fatal("No memory for string reallocation",(char *)0,0);
 }
 
+/*
+ *	Hash a name or macro name: the chain it is on in nametab or macrotab
+ */
+unsigned hash(s)
+register char *s;
+{
+  register unsigned h = 0;
+
+  while (*s)
+     h = (h << 5) - h + (uchar)*s++;	/* h * 31 + c */
+  return h & (NHASH-1);
+}
+
+/*
+ *	Find a name.  Return a pointer to the name struct, or NULL
+ *	if there is none.
+ */
+struct name *findname(name)
+char *name;
+{
+  register struct name *rp;
+
+  for (rp = nametab[hash(name)]; rp; rp = rp->n_next)
+     if (strcmp(name, rp->n_name) == 0)  return rp;
+  return (struct name *)0;
+}
+
 /*
  *	Intern a name.  Return a pointer to the name struct
  */
 struct name *newname(name)
 char *name;
 {
-  register struct name *rp;
-  register struct name *rrp;
-  register char        *cp;
-
-  register int           i;
-  register char         *suff;   /* ptr. to suffix in current name */
-  register struct name **sp;     /* ptr. to ptr. to chain of names */
-
-  if ( (suff = suffix(name)) != (char *)NULL) {
-     for (i = 1, sp = suffparray, sp++;
-          i <= maxsuffarray && strcmp(suff, (*sp)->n_name) != 0;
-          sp++,i++);
-     if (i > maxsuffarray) {
-        if ( i >= sizesuffarray) { /* must realloc suffarray */
-           sizesuffarray *= 2;
-           if( (suffparray = (struct name **) realloc((char *) suffparray,
-                sizesuffarray * sizeof(struct name *))) == (struct name **) NULL)
-              fatal("No memory for suffarray",(char *)0,0);
-        }
-        maxsuffarray++;
-        sp = &suffparray[i];
-        if ((*sp = (struct name *)malloc(sizeof (struct name)))
-                                   == (struct name *)0)
-           fatal("No memory for name",(char *)0,0);
-        (*sp)->n_next = (struct name *)0;
-        if ((cp = malloc(strlen(suff)+1)) == (char *)0)
-           fatal("No memory for name",(char *)0,0);
-        strcpy(cp, suff);
-        (*sp)->n_name = cp;
-     }
-  }
-  else
-     sp = suffparray;
+  register struct name  *rp;
+  register struct name **hp;
+  register char         *cp;
 
-  for ( rp = (*sp)->n_next, rrp = *sp; rp; rp = rp->n_next, rrp = rrp->n_next )
+  hp = &nametab[hash(name)];
+  for (rp = *hp; rp; rp = rp->n_next)
      if (strcmp(name, rp->n_name) == 0)  return rp;
 
   if ( freerp ==  (struct name *)NULL) {
@@ -104,8 +94,8 @@ char *name;
      rp = freerp;
      freerp =  (struct name *)NULL;
   }
-  rrp->n_next = rp;
-  rp->n_next = (struct name *)0;
+  rp->n_next = *hp;
+  *hp = rp;
   if ((cp = malloc(strlen(name)+1)) == (char *)0)
      fatal("No memory for name",(char *)0,0);
   strcpy(cp, name);
@@ -113,7 +103,8 @@ char *name;
   rp->n_line = (struct line *)0;
   rp->n_time = (time_t)0;
   rp->n_flag = 0;
-  lastrrp = rrp;
+  rp->n_state = 0;
+  lastrrp = hp;
 
   return rp;
 }
@@ -129,16 +120,17 @@ char *name;
 {
   register struct name *rp;
 
-  lastrrp = (struct name *)NULL;
+  lastrrp = (struct name **)NULL;
   rp = newname( name);
   if (rp->n_line || rp->n_flag & N_EXISTS)
      return(rp);
-  modtime(rp);
+  if (!(rp->n_state & S_TIME))
+     modtime(rp);
   if (rp->n_flag & N_EXISTS)
      return(rp);
-  if (lastrrp != (struct name *)NULL) {
+  if (lastrrp != (struct name **)NULL) {	/*  Still first on its chain  */
      free (rp->n_name);
-     lastrrp->n_next = (struct name *)NULL;
+     *lastrrp = rp->n_next;
      freerp = rp;
   }
   return((struct name *)NULL);
@@ -28,7 +28,7 @@ char *name;
 {
   register struct macro *rp;
 
-  for (rp = macrohead; rp; rp = rp->m_next)
+  for (rp = macrotab[hash(name)]; rp; rp = rp->m_next)
 		if (strcmp(name, rp->m_name) == 0)
 			return rp;
   return (struct macro *)0;
@@ -53,14 +53,13 @@ char *val;
 {
   register struct macro *rp;
   register char         *cp;
+  unsigned               h;
 
 
 		/*  Replace macro definition if it exists  */
-  for (rp = macrohead; rp; rp = rp->m_next)
-	if (strcmp(name, rp->m_name) == 0) {
+  if (rp = getmp(name)) {
 		if(rp->m_flag & M_OVERRIDE) return rp;	/* mustn't change */
 		free(rp->m_val);	/*  Free space from old  */
-		break;
 		}
 
 	if (!rp)		/*  If not defined, allocate space for new  */
@@ -69,8 +68,8 @@ char *val;
 					 == (struct macro *)0)
 			fatal("No memory for macro",(char *)0,0);
 
-		rp->m_next = macrohead;
-		macrohead = rp;
+		rp->m_next = macrotab[h = hash(name)];
+		macrotab[h] = rp;
 		rp->m_flag = FALSE;
 
 		if ((cp = malloc(strlen(name)+1)) == (char *)0)
@@ -27,6 +27,7 @@
  *	-e environment macro def. overwrite makefile def.
  *	-f makefile name
  *	-i ignore exit status
+ *	-j run up to N jobs at once
  *	-k continue on errors
  *	-n pretend to make
  *	-p print all macros & targets
@@ -102,6 +103,15 @@ char **argv;
 				}
 				makefile = p;
 				goto end_of_args;
+			case 'j':	/*  Jobs at once  */
+				if (*++p == '\0') {
+					--argc;
+					if (targc-- == 0)
+						usage();
+					p = *targv++;
+				}
+				jobs = atoi(p);
+				goto end_of_args;
 #ifdef eon
 			case 'm':	/*  Change space requirements  */
 				if (*++p == '\0') {
@@ -130,6 +140,11 @@ char **argv;
   *p = '\0';
   putenv(makeflags);
 
+  if (jobs > MAXJOBS)
+	jobs = MAXJOBS;
+  if (jobs < 1 || !domake || quest || dotouch)
+	jobs = 1;	/*  Nothing worth doing at once  */
+
 
 #ifdef eon
   if (initalloc(memspace) == 0xffff)  /*  Must get memory for alloc  */
@@ -192,10 +207,10 @@ char **argv;
   circh();	/*  Check circles in target definitions  */
 
   if (!argc)
-	estat = make(firstname, 0);
+	estat = maketop(firstname);
   else
 	while (argc--) {
-		estat |= make(newname(*argv++), 0);
+		estat |= maketop(newname(*argv++));
 	}
 
   if (quest)
@@ -265,6 +280,7 @@ void usage()
   fprintf(stderr, "          -e : environment macro def. overwrite makefile def.\n");
   fprintf(stderr, "          -f filename : makefile name (default: makefile, Makefile)\n");
   fprintf(stderr, "          -i : ignore exit status of executed commands\n");
+  fprintf(stderr, "          -j n : run up to n commands at once\n");
   fprintf(stderr, "          -k : continue with unrelated branches on errors\n");
   fprintf(stderr, "          -n : pretend to make\n");
   fprintf(stderr, "          -p : print all macros & targets\n");
@@ -25,6 +25,21 @@
 
 static bool  execflag;
 
+/*
+ *	Jobs running with -j.  Each job runs the commands of one target
+ *	in a child of its own, with all their output going to a file of
+ *	its own, which is copied out when the job is done.
+ */
+static struct job
+{
+  int           j_pid;		/* Child running it, 0 if slot free */
+  struct name  *j_name;		/* Target being made */
+  char          j_out[24];	/* File with its output */
+} jobtab[MAXJOBS];
+static int   njobs;		/* Jobs running */
+static bool  jobfail;		/* A job failed; stop starting more */
+static char  jobbuf[512];	/* For copying out job output */
+
 /*
  *	Exec a shell that returns exit status correctly (/bin/esh).
  *	The standard EON shell returns the process number of the last
@@ -123,6 +138,7 @@ struct line *lp;
 		printf("\n");
 
 	if (domake || expmake) {	/*  Get the shell to execute it  */
+		fflush(stdout);
 		if ((estat = dosh(q, shell)) != 0) {
 		    if (estat == -1)
 			fatal("Couldn't execute %s", shell,0);
@@ -152,6 +168,120 @@ struct name *np;
 	docmds1(np, lp);
 }
 
+
+/*
+ *	Start a job to do the commands of a target (-j).  A target
+ *	without commands needs no job.  If all jobs are busy, wait
+ *	for one first.
+ */
+void startjob(np, lp)
+struct name *np;
+struct line *lp;
+{
+  register struct job  *jp;
+  register struct line *llp;
+  int                   fd;
+
+  for (llp = lp ? lp : np->n_line; llp; llp = lp ? (struct line *)0 : llp->l_next)
+	if (llp->l_cmd) break;
+  if (!llp) return;
+
+  while (njobs >= jobs) waitjob();
+  for (jp = jobtab; jp->j_pid != 0; jp++) ;
+  sprintf(jp->j_out, "/tmp/mk%d.%d", getpid(), (int)(jp - jobtab));
+  execflag = TRUE;
+  fflush(stdout);
+  fflush(stderr);
+
+  switch (jp->j_pid = fork()) {
+  case -1:
+	fatal("Couldn't fork for %s", np->n_name,0);
+  case 0:
+	if ((fd = creat(jp->j_out, 0600)) < 0) exit(2);
+	dup2(fd, 1);
+	dup2(fd, 2);
+	close(fd);
+	conterr = TRUE;		/*  Let the parent see the error  */
+	if (lp)
+		docmds1(np, lp);
+	else
+		docmds(np);
+	fflush(stdout);
+	exit((np->n_flag & N_ERROR) ? 1 : 0);
+  }
+  jp->j_name = np;
+  np->n_state |= S_RUN;
+  njobs++;
+}
+
+
+/*
+ *	Wait for a job to end, copy out what it printed, and finish
+ *	its target.  If it failed and -k is not given, let the other
+ *	jobs end too, and stop.
+ */
+static void endjob()
+{
+  register struct job  *jp;
+  register struct name *np;
+  int                   pid, status, fd, n;
+
+  do {
+	if ((pid = wait(&status)) == -1)
+		fatal("No jobs to wait for",(char *)0,0);
+	for (jp = jobtab; jp < &jobtab[MAXJOBS] && jp->j_pid != pid; jp++) ;
+  } while (jp == &jobtab[MAXJOBS]);
+
+  fflush(stdout);
+  if ((fd = open(jp->j_out, 0)) >= 0) {
+	while ((n = read(fd, jobbuf, sizeof(jobbuf))) > 0) write(1, jobbuf, n);
+	close(fd);
+	unlink(jp->j_out);
+  }
+
+  np = jp->j_name;
+  np->n_state &= ~S_RUN;
+  np->n_flag |= N_EXEC;
+  if (status != 0) {
+	np->n_flag |= N_ERROR;
+	if (!conterr) jobfail = TRUE;
+  }
+  if (!(np->n_flag & N_DOUBLE)) {
+	np->n_flag |= N_DONE;
+	time(&np->n_time);
+  }
+  jp->j_pid = 0;
+  njobs--;
+}
+
+void waitjob()
+{
+  endjob();
+  if (jobfail) {
+	while (njobs > 0) endjob();
+	exit(1);
+  }
+}
+
+
+/*
+ *	Make a target given to make.  With -j, make() may leave it
+ *	waiting for jobs; each time one ends, try again.
+ */
+int maketop(np)
+struct name *np;
+{
+  int estat;
+
+  estat = make(np, 0);
+  while (!(np->n_flag & N_DONE)) {
+	waitjob();
+	estat = make(np, 0);
+  }
+  while (njobs > 0) waitjob();
+  return estat;
+}
+
 #ifdef tos
 /*
  *      execute the command submitted by make,
@@ -350,7 +480,8 @@ time_t *tp;
 
 /*
  *	Get the modification time of a file.  If the first
- *	doesn't exist, it's modtime is set to 0.
+ *	doesn't exist, it's modtime is set to 0.  It is only
+ *	looked up once.
  */
 void modtime(np)
 struct name *np;
@@ -423,6 +554,7 @@ struct name *np;
 
   close(fd);
 #endif
+  np->n_state |= S_TIME;
 }
 
 
@@ -498,6 +630,7 @@ int          level;
   register struct depend  *qdp;
   time_t  dtime = 0;
   bool    dbgfirst     = TRUE;
+  bool    waiting      = FALSE;
   char   *basename  = (char *) 0;
   char   *inputname = (char *) 0;
 
@@ -506,26 +639,51 @@ int          level;
      if(dbginfo) dbgprint(level,np,"already done");
      return 0;
   }
+  if (np->n_state & S_RUN)
+     return 0;			/*  Its job is not done yet  */
 
-  if (!(np->n_flag & N_EXISTS))
-     modtime(np);		/*  Gets modtime of this file  */
+  if (np->n_state & S_SEEN) {	/*  Back after waiting for jobs  */
+     basename = np->n_base;
+     inputname = np->n_input;
+  }
+  else {
+     np->n_state |= S_SEEN;
+     if (!(np->n_state & S_TIME))
+        modtime(np);		/*  Gets modtime of this file  */
+
+     if (rules) {
+        for (lp = np->n_line; lp; lp = lp->l_next)
+           if (lp->l_cmd)
+              break;
+        if (!lp)
+           dyndep(np,&basename,&inputname);
+     }
 
-  if (rules) {
-     for (lp = np->n_line; lp; lp = lp->l_next)
-        if (lp->l_cmd)
-           break;
-     if (!lp)
-        dyndep(np,&basename,&inputname);
+     if (!(np->n_flag & (N_TARG | N_EXISTS))) {
+        fprintf(stderr,"%s: Don't know how to make %s\n", myname, np->n_name);
+        if (conterr) {
+           np->n_flag |= N_ERROR | N_DONE;
+           if (dbginfo) dbgprint(level,np,"don't know how to make");
+           return 0;
+        }
+        while (njobs > 0)	/*  As for a failed job  */
+           endjob();
+        exit(1);
+     }
   }
 
-  if (!(np->n_flag & (N_TARG | N_EXISTS))) {
-     fprintf(stderr,"%s: Don't know how to make %s\n", myname, np->n_name);
-     if (conterr) {
-        np->n_flag |= N_ERROR;
-        if (dbginfo) dbgprint(level,np,"don't know how to make");
+  if (jobs > 1) {
+     /*  Start on all it depends on, and wait until that is made  */
+     for (lp = np->n_line; lp; lp = lp->l_next)
+        for (dp = lp->l_dep; dp; dp = dp->d_next) {
+           make(dp->d_name, level+1);
+           if (!(dp->d_name->n_flag & N_DONE)) waiting = TRUE;
+        }
+     if (waiting) {
+        np->n_base = basename;
+        np->n_input = inputname;
         return 0;
      }
-     else  exit(1);
   }
 
   for (qdp = (struct depend *)0, lp = np->n_line; lp; lp = lp->l_next) {
@@ -545,6 +703,7 @@ int          level;
            (np->n_time < dtime || !( np->n_flag & N_EXISTS))) {
         execflag = FALSE;
         make1(np, lp, qdp, basename, inputname); /* free()'s qdp */
+        while (np->n_state & S_RUN) waitjob();
         dtime = 0;
         qdp = (struct depend *)0;
         if(execflag) np->n_flag |= N_EXEC;
@@ -564,6 +723,11 @@ int          level;
                && !(np->n_flag & N_DOUBLE)) {
      execflag = FALSE;
      make1(np, (struct line *)0, qdp, basename, inputname); /* free()'s qdp */
+     if (np->n_state & S_RUN) {	/*  Made when its job is done  */
+        np->n_flag &= ~N_DONE;
+        if (basename) free(basename);
+        return 0;
+     }
      time(&np->n_time);
      if ( execflag) np->n_flag |= N_EXEC;
   }
@@ -631,7 +795,9 @@ char        *inputname;
     setmacro("?", str1);
     setDFmacro("@", np->n_name);
 
-    if (lp)		/* lp set if doing a :: rule */
+    if (jobs > 1)
+       startjob(np, lp);
+    else if (lp)	/* lp set if doing a :: rule */
        docmds1(np, lp);
     else
        docmds(np);
@@ -72,8 +72,8 @@ char        **pinputname;
         q = suff;
         while (*p++ = *q++) ;
         /* look if the rule exists */
-        sp = newname(str1);
-        if (sp->n_flag & N_TARG) {
+        if ((sp = findname(str1)) != (struct name *)0 &&
+                                           (sp->n_flag & N_TARG)) {
            /* compose resulting dependency name */
            while (strlen(*pbasename) + strlen(newsuff)+1 >= str1s.len)
               strrealloc(&str1s);
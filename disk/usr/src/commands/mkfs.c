@@ -30,6 +30,7 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <stdlib.h>
+#include <string.h>
 #include <stdio.h>
 
 #ifndef DOS
@@ -48,6 +49,8 @@
 #define BINGRP               2
 #define BIT_MAP_SHIFT       13
 #define N_BLOCKS       0x10000L	/* must be multiple of 8 */
+#define RUN_BLOCKS           8	/* blocks written at once; a multiple of
+				 * the zone size */
 
 #ifdef DOS
    maybedefine O_RDONLY	     4	/* O_RDONLY | BINARY_BIT */
@@ -63,9 +66,15 @@ unsigned nrblocks;
 int inode_offset, nrinodes, lct = 1, disk, fd, print = 0, file = 0;
 int override = 0, simple = 0, dflag;
 int donttest;			/* skip test if it fits on medium */
+int dryrun;			/* build in a scratch file, report layout */
+int zeroed;			/* special reads back as zeros already */
+char *specname;			/* special file named on the command line */
+char scratch[] = "/tmp/mkfsXXXXXX";	/* stands in for it in a dry run */
+char path[PATH_MAX + 1];	/* path of the file being made */
 
 long current_time, bin_time;
 char zero[BLOCK_SIZE], *lastp;
+char runbuf[RUN_BLOCKS * BLOCK_SIZE];	/* file data and runs of blocks */
 char umap[(N_BLOCKS + 8) / 8];	/* bit map tells if block read yet */
 int zone_map = 3;		/* where is zone map? (depends on # inodes) */
 
@@ -107,7 +116,7 @@ char *argv[];
 	if ((statbuf.st_mode & S_IFMT) != S_IFREG) badusage = 1;
   }
   if (badusage) {
-	write(2, "Usage: mkfs [-ldt] special proto\n", 33);
+	write(2, "Usage: mkfs [-ldnt] special proto\n", 34);
 	exit(1);
   }
   while (--argc) {
@@ -125,6 +134,10 @@ char *argv[];
 				current_time = bin_time;
 				dflag = 1;
 				break;
+			    case 'n':
+			    case 'N':
+				dryrun = 1;
+				break;
 			    case 't':
 			    case 'T':
 				donttest = 1;
@@ -174,19 +187,26 @@ char *argv[];
 			simple = 1;
 		}
 
-		/* Open special */
+		/* The special is opened once all the flags are known. */
 		argc--;
-		special(argv[argc]);
+		specname = argv[argc];
 
 		nrblocks = blocks;
 		nrinodes = inodes;
 	}			/* end switch */
   }				/* end while */
 
-
+  /* A dry run builds the file system in a scratch file, without the file
+   * data, and leaves the special alone.
+   */
+  if (dryrun) {
+	printf("Layout of %s:\n", specname);
+	special(mktemp(scratch));
+  } else
+	special(specname);
 
 #ifdef UNIX
-  if (!donttest) {
+  if (!donttest && !dryrun) {
 	static short testb[BLOCK_SIZE / sizeof(short)];
 
 	/* Try writing the last block of partition or diskette. */
@@ -241,10 +261,17 @@ char *argv[];
 
   i = alloc_inode(mode, usrid, grpid);
   rootdir(i);
+  report(i, next_zone - 1);
   if (simple == 0) eat_dir(i);
 
   if (print) print_fs();
   flush();
+  if (dryrun) {
+	printf("\n%d of %u inodes and %u of %u data zones used.\n",
+	       next_inode - 1, nrinodes, next_zone - (zoff + 1),
+	       zones - (zoff + 1));
+	unlink(scratch);
+  }
   exit(0);
 
 
@@ -291,7 +318,20 @@ unsigned zones, inodes;
   put_block(1, buf);
 
   /* Clear maps and inodes. */
-  for (i = 2; i < initblks; i++) put_block(i, zero);
+  zero_blocks(2, initblks - 2);
+
+  if (dryrun) {
+	printf("\nregion        first  count\n");
+	printf("boot block        0      1\n");
+	printf("super block       1      1\n");
+	printf("inode map     %5d  %5d\n", 2, sup->s_imap_blocks);
+	printf("zone map      %5d  %5d\n", 2 + sup->s_imap_blocks,
+	       sup->s_zmap_blocks);
+	printf("inodes        %5d  %5u\n", inode_offset, inodeblks);
+	printf("data zones    %5u  %5u\n", sup->s_firstdatazone,
+	       nrzones - sup->s_firstdatazone);
+	printf("\ninode   zone  zones  file\n");
+  }
 
   next_zone = sup->s_firstdatazone;
   next_inode = 1;
@@ -399,11 +439,13 @@ eat_dir(parent)
 int parent;			/* parent's inode nr */
 {
   /* Read prototype lines and set up directory. Recurse if need be. */
-  char *token[MAX_TOKENS], *p;
+  char *token[MAX_TOKENS], *p, *end;
   char line[LINE_LEN];
-  int mode, n, usrid, grpid, z, maj, min, f;
+  int mode, n, usrid, grpid, z, maj, min, f, first;
   long size;
 
+  end = path + strlen(path);
+
   while (1) {
 	getline(line, token);
 	p = token[0];
@@ -418,6 +460,8 @@ int parent;			/* parent's inode nr */
 	/* Enter name in directory and update directory's size. */
 	enter_dir(parent, token[0], n);
 	incr_size(parent, 16L);
+	if (end + 16 <= &path[PATH_MAX]) sprintf(end, "/%.14s", token[0]);
+	first = next_zone;
 
 	/* Check to see if file is directory or special. */
 	incr_link(n);
@@ -429,6 +473,7 @@ int parent;			/* parent's inode nr */
 		enter_dir(n, "..", parent);
 		incr_link(parent);
 		incr_link(n);
+		report(n, first);
 		eat_dir(n);
 	} else if (*p == 'b' || *p == 'c') {
 		/* Special file. */
@@ -438,6 +483,7 @@ int parent;			/* parent's inode nr */
 		if (token[6]) size = atoi(token[6]);
 		size = BLOCK_SIZE * size;
 		add_zone(n, (maj << 8) | min, size, current_time);
+		report(n, first);
 	} else {
 		/* Regular file. Go read it. */
 		if ((f = open(token[4], O_RDONLY)) < 0) {
@@ -446,7 +492,9 @@ int parent;			/* parent's inode nr */
 			write(2, "\n", 1);
 		} else
 			eat_file(n, f);
+		report(n, first);
 	}
+	*end = 0;
   }
 
 }
@@ -457,30 +505,61 @@ int parent;			/* parent's inode nr */
  * 		eat_file  -  copy file to MINIX
  *===============================================================*/
 
-/* Zonesize >= blocksize */
+/* Zonesize >= blocksize.  The file is read RUN_BLOCKS blocks at a time.
+ * Its zones are allocated one after the other, so they are consecutive
+ * except where an indirect block comes between, and each piece of the file
+ * goes to the special in one or two writes.
+ */
 eat_file(inode, f)
 int inode, f;
 {
-  int z, ct, i, j, k;
-  char buf[BLOCK_SIZE];
+  int z, b, k, n, nz, zbytes, start, run;
+  char *p;
   long timeval;
   extern long file_time();
 
+  timeval = (dflag ? current_time : file_time(f));
+  zbytes = zone_size * BLOCK_SIZE;
   do {
-	for (i = 0, j = 0; i < zone_size; i++, j += ct) {
-		for (k = 0; k < BLOCK_SIZE; k++) buf[k] = 0;
-		if ((ct = read(f, buf, BLOCK_SIZE)) > 0) {
-			if (i == 0) z = alloc_zone();
-			put_block((z << zone_shift) + i, buf);
+	n = fill(f, runbuf, RUN_BLOCKS * BLOCK_SIZE);
+	nz = (n + zbytes - 1) / zbytes;
+	for (k = n; k < nz * zbytes; k++) runbuf[k] = 0;
+	run = 0;
+	for (k = 0; k < nz; k++) {
+		z = alloc_zone();
+		add_zone(inode, z,
+			 (long) (n - k * zbytes < zbytes ? n - k * zbytes : zbytes),
+			 timeval);
+		b = z << zone_shift;
+		if (run > 0 && b != start + run) {
+			write_run(start, p, run);
+			run = 0;
 		}
+		if (run == 0) {
+			start = b;
+			p = runbuf + k * zbytes;
+		}
+		run += zone_size;
 	}
-	timeval = (dflag ? current_time : file_time(f));
-	if (ct) add_zone(inode, z, (long) j, timeval);
-  } while (ct == BLOCK_SIZE);
+	if (run > 0) write_run(start, p, run);
+  } while (n == RUN_BLOCKS * BLOCK_SIZE);
   close(f);
 }
 
 
+int fill(f, buf, size)
+int f, size;
+char *buf;
+{
+  /* Read from f until buf is full or the file ends. */
+  int got, ct;
+
+  for (got = 0; got < size; got += ct)
+	if ((ct = read(f, buf + got, size - got)) <= 0) break;
+  return(got);
+}
+
+
 
 
 
@@ -658,7 +737,12 @@ int alloc_zone()
   b = z << zone_shift;
   if ((b + zone_size) > nrblocks)
 	pexit("File system not big enough for all the files");
-  for (i = 0; i < zone_size; i++)
+
+  /* A block reads back as zeros until it is written (see read_and_set),
+   * and every caller writes the first block of the zone it gets, so only
+   * the rest of the zone is cleared.
+   */
+  for (i = 1; i < zone_size; i++)
 	put_block(b + i, zero);	/* give an empty zone */
   insert_bit(zone_map, z - zoff, 1);
   return(z);
@@ -791,10 +875,21 @@ char *s;
   write(2, "\n", 1);
   printf("Line %d being processed when error detected.\n", lct);
   flush();
+  if (dryrun) unlink(scratch);
   exit(2);
 }
 
 
+report(n, first)
+int n, first;
+{
+  /* In a dry run, tell where inode n, just made, and its zones went. */
+
+  if (dryrun) printf("%5d  %5d  %5d  %s\n", n, first, next_zone - first,
+	       *path != 0 ? path : "/");
+}
+
+
 copy(from, to, count)
 char *from, *to;
 int count;
@@ -1052,6 +1147,31 @@ flush()
 
 
 
+write_run(n, buf, count)
+int n, count;
+char *buf;
+{
+  /* Write 'count' blocks of file data starting at block n. */
+
+  if (dryrun) return;
+  while (count-- > 0) {
+	put_block(n++, buf);
+	buf += BLOCK_SIZE;
+  }
+}
+
+
+
+zero_blocks(n, count)
+int n, count;
+{
+  /* Clear 'count' blocks starting at block n. */
+
+  while (count-- > 0) put_block(n++, zero);
+}
+
+
+
 /*==================================================================
  *			hard read & write etc.
  *=================================================================*/
@@ -1139,29 +1259,98 @@ char *s;
 
 #ifdef UNIX
 
+#define NR_CACHE	16	/* blocks kept in core */
+
+/* The blocks most recently used are kept in a cache, and a block that is
+ * written stays there until its buffer is needed for another block, so the
+ * bit maps and the block of the inode table in use are changed in core many
+ * times but written once.  File data does not go through the cache; it is
+ * written by write_run() in as few pieces as its zones allow.
+ */
+struct cache {
+  char blockbuf[BLOCK_SIZE];
+  int blocknum;
+  int dirty;
+  long usetime;			/* when last used */
+} cache[NR_CACHE];
+
+long usecount;			/* clock for usetime */
+
+
+
 special(string)
 char *string;
 {
+  struct stat statbuf;
+
   fd = creat(string, 0777);
   close(fd);
   fd = open(string, O_RDWR);
   if (fd < 0) pexit("Can't open special file");
+  if (fstat(fd, &statbuf) < 0) return;
+
+  /* Creat() has emptied a regular file, so it reads back as zeros. */
+  zeroed = (statbuf.st_mode & S_IFMT) == S_IFREG;
 #if (MACHINE == ATARI)
-  {
-	struct stat statbuf;
+  isdev = (statbuf.st_mode & S_IFMT) == S_IFCHR
+	||
+	(statbuf.st_mode & S_IFMT) == S_IFBLK
+	;
+#endif
+}
 
-	if (fstat(fd, &statbuf) < 0)
-		return;
-	isdev = (statbuf.st_mode & S_IFMT) == S_IFCHR
-		||
-		(statbuf.st_mode & S_IFMT) == S_IFBLK
-		;
+
+
+write_blocks(n, buf, count)
+int n, count;
+char *buf;
+{
+  /* Write 'count' blocks starting at block n, with one write. */
+
+  if (lseek(fd, (long) n * BLOCK_SIZE, SEEK_SET) < 0L) {
+	pexit("put_block couldn't seek");
+  }
+  if (write(fd, buf, count * BLOCK_SIZE) != count * BLOCK_SIZE) {
+	pexit("put_block couldn't write");
   }
-#endif
 }
 
 
 
+struct cache *lookup(n)
+int n;
+{
+  /* Find block n in the cache. */
+  struct cache *bp;
+
+  for (bp = cache; bp < &cache[NR_CACHE]; bp++)
+	if (bp->blocknum == n) return(bp);
+  return((struct cache *) 0);
+}
+
+
+
+struct cache *grab(n)
+int n;
+{
+  /* Find block n in the cache, or give it the least recently used buffer,
+   * writing the block that was there first if it has been changed.
+   */
+  struct cache *bp, *fp;
+
+  if ((bp = lookup(n)) == 0) {
+	for (bp = cache, fp = cache; fp < &cache[NR_CACHE]; fp++)
+		if (fp->usetime < bp->usetime) bp = fp;
+	if (bp->dirty) {
+		bp->dirty = 0;
+		write_blocks(bp->blocknum, bp->blockbuf, 1);
+	}
+	bp->blocknum = -1;
+  }
+  bp->usetime = ++usecount;
+  return(bp);
+}
+
 
 
 get_block(n, buf)
@@ -1170,18 +1359,22 @@ char buf[BLOCK_SIZE];
 {
 /* Read a block. */
 
-  int k;
+  struct cache *bp;
 
   /* First access returns a zero block */
   if (read_and_set(n) == 0) {
 	copy(zero, buf, BLOCK_SIZE);
 	return;
   }
-  lseek(fd, (long) n * BLOCK_SIZE, SEEK_SET);
-  k = read(fd, buf, BLOCK_SIZE);
-  if (k != BLOCK_SIZE) {
-	pexit("get_block couldn't read");
+  bp = grab(n);
+  if (bp->blocknum != n) {
+	lseek(fd, (long) n * BLOCK_SIZE, SEEK_SET);
+	if (read(fd, bp->blockbuf, BLOCK_SIZE) != BLOCK_SIZE) {
+		pexit("get_block couldn't read");
+	}
+	bp->blocknum = n;
   }
+  copy(bp->blockbuf, buf, BLOCK_SIZE);
 }
 
 
@@ -1192,29 +1385,94 @@ char buf[BLOCK_SIZE];
 {
 /* Write a block. */
 
+  struct cache *bp;
+
   read_and_set(n);
+  bp = grab(n);
+  bp->blocknum = n;
+  copy(buf, bp->blockbuf, BLOCK_SIZE);
+  bp->dirty = 1;
+}
 
-  if (lseek(fd, (long) n * BLOCK_SIZE, SEEK_SET) < 0L) {
-	pexit("put_block couldn't seek");
+
+
+write_run(n, buf, count)
+int n, count;
+char *buf;
+{
+  /* Write 'count' blocks of file data starting at block n.  They are new
+   * blocks, but a copy in the cache (the rest of a zone cleared by
+   * alloc_zone) must not be written over them later.  Nothing is written
+   * in a dry run.
+   */
+  struct cache *bp;
+  int i;
+
+  if (dryrun) return;
+  for (i = 0; i < count; i++) {
+	read_and_set(n + i);
+	if ((bp = lookup(n + i)) != 0) {
+		bp->blocknum = -1;
+		bp->dirty = 0;
+	}
   }
-  if (write(fd, buf, BLOCK_SIZE) != BLOCK_SIZE) {
-	pexit("put_block couldn't write");
+  write_blocks(n, buf, count);
+}
+
+
+
+zero_blocks(n, count)
+int n, count;
+{
+  /* Clear 'count' blocks starting at block n, RUN_BLOCKS at a time, unless
+   * the special reads back as zeros already.  The blocks are not marked
+   * as read, so get_block() hands out zeros for them without reading.
+   */
+  int i;
+
+  if (zeroed) return;
+  for (i = 0; i < RUN_BLOCKS * BLOCK_SIZE; i++) runbuf[i] = 0;
+  for (; count > 0; n += i, count -= i) {
+	i = (count < RUN_BLOCKS ? count : RUN_BLOCKS);
+	write_blocks(n, runbuf, i);
   }
 }
 
 
-/* Dummy routines to keep source file clean from #ifdefs */
 
 flush()
 {
-  return;
+  /* Write all changed blocks in order of block number, each run of
+   * consecutive blocks with one write.  This is done at the end only, so
+   * runbuf is free.
+   */
+  struct cache *bp, *fp;
+  int count;
+
+  while (1) {
+	fp = 0;
+	for (bp = cache; bp < &cache[NR_CACHE]; bp++)
+		if (bp->dirty && (fp == 0 || bp->blocknum < fp->blocknum))
+			fp = bp;
+	if (fp == 0) return;
+	count = 0;
+	while (count < RUN_BLOCKS
+	       && (bp = lookup(fp->blocknum + count)) != 0 && bp->dirty) {
+		copy(bp->blockbuf, runbuf + count * BLOCK_SIZE, BLOCK_SIZE);
+		bp->dirty = 0;
+		count++;
+	}
+	write_blocks(fp->blocknum, runbuf, count);
+  }
 }
 
 
 
 cache_init()
 {
-  return;
+  struct cache *bp;
+
+  for (bp = cache; bp < &cache[NR_CACHE]; bp++) bp->blocknum = -1;
 }
 
 #endif
@@ -167,7 +167,10 @@ extern	char	*elinep;
  * other functions
  */
 int	(*inbuilt())();	/* find builtin command */
+int	(*incommand())();	/* find command the shell does itself */
 char	*rexecve();
+char	*findcmd();	/* where a command is on $PATH */
+void	hashflush();	/* forget where commands are */
 char	*space();
 char	*getwd();
 char	*strsave();
@@ -207,6 +210,7 @@ struct	var {
 	char	*value;
 	char	*name;
 	struct	var	*next;
+	struct	var	*hnext;	/* next in hash chain */
 	char	status;
 };
 #define	COPYV	1	/* flag to setval, suggesting copy */
@@ -214,7 +218,10 @@ struct	var {
 #define	EXPORT	02	/* variable is to be exported */
 #define	GETCELL	04	/* name & value space was got with getcell */
 
+#define	NVHASH	64	/* hash chains in dictionary (power of 2) */
+
 Extern	struct	var	*vlist;		/* dictionary */
+Extern	struct	var	*vtab[NVHASH];	/* its hash chains */
 
 Extern	struct	var	*homedir;	/* home directory */
 Extern	struct	var	*prompt;	/* main prompt */
@@ -233,6 +240,7 @@ int	checkname(/* char *name */);
 int	assign(/* char *s, int copyflag */);
 void	putvlist(/* int key, int fd */);
 int	eqname(/* char *n1, char *n2 */);
+unsigned hashname(/* char *n */);
 
 /* -------- io.h -------- */
 /* io buffer */
@@ -499,6 +499,7 @@ register char *n;
 	register struct var *vp;
 	register char *cp;
 	register int c;
+	struct var **hp;
 	static struct var dummy;
 
 	if (digit(*n)) {
@@ -509,7 +510,8 @@ register char *n;
 		dummy.value = c <= dolc? dolv[c]: null;
 		return(&dummy);
 	}
-	for (vp = vlist; vp; vp = vp->next)
+	hp = &vtab[hashname(n) & (NVHASH-1)];
+	for (vp = *hp; vp; vp = vp->hnext)
 		if (eqname(vp->name, n))
 			return(vp);
 	cp = findeq(n);
@@ -527,8 +529,10 @@ register char *n;
 	setarea((char *)vp->name, 0);
 	vp->value = null;
 	vp->next = vlist;
+	vp->hnext = *hp;
 	vp->status = GETCELL;
 	vlist = vp;
+	*hp = vp;
 	return(vp);
 }
 
@@ -588,6 +592,8 @@ char *val, *name;
 	vp->name = name;
 	vp->value = val;
 	vp->status |= fl;
+	if (vp == path)
+		hashflush();	/* commands may be elsewhere now */
 }
 
 void
@@ -676,6 +682,20 @@ register char *n1, *n2;
 	return(*n2 == 0 || *n2 == '=');
 }
 
+/*
+ * hash of a name, up to `=' if there is one
+ */
+unsigned
+hashname(n)
+register char *n;
+{
+	register unsigned h;
+
+	for (h = 0; *n != '=' && *n != 0; n++)
+		h = (h << 5) - h + (*n & 0377);	/* h*31 + c */
+	return(h);
+}
+
 static char *
 findeq(cp)
 register char *cp;
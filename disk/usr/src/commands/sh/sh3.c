@@ -6,6 +6,7 @@
 #include <stddef.h>
 #include <time.h>
 #include <sys/times.h>
+#include <sys/stat.h>
 #undef NULL
 #include "sh.h"
 
@@ -41,6 +42,7 @@ static	void	brkset();
 static	void	echo();
 static	int	forkexec();
 static	int	parent();
+static	char	*hashfind();
 
 int
 execute(t, pin, pout, act)
@@ -210,7 +212,7 @@ int act;
 char **wp;
 int *pforked;
 {
-	int i, rv, (*shcom)();
+	int i, rv, (*shcom)(), (*cmdcom)();
 	int doexec();
 	register int f;
 	char *cp;
@@ -221,7 +223,7 @@ int *pforked;
 	owp = wp;
 	resetsig = 0;
 	*pforked = 0;
-	shcom = NULL;
+	shcom = cmdcom = NULL;
 	rv = -1;	/* system-detected error */
 	if (t->type == TCOM) {
 		while ((cp = *wp++) != NULL)
@@ -237,11 +239,23 @@ int *pforked;
 				;
 			return(setstatus(0));
 		}
-		else if (cp != NULL)
-			shcom = inbuilt(cp);
+		else if (cp != NULL && (shcom = inbuilt(cp)) == NULL &&
+		    (cmdcom = incommand(cp, wp)) == NULL)
+			findcmd(cp);	/* so children know where it is */
 	}
 	t->words = wp;
 	f = act;
+	/*
+	 * commands the shell does itself need
+	 * a process of their own only to be
+	 * redirected or piped, or to keep
+	 * assignments before them to themselves
+	 */
+	if (cmdcom != NULL && pin == NULL && pout == NULL &&
+	    t->ioact == NULL && (f & FEXEC) == 0 && *owp == NULL) {
+		shcom = cmdcom;
+		cmdcom = NULL;
+	}
 	if (shcom == NULL && (f & FEXEC) == 0) {
 		i = parent();
 		if (i != 0) {
@@ -292,6 +306,8 @@ int *pforked;
 	}
 	if (shcom)
 		return(setstatus((*shcom)(t)));
+	if (cmdcom)
+		exit((*cmdcom)(t));
 	/* should use FIOCEXCL */
 	for (i=FDBASE; i<NOFILE; i++)
 		close(i);
@@ -542,23 +558,32 @@ char *c, **v, **envp;
 {
 	register int i;
 	register char *sp, *tp;
+	char *hp;
 	int eacces = 0, asis = 0;
 	extern int errno;
 
 	sp = any('/', c)? "": path->value;
 	asis = *sp == '\0';
-	while (asis || *sp != '\0') {
-		asis = 0;
-		tp = e.linep;
-		for (; *sp != '\0'; tp++)
-			if ((*tp = *sp++) == ':') {
-				asis = *sp == '\0';
-				break;
-			}
-		if (tp != e.linep)
-			*tp++ = '/';
-		for (i = 0; (*tp++ = c[i++]) != '\0';)
-			;
+	hp = any('/', c)? NULL: hashfind(c);
+	while (hp != NULL || asis || *sp != '\0') {
+		if (hp != NULL) {
+			/* where it was last time; if gone, search */
+			for (tp = e.linep; (*tp++ = *hp++) != '\0';)
+				;
+			hp = NULL;
+		} else {
+			asis = 0;
+			tp = e.linep;
+			for (; *sp != '\0'; tp++)
+				if ((*tp = *sp++) == ':') {
+					asis = *sp == '\0';
+					break;
+				}
+			if (tp != e.linep)
+				*tp++ = '/';
+			for (i = 0; (*tp++ = c[i++]) != '\0';)
+				;
+		}
 		execve(e.linep, v, envp);
 		switch (errno) {
 		case ENOEXEC:
@@ -583,6 +608,113 @@ char *c, **v, **envp;
 	return(errno==ENOENT ? "not found" : "cannot execute");
 }
 
+/*
+ * Table of where commands were found on $PATH,
+ * so that they need not be looked for each time.
+ * It is emptied whenever PATH is set.
+ */
+#define	NCMDHASH	32	/* power of 2 */
+
+struct	cmd {
+	struct	cmd	*next;
+	int	hits;		/* times used since found */
+	char	*path;		/* full name; the command name follows it */
+};
+static	struct	cmd	*cmdtab[NCMDHASH];
+
+static struct cmd *
+hashlook(c)
+char *c;
+{
+	register struct cmd *cp;
+
+	for (cp = cmdtab[hashname(c) & (NCMDHASH-1)]; cp; cp = cp->next)
+		if (strcmp(cp->path + strlen(cp->path) + 1, c) == 0)
+			break;
+	return(cp);
+}
+
+/*
+ * where command `c' was found, if it is known
+ */
+static char *
+hashfind(c)
+char *c;
+{
+	register struct cmd *cp;
+
+	return((cp = hashlook(c)) != NULL? cp->path: NULL);
+}
+
+/*
+ * find command `c' on $PATH and remember where it is.
+ * NULL if it is not there, or if it is in a directory
+ * given relative to the current one, since that changes.
+ */
+char *
+findcmd(c)
+register char *c;
+{
+	register struct cmd *cp;
+	register char *sp, *tp;
+	int asis, found, n;
+	struct stat st;
+
+	if (any('/', c))
+		return(NULL);
+	if ((cp = hashlook(c)) != NULL) {
+		cp->hits++;
+		return(cp->path);
+	}
+	sp = path->value;
+	asis = *sp == '\0';
+	found = 0;
+	while (!found && (asis || *sp != '\0')) {
+		asis = 0;
+		tp = e.linep;
+		for (; *sp != '\0'; tp++)
+			if ((*tp = *sp++) == ':') {
+				asis = *sp == '\0';
+				break;
+			}
+		if (tp != e.linep)
+			*tp++ = '/';
+		for (n = 0; (*tp++ = c[n++]) != '\0';)
+			;
+		found = access(e.linep, 1) == 0 && stat(e.linep, &st) == 0 &&
+			(st.st_mode & S_IFMT) == S_IFREG;
+	}
+	if (!found || *e.linep != '/')
+		return(NULL);
+	n = strlen(e.linep);
+	if ((cp = (struct cmd *)space(sizeof(*cp) + n + strlen(c) + 2)) == NULL)
+		return(NULL);
+	setarea((char *)cp, 0);
+	cp->path = (char *)(cp + 1);
+	strcpy(cp->path, e.linep);
+	strcpy(cp->path + n + 1, c);
+	cp->hits = 1;
+	n = hashname(c) & (NCMDHASH-1);
+	cp->next = cmdtab[n];
+	cmdtab[n] = cp;
+	return(cp->path);
+}
+
+void
+hashflush()
+{
+	register struct cmd *cp, *np;
+	register int i;
+
+	for (i = 0; i < NCMDHASH; i++) {
+		for (cp = cmdtab[i]; cp != NULL; cp = np) {
+			np = cp->next;
+			xfree((char *)cp);
+		}
+		cmdtab[i] = NULL;
+	}
+}
+
 /*
  * Run the command produced by generator `f'
  * applied to stream `arg'.
@@ -1053,6 +1185,42 @@ dotimes()
 	prs("s\n");
 }
 
+/*
+ * hash [-r] [name ...]
+ * with no names, list where commands were found
+ */
+dohash(t)
+struct op *t;
+{
+	register struct cmd *cp;
+	register char **wp;
+	register int i, rv;
+
+	wp = t->words+1;
+	if (*wp == NULL) {
+		for (i = 0; i < NCMDHASH; i++)
+			for (cp = cmdtab[i]; cp != NULL; cp = cp->next) {
+				prn(cp->hits);
+				putc('\t');
+				prs(cp->path);
+				putc('\n');
+			}
+		return(0);
+	}
+	if (strcmp(*wp, "-r") == 0) {
+		hashflush();
+		wp++;
+	}
+	rv = 0;
+	for (; *wp != NULL; wp++)
+		if (!any('/', *wp) && findcmd(*wp) == NULL) {
+			prs(*wp);
+			prs(": not found\n");
+			rv = 1;
+		}
+	return(rv);
+}
+
 struct	builtin {
 	char	*command;
 	int	(*fn)();
@@ -1077,6 +1245,7 @@ static struct	builtin	builtin[] = {
 	"login",	dologin,
 	"newgrp",	dologin,
 	"times",	dotimes,
+	"hash",		dohash,
 	0,
 };
 
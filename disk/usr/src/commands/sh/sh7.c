@@ -0,0 +1,649 @@
+#define Extern extern
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <signal.h>
+#include <errno.h>
+#include <setjmp.h>
+#include <limits.h>
+#include "sh.h"
+
+/* -------- cmd.c -------- */
+/* #include "sh.h" */
+
+/*
+ * Commands that scripts use all the time,
+ * done by the shell itself so that it does
+ * not have to fork and exec for them.
+ * They behave as /bin/echo, /usr/bin/pwd,
+ * /usr/bin/test and /usr/bin/expr do, and
+ * their output goes to fd 1.
+ */
+
+static	int	doecho();
+static	int	dopwd();
+static	int	dotest();
+static	int	doexpr();
+
+static	void	oputs();
+static	void	oflush();
+static	void	cmderr();
+
+static	char	obuf[512];	/* output of the command */
+static	int	onum;
+static	jmp_buf	cmdfail;	/* to get out of a bad expression */
+static	int	failstat;	/* and the status to return then */
+
+static struct {
+	char	*command;
+	int	(*fn)();
+} cmds[] = {
+	"echo",		doecho,
+	"pwd",		dopwd,
+	"test",		dotest,
+	"[",		dotest,
+	"expr",		doexpr,
+	0,
+};
+
+/*
+ * the command the shell does itself for
+ * `s', with arguments `wp', if there is one
+ */
+int (*incommand(s, wp))()
+register char *s;
+register char **wp;
+{
+	register int i;
+
+	for (i = 0; cmds[i].command != NULL; i++)
+		if (strcmp(cmds[i].command, s) == 0)
+			break;
+	if (cmds[i].command == NULL)
+		return((int(*)())NULL);
+	if (cmds[i].fn == doexpr)
+		while (*++wp != NULL)
+			if (strcmp(*wp, ":") == 0)	/* matching is left */
+				return((int(*)())NULL);	/* to /usr/bin/expr */
+	return(cmds[i].fn);
+}
+
+static void
+oputs(s)
+register char *s;
+{
+	while (*s) {
+		if (onum == sizeof(obuf))
+			oflush();
+		obuf[onum++] = *s++;
+	}
+}
+
+static void
+oflush()
+{
+	if (onum > 0)
+		write(1, obuf, onum);
+	onum = 0;
+}
+
+static void
+cmderr(cmd, s, status)
+char *cmd, *s;
+int status;
+{
+	prs(cmd);
+	prs(": ");
+	prs(s);
+	prs("\n");
+	failstat = status;
+	longjmp(cmdfail, 1);
+}
+
+static int
+doecho(t)
+struct op *t;
+{
+	register char **wp;
+	int nflag;
+
+	wp = t->words+1;
+	nflag = 0;
+	if (*wp != NULL && wp[0][0] == '-' && wp[0][1] == 'n') {
+		nflag++;
+		wp++;
+	}
+	for (; *wp != NULL; wp++) {
+		oputs(*wp);
+		if (wp[1] != NULL)
+			oputs(" ");
+	}
+	if (nflag == 0)
+		oputs("\n");
+	oflush();
+	return(0);
+}
+
+static int
+dopwd(t)
+struct op *t;
+{
+	char dir[PATH_MAX+1];
+	char *getcwd();
+
+	if (getcwd(dir, PATH_MAX) == NULL) {
+		prs("pwd: cannot search some directory on the path\n");
+		return(1);
+	}
+	oputs(dir);
+	oputs("\n");
+	oflush();
+	return(0);
+}
+
+/* -------- test -------- */
+
+/*
+ * expr	::= bexpr | bexpr "-o" expr ;
+ * bexpr	::= primary | primary "-a" bexpr ;
+ * primary	::= unary-operator operand
+ *		| operand binary-operator operand
+ *		| operand
+ *		| "(" expr ")"
+ *		| "!" expr ;
+ */
+
+#define	EOI	0
+#define	FILRD	1
+#define	FILWR	2
+#define	FILND	3
+#define	FILID	4
+#define	FILGZ	5
+#define	FILTT	6
+#define	STZER	7
+#define	STNZE	8
+#define	STEQL	9
+#define	STNEQ	10
+#define	INTEQ	11
+#define	INTNE	12
+#define	INTGE	13
+#define	INTGT	14
+#define	INTLE	15
+#define	INTLT	16
+#define	UNEGN	17
+#define	BAND	18
+#define	BOR	19
+#define	LPAREN	20
+#define	RPAREN	21
+#define	OPERAND	22
+
+#define	UNOP	1
+#define	BINOP	2
+#define	BUNOP	3
+#define	BBINOP	4
+#define	PAREN	5
+
+static struct tstop {
+	char	*op_text;
+	short	op_num, op_type;
+} tstops[] = {
+	"-r",	FILRD,	UNOP,
+	"-w",	FILWR,	UNOP,
+	"-f",	FILND,	UNOP,
+	"-d",	FILID,	UNOP,
+	"-s",	FILGZ,	UNOP,
+	"-t",	FILTT,	UNOP,
+	"-z",	STZER,	UNOP,
+	"-n",	STNZE,	UNOP,
+	"=",	STEQL,	BINOP,
+	"!=",	STNEQ,	BINOP,
+	"-eq",	INTEQ,	BINOP,
+	"-ne",	INTNE,	BINOP,
+	"-ge",	INTGE,	BINOP,
+	"-gt",	INTGT,	BINOP,
+	"-le",	INTLE,	BINOP,
+	"-lt",	INTLT,	BINOP,
+	"!",	UNEGN,	BUNOP,
+	"-a",	BAND,	BBINOP,
+	"-o",	BOR,	BBINOP,
+	"(",	LPAREN,	PAREN,
+	")",	RPAREN,	PAREN,
+	0,	0,	0,
+};
+
+static	char	**tip;		/* next word of the expression */
+static	char	*tprog;		/* "test" or "[" */
+static	struct	tstop	*tip_op;
+
+static	int	texpr();
+
+static void
+tsyntax()
+{
+	cmderr(tprog, "syntax error", 1);
+}
+
+static long
+tnum(s)
+register char *s;
+{
+	long l = 0;
+	long sign = 1;
+
+	while (*s == ' ' || *s == '\t')
+		++s;
+	if (*s == '\0')
+		tsyntax();
+	if (*s == '-') {
+		sign = -1;
+		s++;
+	}
+	while (*s >= '0' && *s <= '9')
+		l = l * 10 + *s++ - '0';
+	while (*s == ' ' || *s == '\t')
+		++s;
+	if (*s != '\0')
+		tsyntax();
+	return(sign * l);
+}
+
+static int
+filstat(nm, mode)
+char *nm;
+int mode;
+{
+	struct stat s;
+
+	switch (mode) {
+	case FILRD:
+		return(access(nm, 4) == 0);
+	case FILWR:
+		return(access(nm, 2) == 0);
+	case FILND:
+		return(stat(nm, &s) == 0 && (s.st_mode & S_IFMT) != S_IFDIR);
+	case FILID:
+		return(stat(nm, &s) == 0 && (s.st_mode & S_IFMT) == S_IFDIR);
+	case FILGZ:
+		return(stat(nm, &s) == 0 && s.st_size > 0L);
+	case FILTT:
+		return(isatty((int)tnum(nm)));
+	}
+	return(0);
+}
+
+static int
+tlex(s)
+register char *s;
+{
+	register struct tstop *op;
+
+	if (s == NULL)
+		return(EOI);
+	for (op = tstops; op->op_text; op++)
+		if (strcmp(s, op->op_text) == 0) {
+			tip_op = op;
+			return(op->op_num);
+		}
+	tip_op = (struct tstop *)NULL;
+	return(OPERAND);
+}
+
+static int
+tprimary(n)
+int n;
+{
+	register char *opnd1, *opnd2;
+	int res;
+
+	if (n == EOI)
+		tsyntax();
+	if (n == UNEGN)
+		return(!texpr(tlex(*++tip)));
+	if (n == LPAREN) {
+		res = texpr(tlex(*++tip));
+		if (tlex(*++tip) != RPAREN)
+			tsyntax();
+		return(res);
+	}
+	if (n == OPERAND) {
+		opnd1 = *tip;
+		(void) tlex(*++tip);
+		if (tip_op && tip_op->op_type == BINOP) {
+			n = tip_op->op_num;
+			if ((opnd2 = *++tip) == NULL)
+				tsyntax();
+			switch (n) {
+			case STEQL:
+				return(strcmp(opnd1, opnd2) == 0);
+			case STNEQ:
+				return(strcmp(opnd1, opnd2) != 0);
+			case INTEQ:
+				return(tnum(opnd1) == tnum(opnd2));
+			case INTNE:
+				return(tnum(opnd1) != tnum(opnd2));
+			case INTGE:
+				return(tnum(opnd1) >= tnum(opnd2));
+			case INTGT:
+				return(tnum(opnd1) > tnum(opnd2));
+			case INTLE:
+				return(tnum(opnd1) <= tnum(opnd2));
+			case INTLT:
+				return(tnum(opnd1) < tnum(opnd2));
+			}
+		}
+		tip--;
+		return(*opnd1 != '\0');
+	}
+
+	/* unary expression */
+	if (tip_op->op_type != UNOP || *++tip == NULL)
+		tsyntax();
+	if (n == STZER)
+		return(**tip == '\0');
+	if (n == STNZE)
+		return(**tip != '\0');
+	return(filstat(*tip, n));
+}
+
+static int
+tbexpr(n)
+int n;
+{
+	int res;
+
+	if (n == EOI)
+		tsyntax();
+	res = tprimary(n);
+	if (tlex(*++tip) == BAND)
+		return(tbexpr(tlex(*++tip)) && res);
+	tip--;
+	return(res);
+}
+
+static int
+texpr(n)
+int n;
+{
+	int res;
+
+	if (n == EOI)
+		tsyntax();
+	res = tbexpr(n);
+	if (tlex(*++tip) == BOR)
+		return(texpr(tlex(*++tip)) || res);
+	tip--;
+	return(res);
+}
+
+static int
+dotest(t)
+struct op *t;
+{
+	register char **wp;
+	int res;
+
+	wp = t->words;
+	tprog = *wp;
+	if (strcmp(tprog, "[") == 0) {
+		while (*++wp != NULL)
+			;
+		if (wp == t->words+1 || strcmp(*--wp, "]") != 0) {
+			prs("test: ] missing\n");
+			return(1);
+		}
+		*wp = NULL;
+	}
+	tip = t->words+1;
+	if (*tip == NULL)
+		return(1);
+	if (setjmp(cmdfail))
+		return(failstat);
+	res = texpr(tlex(*tip));
+	return(!res);
+}
+
+/* -------- expr -------- */
+
+/*
+ * expr1	::= expr2 { "|" expr2 }
+ * expr2	::= expr3 { "&" expr3 }
+ * expr3	::= expr4 { relop expr4 }
+ * expr4	::= expr5 { ("+" | "-") expr5 }
+ * expr5	::= expr7 { ("*" | "/" | "%") expr7 }
+ * expr7	::= "(" expr1 ")" | operand
+ *
+ * The ":" operator is not done here.
+ */
+
+struct value {
+	long	numval;		/* numeric value */
+	int	nf_valid;	/* numval is valid */
+	char	*strval;	/* string value, if not numeric */
+	char	numbuf[12];	/* numval as a string */
+};
+
+static	char	**argp;		/* next word of the expression */
+static	char	NUMARG[] = "numeric argument required";
+
+static	void	expr1();
+
+static void
+invalid(s)
+char *s;
+{
+	cmderr("expr", s, 2);
+}
+
+static void
+numresult(valp, n)
+register struct value *valp;
+long n;
+{
+	valp->nf_valid = 1;
+	valp->strval = NULL;
+	valp->numval = n;
+}
+
+/*
+ * is the value a number? it is made one
+ * if its string looks like a number
+ */
+static int
+numvalue(valp)
+register struct value *valp;
+{
+	register char *p;
+	int sign = 0, digits = 0;
+	unsigned long num = 0;
+
+	if (valp->nf_valid)
+		return(1);
+	if ((p = valp->strval) == NULL)
+		return(0);
+	if (*p == '-') {
+		++p;
+		sign = 1;
+	}
+	while (digit(*p)) {
+		num = num * 10 + (*p++ - '0');
+		digits = 1;
+	}
+	if (!digits || *p != '\0')
+		return(0);
+	valp->numval = sign? -num: num;
+	valp->nf_valid = 1;
+	return(1);
+}
+
+static char *
+strvalue(valp)
+register struct value *valp;
+{
+	register char *p;
+	unsigned long num;
+
+	if (!valp->nf_valid)
+		return(valp->strval != NULL? valp->strval: "");
+	p = valp->numbuf + sizeof(valp->numbuf);
+	*--p = '\0';
+	num = valp->numval < 0? -valp->numval: valp->numval;
+	do {
+		*--p = '0' + (int)(num % 10);
+		num /= 10;
+	} while (num);
+	if (valp->numval < 0)
+		*--p = '-';
+	return(p);
+}
+
+static int
+nullz(valp)
+struct value *valp;
+{
+	if (numvalue(valp))
+		return(valp->numval == 0);
+	return(*strvalue(valp) == '\0');
+}
+
+static void
+expr7(valp)
+register struct value *valp;
+{
+	if (*argp == NULL)
+		invalid("missing argument(s)");
+	else if (strcmp(*argp, "(") == 0) {
+		++argp;
+		expr1(valp);
+		if (*argp == NULL || strcmp(*argp++, ")") != 0)
+			invalid("unbalanced parentheses");
+	} else {
+		valp->nf_valid = 0;
+		valp->strval = *argp++;
+	}
+}
+
+static void
+expr5(valp)
+register struct value *valp;
+{
+	struct value val1;
+	register int op;
+
+	expr7(valp);
+	while (*argp != NULL && (op = **argp) != '\0' && (*argp)[1] == '\0' &&
+	    (op == '*' || op == '/' || op == '%')) {
+		++argp;
+		expr7(&val1);
+		if (!numvalue(valp) || !numvalue(&val1))
+			invalid(NUMARG);
+		if (op != '*' && val1.numval == 0)
+			invalid("division by zero");
+		numresult(valp, op == '*'? valp->numval * val1.numval:
+				op == '/'? valp->numval / val1.numval:
+				valp->numval % val1.numval);
+	}
+}
+
+static void
+expr4(valp)
+register struct value *valp;
+{
+	struct value val1;
+	register int op;
+
+	expr5(valp);
+	while (*argp != NULL && (op = **argp) != '\0' && (*argp)[1] == '\0' &&
+	    (op == '+' || op == '-')) {
+		++argp;
+		expr5(&val1);
+		if (!numvalue(valp) || !numvalue(&val1))
+			invalid(NUMARG);
+		numresult(valp, op == '+'? valp->numval + val1.numval:
+				valp->numval - val1.numval);
+	}
+}
+
+static void
+expr3(valp)
+register struct value *valp;
+{
+	struct value val1;
+	register char *op;
+	long c;
+
+	expr4(valp);
+	while ((op = *argp) != NULL && (strcmp(op, "<") == 0 ||
+	    strcmp(op, "<=") == 0 || strcmp(op, "=") == 0 ||
+	    strcmp(op, "!=") == 0 || strcmp(op, ">=") == 0 ||
+	    strcmp(op, ">") == 0)) {
+		++argp;
+		expr4(&val1);
+		if (numvalue(valp) && numvalue(&val1))
+			c = valp->numval < val1.numval? -1:
+			    valp->numval > val1.numval? 1: 0;
+		else
+			c = strcmp(strvalue(valp), strvalue(&val1));
+		switch (*op) {
+		case '<':
+			c = op[1]? c <= 0: c < 0;
+			break;
+		case '>':
+			c = op[1]? c >= 0: c > 0;
+			break;
+		case '=':
+			c = c == 0;
+			break;
+		default:
+			c = c != 0;
+			break;
+		}
+		numresult(valp, c);
+	}
+}
+
+static void
+expr2(valp)
+register struct value *valp;
+{
+	struct value val1;
+
+	expr3(valp);
+	while (*argp != NULL && strcmp(*argp, "&") == 0) {
+		++argp;
+		expr3(&val1);
+		if (nullz(valp) && nullz(&val1))
+			numresult(valp, 0L);
+	}
+}
+
+static void
+expr1(valp)
+register struct value *valp;
+{
+	struct value val1;
+
+	expr2(valp);
+	while (*argp != NULL && strcmp(*argp, "|") == 0) {
+		++argp;
+		expr2(&val1);
+		if (nullz(valp))
+			*valp = val1;
+	}
+}
+
+static int
+doexpr(t)
+struct op *t;
+{
+	struct value val0;
+
+	argp = t->words+1;
+	if (setjmp(cmdfail))
+		return(failstat);
+	expr1(&val0);
+	if (*argp != NULL)
+		invalid("syntax error");
+	oputs(strvalue(&val0));
+	oputs("\n");
+	oflush();
+	return(nullz(&val0));
+}
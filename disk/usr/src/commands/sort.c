@@ -29,6 +29,15 @@
  * 	-a.b : Stop comparing at field 'a' with offset 'b'. A missing 'b' is
  * 	       taken to be 0.
  * 	A missing -a.b means the rest of the line.
+ *
+ * Sort takes as much memory as the heap will give it.  Input is read into the
+ * bottom of it, and for each line a LINE record, holding the line's address
+ * and the first bytes of its first key, is put at the top.  When the two
+ * meet, the records are sorted and the lines written to a temp file as one
+ * run.  Most comparisons are settled by the key prefixes alone, so the lines
+ * are only looked at, and the fields only built, for lines that start alike.
+ * The runs are merged OPEN_FILES at a time through a loser tree, which costs
+ * one path from a leaf to the root of comparisons per line output.
  */
 
 #include <sys/types.h>
@@ -36,13 +45,22 @@
 #include <fcntl.h>
 #include <signal.h>
 #include <unistd.h>
+#include <string.h>
 
 #define OPEN_FILES	16	/* Nr of open files per process */
 
-#define MEMORY_SIZE	(20 * 1024)	/* Total mem_size */
+#define MEM_CHUNK	(4 * 1024)	/* Heap is taken this much at a time */
+#define MAX_MEMORY	(1024L * 1024L)	/* Never take more than this */
+#define MIN_MEMORY	(16 * 1024)	/* Nor run with less */
+#define STACK_SLACK	(4 * 1024)	/* Heap left for the stack to grow in */
+#define MIN_ROOM	1024	/* Sort what is in core if less is free */
+#define MAX_LINES	16000	/* Max nr of lines in one run */
+#define READ_SIZE	(16 * 1024)	/* Max size of one read of input */
+#define MERGE_BUF	(16 * 1024)	/* Max size of the buffer per merge file */
 #define LINE_SIZE	(1024 >> 1)	/* Max length of a line */
-#define IO_SIZE		(2 * 1024)	/* Size of buffered output */
+#define IO_SIZE		(8 * 1024)	/* Size of buffered output */
 #define STD_OUT		 1	/* Fd of terminal */
+#define INSERT_SORT	 8	/* Partitions this small are left to insertion */
 
 /* Return status of functions */
 #define OK		 0
@@ -74,10 +92,15 @@ typedef struct {
   char *line;			/* Contains line currently used */
 } MERGE;
 
-#define NIL_MERGE	((MERGE *) 0)
 MERGE merge_f[OPEN_FILES];	/* Merge structs */
+int loser[OPEN_FILES];		/* Loser tree; loser[0] holds the winner */
 int buf_size;			/* Size of core available for each struct */
 
+typedef struct {
+  unsigned long key;		/* Prefix of the first key. See make_key() */
+  char *line;			/* The line itself */
+} LINE;
+
 #define FIELDS_LIMIT	10	/* 1 global + 9 user */
 #define GLOBAL		 0
 
@@ -102,10 +125,18 @@ BOOL only_merge = FALSE;
 BOOL uniq = FALSE;
 
 char *mem_top;			/* Mem_top points to lowest pos of memory. */
+long mem_size;			/* Nr of bytes from mem_top on we may use */
 char *cur_pos;			/* First free position in mem */
-char **line_table;		/* Pointer to the internal line table */
+char *line_start;		/* Start of the line being read */
+char *scan_pos;			/* Where to look for the next '\n' */
+LINE *line_table;		/* Lowest LINE record; they go down from */
+LINE *table_end;		/* ... table_end */
 BOOL in_core = TRUE;		/* Set if input cannot all be sorted in core */
 
+BOOL use_key;			/* Set if key prefixes are made */
+BOOL signed_chars;		/* Set if chars compare as signed */
+int key_order;			/* LOWER, or HIGHER if first key is reversed */
+
  /* Place where temp_files should be made */
 char temp_files[] = "/tmp/sort.XXXXX.XX";
 char *output_file;		/* Name of output file */
@@ -118,15 +149,15 @@ int args_limit;			/* Nr of args given */
 
 char separator;			/* Char that separates fields */
 int nr_of_files = 0;		/* Nr_of_files to be merged */
-int disabled;			/* Nr of files done */
 
 char USAGE[] = "Usage: sort [-funbirdcmt'x'] [+beg_pos [-end_pos]] [-o outfile] [file] ..";
 
 /* Forward declarations */
 void catch();
-char *file_name(), *skip_fields();
-MERGE *skip_lines(), *print();
-extern char *msbrk(), *mbrk();
+char *file_name(), *skip_fields(), *key_field();
+unsigned long make_key();
+BOOL beats();
+extern char *mbrk();
 
 /* Table of all chars. 0 means no special meaning. */
 char table[256] = {
@@ -291,7 +322,7 @@ char *argv[];
   int pid, pow;
 
   argptr = argv;
-  cur_pos = mem_top = msbrk(MEMORY_SIZE);	/* Find lowest mem. location */
+  get_memory();
 
   while (arg_count < argc && ((ptr = argv[arg_count])[0] == '-' || *ptr == '+')) {
 	if (*ptr == '-' && *(ptr + 1) == '\0')	/* "-" means stdin */
@@ -328,6 +359,7 @@ char *argv[];
   }
 
   for (fd = 1; fd <= field_cnt; fd++) adjust_options(&fields[fd]);
+  set_key();
 
 /* Create name of tem_files 'sort.pid.aa' */
   ptr = &temp_files[10];
@@ -353,7 +385,7 @@ char *argv[];
 	if (check)
 		check_file(0, NIL_PTR);
 	else
-		get_file(0, 0L);
+		get_file(0);
   } else
 	while (arg_count < argc) {	/* Sort or check args */
 		if (strcmp(argv[arg_count], "-") == 0)
@@ -371,7 +403,7 @@ char *argv[];
 		if (check)
 			check_file(fd, argv[arg_count]);
 		else		/* Get_file reads whole file */
-			get_file(fd, st.st_size);
+			get_file(fd);
 		arg_count++;
 	}
 
@@ -424,72 +456,110 @@ open_outfile()
 	error(TRUE, "Cannot creat ", output_file);
 }
 
-/* Get_file reads the whole file of filedescriptor fd. If the file is too big
- * to keep in core, a partial sort is done, and the output is stashed somewhere.
+/* Get_memory () takes what the heap will give, up to MAX_MEMORY, but leaves
+ * STACK_SLACK of it for the stack.
  */
-get_file(fd, size)
+get_memory()
+{
+  extern char *sbrk();
+
+  mem_top = sbrk(0);
+  if ((long) mem_top & (sizeof(long) - 1)) {	/* Align LINE records */
+	(void) sbrk((int) (sizeof(long) - ((long) mem_top & (sizeof(long) - 1))));
+	mem_top = sbrk(0);
+  }
+  while (mem_size < MAX_MEMORY && sbrk(MEM_CHUNK) != (char *) -1)
+	mem_size += MEM_CHUNK;
+  mem_size -= STACK_SLACK;
+  if (mem_size < MIN_MEMORY)
+	error(TRUE, "Not enough memory. Use chmem to allocate more", NIL_PTR);
+  mbrk(mem_top + mem_size);	/* Give the slack back */
+
+  cur_pos = line_start = scan_pos = mem_top;
+  line_table = table_end = (LINE *) (mem_top + mem_size);
+}
+
+/* Get_file reads the whole file of filedescriptor fd. Each time memory is
+ * full, the lines read so far are sorted and the output is stashed somewhere.
+ */
+get_file(fd)
 int fd;				/* Fd of file to read */
-register long size;		/* Size of file */
 {
-  register int i;
-  int rest;			/* Rest in memory */
-  char save_ch;			/* Used in stdin readings */
-
-  rest = MEMORY_SIZE - (cur_pos - mem_top);
-  if (fd == 0) {		/* We're reding stdin */
-	while ((i = read(0, cur_pos, rest)) > 0) {
-		if ((cur_pos - mem_top) + i == MEMORY_SIZE) {
-			in_core = FALSE;
-			i = last_line();	/* End of last line */
-			save_ch = mem_top[i];
-			mem_top[i] = '\0';
-			sort();	/* Sort core */
-			mem_top[i] = save_ch;	/* Restore erased char */
-			/* Restore last (half read) line */
-			for (rest = 0; i + rest != MEMORY_SIZE; rest++)
-				mem_top[rest] = mem_top[i + rest];
-			/* Assign current pos. in memory */
-			cur_pos = &mem_top[rest];
-		} else {	/* Fits, just assign position in mem. */
-			cur_pos = cur_pos + i;
-			*cur_pos = '\0';
-		}
+  register char *ptr;
+  register int n;
+  long room;
 
-		/* Calculate rest of mem */
-		rest = MEMORY_SIZE - (cur_pos - mem_top);
+  for (;;) {
+	/* One byte is kept free for a '\n' after an unfinished last line. */
+	room = (char *) line_table - cur_pos - 1;
+	if (room < MIN_ROOM) {	/* Text has met the LINE records */
+		if (line_table == table_end)
+			error(TRUE, "Line too long", NIL_PTR);
+		flush_run();
+		continue;
+	}
+	/* Read no more than half of it, so that when the lines that fit
+	 * have been sorted, the rest of the text leaves room for their
+	 * LINE records.
+	 */
+	room >>= 1;
+	n = (room > READ_SIZE) ? READ_SIZE : (int) room;
+	if ((n = read(fd, cur_pos, n)) < 0) error(TRUE, "Read error", NIL_PTR);
+	if (n == 0) break;
+	cur_pos += n;
+
+	/* Make a LINE record for each line completed by this read. */
+	for (ptr = scan_pos; ptr < cur_pos; ptr++) {
+		if (*ptr != '\n') continue;
+		add_line(ptr + 1);
+		ptr = line_start - 1;	/* add_line() may have moved it */
 	}
+	scan_pos = cur_pos;
   }
 
-   /* Reading file. Check size */ 
-  else if (size > rest) {	/* Won't fit */
-	mread(fd, cur_pos, rest);
-	in_core = FALSE;
-	i = last_line();	/* Get pos. of last line */
-	mem_top[i] = '\0';	/* Truncate */
-	(void) lseek(fd, (long) (i - MEMORY_SIZE), SEEK_CUR);	/* Do this next time */
-	size = size - rest - i + MEMORY_SIZE;	/* Calculate rest */
-	cur_pos = mem_top;	/* Reset mem */
-	sort();			/* Sort core */
-	get_file(fd, size);	/* Get rest of file */
-  } else {			/* Fits. Just read in */
-	rest = size;
-	mread(fd, cur_pos, rest);
-	cur_pos = cur_pos + rest;	/* Reassign cur_pos */
-	*cur_pos = '\0';
-	(void) close(fd);	/* File completed */
+  if (line_start != cur_pos) {	/* Add '\n' to last line */
+	*cur_pos++ = '\n';
+	add_line(cur_pos);
+	scan_pos = cur_pos;
   }
+  if (fd != 0) (void) close(fd);	/* File completed */
 }
 
-/* Last_line () find the last line in core and retuns the offset from the top
- * of the memory.
+/* Add_line () makes a LINE record for the line from line_start up to next.
+ * If there is no room for it, the lines before it are sorted first and the
+ * text not yet sorted is moved down to mem_top.
  */
-last_line()
+add_line(next)
+char *next;			/* Start of the line after it */
 {
-  register int i;
+  register LINE *lp;
+  int len = next - line_start;
 
-  for (i = MEMORY_SIZE - 1; i > 0; i--)
-	if (mem_top[i] == '\n') break;
-  return i + 1;
+  if ((char *) (line_table - 1) < cur_pos || table_end - line_table == MAX_LINES) {
+	flush_run();
+	next = line_start + len;
+  }
+  lp = --line_table;
+  lp->line = line_start;
+  lp->key = use_key ? make_key(line_start) : 0L;
+  line_start = next;
+}
+
+/* Flush_run () sorts the lines read so far and writes them to a temp file.
+ * The unfinished line, and any text not yet looked at, are moved to mem_top.
+ */
+flush_run()
+{
+  register char *src, *dest;
+  long shift;
+
+  in_core = FALSE;
+  sort();
+  shift = line_start - mem_top;
+  for (src = line_start, dest = mem_top; src < cur_pos;) *dest++ = *src++;
+  line_start -= shift;
+  scan_pos -= shift;
+  cur_pos -= shift;
 }
 
 /* Print_table prints the line table in the given file_descriptor. If the fd
@@ -498,30 +568,20 @@ last_line()
 print_table(fd)
 int fd;
 {
-  register char **line_ptr;	/* Ptr in line_table */
-  register char *ptr;		/* Ptr to line */
-  int index = 0;		/* Index in output buffer */
+  register LINE *lp;		/* Ptr in line_table */
 
   if (fd == ERROR) {
 	if ((fd = creat(file_name(nr_of_files), 0644)) < 0)
 		error(TRUE, "Cannot creat ", file_name(nr_of_files));
   }
-  for (line_ptr = line_table; *line_ptr != NIL_PTR; line_ptr++) {
-	ptr = *line_ptr;
+  out_fd = fd;
+  for (lp = line_table; lp < table_end; lp++) {
 	/* Skip all same lines if uniq is set */
-	if (uniq && *(line_ptr + 1) != NIL_PTR) {
-		if (compare(ptr, *(line_ptr + 1)) == SAME) continue;
-	}
-	do {			/* Print line in a buffered way */
-		out_buffer[index++] = *ptr;
-		if (index == IO_SIZE) {
-			mwrite(fd, out_buffer, IO_SIZE);
-			index = 0;
-		}
-	} while (*ptr++ != '\n');
+	if (uniq && lp + 1 < table_end && line_cmp(lp, lp + 1) == SAME)
+		continue;
+	put_line(lp->line);
   }
-  mwrite(fd, out_buffer, index);/* Flush buffer */
-  (void) close(fd);		/* Close file */
+  put_line(NIL_PTR);		/* Flush buffer and close file */
   nr_of_files++;		/* Increment nr_of_files to merge */
 }
 
@@ -540,16 +600,6 @@ register int nr;
   return temp_files;
 }
 
-/* Mread () performs a normal read (), but checks the return value. */
-mread(fd, address, bytes)
-int fd;
-char *address;
-register int bytes;
-{
-  if (read(fd, address, bytes) < 0 && bytes != 0)
-	error(TRUE, "Read error", NIL_PTR);
-}
-
 /* Mwrite () performs a normal write (), but checks the return value. */
 mwrite(fd, address, bytes)
 int fd;
@@ -560,30 +610,10 @@ register int bytes;
 	error(TRUE, "Write error", NIL_PTR);
 }
 
-/* Sort () sorts the input in memory starting at mem_top. */
+/* Sort () sorts the lines in the line table and writes them out. */
 sort()
 {
-  register char *ptr = mem_top;
-  register int count = 0;
-
-/* Count number of lines in memory */
-  while (*ptr) {
-	if (*ptr++ == '\n') count++;
-  }
-
-/* Set up the line table */
-  line_table = (char **) msbrk(count * sizeof(char *) + sizeof(char *));
-
-  count = 1;
-  ptr = line_table[0] = mem_top;
-  while (*ptr) {
-	if (*ptr++ == '\n') line_table[count++] = ptr;
-  }
-
-  line_table[count - 1] = NIL_PTR;
-
-/* Sort the line table */
-  sort_table(count - 1);
+  sort_table(line_table, table_end);
 
 /* Stash output somewhere */
   if (in_core) {
@@ -592,44 +622,155 @@ sort()
   } else
 	print_table(ERROR);
 
-/* Free line table */
-  mbrk(line_table);
+/* Empty line table */
+  line_table = table_end;
 }
 
-/* Sort_table () sorts the line table consisting of nel elements. */
-sort_table(nel)
-register int nel;
+/* Set_key () decides whether key prefixes can be used. They can if the
+ * first key is compared char by char, perhaps with case folded or leading
+ * blanks skipped.
+ */
+set_key()
 {
-  char *tmp;
-  register int i;
+  register FIELD *field = &fields[field_cnt > GLOBAL ? 1 : GLOBAL];
 
-  /* Make heap */
-  for (i = (nel >> 1); i >= 1; i--) incr(i, nel);
+  use_key = !field->numeric && !field->dictionary && !field->ascii;
+  key_order = field->reverse ? HIGHER : LOWER;
+  signed_chars = ((char) 0x80 < 0);
+}
 
-  /* Sort from heap */
-  for (i = nel; i > 1; i--) {
-	tmp = line_table[0];
-	line_table[0] = line_table[i - 1];
-	line_table[i - 1] = tmp;
-	incr(1, i - 1);
+/* Key_field () returns the start of the first key of line and puts where it
+ * ends in *end, the way build_field () would cut it out.
+ */
+char *key_field(line, end)
+register char *line;
+char **end;
+{
+  register FIELD *field;
+  register char *src, *last;
+  int i;
+
+  *end = NIL_PTR;
+  if (field_cnt == GLOBAL) return line;
+  field = &fields[1];
+  src = skip_fields(line, field->beg_field);
+  for (i = 0; i < field->beg_pos && *src != '\n'; i++) src++;
+  if (field->end_field != ERROR) {
+	last = skip_fields(line, field->end_field);
+	for (i = 0; i < field->end_pos && *last != '\n'; i++) last++;
+	if (last >= src) *end = last;
   }
+  return src;
 }
 
-/* Incr () increments the heap. */
-incr(si, ei)
-register int si, ei;
+/* Make_key () makes the key prefix of a line: the first bytes of its first
+ * key, packed so that comparing two prefixes as numbers gives the order
+ * cmp () would give, or a tie. The end of the key is 0 and lower than any
+ * char. A char that would be 0 as well ends the prefix, since from there on
+ * the prefix could tell lines apart that cmp () does not.
+ */
+unsigned long make_key(line)
+char *line;
 {
-  char *tmp;
+  register char *ptr;
+  register int c, i;
+  char *end;
+  unsigned long key = 0L;
+  FIELD *field = &fields[field_cnt > GLOBAL ? 1 : GLOBAL];
+  BOOL fold = field->fold_case;
+
+  ptr = key_field(line, &end);
+  if (field->blanks)
+	while (ptr != end && (table[*ptr] & BLANK)) ptr++;
+  for (i = 0; i < sizeof(key); i++) {
+	key <<= 8;
+	if (ptr == end || *ptr == '\n') continue;
+	c = *ptr++;
+	if (fold && (table[c & 0xFF] & UPPER)) c += 'a' - 'A';
+	c = signed_chars ? (c + 0x80) & 0xFF : c & 0xFF;
+	if (c == 0) end = ptr;	/* End the prefix */
+	key |= c;
+  }
+  return key;
+}
 
-  while (si <= (ei >> 1)) {
-	si <<= 1;
-	if (si + 1 <= ei && compare(line_table[si - 1], line_table[si]) <= 0)
-		si++;
-	if (compare(line_table[(si >> 1) - 1], line_table[si - 1]) >= 0)
-		return;
-	tmp = line_table[(si >> 1) - 1];
-	line_table[(si >> 1) - 1] = line_table[si - 1];
-	line_table[si - 1] = tmp;
+/* Line_cmp () compares two LINE records. Only if their key prefixes are the
+ * same are the lines themselves compared.
+ */
+line_cmp(l1, l2)
+register LINE *l1, *l2;
+{
+  if (l1->key != l2->key) return (l1->key < l2->key) ? key_order : -key_order;
+  return compare(l1->line, l2->line);
+}
+
+/* Sort_table () sorts the LINE records from lo up to hi. It is a quicksort
+ * on a median of three that leaves small partitions alone, and finishes with
+ * one insertion sort over the whole table. The smaller partition is always
+ * done first, so the stack never holds more than log2(MAX_LINES) of them.
+ */
+sort_table(lo, hi)
+register LINE *lo, *hi;
+{
+  LINE *stack[2 * 16];		/* Partitions still to do */
+  register LINE *i, *j;
+  LINE *base = lo, *end = hi, *mid;
+  LINE pivot, tmp;
+  int sp = 0;
+
+  for (;;) {
+	while (hi - lo > INSERT_SORT) {
+		/* Put the median of lo, mid and hi - 1 at lo */
+		mid = lo + ((hi - lo) >> 1);
+		if (line_cmp(mid, lo) < 0) {
+			tmp = *mid; *mid = *lo; *lo = tmp;
+		}
+		if (line_cmp(hi - 1, mid) < 0) {
+			tmp = *mid; *mid = *(hi - 1); *(hi - 1) = tmp;
+			if (line_cmp(mid, lo) < 0) {
+				tmp = *mid; *mid = *lo; *lo = tmp;
+			}
+		}
+		tmp = *mid; *mid = *lo; *lo = tmp;
+		pivot = *lo;
+
+		/* Partition around it */
+		i = lo;
+		j = hi;
+		for (;;) {
+			while (++i < hi && line_cmp(i, &pivot) < 0);
+			while (line_cmp(--j, &pivot) > 0);
+			if (i >= j) break;
+			tmp = *i; *i = *j; *j = tmp;
+		}
+		*lo = *j;
+		*j = pivot;
+
+		/* Stack the larger part, go on with the smaller */
+		if (j - lo > hi - j) {
+			stack[sp++] = lo;
+			stack[sp++] = j;
+			lo = j + 1;
+		} else {
+			stack[sp++] = j + 1;
+			stack[sp++] = hi;
+			hi = j;
+		}
+	}
+	if (sp == 0) break;
+	hi = stack[--sp];
+	lo = stack[--sp];
+  }
+
+  /* Every record is now at most INSERT_SORT places from where it belongs */
+  for (i = base + 1; i < end; i++) {
+	if (line_cmp(i - 1, i) <= 0) continue;
+	tmp = *i;
+	j = i;
+	do {
+		*j = *(j - 1);
+	} while (--j > base && line_cmp(j - 1, &tmp) > 0);
+	*j = tmp;
   }
 }
 
@@ -748,13 +889,13 @@ FIELD *field;
 		if ((table[*el1] & ASCII) == 0) {
 			do {
 				el1++;
-			} while ((table[*el1] & ASCII) == 0);
+			} while ((table[*el1] & ASCII) == 0 && *el1 != '\n');
 			continue;
 		}
 		if ((table[*el2] & ASCII) == 0) {
 			do {
 				el2++;
-			} while ((table[*el2] & ASCII) == 0);
+			} while ((table[*el2] & ASCII) == 0 && *el2 != '\n');
 			continue;
 		}
 	}
@@ -762,13 +903,13 @@ FIELD *field;
 		if ((table[*el1] & DICT) == 0) {
 			do {
 				el1++;
-			} while ((table[*el1] & DICT) == 0);
+			} while ((table[*el1] & DICT) == 0 && *el1 != '\n');
 			continue;
 		}
 		if ((table[*el2] & DICT) == 0) {
 			do {
 				el2++;
-			} while ((table[*el2] & DICT) == 0);
+			} while ((table[*el2] & DICT) == 0 && *el2 != '\n');
 			continue;
 		}
 	}
@@ -881,71 +1022,102 @@ register int file_cnt;		/* Nr_of_files to merge */
   while (i < file_cnt) (void) unlink(file_name(i++));
 }
 
-/* Merge () merges the files between start_file and limit_file. */
+/* Merge () merges the files between start_file and limit_file. The files
+ * are the leaves of a loser tree: each inner node holds the file that lost
+ * the match played there, and loser[0] the overall winner, whose line is
+ * the smallest. After a line is printed, only the matches on the path from
+ * its file up to the root have to be played again.
+ */
 merge(start_file, limit_file)
 int start_file, limit_file;
 {
-  register MERGE *smallest;	/* Keeps track of smallest line */
-  register int i;
+  register MERGE *merg;
+  register int i, node;
   int file_cnt = limit_file - start_file;	/* Nr of files to merge */
+  int winner, tmp;
+  BOOL have_last = FALSE;	/* Set if lastline holds a line */
+  char lastline[LINE_SIZE];	/* Last line printed, if uniq is set */
 
 /* Calculate size in core available for file_cnt merge structs */
-  buf_size = MEMORY_SIZE / file_cnt - LINE_SIZE;
-
-  mbrk(mem_top);		/* First reset mem to lowest loc. */
-  disabled = 0;			/* All files not done yet */
+  if (mem_size / file_cnt > MERGE_BUF)
+	buf_size = MERGE_BUF;
+  else
+	buf_size = (int) (mem_size / file_cnt);
 
 /* Set up merge structures. */
-  for (i = start_file; i < limit_file; i++) {
-	smallest = &merge_f[i - start_file];
-	if (!strcmp(file_name(i), "-"))	/* File is stdin */
-		smallest->fd = 0;
-	else if ((smallest->fd = open(file_name(i), O_RDONLY)) < 0) {
-		smallest->fd = ERROR;
-		error(FALSE, "Cannot open ", file_name(i));
-		disabled++;	/* Done this file */
+  for (i = 0; i < file_cnt; i++) {
+	merg = &merge_f[i];
+	if (!strcmp(file_name(start_file + i), "-"))	/* File is stdin */
+		merg->fd = 0;
+	else if ((merg->fd = open(file_name(start_file + i), O_RDONLY)) < 0) {
+		merg->fd = ERROR;
+		error(FALSE, "Cannot open ", file_name(start_file + i));
 		continue;
 	}
-	smallest->buffer = msbrk(buf_size);
-	smallest->line = msbrk(LINE_SIZE);
-	smallest->cnt = smallest->read_chars = 0;
-	(void) read_line(smallest);	/* Read first line */
+	merg->buffer = mem_top + (long) i * buf_size;
+	merg->cnt = merg->read_chars = 0;
+	(void) read_line(merg);	/* Read first line */
   }
 
-  if (disabled == file_cnt) {	/* Couldn't open files */
-	(void) close(out_fd);
-	return;
-  }
+  loser[0] = play(1, file_cnt);	/* Build the tree */
 
-/* Find a merg struct to assign smallest. */
-  for (i = 0; i < file_cnt; i++) {
-	if (merge_f[i].fd != ERROR) {
-		smallest = &merge_f[i];
-		break;
+  while (merge_f[winner = loser[0]].fd != ERROR) {
+	merg = &merge_f[winner];
+	if (!uniq || !have_last || compare(lastline, merg->line) != SAME) {
+		put_line(merg->line);
+		if (uniq) {
+			copy(lastline, merg->line);
+			have_last = TRUE;
+		}
 	}
+	(void) read_line(merg);
+
+	/* Play the matches on the way up again */
+	for (node = (winner + file_cnt) >> 1; node > 0; node >>= 1) {
+		if (beats(loser[node], winner)) {
+			tmp = loser[node];
+			loser[node] = winner;
+			winner = tmp;
+		}
+	}
+	loser[0] = winner;
   }
 
-/* Loop until all files minus one are done */
-  while (disabled < file_cnt - 1) {
-	if (uniq)		/* Skip all same lines */
-		smallest = skip_lines(smallest, file_cnt);
-	else {			/* Find smallest line */
-		for (i = 0; i < file_cnt; i++) {
-			if (merge_f[i].fd == ERROR)
-				continue;	/* We've had this one */
-			if (compare(merge_f[i].line, smallest->line) < 0)
-				smallest = &merge_f[i];
-		}
-	}			/* Print line and read next */
-	smallest = print(smallest, file_cnt);
+  put_line(NIL_PTR);		/* Flush output buffer */
+}
+
+/* Play () fills in the losers below node of a tree with file_cnt leaves, and
+ * returns the winner. Node n has sons 2n and 2n + 1; leaf i is node
+ * file_cnt + i.
+ */
+play(node, file_cnt)
+int node, file_cnt;
+{
+  int left, right;
+
+  if (node >= file_cnt) return node - file_cnt;
+  left = play(node << 1, file_cnt);
+  right = play((node << 1) + 1, file_cnt);
+  if (beats(right, left)) {
+	loser[node] = left;
+	return right;
   }
+  loser[node] = right;
+  return left;
+}
 
-  if (only_merge && uniq)
-	uniq_lines(smallest);	/* Print only uniq lines */
-  else				/* Print rest of file */
-	while (print(smallest, file_cnt) != NIL_MERGE);
+/* Beats () returns TRUE if the line of file f1 goes before that of file f2.
+ * A file that is done loses to all others. Equal lines go in file order.
+ */
+BOOL beats(f1, f2)
+int f1, f2;
+{
+  register int ret;
 
-  put_line(NIL_PTR);		/* Flush output buffer */
+  if (merge_f[f1].fd == ERROR) return FALSE;
+  if (merge_f[f2].fd == ERROR) return TRUE;
+  ret = compare(merge_f[f1].line, merge_f[f2].line);
+  return ret < 0 || (ret == SAME && f1 < f2);
 }
 
 /* Put_line () prints the line into the out_fd filedescriptor. If line equals
@@ -955,6 +1127,7 @@ put_line(line)
 register char *line;
 {
   static int index = 0;		/* Index in out_buffer */
+  register int len;
 
   if (line == NIL_PTR) {	/* Flush and close */
 	mwrite(out_fd, out_buffer, index);
@@ -962,116 +1135,64 @@ register char *line;
 	(void) close(out_fd);
 	return;
   }
-  do {				/* Fill out_buffer with line */
-	out_buffer[index++] = *line;
-	if (index == IO_SIZE) {
-		mwrite(out_fd, out_buffer, IO_SIZE);
-		index = 0;
-	}
-  } while (*line++ != '\n');
-}
-
-/*
- * Print () prints the line of the merg structure and tries to read another one.
- * If this fails, it returns the next merg structure which file_descriptor is
- * still open. If none could be found, a NIL structure is returned.
- */
-MERGE *print(merg, file_cnt)
-register MERGE *merg;
-int file_cnt;			/* Nr of files that are being merged */
-{
-  register int i;
-
-  put_line(merg->line);		/* Print the line */
-
-  if (read_line(merg) == ERROR) {	/* Read next line */
-	for (i = 0; i < file_cnt; i++) {
-		if (merge_f[i].fd != ERROR) {
-			merg = &merge_f[i];
-			break;
-		}
+  len = length(line);
+  if (index + len > IO_SIZE) {	/* Won't fit. Flush first */
+	mwrite(out_fd, out_buffer, index);
+	index = 0;
+	if (len > IO_SIZE) {	/* Won't fit at all */
+		mwrite(out_fd, line, len);
+		return;
 	}
-	if (i == file_cnt)	/* No more files left */
-		return NIL_MERGE;
   }
-  return merg;
+  memcpy(&out_buffer[index], line, len);
+  index += len;
 }
 
 /* Read_line () reads a line from the fd from the merg struct. If the read
- * failed, disabled is incremented and the file is closed. Readings are
- * done in buf_size bytes.
+ * failed, the file is closed. Readings are done in buf_size bytes. The line
+ * is left in the buffer, and merg->line points to it; a line that runs past
+ * the end of the buffer is moved to the start of it first.
  * Lines longer than LINE_SIZE are silently truncated.
  */
 read_line(merg)
 register MERGE *merg;
 {
-  register char *ptr = merg->line - 1;	/* Ptr buf that will hold line */
+  register char *ptr, *last;
+  char *end, *limit;
+  int rest, n;
 
-  do {
-	ptr++;
-	if (merg->cnt == merg->read_chars) {	/* Read new buffer */
-		if ((merg->read_chars =
-		     read(merg->fd, merg->buffer, buf_size)) <= 0) {
-			(void) close(merg->fd);	/* OOPS */
-			merg->fd = ERROR;
-			disabled++;
-			return ERROR;
-		}
-		merg->cnt = 0;
-	}
-	*ptr = merg->buffer[merg->cnt++];	/* Assign next char of line */
-	if (ptr - merg->line == LINE_SIZE - 1)
+  for (;;) {
+	ptr = merg->buffer + merg->cnt;
+	end = merg->buffer + merg->read_chars;
+	limit = ptr + LINE_SIZE - 1;
+	last = (limit < end) ? limit : end;
+	merg->line = ptr;
+	while (ptr < last && *ptr != '\n') ptr++;
+	if (ptr < end) {	/* Found '\n', or line is too long */
 		*ptr = '\n';	/* Truncate very long lines */
-  } while (*ptr != '\n' && *ptr != '\0');
-
-  if (*ptr == '\0')		/* Add '\n' to last line */
-	*ptr = '\n';
-  *++ptr = '\0';		/* Add '\0' */
-  return OK;
-}
-
-/* Skip_lines () skips all same lines in all the files currently being merged.
- * It returns a pointer to the merge struct containing the smallest line.
- */
-MERGE *skip_lines(smallest, file_cnt)
-register MERGE *smallest;
-int file_cnt;
-{
-  register int i;
-  int ret;
-
-  if (disabled == file_cnt - 1)	/* We've had all */
-	return smallest;
-
-  for (i = 0; i < file_cnt; i++) {
-	if (merge_f[i].fd == ERROR || smallest == &merge_f[i])
-		continue;	/* Don't check same file */
-	while ((ret = compare(merge_f[i].line, smallest->line)) == 0) {
-		if (read_line(&merge_f[i]) == ERROR) break;	/* EOF */
+		merg->cnt = ptr + 1 - merg->buffer;
+		return OK;
 	}
-	if (ret < 0)		/* Line wasn't smallest. Try again */
-		return skip_lines(&merge_f[i], file_cnt);
-  }
-  return smallest;
-}
-
-/* Uniq_lines () prints only the uniq lines out of the fd of the merg struct. */
-uniq_lines(merg)
-register MERGE *merg;
-{
-  char lastline[LINE_SIZE];	/* Buffer to hold last line */
 
-  for (;;) {
-	put_line(merg->line);	/* Print this line */
-	copy(lastline, merg->line);	/* and save it */
-	if (read_line(merg) == ERROR)	/* Read the next */
-		return;
-	/* Keep reading until lines duffer */
-	while (compare(lastline, merg->line) == SAME)
-		if (read_line(merg) == ERROR) return;
+	/* Move the start of the line down and read the rest after it */
+	rest = end - merg->line;
+	if (merg->line != merg->buffer) {
+		for (ptr = merg->line, last = merg->buffer; ptr < end;)
+			*last++ = *ptr++;
+	}
+	merg->cnt = 0;
+	merg->read_chars = rest;
+	n = read(merg->fd, merg->buffer + rest, buf_size - rest - 1);
+	if (n <= 0) {
+		if (rest == 0) {	/* OOPS */
+			(void) close(merg->fd);
+			merg->fd = ERROR;
+			return ERROR;
+		}
+		merg->buffer[merg->read_chars++] = '\n';	/* Add '\n' to last line */
+	} else
+		merg->read_chars += n;
   }
-
-  /* NOTREACHED */
 }
 
 /*
@@ -1082,17 +1203,15 @@ check_file(fd, file)
 int fd;
 char *file;
 {
-  register MERGE *merg;		/* 1 file only */
+  register MERGE *merg = &merge_f[0];	/* 1 file only */
   char lastline[LINE_SIZE];	/* Save last line */
   register int ret;		/* ret status of compare */
 
   if (fd == 0) file = "stdin";
-  merg = (MERGE *) mem_top;	/* Assign MERGE structure */
-  merg->buffer = mem_top + sizeof(MERGE);
-  merg->line = msbrk(LINE_SIZE);
+  merg->buffer = mem_top;
   merg->cnt = merg->read_chars = 0;
   merg->fd = fd;
-  buf_size = MEMORY_SIZE - sizeof(MERGE);
+  buf_size = (mem_size > MERGE_BUF) ? MERGE_BUF : (int) mem_size;
 
   if (read_line(merg) == ERROR)	/* Read first line */
 	return;
@@ -1113,8 +1232,6 @@ char *file;
 		break;
 	}
   }
-
-  mbrk(mem_top);		/* Reset mem */
 }
 
 /* Length () returns the length of the argument line including the linefeed. */
@@ -1134,18 +1251,6 @@ register char *dest, *src;
   while ((*dest++ = *src++) != '\n');
 }
 
-/* Msbrk() does a sbrk() and checks the return value. */
-char *msbrk(size)
-register size;
-{
-  extern char *sbrk();
-  register char *address;
-
-  if ((address = sbrk(size)) == (char *) -1)
-	error(TRUE, "Not enough memory. Use chmem to allocate more", NIL_PTR);
-  return address;
-}
-
 /* Mbrk() does a brk() and checks the return value. */
 char *mbrk(address)
 char *address;
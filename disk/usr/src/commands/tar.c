@@ -1,6 +1,6 @@
 /* tar - tape archiver			Author: Michiel Huisjes */
 
-/* Usage: tar [cxt][vo][F][f] tapefile [files]
+/* Usage: tar [cxt][vo][F][f][b] tapefile [blocks] [files]
  *
  * attempt to make tar to conform to POSIX 1003.1
  * disclaimer: based on an old (1986) POSIX draft.
@@ -42,6 +42,8 @@
  *  made lint complains less (On a BSD 4.3 system)		KS 3/10/89
  *  use of directory(3) routines				KS 3/10/89
  *  deleted use of d_namlen selector of struct dirent		KS 18/10/89
+ *  archive read and written through a buffer of whole records;
+ *  b key sets the blocking factor, 20 on a device
  *
  * Bugs:
  *  verbose mode is not reporting consistent
@@ -55,6 +57,8 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
 #include <pwd.h>
 #include <grp.h>
 #include <tar.h>
@@ -85,7 +89,8 @@ typedef char BOOL;
 
 #define HEADER_SIZE	TBLOCK
 #define NAME_SIZE	NAMSIZ
-/* #define BLOCK_BOUNDARY	 20 -- not in POSIX ! */
+#define BLOCKING	20	/* blocks per record on a device */
+#define MAX_BLOCKING	60	/* so that a record fits in an int */
 
 typedef union hblock HEADER;
 
@@ -147,8 +152,18 @@ BOOL show_fl, creat_fl, ext_fl;
 
 int tar_fd;
 /* Char usage[] = "Usage: tar [cxt] tarfile [files]."; */
-char usage[] = "Usage: tar [cxt][vo][F][f] tarfile [files].";
-char io_buffer[BLOCK_SIZE];
+char usage[] = "Usage: tar [cxt][vo][F][f][b] tarfile [blocks] [files].";
+
+/* The archive is read and written through tar_buf, which holds buf_blocks
+ * blocks: a whole number of records of nblock blocks each.  On a character
+ * device (a tape) it is one record, since each read() or write() there is a
+ * record; otherwise it is as large as memory allows.
+ */
+char *tar_buf;
+int nblock;			/* blocking factor */
+int buf_blocks;			/* blocks in tar_buf */
+int buf_pos;			/* next block to use in tar_buf */
+int buf_cnt;			/* blocks read into tar_buf */
 char path[NAME_SIZE];
 char pathname[NAME_SIZE];
 int force_flag = 0;
@@ -181,6 +196,7 @@ char *s1, *s2;
 }
 
 BOOL get_header();
+char *read_block(), *write_block();
 
 main(argc, argv)
 int argc;
@@ -188,11 +204,17 @@ register char *argv[];
 {
   register char *mem_name;
   register char *ptr;
+  char *tar_name;
   struct stat st;
-  int i;
+  int i, argn = 2;
 
   if (argc < 3) error(usage, NIL_PTR);
 
+  /* Keys f and b take the next argument in turn; without f the archive
+   * comes first.
+   */
+  if (strchr(argv[1], 'f') == NIL_PTR) tar_name = argv[argn++];
+
   for (ptr = argv[1]; *ptr; ptr++) {
 	switch (*ptr) {
 	    case 'c':	creat_fl = TRUE;	break;
@@ -208,6 +230,14 @@ register char *argv[];
 		force_flag = TRUE;
 		break;
 	    case 'f':		/* standard U*IX usage -KS */
+		if (argn == argc) error(usage, NIL_PTR);
+		tar_name = argv[argn++];
+		break;
+	    case 'b':		/* blocking factor */
+		if (argn == argc) error(usage, NIL_PTR);
+		nblock = atoi(argv[argn++]);
+		if (nblock < 1 || nblock > MAX_BLOCKING)
+			error("Tar: blocking factor must be 1 to 60", NIL_PTR);
 		break;
 	    default:	error(usage, NIL_PTR);
 	}
@@ -215,13 +245,15 @@ register char *argv[];
 
   if (creat_fl + ext_fl + show_fl != 1) error(usage, NIL_PTR);
 
-  if (strcmp(argv[2], "-") == 0)/* only - means stdin/stdout - KS */
+  if (strcmp(tar_name, "-") == 0)/* only - means stdin/stdout - KS */
 	tar_fd = creat_fl ? 1 : 0;	/* '-' means used
 					 * stdin/stdout  -Dal */
   else
-	tar_fd = creat_fl ? creat(argv[2], 0666) : open(argv[2], O_RDONLY);
+	tar_fd = creat_fl ? creat(tar_name, 0666) : open(tar_name, O_RDONLY);
 
-  if (tar_fd < 0) error("Cannot open ", argv[2]);
+  if (tar_fd < 0) error("Cannot open ", tar_name);
+  if (fstat(tar_fd, &st) < 0) error("Can't stat ", tar_name);
+  init_buffer(&st);
 
   if (geteuid()) {		/* check if super-user */
 	int save_umask;
@@ -234,15 +266,15 @@ register char *argv[];
 
   ar_dev = -1;			/* impossible device nr */
   if (creat_fl) {
-	if (tar_fd > 1 && fstat(tar_fd, &st) < 0)
-		error("Can't stat ", argv[2]);	/* will never be here,
-						 * right? */
-	else {			/* get archive inode & device	 */
+	if (tar_fd > 1) {	/* get archive inode & device	 */
 		ar_inode = st.st_ino;	/* save files inode	 */
 		ar_dev = st.st_dev;	/* save files device	 */
 	}			/* marks@mgse Mon Sep 25 11:30:45 CDT 1989 */
 
-	for (i = 3; i < argc; i++) {
+	/* A child writes to a tape, floppy or pipe while files are read */
+	tar_fd = streamopen(tar_fd, buf_blocks * BLOCK_SIZE);
+
+	for (i = argn; i < argc; i++) {
 		add_file(argv[i]);
 		path[0] = '\0';
 	}
@@ -256,10 +288,10 @@ register char *argv[];
 			*(ptr - 1) = '\0';
 			header.dbuf.typeflag = '5';
 		}
-		for (i = 3; i < argc; i++)
+		for (i = argn; i < argc; i++)
 			if (!strncmp(argv[i], mem_name, strlen(argv[i])))
 				break;
-		if (argc == 3 || (i < argc)) {
+		if (argc == argn || (i < argc)) {
 			extract(mem_name);
 		} else
 			if (header.dbuf.typeflag == '0' ||
@@ -279,7 +311,7 @@ BOOL get_header()
 {
   register int check;
 
-  mread(tar_fd, (char *) &header, sizeof(header));
+  memcpy(header.hdr_block, read_block(), BLOCK_SIZE);
   if (header.member.m_name[0] == '\0') return FALSE;
 
   if (force_flag)		/* skip checksum verification  -Dal */
@@ -344,7 +376,7 @@ skip_entry()
 {
   register int blocks = block_size();
 
-  while (blocks--) (void) read(tar_fd, io_buffer, BLOCK_SIZE);
+  while (blocks--) (void) read_block();
 }
 
 extract(file)
@@ -450,21 +482,42 @@ char *file;
   utime(file, times);
 }
 
+/* Copy() moves a file into or out of the archive.  The file is read into,
+ * or written from, tar_buf itself, as many blocks at a time as there are
+ * there.
+ */
 copy(file, from, to, bytes)
 char *file;
 int from, to;
 register long bytes;
 {
-  register int rest;
-  int blocks = (int) ((bytes + (long) BLOCK_SIZE - 1) / (long) BLOCK_SIZE);
+  register int n, rest;
+  register char *ptr;
+  int i, blocks = (int) ((bytes + (long) BLOCK_SIZE - 1) / (long) BLOCK_SIZE);
 
   if (verbose_flag)
 	string_print(NIL_PTR, "%s, %d tape blocks\n", file, blocks);
 
-  while (blocks--) {
-	(void) read(from, io_buffer, BLOCK_SIZE);
-	rest = (bytes > (long) BLOCK_SIZE) ? BLOCK_SIZE : (int) bytes;
-	mwrite(to, io_buffer, (to == tar_fd) ? BLOCK_SIZE : rest);
+  while (blocks > 0) {
+	if (to == tar_fd) {
+		if (buf_pos == buf_blocks) flush_buffer();
+		n = buf_blocks - buf_pos;
+	} else {
+		if (buf_pos == buf_cnt) fill_buffer();
+		n = buf_cnt - buf_pos;
+	}
+	if (n > blocks) n = blocks;
+	ptr = &tar_buf[buf_pos * BLOCK_SIZE];
+	rest = (bytes > (long) n * BLOCK_SIZE) ? n * BLOCK_SIZE : (int) bytes;
+	if (to == tar_fd) {
+		/* A file that shrank is padded out with zeros */
+		if ((i = read(from, ptr, rest)) < 0) i = 0;
+		while (i < n * BLOCK_SIZE) ptr[i++] = '\0';
+		total_blocks += n;
+	} else if (write(to, ptr, rest) != rest)
+		error("Tar: write error.", NIL_PTR);
+	buf_pos += n;
+	blocks -= n;
 	bytes -= (long) rest;
   }
 }
@@ -593,13 +646,13 @@ register char *file;
       case S_IFREG:
 	header.dbuf.typeflag = '0';
 	string_print(header.member.m_checksum, "%I ", checksum());
-	mwrite(tar_fd, (char *) &header, sizeof(header));
+	memcpy(write_block(), header.hdr_block, BLOCK_SIZE);
 	copy(path_name(file), fd, tar_fd, (long) st.st_size);
 	break;
       case S_IFDIR:
 	header.dbuf.typeflag = '5';
 	string_print(header.member.m_checksum, "%I ", checksum());
-	mwrite(tar_fd, (char *) &header, sizeof(header));
+	memcpy(write_block(), header.hdr_block, BLOCK_SIZE);
 	if (NULL == getcwd(cwd, 129))
 		string_print(NIL_PTR, "Error: cannot getcwd()\n");
 	else if (chdir(file) < 0)
@@ -644,7 +697,7 @@ register char *file;
 	header.dbuf.typeflag = '6';
 	verb_print("read fifo", file);
 	string_print(header.member.m_checksum, "%I ", checksum());
-	mwrite(tar_fd, (char *) &header, sizeof(header));
+	memcpy(write_block(), header.hdr_block, BLOCK_SIZE);
 	break;
 #endif
       case S_IFBLK:
@@ -653,7 +706,7 @@ register char *file;
 			 "read block device %s major %s minor %s\n",
 		  file, header.dbuf.devmajor, header.dbuf.devminor);
 	string_print(header.member.m_checksum, "%I ", checksum());
-	mwrite(tar_fd, (char *) &header, sizeof(header));
+	memcpy(write_block(), header.hdr_block, BLOCK_SIZE);
 	break;
       case S_IFCHR:
 	header.dbuf.typeflag = '3';
@@ -661,14 +714,14 @@ register char *file;
 		     "read character device %s major %s minor %s\n",
 		  file, header.dbuf.devmajor, header.dbuf.devminor);
 	string_print(header.member.m_checksum, "%I ", checksum());
-	mwrite(tar_fd, (char *) &header, sizeof(header));
+	memcpy(write_block(), header.hdr_block, BLOCK_SIZE);
 	break;
       case -1 & S_IFMT:
 	header.dbuf.typeflag = '1';
 	if (verbose_flag) string_print(NIL_PTR, "linked %s to %s\n",
 			     header.dbuf.linkname, file);
 	string_print(header.member.m_checksum, "%I ", checksum());
-	mwrite(tar_fd, (char *) &header, sizeof(header));
+	memcpy(write_block(), header.hdr_block, BLOCK_SIZE);
 	break;
       default:
 	string_print(NIL_PTR, "Tar: %s unknown file type. Not added.\n", file);
@@ -790,34 +843,84 @@ clear_header()
   while (ptr < &header.hdr_block[BLOCK_SIZE]) *ptr++ = '\0';
 }
 
+/* Adjust_boundary() ends the archive with two zero blocks, and fills up the
+ * last record with more of them.
+ */
 adjust_boundary()
 {
   clear_header();
-  mwrite(tar_fd, (char *) &header, sizeof(header));
-#ifndef POSIX_COMP
-  while (total_blocks++ < BLOCK_BOUNDARY)
-	mwrite(tar_fd, (char *) &header, sizeof(header));
-#else
-  mwrite(tar_fd, (char *) &header, sizeof(header));
-#endif
-  (void) close(tar_fd);
+  memcpy(write_block(), header.hdr_block, BLOCK_SIZE);
+  memcpy(write_block(), header.hdr_block, BLOCK_SIZE);
+  while (total_blocks % nblock != 0)
+	memcpy(write_block(), header.hdr_block, BLOCK_SIZE);
+  flush_buffer();
+  if (streamclose(tar_fd) < 0) error("Tar: write error.", NIL_PTR);
 }
 
-mread(fd, address, bytes)
-int fd, bytes;
-char *address;
+/* Init_buffer() sets up tar_buf for an archive with status *st. */
+init_buffer(st)
+struct stat *st;
 {
-  if (read(fd, address, bytes) != bytes) error("Tar: read error.", NIL_PTR);
+  int mode = st->st_mode & S_IFMT;
+  unsigned size;
+
+  if (nblock == 0) nblock = (mode == S_IFCHR || mode == S_IFBLK) ? BLOCKING : 1;
+  size = (mode == S_IFCHR) ? nblock * BLOCK_SIZE : 0;
+  if ((tar_buf = streambuf(&size)) == NIL_PTR || size < nblock * BLOCK_SIZE)
+	error("Tar: not enough memory for the blocking factor", NIL_PTR);
+  buf_blocks = size / BLOCK_SIZE;
+  buf_blocks -= buf_blocks % nblock;
+  buf_pos = buf_cnt = 0;
 }
 
-mwrite(fd, address, bytes)
-int fd, bytes;
-char *address;
+/* Fill_buffer() reads the next records of the archive into tar_buf.  A
+ * read() from a pipe can stop anywhere, so it goes on to the end of a block.
+ */
+fill_buffer()
 {
-  if (write(fd, address, bytes) != bytes)
+  register int n, m;
+
+  n = read(tar_fd, tar_buf, buf_blocks * BLOCK_SIZE);
+  while (n > 0 && n % BLOCK_SIZE != 0) {
+	if ((m = read(tar_fd, tar_buf + n, BLOCK_SIZE - n % BLOCK_SIZE)) <= 0)
+		break;
+	n += m;
+  }
+  if (n < BLOCK_SIZE) error("Tar: read error.", NIL_PTR);
+  buf_cnt = n / BLOCK_SIZE;
+  buf_pos = 0;
+}
+
+/* Read_block() returns the next block of the archive. */
+char *read_block()
+{
+  if (buf_pos == buf_cnt) fill_buffer();
+  return &tar_buf[(buf_pos++) * BLOCK_SIZE];
+}
+
+/* Flush_buffer() writes out the blocks in tar_buf. */
+flush_buffer()
+{
+  register int n = buf_pos * BLOCK_SIZE;
+
+  if (n != 0 && write(tar_fd, tar_buf, n) != n)
 	error("Tar: write error.", NIL_PTR);
+  buf_pos = 0;
+}
 
+/* Write_block() returns room for the next block of the archive. */
+char *write_block()
+{
+  if (buf_pos == buf_blocks) flush_buffer();
   total_blocks++;
+  return &tar_buf[(buf_pos++) * BLOCK_SIZE];
+}
+
+mread(fd, address, bytes)
+int fd, bytes;
+char *address;
+{
+  if (read(fd, address, bytes) != bytes) error("Tar: read error.", NIL_PTR);
 }
 
 char output[BLOCK_SIZE];
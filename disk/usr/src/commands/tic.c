@@ -0,0 +1,262 @@
+/* tic - compile a termcap file */
+
+/* Usage: tic [file]
+ *
+ * The termcap file (default /etc/termcap) is compiled into file.db, from
+ * which tgetent() reads an entry with a few reads instead of scanning the
+ * text, and in which tgetnum(), tgetflag() and tgetstr() find capabilities
+ * already decoded (see <tcdb.h>).  The library uses the compiled file only
+ * while the text file keeps the modification time it had when tic ran, so
+ * tic must be run again after the text is edited.
+ *
+ * Names longer than TC_NAMELEN are not put in the index, and the names of
+ * an entry whose compiled form would not fit in a tgetent() buffer are put
+ * in with length 0; tgetent() finds both in the text as before.
+ */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <termcap.h>
+#include <tcdb.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdio.h>
+
+#define MAXCAPS	  255		/* capabilities in an entry */
+#define MAXSLOT	 2048		/* slots in the index */
+#define WSLOTS	  256		/* slots written at a time */
+
+extern char *capab;		/* the entry tgetnum() and tgetstr() look in */
+
+struct cap {
+  char id[3];			/* the id, as a string */
+  char type;			/* '#', '=' or TC_FLAG */
+} caps[MAXCAPS];
+
+char bp[TC_BUFSIZE];		/* an entry, as tgetent() reads it */
+char rec[2 * TC_BUFSIZE];	/* its compiled form, and room to spare */
+char *slots;			/* the hash index */
+unsigned nslot;
+char *prog;
+
+int cmpcap();
+void addnames(), enter(), fatal();
+
+main(argc, argv)
+int argc;
+char *argv[];
+{
+  char *file, db[PATH_MAX + 1], head[TC_HSIZE];
+  register char *cp, *np;
+  struct stat st;
+  FILE *fp;
+  int fd, len, names;
+  unsigned n;
+  long offset;
+
+  prog = argv[0];
+  if (argc > 2) {
+	fprintf(stderr, "Usage: %s [file]\n", prog);
+	exit(1);
+  }
+  file = argc == 2 ? argv[1] : "/etc/termcap";
+  if (strlen(file) + 3 > PATH_MAX) fatal(file, "name too long");
+  strcpy(db, file);
+  strcat(db, ".db");
+  if ((fp = fopen(file, "r")) == (FILE *) NULL || fstat(fileno(fp), &st) < 0)
+	fatal(file, "cannot open");
+
+  /* Count the names, to size the index at less than half full. */
+  names = 0;
+  while (getentry(fp))
+	for (names++, cp = bp; *cp != ':' && *cp != '\0'; cp++)
+		if (*cp == '|') names++;
+  for (nslot = 4; nslot < 2 * (names + 1) + 1; nslot <<= 1)
+	if (nslot == MAXSLOT) fatal(file, "too many names");
+  if ((slots = calloc(nslot, TC_SSIZE)) == (char *) NULL)
+	fatal(file, "out of memory");
+
+  /* Write the entries after the index, and enter their names. */
+  if ((fd = creat(db, 0644)) < 0) fatal(db, "cannot create");
+  offset = TC_HSIZE + (long) nslot * TC_SSIZE;
+  rewind(fp);
+  while (getentry(fp)) {
+	if ((len = compile()) == 0) {
+		for (cp = bp; isspace(*cp); cp++);
+		for (np = cp; *np != '|' && *np != ':' && *np != '\0'; np++);
+		fprintf(stderr, "%s: %.*s: too big to compile\n",
+						prog, (int) (np - cp), cp);
+
+		/* Keep its names from a later entry, as the text does. */
+		addnames(0, 0L);
+		continue;
+	}
+	if (lseek(fd, offset, SEEK_SET) < 0 || write(fd, rec, len) != len)
+		fatal(db, "write error");
+	addnames(len, offset);
+	offset += len;
+  }
+  fclose(fp);
+
+  /* The header goes last, so that a half-made file is never used. */
+  tcput2(head + TC_HMAGIC, TC_MAGIC);
+  tcput2(head + TC_HNSLOT, nslot);
+  tcput4(head + TC_HMTIME, (long) st.st_mtime);
+  if (lseek(fd, (long) TC_HSIZE, SEEK_SET) < 0) fatal(db, "write error");
+  for (n = 0; n < nslot; n += len) {
+	len = nslot - n < WSLOTS ? nslot - n : WSLOTS;
+	if (write(fd, slots + n * TC_SSIZE, len * TC_SSIZE) != len * TC_SSIZE)
+		fatal(db, "write error");
+  }
+  if (lseek(fd, 0L, SEEK_SET) < 0 || write(fd, head, TC_HSIZE) != TC_HSIZE ||
+      close(fd) < 0)
+	fatal(db, "write error");
+  exit(0);
+}
+
+getentry(fp)
+FILE *fp;
+{
+/* Read the next entry into bp, joining its lines as tgetent() does, and
+ * skipping comments.  Returns 0 at the end of the file.
+ */
+
+  register int len;
+  register char *cp;
+
+  for (;;) {
+	len = 0;
+	do {
+		if (fgets(&bp[len], TC_BUFSIZE - len, fp) == (char *) NULL)
+			return(0);
+		len = strlen(bp) - 2;
+	} while (len >= 0 && bp[len] == '\\');
+
+	for (cp = bp; isspace(*cp); cp++);
+	if (*cp != '#' && *cp != '\0') return(1);
+  }
+}
+
+compile()
+{
+/* Compile the entry in bp into rec.  Returns the length, or 0 if it does
+ * not fit.
+ */
+
+  register char *cp, *rp;
+  register int i, n;
+  char *sp, *area;
+  int len;
+
+  /* Find the capabilities the same way tgetnum() and friends do. */
+  n = 0;
+  for (cp = bp; (cp = strchr(cp, ':')) != (char *) NULL;) {
+	for (cp++; isspace(*cp); cp++);
+	if (cp[0] == '\0' || cp[0] == ':' || cp[1] == '\0' || cp[1] == ':')
+		continue;
+	caps[n].id[0] = cp[0];
+	caps[n].id[1] = cp[1];
+	caps[n].id[2] = '\0';
+	caps[n].type = (cp[2] == '#' || cp[2] == '=') ? cp[2] : TC_FLAG;
+	for (i = 0; i < n; i++)
+		if (strcmp(caps[i].id, caps[n].id) == 0 &&
+					caps[i].type == caps[n].type)
+			break;
+	if (i == n && ++n == MAXCAPS) return(0);
+  }
+  qsort((void *) caps, (size_t) n, sizeof(caps[0]), cmpcap);
+
+  /* The text, the table, and the strings after it. */
+  len = strlen(bp) + 1;
+  if (len + TC_CSIZE + n * TC_RSIZE > TC_BUFSIZE) return(0);
+  memcpy(rec, bp, len);
+  rec[len] = n;
+  rp = rec + len + TC_CSIZE;
+  sp = rp + n * TC_RSIZE;
+  capab = bp;
+  for (i = 0; i < n; i++, rp += TC_RSIZE) {
+	rp[TC_RID] = caps[i].id[0];
+	rp[TC_RID + 1] = caps[i].id[1];
+	rp[TC_RTYPE] = caps[i].type;
+	rp[TC_RLEN] = 0;
+	tcput2(rp + TC_RVALUE, 0);
+	if (caps[i].type == '#') {
+		tcput2(rp + TC_RVALUE, tgetnum(caps[i].id));
+	} else if (caps[i].type == '=') {
+		/* Decoding never makes a string longer; there is room. */
+		area = sp;
+		tgetstr(caps[i].id, &area);
+		if (area - sp > 255) return(0);
+		rp[TC_RLEN] = area - sp;
+		tcput2(rp + TC_RVALUE, (int) (sp - (rec + len)));
+		sp = area;
+	}
+  }
+  return(sp - rec <= TC_BUFSIZE ? sp - rec : 0);
+}
+
+int cmpcap(p, q)
+register struct cap *p, *q;
+{
+/* Order capabilities by id and then type, the bytes taken as unsigned. */
+
+  if (p->id[0] != q->id[0]) return((p->id[0] & 0377) - (q->id[0] & 0377));
+  if (p->id[1] != q->id[1]) return((p->id[1] & 0377) - (q->id[1] & 0377));
+  return((p->type & 0377) - (q->type & 0377));
+}
+
+void addnames(len, offset)
+int len;
+long offset;
+{
+/* Enter the names of the entry in bp.  Each is followed by '|' or by the
+ * ':' that ends them.
+ */
+  char name[TC_NAMELEN + 1];
+  register char *cp, *np;
+
+  for (cp = bp; isspace(*cp); cp++);
+  for (;;) {
+	for (np = cp; *np != '|' && *np != ':' && *np != '\0'; np++);
+	if (*np == '\0') break;
+	if (np > cp && np - cp <= TC_NAMELEN) {
+		strncpy(name, cp, (size_t) (np - cp));
+		name[np - cp] = '\0';
+		enter(name, len, offset);
+	}
+	if (*np++ != '|') break;
+	cp = np;
+  }
+}
+
+void enter(name, len, offset)
+char *name;
+int len;
+long offset;
+{
+/* Put a name in the index, unless an earlier entry has it. */
+
+  register char *sp;
+  unsigned h;
+
+  tchash(name, h);
+  for (h &= nslot - 1;; h = (h + 1) & (nslot - 1)) {
+	sp = slots + h * TC_SSIZE;
+	if (*sp == '\0') break;
+	if (strncmp(sp, name, TC_NAMELEN) == 0) return;
+  }
+  strncpy(sp + TC_SNAME, name, TC_NAMELEN);
+  tcput2(sp + TC_SLEN, len);
+  tcput4(sp + TC_SOFFSET, offset);
+}
+
+void fatal(s1, s2)
+char *s1, *s2;
+{
+  fprintf(stderr, "%s: %s: %s\n", prog, s1, s2);
+  exit(1);
+}
@@ -46,6 +46,10 @@ int only_search;		/* if NO_READ, don't read, else act normal */
 
   register struct buf *bp, *prev_ptr;
 
+#if CACHE_TRACE
+  printf("g %u %u %d\n", dev, block, only_search);
+#endif
+
   /* Search the hash chain for (dev, block). */
   if (dev != NO_DEV) {
 	/* ??? DEBUG What if dev == NO_DEV ??? */
@@ -127,6 +131,9 @@ int block_type;			/* INODE_BLOCK, DIRECTORY_BLOCK, or whatever */
   register struct buf *next_ptr, *prev_ptr;
 
   if (bp == NIL_BUF) return;	/* it is easier to check here than in caller */
+#if CACHE_TRACE
+  printf("p %u %u %d %d\n", bp->b_dev, bp->b_blocknr, block_type, bp->b_dirt);
+#endif
 
   /* If block is no longer in use, first remove it from LRU chain. */
   bp->b_count--;		/* there is one use fewer now */
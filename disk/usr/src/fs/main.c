@@ -27,6 +27,31 @@
 #define RAM_IMAGE (dev_t)0x303	/* major-minor dev where root image is kept */
 #define DEMO_RAM_OFFSET  200	/* location of RAM image on demo diskette */
 
+#if FASTLOAD
+#define TRACK_BLOCKS       9	/* blocks per cylinder on a 720K diskette */
+#define LOAD_TRACKS        2	/* max # of cylinders read in one transfer */
+#define track_used(t) \
+  ((t) < 8 * sizeof(used_tracks) && ((used_tracks[(t) >> 3] >> ((t) & 7)) & 1))
+
+/* Bit map of the boot device tracks that hold a part of the root image. */
+PRIVATE char used_tracks[((MAX_RAM + DEMO_RAM_OFFSET)/TRACK_BLOCKS + 8) / 8];
+#endif
+
+#if BOOT_TIMING
+#define BP_START           0	/* FS starts initializing */
+#define BP_INIT            1	/* buffer pool and boot parameters set up */
+#define BP_RAM             2	/* RAM disk allocated */
+#define BP_ZMAP            3	/* zone map of the root image scanned */
+#define BP_LOAD            4	/* root image loaded into the RAM disk */
+#define BP_SUPER           5	/* root super block and bit maps loaded */
+#define BP_COUNT           6
+#define BOOT_PHASE(p)	boot_phase(p)
+
+PRIVATE long boot_ticks[BP_COUNT];	/* clock ticks at the end of each phase */
+#else
+#define BOOT_PHASE(p)
+#endif
+
 FORWARD void buf_pool();
 FORWARD void fs_init();
 FORWARD void get_boot_parameters();
@@ -40,7 +65,14 @@ FORWARD int askdev();
 
 #if FASTLOAD
 FORWARD void fastload();
-FORWARD int lastused();
+FORWARD void load_blocks();
+FORWARD int mark_tracks();
+FORWARD int track_map();
+#endif
+
+#if BOOT_TIMING
+FORWARD void boot_phase();
+FORWARD void boot_report();
 #endif
 
 #if (CHIP == INTEL)
@@ -145,10 +177,16 @@ PRIVATE void fs_init()
   int i;
   dev_t d;			/* device to fetch the superblock from */
 
+  BOOT_PHASE(BP_START);
   buf_pool();			/* initialize buffer pool */
   get_boot_parameters();
+  BOOT_PHASE(BP_INIT);
   d = load_ram();		/* init RAM disk, load if it is root */
   load_super(d);		/* Load super block for root device */
+  BOOT_PHASE(BP_SUPER);
+#if BOOT_TIMING
+  boot_report();
+#endif
 
   /* Initialize the 'fproc' fields for process 0 and process 2. */
   for (i = 0; i < 3; i+= 2) {
@@ -325,14 +363,17 @@ got_root_dev:
 	 boot_parameters.bp_processor ? "protected" : "real");
 #endif
 
+  BOOT_PHASE(BP_RAM);
+
   /* If the root device is not the RAM disk, it doesn't need loading. */
   if (ROOT_DEV != DEV_RAM) return(super_dev);	/* ROOT_DEV is a macro */
 
-  /* Copy the blocks one at a time from the root diskette to the RAM */
-
 #if FASTLOAD
-  fastload(root_device, (char *) m1.POSITION);	/* assumes 32 bit pointers */
+  /* Copy the used tracks of the root image straight into the RAM disk. */
+  fastload(root_device, (char *) m1.POSITION, ram_offset, count);
 #else
+  /* Copy the blocks one at a time from the root diskette to the RAM */
+
   printf("Loading RAM disk.                            Loaded:   0K ");
 
   inode[0].i_mode = I_BLOCK_SPECIAL;	/* temp inode for rahead */
@@ -351,6 +392,7 @@ got_root_dev:
 	if (k_loaded % 5 == 0) printf("\b\b\b\b\b\b%4DK %c", k_loaded, 0);
   }
 #endif /* FASTLOAD */
+  BOOT_PHASE(BP_LOAD);
 
   if ( ((root_device ^ DEV_FD0) & ~BYTE) == 0 )
 	printf("\rRAM disk loaded.    Please remove root diskette.           \n\n");
@@ -451,77 +493,204 @@ PRIVATE askdev()
 /*===========================================================================*
  *				fastload				     *
  *===========================================================================*/
-PRIVATE void fastload(boot_dev, address)
-dev_t boot_dev;
-char *address;
+PRIVATE void fastload(boot_dev, address, offset, count)
+dev_t boot_dev;			/* device holding the root image */
+char *address;			/* physical address of the RAM disk */
+block_nr offset;		/* block offset of the image on 'boot_dev' */
+int count;			/* size of the image in blocks */
 {
-  register i, blocks;
-  register long position;
+/* Copy the root image to the RAM disk with a few large transfers.  Each
+ * transfer covers whole tracks of the boot device, and tracks that hold
+ * no used zones are skipped altogether, so an image that is mostly empty
+ * loads in a fraction of the time.
+ */
+
+  register int t, n;
+  int first, last, blocks;
+  long loaded, to_load;
 
-  blocks = lastused(boot_dev);
+  to_load = (long) track_map(boot_dev, offset, count) * BLOCK_SIZE;
   printf("Loading RAM disk. To load: %4DK           Loaded:   0K %c",
-	((long)blocks * BLOCK_SIZE) / 1024, 0);
-  position = 0;
-  while (blocks) {
-	i = blocks;
-	if (i > (18*1024)/BLOCK_SIZE)
-		i = (18*1024)/BLOCK_SIZE;
-	blocks -= i;
-	i *= BLOCK_SIZE;
-	m1.m_type = DISK_READ;
-	m1.DEVICE = (boot_dev >> MINOR) & BYTE;
-	m1.POSITION = position;
-	m1.PROC_NR = HARDWARE;
-	m1.ADDRESS = address;
-	m1.COUNT = i;
-	(*dmap[(boot_dev >> MAJOR) & BYTE].dmap_rw)(
-		dmap[(boot_dev >> MAJOR) & BYTE].dmap_task,
-		&m1
-	);
-	if (m1.REP_STATUS < 0)
-		panic("Disk error loading BOOT disk", m1.REP_STATUS);
-	position += i;
-	address += i;
-	printf("\b\b\b\b\b\b%4DK %c", position / 1024L, 0);
+	to_load / 1024, 0);
+  BOOT_PHASE(BP_ZMAP);
+
+  loaded = 0;
+  first = offset;		/* first device block still to be looked at */
+  last = offset + count;	/* first device block beyond the image */
+  t = first / TRACK_BLOCKS;
+  while (first < last) {
+	/* Skip the tracks that contain nothing but free zones. */
+	if (!track_used(t)) {
+		first = ++t * TRACK_BLOCKS;
+		continue;
+	}
+
+	/* Gather as many used tracks in a row as fit in one transfer. */
+	for (n = 1; n < LOAD_TRACKS && track_used(t + n); n++)
+		;
+	t += n;
+	blocks = t * TRACK_BLOCKS - first;
+	if (blocks > last - first) blocks = last - first;
+	load_blocks(boot_dev, address + (long) (first - offset) * BLOCK_SIZE,
+							first, blocks);
+	first += blocks;
+	loaded += (long) blocks * BLOCK_SIZE;
+	printf("\b\b\b\b\b\b%4DK %c", loaded / 1024L, 0);
   }
 }
 
 /*===========================================================================*
- *				lastused				     *
+ *				load_blocks				     *
  *===========================================================================*/
-PRIVATE int lastused(boot_dev)
-dev_t boot_dev;
+PRIVATE void load_blocks(boot_dev, address, block, blocks)
+dev_t boot_dev;			/* device holding the root image */
+char *address;			/* physical address to load to */
+block_nr block;			/* first block to load */
+int blocks;			/* how many blocks to load */
 {
-  register i, w, b, last, this, zbase;
-  register struct super_block *sp = &super_block[0];
-  register struct buf *bp;
+/* Read 'blocks' consecutive blocks straight into memory with a single
+ * request to the boot device's driver.
+ */
+
+  int major;
+
+  major = (boot_dev >> MAJOR) & BYTE;
+  m1.m_type = DISK_READ;
+  m1.DEVICE = (boot_dev >> MINOR) & BYTE;
+  m1.POSITION = (long) block * BLOCK_SIZE;
+  m1.PROC_NR = HARDWARE;
+  m1.ADDRESS = address;
+  m1.COUNT = blocks * BLOCK_SIZE;
+  (*dmap[major].dmap_rw)(dmap[major].dmap_task, &m1);
+  if (m1.REP_STATUS < 0)
+	panic("Disk error loading BOOT disk", m1.REP_STATUS);
+}
+
+/*===========================================================================*
+ *				track_map				     *
+ *===========================================================================*/
+PRIVATE int track_map(boot_dev, offset, count)
+dev_t boot_dev;			/* device holding the root image */
+block_nr offset;		/* block offset of the image on 'boot_dev' */
+int count;			/* size of the image in blocks */
+{
+/* Scan the zone bit map of the root image and mark in 'used_tracks' every
+ * track of the boot device that holds part of the boot block, super block,
+ * bit maps, inodes or a zone in use.  Return the number of blocks to load.
+ */
+
   register short *wptr, *wlim;
+  register int b, w;
+  int i, zbase, zones, zone_blocks, blocks;
+  bit_nr bit;
+  struct super_block *sp = &super_block[0];
+  struct buf *bp;
 
+  for (i = 0; i < sizeof(used_tracks); i++) used_tracks[i] = 0;
+  zone_blocks = 1 << sp->s_log_zone_size;
+  zones = sp->s_nzones - sp->s_firstdatazone + 1;	/* bits in the map */
+
+  /* Everything in front of the first data zone is always needed. */
+  blocks = mark_tracks(offset, sp->s_firstdatazone << sp->s_log_zone_size);
+
+  /* Bit 'bit' of the zone map is zone 'bit + s_firstdatazone - 1'.  Bit 0
+   * is never used for a zone, so the scan starts at bit 1.
+   */
   zbase = SUPER_BLOCK + 1 + sp->s_imap_blocks;
-  this = sp->s_firstdatazone;
-  last = this - 1;
-  for (i = 0; i < sp->s_zmap_blocks; i++) {
-	bp = get_block(boot_dev, (block_nr) zbase + i, NORMAL);
-	wptr = (short *)&bp->b_data[0];
-	wlim = (short *)&bp->b_data[BLOCK_SIZE];
-	while (wptr != wlim) {
+  bit = 0;
+  for (i = 0; i < sp->s_zmap_blocks && bit < zones; i++) {
+	bp = get_block(boot_dev, (block_nr) (offset + zbase + i), NORMAL);
+	wptr = (short *) &bp->b_data[0];
+	wlim = (short *) &bp->b_data[BLOCK_SIZE];
+	while (wptr != wlim && bit < zones) {
 		w = *wptr++;
-		for (b = 0; b < 8*sizeof(*wptr); b++) {
-			if (this == sp->s_nzones) {
-				put_block(bp, ZMAP_BLOCK);
-				return(last << sp->s_log_zone_size);
-			}
-			if ((w>>b) & 1)
-				last = this;
-			this++;
+		if (w == 0) {
+			bit += 8*sizeof(*wptr);	/* a whole word of free zones */
+			continue;
 		}
+		for (b = 0; b < 8*sizeof(*wptr) && bit < zones; b++, bit++)
+			if (bit != 0 && ((w >> b) & 1))
+				blocks += mark_tracks(offset + (int)
+				  (bit + sp->s_firstdatazone - 1) * zone_blocks,
+				  zone_blocks);
 	}
 	put_block(bp, ZMAP_BLOCK);
   }
-  panic("lastused", NO_NUM);
+  if (blocks > count) blocks = count;
+  return(blocks);
+}
+
+/*===========================================================================*
+ *				mark_tracks				     *
+ *===========================================================================*/
+PRIVATE int mark_tracks(block, blocks)
+int block;			/* first device block in use */
+int blocks;			/* number of blocks in use */
+{
+/* Mark the tracks holding 'blocks' blocks from 'block' on as used.  Return
+ * the number of blocks in tracks that were not marked before.
+ */
+
+  register int t, last;
+  int newly;
+
+  newly = 0;
+  last = (block + blocks - 1) / TRACK_BLOCKS;
+  for (t = block / TRACK_BLOCKS; t <= last; t++) {
+	if (t >= 8 * sizeof(used_tracks)) break;
+	if (!track_used(t)) {
+		used_tracks[t >> 3] |= 1 << (t & 7);
+		newly += TRACK_BLOCKS;
+	}
+  }
+  return(newly);
 }
 #endif /* FASTLOAD */
 
+#if BOOT_TIMING
+/*===========================================================================*
+ *				boot_phase				     *
+ *===========================================================================*/
+PRIVATE void boot_phase(phase)
+int phase;			/* which phase has just been completed */
+{
+/* Record the time at which a boot phase ended.  The times are kept until
+ * the root file system is up and then reported by boot_report().
+ */
+
+  message mess;
+
+  mess.m_type = GET_UPTIME;
+  if (sendrec(CLOCK, &mess) != OK) return;
+  boot_ticks[phase] = mess.NEW_TIME;
+}
+
+/*===========================================================================*
+ *				boot_report				     *
+ *===========================================================================*/
+PRIVATE void boot_report()
+{
+/* Tell how long each phase of the file system initialization took, in
+ * tenths of a second.
+ */
+
+  static char *name[BP_COUNT] = {
+	"", "init", "ram", "zmap", "load", "super"
+  };
+  register int i;
+  long tenths;
+
+  printf("Boot times:");
+  for (i = 1; i < BP_COUNT; i++) {
+	if (boot_ticks[i] < boot_ticks[i - 1]) boot_ticks[i] = boot_ticks[i-1];
+	tenths = ((boot_ticks[i] - boot_ticks[i - 1]) * 10 + HZ/2) / HZ;
+	printf(" %s %D.%Ds", name[i], tenths / 10, tenths % 10);
+  }
+  tenths = ((boot_ticks[BP_COUNT - 1] - boot_ticks[0]) * 10 + HZ/2) / HZ;
+  printf(", total %D.%Ds\n\n", tenths / 10, tenths % 10);
+}
+#endif /* BOOT_TIMING */
+
 /*===========================================================================*
  *				get_boot_parameters			     *
  *===========================================================================*/
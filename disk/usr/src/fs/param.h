@@ -10,6 +10,7 @@
 #define erki          m.m1_p1
 #define fd	      m.m1_i1
 #define fd2	      m.m1_i2
+#define dir_fd	      m.m1_i3
 #define ioflags       m.m1_i3
 #define group	      m.m1_i3
 #define real_grp_id   m.m1_i2
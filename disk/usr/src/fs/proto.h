@@ -104,7 +104,9 @@ int rw_user();
 int do_chdir();
 int do_chroot();
 int do_fstat();
+int do_getdents();
 int do_stat();
+int do_statat();
 
 /* super.c */
 bit_nr alloc_bit();
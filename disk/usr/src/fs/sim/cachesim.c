@@ -0,0 +1,460 @@
+/* cachesim - buffer cache simulator */
+
+/* Cachesim runs the real file system code (see simfs.c) on the host, on a
+ * file system image held in memory, and reports how well the buffer cache
+ * does.  It can run built-in workloads, or replay a trace of get_block() and
+ * put_block() calls.  Traces are written by cachesim itself (-w), or by a
+ * MINIX kernel built with CACHE_TRACE set in <minix/config.h>, whose console
+ * output can be fed in as it is; lines that are not trace records are skipped.
+ *
+ *	Usage: cachesim [-b blocks] [-i inodes] [-c blocks/cyl] [-s step_ms]
+ *			[-l latency_ms] [-x transfer_ms] [-w trace] [-r trace]
+ *			[workload ...]
+ *
+ * The workloads are untar, find, cat and compile; the default is all of them
+ * in that order.  The cache is emptied between workloads.  The cache size is
+ * the NR_BUFS the FS objects were compiled with, see the Makefile.
+ *
+ * The time is that of a disk whose blocks are numbered in cylinder order.
+ * A request costs a seek (per cylinder crossed) and the rotational latency,
+ * except for a block that follows the previous one in the same scattered
+ * request, which costs only its transfer time.
+ *
+ * The image uses the host's own layout of the FS structures (a d_inode, for
+ * one, is larger on a 64-bit host), so it is good for measuring the cache and
+ * nothing else; it is never written to a file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "sim.h"
+
+#ifndef _PROTOTYPE
+#define _PROTOTYPE(f, a)	f a
+#endif
+
+#define NAME_MAX	14	/* MINIX file name length */
+#define DIR_SIZE	16	/* a MINIX directory entry */
+#define CHUNK		1024	/* bytes per read or write */
+
+struct stats {
+  long lookups;			/* get_block() other than prefetch */
+  long hits;			/* ... found in the cache */
+  long prefetch;		/* prefetch lookups */
+  long reads;			/* blocks read from the disk */
+  long writes;			/* blocks written to the disk */
+  long requests;		/* requests that needed a seek */
+  double ms;			/* simulated disk time */
+} st;
+
+char *image;			/* the disk */
+long nblocks = 4000;		/* size of the file system */
+int ninodes = 800;
+int cylblocks = 9;		/* blocks per cylinder */
+double step_ms = 3.0;		/* head step time per cylinder */
+double latency_ms = 100.0;	/* average rotational latency */
+double transfer_ms = 22.0;	/* time to transfer one block */
+long cur_cyl;			/* where the head is */
+FILE *trace;			/* where -w writes the trace */
+
+char data[CHUNK];
+
+_PROTOTYPE(int main, (int argc, char **argv));
+_PROTOTYPE(void usage, (void));
+_PROTOTYPE(void report, (char *what));
+_PROTOTYPE(void replay, (char *file));
+_PROTOTYPE(void untar, (void));
+_PROTOTYPE(void find, (char *dir));
+_PROTOTYPE(void do_find, (void));
+_PROTOTYPE(long cat, (char *path));
+_PROTOTYPE(void do_cat, (char *dir));
+_PROTOTYPE(void compile, (void));
+_PROTOTYPE(void make_file, (char *path, long size));
+_PROTOTYPE(void check, (int r, char *what, char *path));
+_PROTOTYPE(int printk, (char *fmt, ...));
+
+int main(argc, argv)
+int argc;
+char **argv;
+{
+  int i;
+  char *replay_file = NULL;
+
+  for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+	if (argv[i][2] != 0 || i + 1 == argc) usage();
+	switch (argv[i][1]) {
+	    case 'b':	nblocks = atol(argv[++i]);	break;
+	    case 'i':	ninodes = atoi(argv[++i]);	break;
+	    case 'c':	cylblocks = atoi(argv[++i]);	break;
+	    case 's':	step_ms = atof(argv[++i]);	break;
+	    case 'l':	latency_ms = atof(argv[++i]);	break;
+	    case 'x':	transfer_ms = atof(argv[++i]);	break;
+	    case 'r':	replay_file = argv[++i];	break;
+	    case 'w':
+		if ((trace = fopen(argv[++i], "w")) == NULL) {
+			perror(argv[i]);
+			exit(1);
+		}
+		break;
+	    default:	usage();
+	}
+  }
+  if (cylblocks < 1 || nblocks < 100) usage();
+
+  if ((image = calloc((size_t) nblocks, 1024)) == NULL) {
+	fprintf(stderr, "cachesim: no memory for %ld blocks\n", nblocks);
+	exit(1);
+  }
+  sim_init();
+  if (sim_mkfs(nblocks, ninodes) != 0 || sim_mount() != 0) {
+	fprintf(stderr, "cachesim: cannot make a file system of %ld blocks\n",
+								nblocks);
+	exit(1);
+  }
+  memset(&st, 0, sizeof(st));		/* don't count mkfs */
+
+  printf("%d buffers, %ld blocks, %d inodes\n\n", sim_nbufs(), nblocks,
+								ninodes);
+  printf("%-10s %8s %8s %6s %8s %8s %8s %8s %9s\n", "workload", "lookups",
+	"hits", "hit%", "prefetch", "reads", "writes", "seeks", "disk sec");
+
+  if (replay_file != NULL) {
+	replay(replay_file);
+	report("replay");
+  } else if (i == argc) {
+	untar();	report("untar");
+	do_find();	report("find");
+	do_cat("/");	report("cat");
+	compile();	report("compile");
+  } else {
+	for (; i < argc; i++) {
+		if (strcmp(argv[i], "untar") == 0) untar();
+		else if (strcmp(argv[i], "find") == 0) do_find();
+		else if (strcmp(argv[i], "cat") == 0) do_cat("/");
+		else if (strcmp(argv[i], "compile") == 0) compile();
+		else usage();
+		report(argv[i]);
+	}
+  }
+  if (trace != NULL) fclose(trace);
+  return(0);
+}
+
+
+void usage()
+{
+  fprintf(stderr, "Usage: cachesim [-b blocks] [-i inodes] [-c blocks/cyl] [-s step_ms]\n\t\t[-l latency_ms] [-x transfer_ms] [-w trace] [-r trace]\n\t\t[untar] [find] [cat] [compile]\n");
+  exit(1);
+}
+
+
+void report(what)
+char *what;
+{
+/* Flush the cache, print the numbers for one workload and start afresh. */
+
+  sim_drop();
+  printf("%-10s %8ld %8ld %5.1f%% %8ld %8ld %8ld %8ld %9.2f\n", what,
+	st.lookups, st.hits,
+	st.lookups == 0 ? 0.0 : 100.0 * st.hits / st.lookups,
+	st.prefetch, st.reads, st.writes, st.requests, st.ms / 1000.0);
+  memset(&st, 0, sizeof(st));
+}
+
+
+void replay(file)
+char *file;
+{
+  FILE *f;
+  char line[128];
+  int dev, a, b, n;
+  long block;
+
+  if ((f = fopen(file, "r")) == NULL) {
+	perror(file);
+	exit(1);
+  }
+  n = 0;
+  while (fgets(line, sizeof(line), f) != NULL) {
+	if (line[0] == 'g' && sscanf(line+1, "%d %ld %d", &dev, &block, &a) == 3)
+		sim_get(dev, block, a);
+	else
+	if (line[0] == 'p' &&
+	    sscanf(line+1, "%d %ld %d %d", &dev, &block, &a, &b) == 4)
+		sim_put(dev, block, a, b);
+	else
+		continue;
+	n++;
+  }
+  fclose(f);
+  if (n == 0) fprintf(stderr, "cachesim: no trace records in %s\n", file);
+}
+
+
+/* The workloads.  Untar makes a source tree: 8 directories of 12 files each,
+ * sized from 1K to about 20K, written 1K at a time as tar would.  Find walks
+ * the tree and stats every file.  Cat reads every file.  Compile reads a few
+ * headers and one source per object, writes the object, and links them all.
+ */
+#define NDIRS		8
+#define NFILES		12
+#define NHEADERS	4
+
+void untar()
+{
+  char path[64];
+  int d, f;
+
+  check(sim_mkdir("/src", 0755), "mkdir", "/src");
+  check(sim_mkdir("/include", 0755), "mkdir", "/include");
+  for (f = 0; f < NHEADERS; f++) {
+	sprintf(path, "/include/h%d.h", f);
+	make_file(path, 2048L + f * 1500L);
+  }
+  for (d = 0; d < NDIRS; d++) {
+	sprintf(path, "/src/d%d", d);
+	check(sim_mkdir(path, 0755), "mkdir", path);
+	for (f = 0; f < NFILES; f++) {
+		sprintf(path, "/src/d%d/f%02d.c", d, f);
+		make_file(path, 1024L + ((d * 7 + f * 13) % 20) * 1000L);
+	}
+  }
+}
+
+
+void make_file(path, size)
+char *path;
+long size;
+{
+  int fd, n;
+
+  check(fd = sim_creat(path, 0644), "creat", path);
+  memset(data, path[strlen(path) - 3], sizeof(data));
+  while (size > 0) {
+	n = size > CHUNK ? CHUNK : (int) size;
+	check(sim_write(fd, data, n) == n ? 0 : -1, "write", path);
+	size -= n;
+  }
+  sim_close(fd);
+}
+
+
+void do_find()
+{
+  find("/");
+}
+
+
+void find(dir)
+char *dir;
+{
+/* List a directory, stat everything in it, and descend into directories.
+ * This is how find and ls go through a tree now: a batch of names per
+ * getdents() call, and each name looked up from the open directory by
+ * statat(), not from the root.
+ */
+
+  char names[CHUNK], path[64], *np;
+  char subdirs[NFILES + NDIRS][NAME_MAX + 1];
+  int fd, type, n, i, k;
+  long size;
+
+  check(fd = sim_open(dir, 0), "open", dir);
+  n = 0;
+  while ((k = sim_getdents(fd, names, CHUNK)) > 0) {
+	for (np = names; np < &names[k]; np += strlen(np) + 1) {
+		if (strcmp(np, ".") == 0 || strcmp(np, "..") == 0) continue;
+		check(sim_statat(fd, np, &size, &type), "statat", np);
+		if (type == SIM_DIR && n < NFILES + NDIRS) {
+			strncpy(subdirs[n], np, NAME_MAX);
+			subdirs[n++][NAME_MAX] = 0;
+		}
+	}
+  }
+  check(k, "getdents", dir);
+  sim_close(fd);
+
+  for (i = 0; i < n; i++) {
+	sprintf(path, "%s%s%s", dir, dir[1] == 0 ? "" : "/", subdirs[i]);
+	find(path);
+  }
+}
+
+
+void do_cat(dir)
+char *dir;
+{
+  char entry[DIR_SIZE], path[64];
+  int fd, fd2, type;
+  long size;
+
+  check(fd = sim_open(dir, 0), "open", dir);
+  while (sim_read(fd, entry, DIR_SIZE) == DIR_SIZE) {
+	if (entry[0] == 0 && entry[1] == 0) continue;
+	if (entry[2] == '.') continue;
+	sprintf(path, "%s%s%.14s", dir, dir[1] == 0 ? "" : "/", entry + 2);
+	check(fd2 = sim_open(path, 0), "open", path);
+	sim_fstat(fd2, &size, &type);
+	sim_close(fd2);
+	if (type == SIM_DIR)
+		do_cat(path);
+	else
+		cat(path);
+  }
+  sim_close(fd);
+}
+
+
+long cat(path)
+char *path;
+{
+  int fd, n;
+  long total;
+
+  check(fd = sim_open(path, 0), "open", path);
+  total = 0;
+  while ((n = sim_read(fd, data, CHUNK)) > 0) total += n;
+  sim_close(fd);
+  return(total);
+}
+
+
+void compile()
+{
+  char path[64];
+  int d, f, h;
+
+  check(sim_mkdir("/obj", 0755), "mkdir", "/obj");
+  for (d = 0; d < NDIRS; d++) {
+	for (f = 0; f < NFILES; f++) {
+		for (h = 0; h < NHEADERS; h++) {
+			sprintf(path, "/include/h%d.h", h);
+			cat(path);
+		}
+		sprintf(path, "/src/d%d/f%02d.c", d, f);
+		cat(path);
+		sprintf(path, "/obj/%d%02d.o", d, f);
+		make_file(path, 1024L + (f % 4) * 1024L);
+	}
+  }
+  for (d = 0; d < NDIRS; d++) {
+	for (f = 0; f < NFILES; f++) {
+		sprintf(path, "/obj/%d%02d.o", d, f);
+		cat(path);
+	}
+  }
+  make_file("/obj/a.out", 60000L);
+}
+
+
+void check(r, what, path)
+int r;
+char *what, *path;
+{
+  if (r >= 0) return;
+  fprintf(stderr, "cachesim: %s %s failed (%d)\n", what, path, r);
+  exit(1);
+}
+
+
+/* The calls from the FS half. */
+
+int host_io(rw, dev, block, buf, contig)
+int rw, dev;
+long block;
+char *buf;
+int contig;
+{
+  long cyl;
+
+  if (block < 0 || block >= nblocks) return(-1);
+  if (rw == SIM_WRITE) {
+	memcpy(image + block * 1024, buf, 1024);
+	st.writes++;
+  } else {
+	memcpy(buf, image + block * 1024, 1024);
+	st.reads++;
+  }
+  cyl = block / cylblocks;
+  if (!contig) {
+	st.ms += step_ms * labs(cyl - cur_cyl) + latency_ms;
+	st.requests++;
+  } else if (cyl != cur_cyl) {
+	st.ms += step_ms;
+  }
+  st.ms += transfer_ms;
+  cur_cyl = cyl;
+  return(0);
+}
+
+
+void host_lookup(dev, block, how, hit)
+int dev;
+long block;
+int how, hit;
+{
+  if (how == 2) {		/* PREFETCH */
+	st.prefetch++;
+  } else {
+	st.lookups++;
+	if (hit) st.hits++;
+  }
+  if (trace != NULL) fprintf(trace, "g %u %lu %d\n", dev, block, how);
+}
+
+
+void host_release(dev, block, type, dirty)
+int dev;
+long block;
+int type, dirty;
+{
+  if (trace != NULL)
+	fprintf(trace, "p %u %lu %d %d\n", dev, block, type, dirty);
+}
+
+
+long host_time()
+{
+  return(600000000L + (long) (st.ms / 1000.0));
+}
+
+
+void host_copy(dst, src, n)
+char *dst, *src;
+long n;
+{
+  memcpy(dst, src, (size_t) n);
+}
+
+
+void host_abort()
+{
+  exit(1);
+}
+
+
+int printk(char *fmt, ...)
+{
+/* The FS's printf.  MINIX uses %D, %U, %O and %X for longs. */
+
+  char f[256], *p, *q;
+  va_list ap;
+  int n;
+
+  for (p = fmt, q = f; *p != 0 && q < &f[sizeof(f) - 3]; p++) {
+	*q++ = *p;
+	if (*p == '%' && p[1] != 0 && strchr("DUOX", p[1]) != NULL) {
+		*q++ = 'l';
+		*q++ = p[1] == 'D' ? 'd' : p[1] == 'U' ? 'u' :
+		       p[1] == 'O' ? 'o' : 'X';
+		p++;
+	}
+  }
+  *q = 0;
+  va_start(ap, fmt);
+  n = vfprintf(stderr, f, ap);
+  va_end(ap);
+  return(n);
+}
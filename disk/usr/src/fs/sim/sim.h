@@ -0,0 +1,40 @@
+/* Interface between the two halves of the buffer cache simulator.  simfs.c
+ * is compiled with the MINIX headers, together with the real FS sources;
+ * cachesim.c is compiled with the host headers.  Only int, long and char *
+ * may be passed between them, since the two sets of headers do not agree on
+ * the size of anything else.  The FS prints through printk(), which is in
+ * cachesim.c too.
+ */
+
+/* Calls into the FS half (simfs.c). */
+void sim_init(void);		/* empty the cache and the tables */
+int sim_mkfs(long blocks, int inodes);	/* make an empty file system */
+int sim_mount(void);		/* read super block and root directory */
+int sim_open(char *path, int flags);	/* flags 0 read, 1 write, 2 both */
+int sim_creat(char *path, int mode);
+int sim_mkdir(char *path, int mode);
+int sim_read(int fd, char *buf, int n);
+int sim_write(int fd, char *buf, int n);
+int sim_close(int fd);
+int sim_fstat(int fd, long *size, int *type);
+int sim_statat(int dirfd, char *path, long *size, int *type);
+int sim_getdents(int fd, char *names, int n);	/* names, 0 after each */
+int sim_sync(void);
+void sim_drop(void);		/* sync, then forget all cached blocks */
+int sim_get(int dev, long block, int how);	/* for trace replay */
+int sim_put(int dev, long block, int type, int dirty);
+int sim_nbufs(void);		/* NR_BUFS the FS half was compiled with */
+
+/* Calls into the host half (cachesim.c). */
+int host_io(int rw, int dev, long block, char *buf, int contig);
+void host_lookup(int dev, long block, int how, int hit);
+void host_release(int dev, long block, int type, int dirty);
+long host_time(void);		/* simulated time in seconds */
+void host_copy(char *dst, char *src, long n);
+void host_abort(void);		/* after a panic */
+
+#define SIM_READ	0	/* rw argument of host_io() */
+#define SIM_WRITE	1
+#define SIM_DIR		1	/* type returned by sim_fstat() */
+#define SIM_REG		2
+#define SIM_OTHER	3
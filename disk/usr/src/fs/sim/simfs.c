@@ -0,0 +1,622 @@
+/* This file is the FS half of the buffer cache simulator.  It is compiled
+ * with the MINIX headers and linked with the real file system sources, so the
+ * cache, inode, path and read/write code that runs here is the code that runs
+ * on the machine.  What it replaces is the rest of MINIX: the tables that
+ * table.c would define, the disk task (dev_io), the system task (sys_copy),
+ * the clock (sendrec) and the initialization in main.c.
+ *
+ * The entry points into this file are listed in sim.h.  Each sim_xxx() call
+ * fills in the message the way the library would, and calls the do_xxx()
+ * routine the way main() does.  Calls to get_block() and put_block() from
+ * other files are caught on their way in (the linker is told to wrap them),
+ * so the host half can count hits and write a trace.
+ */
+
+#define _TABLE
+
+#include "../fs.h"
+#include <sys/stat.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <string.h>
+#include <minix/callnr.h>
+#include <minix/com.h>
+#include <minix/boot.h>
+#include "../buf.h"
+#include "../dev.h"
+#include "../file.h"
+#include "../fproc.h"
+#include "../inode.h"
+#include "../super.h"
+#include "sim.h"		/* before param.h, whose names clash */
+#include "../param.h"
+
+#define SIM_PROC           4	/* process slot the workloads run in */
+#define SIM_DEV      DEV_RAM	/* device the file system is on */
+
+PUBLIC struct bparam_s boot_parameters;
+PUBLIC struct dmap dmap[1];	/* pipe.c refers to it; never used here */
+
+PRIVATE struct held {		/* blocks obtained by sim_get() */
+  struct buf *h_bp;
+  int h_dev;
+  long h_block;
+} held[NR_BUFS];
+PRIVATE struct buf *read_q[NR_BUFS];	/* prefetches waiting for sim_put() */
+PRIVATE int read_q_size;
+PRIVATE int q_dev;
+
+extern struct buf *__real_get_block();
+extern void __real_put_block();
+
+FORWARD int call();
+FORWARD int stat_type();
+FORWARD void path_arg();
+FORWARD void flush_q();
+
+/*===========================================================================*
+ *				sim_init				     *
+ *===========================================================================*/
+PUBLIC void sim_init()
+{
+/* Set up the buffer pool and the tables, as buf_pool() and fs_init() do. */
+
+  register struct buf *bp;
+  register struct super_block *sp;
+
+  bufs_in_use = 0;
+  front = &buf[0];
+  rear = &buf[NR_BUFS - 1];
+  for (bp = &buf[0]; bp < &buf[NR_BUFS]; bp++) {
+	bp->b_blocknr = NO_BLOCK;
+	bp->b_dev = NO_DEV;
+	bp->b_dirt = CLEAN;
+	bp->b_count = 0;
+	bp->b_next = bp + 1;
+	bp->b_prev = bp - 1;
+  }
+  buf[0].b_prev = NIL_BUF;
+  buf[NR_BUFS - 1].b_next = NIL_BUF;
+  for (bp = &buf[0]; bp < &buf[NR_BUFS]; bp++) bp->b_hash = bp->b_next;
+  buf_hash[NO_BLOCK & (NR_BUF_HASH - 1)] = front;
+
+  for (sp = &super_block[0]; sp < &super_block[NR_SUPERS]; sp++)
+	sp->s_dev = NO_DEV;
+  boot_parameters.bp_rootdev = SIM_DEV;
+}
+
+
+/*===========================================================================*
+ *				sim_mkfs				     *
+ *===========================================================================*/
+PUBLIC int sim_mkfs(blocks, inodes)
+long blocks;			/* size of the file system */
+int inodes;			/* number of inodes to make */
+{
+/* Write an empty file system with only a root directory on it, directly
+ * through host_io() and not through the cache.  One zone is one block.
+ */
+
+  union {
+	char b[BLOCK_SIZE];
+	int i[INTS_PER_BLOCK];
+	struct super_block s;
+	d_inode d[INODES_PER_BLOCK];
+	dir_struct e[NR_DIR_ENTRIES];
+  } u;
+  int imap, zmap, iblocks, first;
+  long b;
+
+  if (blocks > (zone_nr) ~0 || inodes < 1) return(EINVAL);
+  imap = (inodes + 1 + BLOCK_SIZE * 8 - 1) / (BLOCK_SIZE * 8);
+  iblocks = (inodes + 1 + INODES_PER_BLOCK - 1) / INODES_PER_BLOCK;
+  zmap = 1;
+  while ((long) zmap * BLOCK_SIZE * 8 < blocks - (2+imap+zmap+iblocks) + 1)
+	zmap++;
+  first = 2 + imap + zmap + iblocks;
+  if (imap > I_MAP_SLOTS || zmap > ZMAP_SLOTS || first >= blocks)
+	return(EINVAL);
+
+  /* Boot block and everything up to the first data zone are zero. */
+  memset(u.b, 0, BLOCK_SIZE);
+  for (b = 0; b < first; b++) host_io(SIM_WRITE, SIM_DEV, b, u.b, b > 0);
+
+  u.s.s_ninodes = inodes;
+  u.s.s_nzones = (zone_nr) blocks;
+  u.s.s_imap_blocks = imap;
+  u.s.s_zmap_blocks = zmap;
+  u.s.s_firstdatazone = first;
+  u.s.s_log_zone_size = 0;
+  u.s.s_max_size = MAX_ZONES * BLOCK_SIZE;
+  u.s.s_magic = SUPER_MAGIC;
+  host_io(SIM_WRITE, SIM_DEV, (long) SUPER_BLOCK, u.b, 0);
+
+  /* Inodes 0 and 1, and zones 0 and 1 (the root directory) are in use. */
+  memset(u.b, 0, BLOCK_SIZE);
+  u.i[0] = 3;
+  host_io(SIM_WRITE, SIM_DEV, (long) SUPER_BLOCK + 1, u.b, 0);
+  host_io(SIM_WRITE, SIM_DEV, (long) SUPER_BLOCK + 1 + imap, u.b, 0);
+
+  memset(u.b, 0, BLOCK_SIZE);
+  u.d[0].i_mode = I_DIRECTORY | 0755;
+  u.d[0].i_nlinks = 3;		/* load_super() insists on 3 */
+  u.d[0].i_size = 2 * DIR_ENTRY_SIZE;
+  u.d[0].i_mtime = host_time();
+  u.d[0].i_zone[0] = first;
+  host_io(SIM_WRITE, SIM_DEV, (long) SUPER_BLOCK + 1 + imap + zmap, u.b, 0);
+
+  memset(u.b, 0, BLOCK_SIZE);
+  u.e[0].d_inum = ROOT_INODE;
+  u.e[0].d_name[0] = '.';
+  u.e[1].d_inum = ROOT_INODE;
+  u.e[1].d_name[0] = '.';
+  u.e[1].d_name[1] = '.';
+  host_io(SIM_WRITE, SIM_DEV, (long) first, u.b, 0);
+  return(OK);
+}
+
+
+/*===========================================================================*
+ *				sim_mount				     *
+ *===========================================================================*/
+PUBLIC int sim_mount()
+{
+/* Read the super block and the root directory, as load_super() does, and give
+ * the workload process its root and working directories.
+ */
+
+  register struct super_block *sp;
+  register struct inode *rip;
+
+  sp = &super_block[0];
+  sp->s_dev = SIM_DEV;
+  rw_super(sp, READING);
+  sp->s_dev = SIM_DEV;
+  if (sp->s_magic != SUPER_MAGIC) {
+	sp->s_dev = NO_DEV;
+	return(EINVAL);
+  }
+  rip = get_inode(SIM_DEV, ROOT_INODE);
+  sp->s_imount = rip;
+  dup_inode(rip);
+  sp->s_isup = rip;
+  sp->s_rd_only = 0;
+  if (load_bit_maps(SIM_DEV) != OK) return(ENFILE);
+
+  fp = &fproc[SIM_PROC];
+  dup_inode(rip);
+  fp->fp_rootdir = rip;
+  dup_inode(rip);
+  fp->fp_workdir = rip;
+  fp->fp_realuid = fp->fp_effuid = SU_UID;
+  fp->fp_realgid = fp->fp_effgid = SYS_GID;
+  fp->fp_umask = ~0;
+  return(OK);
+}
+
+
+/*===========================================================================*
+ *				sim_drop				     *
+ *===========================================================================*/
+PUBLIC void sim_drop()
+{
+/* Sync and unmount the file system, empty the cache, and mount it again, so
+ * the next workload starts cold.  All files must be closed.
+ */
+
+  register struct super_block *sp;
+
+  flush_q();
+  call(SYNC, do_sync);
+  sp = &super_block[0];
+  fp = &fproc[SIM_PROC];
+  put_inode(fp->fp_rootdir);
+  put_inode(fp->fp_workdir);
+  put_inode(sp->s_isup);
+  put_inode(sp->s_imount);
+  unload_bit_maps(SIM_DEV);
+  flushall(SIM_DEV);
+  invalidate(SIM_DEV);
+  sp->s_dev = NO_DEV;
+  sim_mount();
+}
+
+
+/*===========================================================================*
+ *				sim_open etc.				     *
+ *===========================================================================*/
+PUBLIC int sim_open(path, flags)
+char *path;
+int flags;
+{
+  path_arg(path);
+  mode = flags;
+  return(call(OPEN, do_open));
+}
+
+PUBLIC int sim_creat(path, bits)
+char *path;
+int bits;
+{
+  path_arg(path);
+  mode = bits;
+  return(call(CREAT, do_creat));
+}
+
+PUBLIC int sim_mkdir(path, bits)
+char *path;
+int bits;
+{
+  name1 = path;
+  name1_length = strlen(path) + 1;
+  mode = bits;
+  return(call(MKDIR, do_mkdir));
+}
+
+PUBLIC int sim_read(fdes, buf, n)
+int fdes;
+char *buf;
+int n;
+{
+  fd = fdes;
+  buffer = buf;
+  nbytes = n;
+  return(call(READ, do_read));
+}
+
+PUBLIC int sim_write(fdes, buf, n)
+int fdes;
+char *buf;
+int n;
+{
+  fd = fdes;
+  buffer = buf;
+  nbytes = n;
+  return(call(WRITE, do_write));
+}
+
+PUBLIC int sim_close(fdes)
+int fdes;
+{
+  fd = fdes;
+  return(call(CLOSE, do_close));
+}
+
+PUBLIC int sim_fstat(fdes, size, type)
+int fdes;
+long *size;
+int *type;
+{
+  struct stat st;
+  int r;
+
+  fd = fdes;
+  buffer = (char *) &st;
+  if ((r = call(FSTAT, do_fstat)) != OK) return(r);
+  return(stat_type(&st, size, type));
+}
+
+PUBLIC int sim_statat(dirfd, path, size, type)
+int dirfd;
+char *path;
+long *size;
+int *type;
+{
+  struct stat st;
+  int r;
+
+  dir_fd = dirfd;
+  name1 = path;
+  name1_length = strlen(path) + 1;
+  name2 = (char *) &st;
+  if ((r = call(STATAT, do_statat)) != OK) return(r);
+  return(stat_type(&st, size, type));
+}
+
+PUBLIC int sim_getdents(fdes, names, n)
+int fdes;
+char *names;
+int n;
+{
+/* The host half cannot read a struct dirent, so the names are passed on one
+ * after another, each with its 0 byte.  'names' must hold n bytes, and the
+ * dirents are made in as many; they are never shorter than the names.
+ */
+
+  PRIVATE union {
+	long align;
+	char b[4096];
+  } dbuf;
+  register struct dirent *dp;
+  register char *np;
+  int r, k;
+
+  fd = fdes;
+  buffer = dbuf.b;
+  nbytes = (n < sizeof(dbuf) ? n : sizeof(dbuf));
+  if ((r = call(GETDENTS, do_getdents)) <= 0) return(r);
+  np = names;
+  for (k = 0; k < r; k += dp->d_reclen) {
+	dp = (struct dirent *) &dbuf.b[k];
+	strcpy(np, dp->d_name);
+	np += strlen(np) + 1;
+  }
+  return(np - names);
+}
+
+PUBLIC int sim_sync()
+{
+  flush_q();
+  return(call(SYNC, do_sync));
+}
+
+PUBLIC int sim_nbufs()
+{
+  return(NR_BUFS);
+}
+
+
+/*===========================================================================*
+ *				call					     *
+ *===========================================================================*/
+PRIVATE int call(nr, handler)
+int nr;				/* system call number */
+int (*handler)();		/* routine that does the work */
+{
+/* Do what main() does around one system call. */
+
+  int r;
+
+  who = SIM_PROC;
+  fs_call = nr;
+  fp = &fproc[who];
+  super_user = (fp->fp_effuid == SU_UID ? TRUE : FALSE);
+  dont_reply = FALSE;
+  r = (*handler)();
+  if (rdahed_inode != NIL_INODE) read_ahead();
+  return(r);
+}
+
+
+/*===========================================================================*
+ *				stat_type				     *
+ *===========================================================================*/
+PRIVATE int stat_type(stp, size, type)
+struct stat *stp;
+long *size;
+int *type;
+{
+/* Pass on the size and the kind of file found by stat_inode(). */
+
+  *size = stp->st_size;
+  switch (stp->st_mode & I_TYPE) {
+	case I_DIRECTORY:	*type = SIM_DIR;	break;
+	case I_REGULAR:		*type = SIM_REG;	break;
+	default:		*type = SIM_OTHER;	break;
+  }
+  return(OK);
+}
+
+
+/*===========================================================================*
+ *				path_arg				     *
+ *===========================================================================*/
+PRIVATE void path_arg(path)
+char *path;
+{
+/* Pass a path the way the library does: in the message if it fits. */
+
+  name = path;
+  name_length = strlen(path) + 1;
+  if (name_length <= M3_STRING) strcpy(pathname, path);
+}
+
+
+/*===========================================================================*
+ *				sim_get					     *
+ *===========================================================================*/
+PUBLIC int sim_get(dev, block, how)
+int dev;
+long block;
+int how;
+{
+/* Replay a get_block() from a trace.  A prefetch that misses is not read
+ * until the next record, so that consecutive ones go out as one scattered
+ * read, as in rahead().  rw_scattered() puts them itself, so they are not
+ * held; put records for them in the trace find nothing and are ignored.
+ */
+
+  register struct buf *bp;
+  register struct held *hp;
+
+  if (how != PREFETCH || dev != q_dev) flush_q();
+  bp = get_block((dev_t) dev, (block_nr) block, how);
+  if (how == PREFETCH && bp->b_dev == NO_DEV) {
+	q_dev = dev;
+	read_q[read_q_size++] = bp;
+	if (read_q_size == NR_BUFS) flush_q();
+	return(OK);
+  }
+  for (hp = &held[0]; hp < &held[NR_BUFS]; hp++) {
+	if (hp->h_bp == NIL_BUF) {
+		hp->h_bp = bp;
+		hp->h_dev = dev;
+		hp->h_block = block;
+		return(OK);
+	}
+  }
+  return(ENFILE);
+}
+
+
+/*===========================================================================*
+ *				sim_put					     *
+ *===========================================================================*/
+PUBLIC int sim_put(dev, block, type, dirty)
+int dev;
+long block;
+int type;
+int dirty;
+{
+/* Replay a put_block() from a trace. */
+
+  register struct held *hp;
+
+  flush_q();
+  for (hp = &held[0]; hp < &held[NR_BUFS]; hp++) {
+	if (hp->h_bp != NIL_BUF && hp->h_dev == dev && hp->h_block == block) {
+		if (dirty) hp->h_bp->b_dirt = DIRTY;
+		put_block(hp->h_bp, type);
+		hp->h_bp = NIL_BUF;
+		return(OK);
+	}
+  }
+  return(ENOENT);
+}
+
+
+/*===========================================================================*
+ *				flush_q					     *
+ *===========================================================================*/
+PRIVATE void flush_q()
+{
+  if (read_q_size == 0) return;
+  rw_scattered((dev_t) q_dev, read_q, read_q_size, READING);
+  read_q_size = 0;
+}
+
+
+/*===========================================================================*
+ *				__wrap_get_block			     *
+ *===========================================================================*/
+PUBLIC struct buf *__wrap_get_block(dev, block, only_search)
+dev_t dev;
+block_nr block;
+int only_search;
+{
+/* Tell the host about a lookup, then do it. */
+
+  register struct buf *bp;
+
+  bp = buf_hash[block & (NR_BUF_HASH - 1)];
+  while (bp != NIL_BUF && (bp->b_blocknr != block || bp->b_dev != dev))
+	bp = bp->b_hash;
+  host_lookup((int) dev, (long) block, only_search,
+	      dev != NO_DEV && bp != NIL_BUF);
+  return(__real_get_block(dev, block, only_search));
+}
+
+
+/*===========================================================================*
+ *				__wrap_put_block			     *
+ *===========================================================================*/
+PUBLIC void __wrap_put_block(bp, block_type)
+register struct buf *bp;
+int block_type;
+{
+  if (bp != NIL_BUF)
+	host_release((int) bp->b_dev, (long) bp->b_blocknr, block_type,
+		     (int) bp->b_dirt);
+  __real_put_block(bp, block_type);
+}
+
+
+/*===========================================================================*
+ *				dev_io					     *
+ *===========================================================================*/
+PUBLIC int dev_io(rw_flag, nonblock, dev, pos, bytes, proc, buff)
+int rw_flag;			/* READING, WRITING or SCATTERED_IO */
+int nonblock;			/* not used */
+dev_t dev;			/* major-minor device number */
+off_t pos;			/* byte position */
+int bytes;			/* how many bytes (or vector entries) */
+int proc;			/* not used */
+char *buff;			/* buffer (or i/o vector) */
+{
+/* Stand in for the disk task.  Every block goes to host_io(), which is told
+ * whether it follows the previous one in the same request, since that is
+ * what decides the cost on a real disk.
+ */
+
+  register struct iorequest_s *iop;
+  long block, last;
+  int i, rw;
+
+  if (rw_flag == SCATTERED_IO) {
+	last = -2;
+	for (i = 0, iop = (struct iorequest_s *) buff; i < bytes; i++, iop++) {
+		block = iop->io_position / BLOCK_SIZE;
+		rw = (iop->io_request & ~OPTIONAL_IO) == DISK_WRITE ?
+							SIM_WRITE : SIM_READ;
+		if (host_io(rw, (int) dev, block, iop->io_buf, block == last + 1)
+								== OK) {
+			iop->io_nbytes = 0;
+			last = block;
+		}
+	}
+	return(OK);
+  }
+
+  rw = (rw_flag == WRITING ? SIM_WRITE : SIM_READ);
+  block = pos / BLOCK_SIZE;
+  for (i = 0; i < bytes; i += BLOCK_SIZE, block++, buff += BLOCK_SIZE)
+	if (host_io(rw, (int) dev, block, buff, i > 0) != OK) return(EIO);
+  return(bytes);
+}
+
+
+/*===========================================================================*
+ *				stand-ins for the rest of MINIX		     *
+ *===========================================================================*/
+PUBLIC int dev_open(rip, mod, nonblock)
+struct inode *rip;
+int mod, nonblock;
+{
+  return(OK);
+}
+
+PUBLIC void dev_close(rip)
+struct inode *rip;
+{
+}
+
+PUBLIC int tty_exit()
+{
+  return(OK);
+}
+
+PUBLIC void reply(whom, result)
+int whom, result;
+{
+}
+
+PUBLIC void sys_kill(proc, signr)
+int proc, signr;
+{
+}
+
+PUBLIC void sys_abort()
+{
+  host_abort();
+}
+
+PUBLIC void sys_copy(mptr)
+message *mptr;
+{
+/* Everything is in one address space, so a copy is a copy. */
+
+  host_copy((char *) mptr->DST_BUFFER, (char *) mptr->SRC_BUFFER,
+	    mptr->COPY_BYTES);
+  mptr->m_type = OK;
+}
+
+PUBLIC int sendrec(task, mptr)
+int task;
+message *mptr;
+{
+/* The only message the linked files send is GET_TIME to the clock. */
+
+  if (task == CLOCK && mptr->m_type == GET_TIME) mptr->NEW_TIME = host_time();
+  mptr->m_type = OK;
+  return(OK);
+}
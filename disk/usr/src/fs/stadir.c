@@ -1,20 +1,31 @@
-/* This file contains the code for performing four system calls relating to
+/* This file contains the code for performing six system calls relating to
  * status and directories.
  *
  * The entry points into this file are
- *   do_chdir:	perform the CHDIR system call
- *   do_chroot:	perform the CHROOT system call
- *   do_stat:	perform the STAT system call
- *   do_fstat:	perform the FSTAT system call
+ *   do_chdir:	  perform the CHDIR system call
+ *   do_chroot:	  perform the CHROOT system call
+ *   do_stat:	  perform the STAT system call
+ *   do_fstat:	  perform the FSTAT system call
+ *   do_statat:	  perform the STATAT system call
+ *   do_getdents: perform the GETDENTS system call
  */
 
 #include "fs.h"
 #include <sys/stat.h>
+#include <dirent.h>
+#include "buf.h"
 #include "file.h"
 #include "fproc.h"
 #include "inode.h"
 #include "param.h"
 
+#define DENT_BYTES	512	/* entries made up before copying them out */
+
+PRIVATE union {
+  long d_align;			/* struct dirent starts with a long */
+  char d_buf[DENT_BYTES];
+} dent;
+
 FORWARD int change();
 FORWARD int stat_inode();
 
@@ -131,6 +142,121 @@ PUBLIC int do_fstat()
 }
 
 
+/*===========================================================================*
+ *				do_statat				     *
+ *===========================================================================*/
+PUBLIC int do_statat()
+{
+/* Perform the statat(fd, name, buf) system call.  A relative name is looked
+ * up from the directory open on fd instead of from the working directory,
+ * so a program going through a directory can stat each entry without the
+ * whole path being parsed again from the root for every one.
+ */
+
+  register struct filp *rfilp;
+  register struct inode *rip;
+  struct inode *work_dir;
+  int r;
+
+  if ( (rfilp = get_filp(dir_fd)) == NIL_FILP) return(err_code);
+  if ( (rfilp->filp_ino->i_mode & I_TYPE) != I_DIRECTORY) return(ENOTDIR);
+  if (fetch_name(name1, name1_length, M1) != OK) return(err_code);
+
+  /* Parse the name as if the directory were the working directory. */
+  work_dir = fp->fp_workdir;
+  fp->fp_workdir = rfilp->filp_ino;
+  rip = eat_path(user_path);
+  fp->fp_workdir = work_dir;
+  if (rip == NIL_INODE) return(err_code);
+
+  r = stat_inode(rip, NIL_FILP, name2);
+  put_inode(rip);
+  return(r);
+}
+
+
+/*===========================================================================*
+ *				do_getdents				     *
+ *===========================================================================*/
+PUBLIC int do_getdents()
+{
+/* Perform the getdents(fd, buf, nbytes) system call.  As many entries of the
+ * directory as fit in buf, from the file position on, are put there as
+ * struct dirents, and the position is moved past them.  Free slots are left
+ * out.  The entries are made up in 'dent' and copied out a bufferful at a
+ * time, so a whole directory usually costs one call, where read() costs one
+ * per block and the library had to convert the entries itself.
+ */
+
+  register struct filp *rfilp;
+  register struct inode *rip;
+  register dir_struct *dp;
+  register struct dirent *ep;
+  struct buf *bp;
+  off_t pos;
+  vir_bytes dst;
+  int r, i, n, len, size, used, full;
+  block_nr b;
+
+  if ( (rfilp = get_filp(fd)) == NIL_FILP) return(err_code);
+  if ( (rfilp->filp_mode & R_BIT) == 0) return(EBADF);
+  rip = rfilp->filp_ino;
+  if ( (rip->i_mode & I_TYPE) != I_DIRECTORY) return(ENOTDIR);
+  if (nbytes < 0) return(EINVAL);
+
+  /* Start at the first whole entry at or after the file position. */
+  pos = (rfilp->filp_pos + DIR_ENTRY_SIZE - 1) / DIR_ENTRY_SIZE
+							* DIR_ENTRY_SIZE;
+  dst = (vir_bytes) buffer;
+  r = OK;
+  size = 0;			/* bytes copied to the user so far */
+  used = 0;			/* bytes in 'dent' */
+  full = FALSE;
+  while (pos < rip->i_size && !full) {
+	/* Since directories don't have holes, 'b' cannot be NO_BLOCK. */
+	b = read_map(rip, pos);
+	bp = get_block(rip->i_dev, b, NORMAL);
+	dp = &bp->b_dir[(int) (pos % BLOCK_SIZE) / DIR_ENTRY_SIZE];
+	for (; dp < &bp->b_dir[NR_DIR_ENTRIES] && pos < rip->i_size;
+						dp++, pos += DIR_ENTRY_SIZE) {
+		if (dp->d_inum == 0) continue;
+		for (len = 0; len < NAME_MAX && dp->d_name[len] != 0; len++);
+		n = _DIRENTSIZ(len);
+		if (size + used + n > nbytes) {
+			full = TRUE;
+			break;
+		}
+		if (used + n > DENT_BYTES) {
+			r = rw_user(D, who, dst + size, (vir_bytes) used,
+						dent.d_buf, TO_USER);
+			if (r != OK) break;
+			size += used;
+			used = 0;
+		}
+		ep = (struct dirent *) &dent.d_buf[used];
+		ep->d_ino = dp->d_inum;
+		ep->d_off = pos;
+		ep->d_reclen = n;
+		used += n;
+		for (i = 0; i < len; i++) ep->d_name[i] = dp->d_name[i];
+		ep->d_name[len] = 0;
+	}
+	put_block(bp, DIRECTORY_BLOCK);
+	if (r != OK) return(r);
+  }
+  if (used > 0) {
+	r = rw_user(D, who, dst + size, (vir_bytes) used, dent.d_buf, TO_USER);
+	if (r != OK) return(r);
+	size += used;
+  }
+
+  /* Not even one entry fitting is an error, as EOF is not. */
+  if (full && size == 0) return(EINVAL);
+  rfilp->filp_pos = pos;
+  return(size);
+}
+
+
 /*===========================================================================*
  *				stat_inode				     *
  *===========================================================================*/
@@ -81,8 +81,8 @@ PUBLIC int (*call_vector[NCALLS])() = {
 	no_sys,		/* 59 = exece	*/
 	do_umask,	/* 60 = umask	*/
 	do_chroot,	/* 61 = chroot	*/
-	no_sys,		/* 62 = unused	*/
-	no_sys,		/* 63 = unused	*/
+	do_getdents,	/* 62 = getdents */
+	do_statat,	/* 63 = statat	*/
 
 	no_sys,		/* 64 = KSIG: signals originating in the kernel	*/
 	do_unpause,	/* 65 = UNPAUSE	*/
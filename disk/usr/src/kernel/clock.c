@@ -1,8 +1,9 @@
 /* This file contains the code and data for the clock task.  The clock task
- * has a single entry point, clock_task().  It accepts four message types:
+ * has a single entry point, clock_task().  It accepts five message types:
  *
  *   HARD_INT:    a clock interrupt has occurred
  *   GET_TIME:    a process wants the real time
+ *   GET_UPTIME:  a process wants the number of ticks since boot
  *   SET_TIME:    a process wants to set the real time
  *   SET_ALARM:   a process wants to be alerted after a specified interval
  *
@@ -16,6 +17,8 @@
  * |------------+----------+---------+---------|
  * | GET_TIME   |          |         |         |
  * |------------+----------+---------+---------|
+ * | GET_UPTIME |          |         |         |
+ * |------------+----------+---------+---------|
  * | SET_TIME   |          |         | newtime |
  * ---------------------------------------------
  *
@@ -62,6 +65,7 @@ PRIVATE void (*watch_dog[NR_TASKS+1])();  /* watch_dog functions to call */
 
 FORWARD void do_clocktick();
 FORWARD void do_get_time();
+FORWARD void do_get_uptime();
 FORWARD void do_set_time();
 FORWARD void do_setalarm();
 FORWARD void init_clock();
@@ -71,7 +75,7 @@ FORWARD void init_clock();
  *===========================================================================*/
 PUBLIC void clock_task()
 {
-/* Main program of clock task.  It determines which of the 4 possible
+/* Main program of clock task.  It determines which of the 5 possible
  * calls this is by looking at 'mc.m_type'.   Then it dispatches.
  */
  
@@ -92,6 +96,7 @@ PUBLIC void clock_task()
      switch (opcode) {
 	case SET_ALARM:	 do_setalarm(&mc);	break;
 	case GET_TIME:	 do_get_time();		break;
+	case GET_UPTIME: do_get_uptime();	break;
 	case SET_TIME:	 do_set_time(&mc);	break;
 	case HARD_INT:   do_clocktick();	break;
 	default: panic("clock task got bad message", mc.m_type);
@@ -149,6 +154,18 @@ PRIVATE void do_get_time()
 }
 
 
+/*===========================================================================*
+ *				do_get_uptime				     *
+ *===========================================================================*/
+PRIVATE void do_get_uptime()
+{
+/* Get and return the number of clock ticks since boot. */
+
+  mc.m_type = REAL_TIME;	/* set message type for reply */
+  mc.NEW_TIME = realtime;	/* ticks since boot */
+}
+
+
 /*===========================================================================*
  *				do_set_time				     *
  *===========================================================================*/
@@ -392,6 +409,7 @@ PUBLIC void clock_handler()
 #endif
 #if (CHIP == M68000)
   kb_timer();			/* keyboard repeat */
+  rs_timer();			/* soft RS232 lines */
   if (sched_ticks == 1) fd_timer();	/* floppy deselect */
 #if (MACHINE == AMIGA)
   beepoff();			/* to turn beeper (^G) off */
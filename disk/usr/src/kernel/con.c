@@ -22,6 +22,8 @@ PRIVATE int	STdoDump = 0;
 #endif
 extern int clipright;	/* from vdu.c */
 
+PRIVATE char cons_inqueue[NR_CONS][TTY_IN_BYTES];	/* input queues */
+
 /*===========================================================================*
  *				tty_init				     *
  *===========================================================================*/
@@ -30,8 +32,8 @@ PUBLIC void tty_init()
   struct tty_struct *tp;
 
   for (tp = &tty_struct[0]; tp < &tty_struct[NR_CONS]; tp++) {
-	tp->tty_inhead = tp->tty_inqueue;
-	tp->tty_intail = tp->tty_inqueue;
+	in_queue_init(tp, cons_inqueue[tp - tty_struct], TTY_IN_BYTES);
+	ring_init(&tp->tty_rawin, tty_kb_buf[tp - tty_struct], KB_IN_BYTES);
 	tp->tty_mode = CRMOD | XTABS | ECHO;
 
 #if (CHIP != M68000)
@@ -51,8 +53,7 @@ PUBLIC void tty_init()
 	tp->tty_eof   = EOT_CHAR;
   }
 
-  tty_buf_max(tty_driver_buf) = MAX_OVERRUN;	/* set up limit on keyboard buffering*/
-  tty_buf_count(tty_driver_buf) = 0;
+  ring_init(&tty_oper, tty_oper_buf, OPER_BYTES);
 
   vduinit();
   kbdinit();
@@ -101,11 +102,10 @@ int pfx;
 	else
 		printf("\nclipright turned off\n");
 	return;
-  case F10:	/* PF10: issue SIGKILL */
+  case F10:	/* PF10: issue SIGKILL on every console */
 	for (i = 0; i < NR_CONS; i++)
-	{
-	    sigchar(&tty_struct[i], SIGKILL); return;
-	}
+	    sigchar(&tty_struct[i], SIGKILL);
+	return;
   default:
 	return; /* don't bomb out */
   }
@@ -144,9 +144,8 @@ int c;
 
   if (STuseCon) {
 #endif
-	vducursor(0);
 	out_char(&tty_struct[CONSOLE], c);
-	vducursor(1);
+	flush(&tty_struct[CONSOLE]);	/* paint it */
 #ifdef DEBOUT
   }
   if (STusePrt)
@@ -226,14 +226,14 @@ PUBLIC void tty_dmp()
    printf("output_done = %d\r\n", output_done);
    printf("flush_flag = %d\r\n", flush_flag);
 
-   printf("tty_buf_count = %d, tty_buf_max = %d\r\n",
-	   tty_buf_count(tty_driver_buf), tty_buf_max(tty_driver_buf));
 
-   for (i = 0; i < NR_CONS + NR_RS_LINES; i++)
+   for (i = 0; i < NR_LINES; i++)
    {
 	tp = &tty_struct[i]; 
 	printf("line %d; incount = %d, inleft = %d, outleft = %d\n",
  		i, tp->tty_incount, tp->tty_inleft, tp->tty_outleft);
+	printf("raw input = %d, overruns = %d\r\n",
+		ring_count(&tp->tty_rawin), tp->tty_overrun);
 	if (tp->tty_busy) printf("busy\r\n"); else printf("not busy\r\n");
 	if (tp->tty_inhibited) printf("inhibited\r\n");
 	else printf("not inhibited\r\n");
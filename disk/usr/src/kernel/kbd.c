@@ -35,7 +35,7 @@ PRIVATE int     sp_sr=SP_REC;   /* am i receiving from or sending to keyboard ?
  *===========================================================================*/
 PUBLIC void kbdint()
 {
-  register short code, make, k;
+  register short code, make;
   register int s;
 
   if (sp_sr == SP_SEND) { /* sending to (handshaking with) keyboard ? */
@@ -46,7 +46,6 @@ PUBLIC void kbdint()
   sp_sr = SP_SEND;        /* going to send in a 'minute' */
 
   s = lock();
-  k = tty_buf_count(tty_driver_buf);
 
   code = *SDRA;
   *CRAA = 0xD1;
@@ -83,7 +82,8 @@ PUBLIC void kbdint()
           }
   }
 
-  if (tty_buf_count(tty_driver_buf) < THRESHOLD) {
+  if (ring_count(&tty_struct[cur_cons].tty_rawin) < THRESHOLD &&
+					ring_count(&tty_oper) == 0) {
 	/* Don't send message.  Just accumulate.  Let clock do it. */
 	INT_CTL_ENABLE;
 	flush_flag++;
@@ -111,14 +111,14 @@ register BYTE code;
       if (control)
           c &= 0x1f;
       /* Check to see if character is XOFF, to stop output. */
-      if ((tty_struct[CONSOLE].tty_mode & (RAW|CBREAK))==0 &&
-       tty_struct[CONSOLE].tty_xoff==c) {
-          tty_struct[CONSOLE].tty_inhibited=STOPPED;
+      if ((tty_struct[cur_cons].tty_mode & (RAW|CBREAK))==0 &&
+       tty_struct[cur_cons].tty_xoff==c) {
+          tty_struct[cur_cons].tty_inhibited=STOPPED;
           return;
       }
       asciikey[0]=c;
       asciikey[1]='\0';
-      kbdput(asciikey, CONSOLE);
+      kbdput(asciikey, cur_cons);
       return;
   }
   if (control && (alt1 || alt2) && code>=0x50 && code<=0x59) {
@@ -130,12 +130,19 @@ register BYTE code;
       kbdput(asciikey, OPERATOR);
       return;
   }
+  if ((alt1 || alt2) && code>=0x50 && code<0x50+NR_CONS) {
+      /*
+       * alt & function-key n shows virtual console n
+       */
+      vduswitch(code-0x50);
+      return;
+  }
   if (code>=0x50 && code<=0x59) { /* function key pressed */
       index=code-0x50;
       if (shift1 || shift2)
           index+=10;
       strcpy(asciikey, (long) kmap.func[index]+ (long) kmap.functext);
-      kbdput(asciikey, CONSOLE);
+      kbdput(asciikey, cur_cons);
       return;
   }
   switch (code) {
@@ -165,26 +172,25 @@ PUBLIC void kbdput(str, line)
 char *str;
 int line;
 {
-  register int k;
+  register struct tty_ring *rp;
   register BYTE c;
 
-  /* Store the character in memory so the task can get at it later.
-   * tty_driver_buf[0] is the current count, and tty_driver_buf[2] is the
-   * maximum allowed to be stored.
+  /* Store the characters in the input ring of the line, where the task can
+   * get at them later.  Function keys for the operator have a ring of their
+   * own, so they cannot be confused with typed control characters.
    */
+  rp = (line == OPERATOR ? &tty_oper : &tty_struct[line].tty_rawin);
   c= *str;
   do {
-      if ( (k = tty_buf_count(tty_driver_buf)) >= tty_buf_max(tty_driver_buf)) 
+      if (ring_full(rp)) {
           /*
            * Too many characters have been buffered.
            * Discard excess.
            */
+          if (line != OPERATOR) tty_struct[line].tty_overrun++;
           return;
-      /* There is room to store this character; do it. */
-      k <<= 1;				/* each entry uses two bytes */
-      tty_driver_buf[k+4] = c;		/* store the char code */
-      tty_driver_buf[k+5] = line;	/* which line it came from */
-      tty_buf_count(tty_driver_buf)++;	/* increment counter */
+      }
+      ring_put(rp, c);			/* store the char code */
   } while (c= *(++str));
 }
 
@@ -198,7 +204,7 @@ PRIVATE kbdansi(c)
     asciikey[1]='[';
     asciikey[2]=c;
     asciikey[3]='\0';
-    kbdput(asciikey, CONSOLE);
+    kbdput(asciikey, cur_cons);
 }
 
 /*===========================================================================*
@@ -206,7 +212,8 @@ PRIVATE kbdansi(c)
  *===========================================================================*/
 PUBLIC void kb_timer()
 {
-  register int k, s;
+  register unsigned k;
+  register int s;
 
   s = lock();
   if (repeattic == 0) {
@@ -217,11 +224,11 @@ PUBLIC void kb_timer()
 	restore(s);
 	return;
   }
-  k = tty_buf_count(tty_driver_buf);
+  k = tty_struct[cur_cons].tty_rawin.tr_head;
   kbdkey(repeatkey);
-  if (k != tty_buf_count(tty_driver_buf))
+  if (k != tty_struct[cur_cons].tty_rawin.tr_head)
   {
-    if (tty_buf_count(tty_driver_buf) < THRESHOLD) {
+    if (ring_count(&tty_struct[cur_cons].tty_rawin) < THRESHOLD) {
 	/* Don't send message.  Just accumulate.  Let clock do it. */
 	INT_CTL_ENABLE;
 	flush_flag++;
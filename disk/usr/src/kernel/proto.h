@@ -234,6 +234,8 @@ void cp_mess();
 void siaint();
 void rs232();
 void rs_flush();
+void rs_refill();
+void rs_timer();
 void rs_out_char();
 int tty_o_done();
 void rs_sig();
@@ -277,6 +279,7 @@ void flush();
 void out_char();
 void vducursor();
 void vduinit();
+void vduswitch();
 
 /* copy68k.s */
 void flipclicks();
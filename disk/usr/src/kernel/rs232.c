@@ -16,9 +16,12 @@
 #endif
 
 /* Definitions used by the RS232 driver. */
-#define	RS_BUF_SIZE		 256	/* output buffer per serial line */
+#define	RS_BUF_SIZE		 256	/* output ring; MUST BE POWER OF 2 */
+#define RS_MASK	     (RS_BUF_SIZE - 1)	/* mask for output ring indices */
 #define SPARE                     16	/* leave room in buffer for echoes */
+#define LOW_WATER                 32	/* ask for more output at this level */
 #define THRESHOLD                 20	/* # chars to accumulate before msg */
+#define CHAR_BITS                 10	/* bits on the line per character */
 
 #if (CHIP != M68000)
 #define PRIMARY                0x3F8	/* I/O port of primary RS232 */
@@ -100,29 +103,60 @@ PRIVATE u_short rec_mask; /* receive mask to mask out stopbits */
 PRIVATE u_short dat_mask; /* receive mask to get databits only */
 #endif
 
+/* The output buffer is a ring like the input rings in tty.h: the TTY task
+ * stores characters at rs_ohead and the transmit interrupt takes them out at
+ * rs_otail.  Only starting an idle line needs a lock.  When the ring runs low
+ * while the writer still has data, the interrupt sets rs_refill and wakes up
+ * the task, which copies the next chunk from user space.
+ */
 PRIVATE struct rs_struct{
   int rs_base;			/* 0x3F8 for primary, 0x2F8 secondary*/
 				/* unused on ST */
   int rs_busy;			/* line is idle or not */
-  int rs_left;			/* # chars left in buffer to output */
-  char *rs_next;		/* pointer to next char to output */
-  char rs_buf[RS_BUF_SIZE];	/* output buffer */
+  int rs_refill;		/* 1 when the task should copy more output */
+  unsigned rs_ohead;		/* # chars ever put in rs_buf; task only */
+  unsigned rs_otail;		/* # chars ever output; interrupt only */
+#if (CHIP == M68000)
+  int rs_txfull;		/* soft line: rs_txchar is being sent */
+  char rs_txchar;		/* soft line: transmit holding register */
+  int rs_rate;			/* soft line: # chars sent per clock tick */
+#endif
+  char rs_buf[RS_BUF_SIZE];	/* output ring */
+  char rs_inbuf[RS_IN_BYTES];	/* storage for the tty_rawin ring */
+  char rs_inqueue[RS_QUEUE_BYTES];	/* storage for the input queue */
 } rs_struct[NR_RS_LINES];
 
+#define rs_count(rs)	((unsigned) ((rs)->rs_ohead - (rs)->rs_otail))
+#define rs_put(rs, c)	((rs)->rs_buf[(rs)->rs_ohead & RS_MASK] = (c), \
+			 (rs)->rs_ohead++)
+
 #if (CHIP == M68000)
+/* Only SERIAL1 is a real UART.  Until there is a driver for a multiport
+ * board, the other lines are soft lines: a stand-in UART that runs off the
+ * clock at the speed set for the line.  They are wired as null-modem pairs,
+ * SERIAL1+1 to SERIAL1+2 and so on; an odd line out loops back to itself.
+ * Thus two terminals programs, or a getty and a terminal program, can talk
+ * to each other through them.
+ */
+#define soft_line(line)	((line) != SERIAL1)
+#define soft_peer(line)	((((line) - SERIAL1 - 1) ^ 1) + SERIAL1 + 1 < NR_LINES \
+			 ? (((line) - SERIAL1 - 1) ^ 1) + SERIAL1 + 1 : (line))
 
 PRIVATE int dummy;	/* to read error chars in */
 PRIVATE int lastchar;	/* save last outputted char for retry */
 
 PUBLIC  void rs_flush();
+PUBLIC  void rs_refill();
 PUBLIC  void rs_out_char();
 PUBLIC  void rs_sig();
 PUBLIC  void init_rs232();
 PUBLIC  void set_uart();
 PRIVATE	void rs_read_int();
+PRIVATE	void rs_in_char();
 PRIVATE	void rs_write_int();
 PRIVATE void rs_feed();
 PRIVATE	void start_rs232();
+PRIVATE void rs_start();
 PRIVATE	void serial_out();
 PRIVATE void rs_expand();
 PRIVATE	void config_rs232();
@@ -222,7 +256,7 @@ int unit;				/* which unit caused the interrupt */
 PRIVATE	void rs_read_int(line)
 int line;
 {
-  int val, k, base;
+  int val, base;
 
   base = rs_struct[line - NR_CONS].rs_base;
 
@@ -232,26 +266,39 @@ int line;
 #else
   port_in(base + RS232_RECEIVER_DATA_REG, &val);
 #endif
+  rs_in_char(line, val);
+}
 
-  /* Store the character in memory so the task can get at it later */
-  if ((k = tty_buf_count(tty_driver_buf)) < tty_buf_max(tty_driver_buf)) {
-	/* There is room to store this character, do it */
-	k = k + k;			/* each entry contains two bytes */
-	tty_driver_buf[k + 4] = val;	/* store the ascii code */
-	tty_driver_buf[k + 5] = line;	/* tell wich line it came from */ 
-	tty_buf_count(tty_driver_buf)++;		/* increment counter */
 
-	if (tty_buf_count(tty_driver_buf) < THRESHOLD) {
-		/* Don't send message.  Just accumulate.  Let clock do it. */
-		INT_CTL_ENABLE;
-		flush_flag++;
-		return;
-	}
-	rs_flush();			/* send TTY task a message */
-  } else {
+/*===========================================================================*
+ *				rs_in_char			 	     *
+ *===========================================================================*/
+PRIVATE	void rs_in_char(line, val)
+int line;			/* line the character arrived on */
+int val;			/* the character */
+{
+  register struct tty_struct *tp;
+
+  /* Store the character in the line's input ring so the task can get at it
+   * later.  The ring only fills up when the task has fallen behind by more
+   * than RS_IN_BYTES characters.
+   */
+  tp = &tty_struct[line];
+  if (ring_full(&tp->tty_rawin)) {
 	/* Too many character have been buffered. Discard excess */
+	tp->tty_overrun++;
+	INT_CTL_ENABLE;
+	return;
+  }
+  ring_put(&tp->tty_rawin, val);
+
+  if (ring_count(&tp->tty_rawin) < THRESHOLD) {
+	/* Don't send message.  Just accumulate.  Let clock do it. */
 	INT_CTL_ENABLE;
+	flush_flag++;
+	return;
   }
+  rs_flush();			/* send TTY task a message */
 }
 
 
@@ -260,15 +307,19 @@ int line;
  *===========================================================================*/
 PUBLIC void rs_flush()
 {
-/* Flush the tty_driver_buf by sending a message to TTY.  This procedure can
- * be triggered locally, when a character arrives, or by the clock task.
+/* Tell the TTY task that there is input in one of the rings.  This procedure
+ * can be triggered locally, when a character arrives, or by the clock task.
  */
+  register struct tty_struct *tp;
   int s = lock();
 
-  /* Build and send the interrupt message */ 
   flush_flag = 0;
-  if ((tty_buf_count(tty_driver_buf) == 0) && (output_done == 0)) return;	/* nothing to flush */
-  interrupt(TTY);	/* send a message to the tty task */
+  for (tp = &tty_struct[0]; tp < &tty_struct[NR_LINES]; tp++) {
+	if (ring_count(&tp->tty_rawin) != 0) break;
+  }
+  if (tp < &tty_struct[NR_LINES] || ring_count(&tty_oper) != 0
+							|| output_done != 0)
+	interrupt(TTY);	/* send a message to the tty task */
   restore(s);
 }
 
@@ -305,20 +356,30 @@ int line;
   }
 #endif
 
-  /* If there are more characters in rs_buf, output the next one. */
-  if (rs->rs_left > 0) {
+  /* If there are more characters in rs_buf, output the next one.  Ask the
+   * task for more before the ring runs dry, so the line keeps busy.
+   */
+  tp = &tty_struct[line];
+  if (rs_count(rs) > 0) {
 	rs_feed(rs);			/* output the next char in rs_buf */
-	INT_CTL_ENABLE;
+	if (rs_count(rs) == LOW_WATER && tp->tty_outleft > 0 && !rs->rs_refill){
+		rs->rs_refill = TRUE;
+		interrupt(TTY);
+	} else {
+		INT_CTL_ENABLE;
+	}
 	return;
   }
 
-  /* The current rs_buf is finished.  See if the complete user buf is done. */
-  tp = &tty_struct[line];
+  /* The ring is empty.  See if the complete user buf is done. */
   rs->rs_busy = FALSE;
-  rs->rs_next = &rs->rs_buf[0];
   if (tp->tty_outleft > 0) {
-	serial_out(tp);			/* copy the next chunk to rs_buf */
-	INT_CTL_ENABLE;
+	if (!rs->rs_refill) {
+		rs->rs_refill = TRUE;	/* let the task copy the next chunk */
+		interrupt(TTY);
+	} else {
+		INT_CTL_ENABLE;
+	}
 	return;
   }
 
@@ -337,51 +398,121 @@ int line;
  *				rs_feed		  		 	     *
  *===========================================================================*/
 PRIVATE void rs_feed(rs)
-struct rs_struct *rs;			/* which line */
+register struct rs_struct *rs;		/* which line */
 {
 /* If there is more output queued, output the next character. */
 
   char byte;
 
-  if (rs->rs_left > 0) {
+  if (rs_count(rs) > 0) {
+	byte = rs->rs_buf[rs->rs_otail & RS_MASK];
 #if (CHIP == M68000)
-	SIAOUT(*rs->rs_next);
+	if (soft_line(rs - rs_struct + NR_CONS)) {
+		rs->rs_txchar = byte;	/* rs_timer() sends it */
+		rs->rs_txfull = TRUE;
+	} else
+		SIAOUT(byte);
 #else
-	byte = *rs->rs_next;
 	port_out(rs->rs_base + RS232_TRANSMIT_HOLDING, (int) byte);
 #endif
-	rs->rs_next++;
-	rs->rs_left--;			/* one char done */
+	rs->rs_otail++;			/* one char done */
   }
 }
 
 
+#if (CHIP == M68000)
 /*===========================================================================*
- *				start_rs232				     * 
+ *				rs_timer				     * 
  *===========================================================================*/
-PRIVATE	void start_rs232(tp)
-struct tty_struct *tp;			/* which tty */
+PUBLIC void rs_timer()
+{
+/* Called by the clock every tick to move the characters of the soft lines.
+ * Each line sends as many characters as its speed allows in one tick, no
+ * matter how many lines there are.  Every character sent is a receive on
+ * the peer line and a transmit interrupt on the sending one.
+ */
+
+  register struct rs_struct *rs;
+  int line, n, s;
+
+  s = lock();
+  for (line = SERIAL1 + 1; line < NR_LINES; line++) {
+	rs = &rs_struct[line - NR_CONS];
+	for (n = rs->rs_rate; n > 0 && rs->rs_txfull; n--) {
+		rs->rs_txfull = FALSE;
+		rs_in_char(soft_peer(line), rs->rs_txchar);
+		rs_write_int(line);	/* loads the next char, if any */
+	}
+  }
+  restore(s);
+}
+#endif
+
+
+/*===========================================================================*
+ *				rs_start				     * 
+ *===========================================================================*/
+PRIVATE void rs_start(rs)
+register struct rs_struct *rs;		/* which line */
 {
+/* Characters have been put in the output ring.  If the line is idle, output
+ * the first one; the transmit interrupts take care of the rest.  The test
+ * must be atomic with respect to rs_write_int(), which may just be deciding
+ * that the line has become idle.
+ */
+
   int old_state;
 
+  if (rs->rs_busy) return;
   old_state = lock();
-  serial_out(tp);
+  if (!rs->rs_busy && rs_count(rs) > 0) {
+	rs->rs_busy = TRUE;
+	rs_feed(rs);
+  }
   restore(old_state);
+}
+
+
+/*===========================================================================*
+ *				start_rs232				     * 
+ *===========================================================================*/
+PRIVATE	void start_rs232(tp)
+struct tty_struct *tp;			/* which tty */
+{
+  serial_out(tp);
 }	
 
 
+/*===========================================================================*
+ *				rs_refill				     * 
+ *===========================================================================*/
+PUBLIC void rs_refill()
+{
+/* Copy more output to the lines whose transmit interrupt asked for it. */
+
+  register struct rs_struct *rs;
+
+  for (rs = &rs_struct[0]; rs < &rs_struct[NR_RS_LINES]; rs++) {
+	if (!rs->rs_refill) continue;
+	rs->rs_refill = FALSE;
+	serial_out(&tty_struct[NR_CONS + (rs - rs_struct)]);
+  }
+}
+
+
 /*===========================================================================*
  *				serial_out				     * 
  *===========================================================================*/
 PRIVATE	void serial_out(tp)
 register struct tty_struct *tp;	/* tells which terminal is to be used */
 {
-/* Copy as much data as possible to the output queue, then start I/O if
- * necessary.
+/* Copy as much data as possible to the output ring, then start I/O if
+ * necessary.  This is only called by the TTY task, which is the only one
+ * to store characters in the ring.
  */
   int bytes = 0;
-  int line;
-  char c, *limit;
+  int line, left;
+  char c;
   register struct rs_struct *rs;
 #if (CHIP == M68000)
   char *charptr = (char *)tp->tty_phys;
@@ -394,16 +525,18 @@ register struct tty_struct *tp;	/* tells which terminal is to be used */
 
   line = tp - &tty_struct[0];		/* line is index into tty_struct */
   rs = &rs_struct[line - NR_CONS];	/* 0 to NR_CONS - 1 are consoles */
-  /* Copy bytes from user space to rs_buf. */
-  limit = &rs->rs_buf[RS_BUF_SIZE - SPARE];
 #if (CHIP != M68000)
   segment = (tp->tty_phys >> 4) & WORD_MASK;
   offset = tp->tty_phys & OFF_MASK;
   offset1 = offset;
 #endif
 
-  /* While there is still data to output and there is still room in buf, copy*/
-  while (tp->tty_outleft > 0 && (rs->rs_next + rs->rs_left) < limit) {
+  /* While there is still data to output and there is still room in buf, copy.
+   * tty_outleft is only updated at the end, so that the interrupt cannot see
+   * it drop to 0 before the last characters are in the ring.
+   */
+  left = tp->tty_outleft;
+  while (left > 0 && rs_count(rs) < RS_BUF_SIZE - SPARE) {
 #if (CHIP == M68000)
 	c = *charptr++;
 	bytes++;
@@ -411,12 +544,11 @@ register struct tty_struct *tp;	/* tells which terminal is to be used */
 	c = get_byte(segment, offset);	/* fetch 1 byte */
 	offset++;
 #endif
-	tp->tty_outleft--;
+	left--;
 	if (c < ' ') {
 		rs_expand(tp, rs, c);	/* insert the char in rs_buf */
 	} else {
-		*(rs->rs_next + rs->rs_left) = c;	/* avoid proc call */
-		rs->rs_left++;
+		rs_put(rs, c);		/* avoid proc call */
 		tp->tty_column++;
 	}
   }
@@ -426,11 +558,9 @@ register struct tty_struct *tp;	/* tells which terminal is to be used */
 #endif
   tp->tty_cum += bytes;			/* update cumulative total */
   tp->tty_phys += bytes;		/* next time, take different bytes */
+  tp->tty_outleft = left;
 
-  if (!rs->rs_busy) {			/* is the line idle? */
-	rs->rs_busy = TRUE;		/* if so, mark it as busy */
-	rs_feed(rs);			/* and start it going */
-  }
+  rs_start(rs);				/* start the line if it is idle */
 }
 
 
@@ -443,21 +573,17 @@ char c;				/* character to be output */
 {
 /* Output a character on an RS232 line. */
 
-  int line, old_state;
+  int line;
   register struct rs_struct *rs;
 
-  /* See if there is room to store a character, and if so, do it. */
-  old_state = lock();
+  /* See if there is room to store a character, and if so, do it.  A tab
+   * may expand to TAB_SIZE characters.
+   */
   line = tp - tty_struct;
   rs = &rs_struct[line - NR_CONS];
-  if (rs->rs_next + rs->rs_left == &rs->rs_buf[RS_BUF_SIZE]) return;  /*full */
+  if (rs_count(rs) > RS_BUF_SIZE - TAB_SIZE) return;  /* full */
   rs_expand(tp, rs, c);
-
-  if (!rs->rs_busy) {		/* if terminal line is idle, start it */
-	rs->rs_busy = TRUE;
-	rs_feed(rs);
-  }
-  restore(old_state);
+  rs_start(rs);			/* if terminal line is idle, start it */
 }
 
 
@@ -474,10 +600,8 @@ char c;				/* character to be output */
  */
 
   int mode, count, count1;
-  char *deposit;		/* where to deposit the next character */
 
   mode = tp->tty_mode;
-  deposit = rs->rs_next + rs->rs_left;
 
   switch(c) {
 	case '\b':
@@ -491,8 +615,7 @@ char c;				/* character to be output */
 	case '\n':
 		/* Check to see if LF has to be mapped to CR + LF. */
 		if (mode & CRMOD) {
-			*deposit++ = '\r';
-			rs->rs_left++;
+			rs_put(rs, '\r');
 			tp->tty_column = -1;
 		}
 		break;
@@ -502,8 +625,7 @@ char c;				/* character to be output */
 		count1 = count;
 		if ((mode & XTABS) == XTABS) {
 			/* Tabs must be expanded. */
-			while (count1--) *deposit++ = ' ';
-			rs->rs_left += count;
+			while (count1--) rs_put(rs, ' ');
 			tp->tty_column += count;
 			return;
 		} else {
@@ -513,8 +635,7 @@ char c;				/* character to be output */
   }
 
   /* Output character and update counters. */
-  *deposit = c;			/* copy character to rs_buf */
-  rs->rs_left++;		/* there is one more character to print */
+  rs_put(rs, c);		/* copy character to rs_buf */
   tp->tty_column++;		/* update column */
 }
 
@@ -530,7 +651,7 @@ PUBLIC int tty_o_done()
   struct tty_struct *tp;
   /* See if any of the RS232 lines are complete.  Send at most one message. */
   old_state = lock();
-  for (tp = &tty_struct[NR_CONS]; tp < &tty_struct[NR_CONS+NR_RS_LINES]; tp++){
+  for (tp = &tty_struct[NR_CONS]; tp < &tty_struct[NR_LINES]; tp++){
 	if (tp->tty_waiting == COMPLETED) {
 		replyee = (int) tp->tty_otcaller;
 		caller = (int) tp->tty_outproc;
@@ -556,14 +677,19 @@ struct tty_struct *tp;
 {
 /* Called when a DEL character is typed.  It resets the output. */
 
-  int line;
+  int line, old_state;
   struct rs_struct *rs;
 
   line = tp - tty_struct;
   rs = &rs_struct[line - NR_CONS];
-  rs->rs_left = 0;
+  old_state = lock();
+  rs->rs_ohead = rs->rs_otail;	/* discard pending output */
+  rs->rs_refill = FALSE;
   rs->rs_busy = FALSE;
-  rs->rs_next = &rs->rs_buf[0];
+#if (CHIP == M68000)
+  rs->rs_txfull = FALSE;
+#endif
+  restore(old_state);
 }
 
 
@@ -576,9 +702,10 @@ PUBLIC void init_rs232()
   register struct rs_struct *rs;
   int line;
 
-  for (tp = &tty_struct[NR_CONS]; tp < &tty_struct[NR_CONS+NR_RS_LINES]; tp++){
-	tp->tty_inhead = tp->tty_inqueue;
-	tp->tty_intail = tp->tty_inqueue;
+  for (tp = &tty_struct[NR_CONS]; tp < &tty_struct[NR_LINES]; tp++){
+	rs = &rs_struct[tp - &tty_struct[NR_CONS]];
+	ring_init(&tp->tty_rawin, rs->rs_inbuf, RS_IN_BYTES);
+	in_queue_init(tp, rs->rs_inqueue, RS_QUEUE_BYTES);
 /*	tp->tty_mode = CRMOD | XTABS | ECHO; */
 	tp->tty_mode = RAW | BITS8;
 	tp->tty_devstart = start_rs232;
@@ -614,9 +741,12 @@ PUBLIC void init_rs232()
 
   for (rs = &rs_struct[0]; rs < &rs_struct[NR_RS_LINES]; rs++) {
 	line = rs - rs_struct + NR_CONS;
-	rs->rs_next = & rs->rs_buf[0];
-	rs->rs_left = 0;
+	rs->rs_ohead = rs->rs_otail = 0;
+	rs->rs_refill = FALSE;
 	rs->rs_busy = FALSE;
+#if (CHIP == M68000)
+	rs->rs_txfull = FALSE;
+#endif
 	config_rs232(line, DEF_BAUD, DEF_BAUD, NONE, 1, 8);    /* set params */
 #if (CHIP != M68000)
 	port_out(rs->rs_base + RS232_MODEM_CONTROL, MODEM_CONTROLS);
@@ -661,6 +791,17 @@ int parity;			/* EVEN, ODD, or NONE */
 int stop_bits;			/* 2 (110 baud) or 1 (other speeds) */
 int data_bits;			/* 5, 6, 7, or 8 */
 {
+#if (CHIP == M68000)
+  if (soft_line(line)) {
+	/* A soft line only needs to know how fast to go. */
+	if (out_baud < 50) out_baud = DEF_BAUD;
+	rs_struct[line - NR_CONS].rs_rate = out_baud / CHAR_BITS / HZ;
+	if (rs_struct[line - NR_CONS].rs_rate == 0)
+		rs_struct[line - NR_CONS].rs_rate = 1;
+	tty_struct[line].tty_speed = ((out_baud/100) << 8) | (in_baud/100);
+	return;
+  }
+#endif
 #if (MACHINE == ATARI_ST)
   unsigned char mode = U_Q16; /* 1 stop bit; divide by 16 */
   switch (stop_bits)
@@ -59,6 +59,8 @@ PUBLIC  void tty_reply();
 PUBLIC  void sigchar();
 PRIVATE void do_int();
 PRIVATE void charint();
+PRIVATE int in_line();
+PRIVATE void in_raw();
 PRIVATE void in_char();
 PRIVATE void echo();
 PRIVATE void do_read();
@@ -76,13 +78,21 @@ PUBLIC void tty_task()
 
   message tty_mess;		/* buffer for all incoming messages */
   register struct tty_struct *tp;
+  int line;
 
   output_done = 0;
   tty_init();			/* initialize */
   init_rs232();
   while (TRUE) {
 	receive(ANY, &tty_mess);
-	tp = &tty_struct[tty_mess.TTY_LINE];
+	line = minor_to_line(tty_mess.TTY_LINE);
+	if (tty_mess.m_type != HARD_INT &&
+			(tty_mess.TTY_LINE < 0 || line >= NR_LINES)) {
+		tty_reply(TASK_REPLY, tty_mess.m_source, tty_mess.PROC_NR,
+							ENXIO, 0L, 0L);
+		continue;
+	}
+	tp = &tty_struct[line];
 	switch(tty_mess.m_type) {
 	    case HARD_INT:	do_int(tp, &tty_mess);		break;
 	    case TTY_READ:	do_read(tp, &tty_mess);		break;
@@ -112,9 +122,9 @@ message *m_ptr;			/* pointer to message sent to the task */
  * task is busy, a bit is set in 'busy_map' and the message pointer stored.
  * If multiple messages happen, the bit is only set once.  No input data is
  * lost even if this happens because all the input messages say is that there
- * is some input.  The actual input is in the tty_driver_buf array, so losing
- * a message just means that when the one interrupt-generated message is given
- * to the TTY task, it will find multiple characters in tty_driver_buf.
+ * is some input.  The actual input is in the tty_rawin ring of each line, so
+ * losing a message just means that when the one interrupt-generated message
+ * is given to the TTY task, it will find multiple characters in the rings.
  *
  * The introduction of RS232 lines has complicated this situation somewhat. Now
  * a message can mean that some RS232 line has finished transmitting all the
@@ -130,9 +140,10 @@ message *m_ptr;			/* pointer to message sent to the task */
  *
  * In short, when this procedure is called, it can check for RS232 line done
  * by inspecting output_done and it can check for characters in the input
- * buffer by inspecting tty_driver_buf[0].  Thus losing a message to the TTY
+ * rings by comparing their head and tail.  Thus losing a message to the TTY
  * task is not serious because the underlying conditions are explicitly checked
- * for on each interrupt.
+ * for on each interrupt.  The same holds for RS232 lines whose output ring
+ * is running low; they are marked and refilled by rs_refill().
  */
 
   /* First check to see if any RS232 lines have completed. */
@@ -145,6 +156,7 @@ message *m_ptr;			/* pointer to message sent to the task */
 		return;
 	}
   }
+  rs_refill();			/* copy more output to RS232 lines */
   charint();			/* check for input characters */
 }
 
@@ -154,51 +166,137 @@ message *m_ptr;			/* pointer to message sent to the task */
  *===========================================================================*/
 PRIVATE void charint()
 {
-/* A character has been typed.  If a character is typed and the tty task is
- * not able to service it immediately, the character is accumulated within
- * the tty driver.  Thus multiple chars may be accumulated.  A single message
- * to the tty task may have to process several characters.
+/* Characters have been typed.  If a character is typed and the tty task is
+ * not able to service it immediately, the character is accumulated in the
+ * input ring of its line.  Thus multiple chars may be accumulated, and a
+ * single message to the tty task may have to process several characters on
+ * several lines.  To be fair to all lines, the rings are served in rounds of
+ * at most TTY_QUANTUM characters per line, starting at a different line on
+ * each call, until they are all empty.
  */
 
-  int m, n, count, replyee, caller, old_state;
-  char *ptr, *copy_ptr, ch;
-  struct tty_struct *tp;
-
-  old_state = lock();
-  ptr = tty_driver_buf;		/* pointer to accumulated char array */
-  copy_ptr = tty_copy_buf;	/* ptr to shadow array where chars copied */
-  n = tty_buf_count(ptr);	/* how many chars have been accumulated */
-  count = n;			/* save the character count */
-  n = n + n;			/* each char occupies 2 bytes */
-  ptr += 4;			/* skip count field at start of array */
-  while (n-- > 0)
-	*copy_ptr++ = *ptr++;	/* copy the array to safety */
-  ptr = tty_driver_buf;
-  tty_buf_count(ptr) = 0;		/* accumulation count set to 0 */
-  restore(old_state);
-
-  /* Loop on the accumulated characters, processing each in turn. */
-  if (count == 0) return;	/* on HARD_INT interrupt, count might be 0 */
-  copy_ptr = tty_copy_buf;
-  while (count-- > 0) {
-	ch = *copy_ptr++;	/* get the character typed */
-	n = *copy_ptr++;	/* get the line number it came in on */
-	in_char(n, ch);		/* queue the char and echo it */
-
-	/* See if a previously blocked reader can now be satisfied. */
-	tp = &tty_struct[n];	/* pointer to struct for this character */
-
-	if (tp->tty_inleft > 0 ) {	/* does anybody want input? */
-		m = tp->tty_mode & (CBREAK | RAW);
-		if (tp->tty_lfct > 0 || (m != 0 && tp->tty_incount > 0)) {
-			m = rd_chars(tp);
-
-			/* Tell hanging reader that chars have arrived. */
-			replyee = (int) tp->tty_incaller;
-			caller = (int) tp->tty_inproc;
-			tty_reply(REVIVE, replyee, caller, m, 0L, 0L);
+  static int first_line;	/* line to start the next call with */
+  int i, more, m, line, replyee, caller;
+  register struct tty_ring *rp;
+  register struct tty_struct *tp;
+  char ch;
+
+#if (CHIP == M68000)
+  /* Function keys for the operator come first; they are not input. */
+  rp = &tty_oper;
+  while (ring_count(rp) != 0) {
+	ch = rp->tr_buf[rp->tr_tail & rp->tr_mask];
+	rp->tr_tail++;
+	func_key(ch);
+  }
+#endif
+
+  do {
+	more = FALSE;
+	for (i = 0; i < NR_LINES; i++) {
+		line = first_line + i;
+		if (line >= NR_LINES) line -= NR_LINES;
+		tp = &tty_struct[line];
+		if (ring_count(&tp->tty_rawin) == 0) continue;
+
+		if (in_line(tp, TTY_QUANTUM)) more = TRUE;
+
+		/* See if a previously blocked reader can now be satisfied. */
+		if (tp->tty_inleft > 0 ) {	/* does anybody want input? */
+			m = tp->tty_mode & (CBREAK | RAW);
+			if (tp->tty_lfct > 0 || (m != 0 && tp->tty_incount > 0)) {
+				m = rd_chars(tp);
+
+				/* Tell hanging reader that chars have arrived. */
+				replyee = (int) tp->tty_incaller;
+				caller = (int) tp->tty_inproc;
+				tty_reply(REVIVE, replyee, caller, m, 0L, 0L);
+			}
 		}
 	}
+  } while (more);
+  if (++first_line == NR_LINES) first_line = 0;
+}
+
+
+/*===========================================================================*
+ *				in_line					     *
+ *===========================================================================*/
+PRIVATE int in_line(tp, max)
+register struct tty_struct *tp;	/* line whose input ring is to be drained */
+int max;			/* maximum number of characters to take */
+{
+/* Take at most 'max' characters from the input ring of a line and queue
+ * them.  Return TRUE if characters are left in the ring.
+ */
+
+  register struct tty_ring *rp;
+  int m, line;
+  char ch;
+
+  rp = &tp->tty_rawin;
+  m = tp->tty_mode & (RAW | CBREAK | ECHO);
+#if (CHIP == M68000)
+  if (m == RAW) {
+#else
+  if (m == RAW && tp->tty_makebreak == ONE_INT) {
+#endif
+	in_raw(tp, max);		/* no editing, no echo: bulk copy */
+  } else {
+	/* Loop on the accumulated characters, processing each in turn. */
+	line = tp - tty_struct;
+	while (max-- > 0 && ring_count(rp) != 0) {
+		ch = rp->tr_buf[rp->tr_tail & rp->tr_mask];
+		rp->tr_tail++;	/* slot may be reused from now on */
+		in_char(line, ch);	/* queue the char and echo it */
+	}
+  }
+  return(ring_count(rp) != 0);
+}
+
+
+/*===========================================================================*
+ *				in_raw					     *
+ *===========================================================================*/
+PRIVATE void in_raw(tp, max)
+register struct tty_struct *tp;	/* line whose input ring is to be drained */
+int max;			/* maximum number of characters to take */
+{
+/* In raw mode without echo, characters need no processing at all, so the
+ * input ring is copied to the input queue in runs, with only the line feeds
+ * being counted.  This is the path taken by file transfer programs.
+ */
+
+  register char *src, *dst;
+  register int n;
+  struct tty_ring *rp;
+  int room, run;
+
+  rp = &tp->tty_rawin;
+  while (max > 0 && (n = ring_count(rp)) != 0) {
+	/* A run ends at the end of the ring or at the end of the queue. */
+	if (n > max) n = max;
+	room = tp->tty_insize - tp->tty_incount;
+	if (room == 0) {
+		rp->tr_tail += n;	/* no room, discard chars */
+		tp->tty_overrun += n;
+		return;
+	}
+	run = rp->tr_mask + 1 - (rp->tr_tail & rp->tr_mask);
+	if (n > run) n = run;
+	run = tp->tty_inlimit - tp->tty_inhead;
+	if (n > run) n = run;
+	if (n > room) n = room;
+
+	src = &rp->tr_buf[rp->tr_tail & rp->tr_mask];
+	dst = tp->tty_inhead;
+	tp->tty_incount += n;
+	max -= n;
+	for (run = n; run > 0; run--)
+		if ((*dst++ = *src++) == '\n') tp->tty_lfct++;
+	rp->tr_tail += n;	/* only now may the slots be reused */
+	if (dst == tp->tty_inlimit) dst = tp->tty_inqueue;
+	tp->tty_inhead = dst;
   }
 }
 
@@ -230,7 +328,7 @@ char ch;			/* scan code for character that arrived */
 	func_key(ch);		/* process function key */
 	return;
   }
-  if (tp->tty_incount >= TTY_IN_BYTES) return;	/* no room, discard char */
+  if (tp->tty_incount >= tp->tty_insize) return;	/* no room, discard char */
   mode = tp->tty_mode & (RAW | CBREAK);
 #if (CHIP != M68000)
   if (tp->tty_makebreak == TWO_INTS) {
@@ -290,8 +388,7 @@ char ch;			/* scan code for character that arrived */
 				/* Store the escape previously skipped over */
 				*tp->tty_inhead++ = '\\';
 				tp->tty_incount++;
-				if (tp->tty_inhead ==
-						&tp->tty_inqueue[TTY_IN_BYTES])
+				if (tp->tty_inhead == tp->tty_inlimit)
 					tp->tty_inhead = tp->tty_inqueue;
 			}
 		}
@@ -330,12 +427,12 @@ char ch;			/* scan code for character that arrived */
 		shift1 == 0 && shift2 == 0 && numlock == 0) {
 	/* This key is to generate a three-character escape sequence. */
 	*tp->tty_inhead++ = ESC; /* put ESC in the input queue */
-	if (tp->tty_inhead == &tp->tty_inqueue[TTY_IN_BYTES])
+	if (tp->tty_inhead == tp->tty_inlimit)
 		tp->tty_inhead = tp->tty_inqueue;      /* handle wraparound */
 	tp->tty_incount++;
 	echo(tp, 'E');
 	*tp->tty_inhead++ = BRACKET; /* put ESC in the input queue */
-	if (tp->tty_inhead == &tp->tty_inqueue[TTY_IN_BYTES])
+	if (tp->tty_inhead == tp->tty_inlimit)
 		tp->tty_inhead = tp->tty_inqueue;      /* handle wraparound */
 	tp->tty_incount++;
 	echo(tp, BRACKET);
@@ -344,7 +441,7 @@ char ch;			/* scan code for character that arrived */
 #endif
 
   *tp->tty_inhead++ = ch;	/* save the character in the input queue */
-  if (tp->tty_inhead == &tp->tty_inqueue[TTY_IN_BYTES])
+  if (tp->tty_inhead == tp->tty_inlimit)
 	tp->tty_inhead = tp->tty_inqueue;	/* handle wraparound */
   tp->tty_incount++;
   echo(tp, ch);
@@ -428,15 +525,7 @@ register char c;		/* character to echo */
 /* MARKER is meaningful only in cooked mode */
   if (c != MARKER || tp->tty_mode & (CBREAK | RAW)) {
 	if (tp - tty_struct < NR_CONS)
-	{
-#if (CHIP == M68000)
-		vducursor(0);
-#endif
 		out_char(tp, c);	/* echo to console */
-#if (CHIP == M68000)
-		vducursor(1);
-#endif
-	}
 	else
 		rs_out_char(tp, c);	/* echo to RS232 line */
   }
@@ -459,7 +548,7 @@ register struct tty_struct *tp;	/* from which tty should chars be removed */
 
   /* Don't delete '\n' or '\r'. */
   prev = (tp->tty_inhead != tp->tty_inqueue ? tp->tty_inhead - 1 :
-					     &tp->tty_inqueue[TTY_IN_BYTES-1]);
+						      tp->tty_inlimit - 1);
   if (*prev == '\n' || *prev == '\r') return(-1);
   tp->tty_inhead = prev;
   tp->tty_incount--;
@@ -536,7 +625,7 @@ register struct tty_struct *tp;	/* pointer to terminal to read from */
 	/* The inner loop fills one buffer. */
 	while(buf_ct-- > 0) {
 		ch = *tp->tty_intail++;
-		if (tp->tty_intail == &tp->tty_inqueue[TTY_IN_BYTES])
+		if (tp->tty_intail == tp->tty_inlimit)
 			tp->tty_intail = tp->tty_inqueue;
 		*tty_ptr++ = ch;
 		ct++;
@@ -641,7 +730,7 @@ message *m_ptr;			/* pointer to message sent to the task */
    * routine will return at once so there is no need to suspend the caller,
    * on ascii terminals however, the call is suspended and later revived.
    */
-  if (m_ptr->TTY_LINE != 0) {
+  if (tp - tty_struct >= NR_CONS) {
 	caller = (int) tp->tty_outproc;
 	replyee = (int) tp->tty_otcaller;
 	tty_reply(TASK_REPLY, replyee, caller, SUSPEND, 0L, 0L);
@@ -705,7 +794,7 @@ message *m_ptr;			/* pointer to message sent to task */
 	break;
 
      case TIOCFLUSH:
-        tty_buf_count(tty_driver_buf)=0;
+	tp->tty_rawin.tr_tail = tp->tty_rawin.tr_head;
         break;
 
      default:
@@ -1,20 +1,26 @@
-#define NR_CONS            1	/* how many consoles can system handle */
+#define NR_CONS            2	/* how many consoles can system handle */
 
 #if (CHIP == M68000)
 #define CONSOLE            0	/* line number for console */
-#define SERIAL1		   1	/* line number for serial port */
+#define SERIAL1	     NR_CONS	/* line number for serial port */
 #define OPERATOR        (-1)	/* handle CTRL-ALT-PFX sequences */
 #endif
 
-#define	NR_RS_LINES	   1	/* how many rs232 terminals can system handle*/
-#define TTY_IN_BYTES    1000	/* input queue size */
+#define	NR_RS_LINES	   3	/* how many rs232 terminals can system handle*/
+#define NR_LINES (NR_CONS + NR_RS_LINES)	/* size of tty_struct[] */
+#define TTY_IN_BYTES    1000	/* console input queue size */
+#define RS_QUEUE_BYTES  2000	/* RS232 input queue size */
 #define TTY_RAM_WORDS    320	/* ram buffer size */
 #define TTY_BUF_SIZE     256	/* unit for copying to/from queues */
+#define TTY_QUANTUM       64	/* chars taken from one line in a round */
 #define TAB_SIZE           8	/* distance between tabs */
 #define TAB_MASK          07	/* mask for tty_column when tabbing */
 #define WORD_MASK     0xFFFF	/* mask for 16 bits */
 #define OFF_MASK      0x000F	/* mask for  4 bits */
 #define MAX_OVERRUN      500	/* size of overrun input buffer */
+#define KB_IN_BYTES      256	/* keyboard input ring; MUST BE POWER OF 2 */
+#define RS_IN_BYTES     1024	/* RS232 input ring; MUST BE POWER OF 2 */
+#define OPER_BYTES        16	/* operator key ring; MUST BE POWER OF 2 */
 #define MAX_ESC_PARMS      2	/* number of escape sequence params allowed */
 
 #define ERASE_CHAR      '\b'	/* default erase character */
@@ -83,9 +89,40 @@
 #define US_EXT		   4	/* U.S. extended keyboard */
 #define NR_SCAN_CODES   0x69	/* Number of scan codes */
 
+/* The interrupt handlers pass input to the TTY task through one ring buffer
+ * per line.  The handler is the only one to advance tr_head and the task is
+ * the only one to advance tr_tail, so neither side has to lock() to use the
+ * ring: a character is stored before tr_head is incremented, and a slot is
+ * not reused before tr_tail has moved past it.  The indices run freely and
+ * are masked on each access, which works because the ring size is a power
+ * of 2 and divides the range of an unsigned.
+ */
+struct tty_ring {
+  unsigned tr_head;		/* # chars ever put in; producer only */
+  unsigned tr_tail;		/* # chars ever taken out; consumer only */
+  unsigned tr_mask;		/* ring size - 1 */
+  char *tr_buf;			/* storage for the ring */
+};
+
+#define ring_init(rp, buf, size) \
+	((rp)->tr_head = (rp)->tr_tail = 0, (rp)->tr_mask = (size) - 1, \
+	 (rp)->tr_buf = (buf))
+#define ring_count(rp)	((unsigned) ((rp)->tr_head - (rp)->tr_tail))
+#define ring_full(rp)	(ring_count(rp) > (rp)->tr_mask)
+#define ring_put(rp, c) \
+	((rp)->tr_buf[(rp)->tr_head & (rp)->tr_mask] = (c), (rp)->tr_head++)
+
 EXTERN struct tty_struct {
-  /* Input queue.  Typed characters are stored here until read by a program. */
-  char tty_inqueue[TTY_IN_BYTES];    /* array used to store the characters */
+  /* Input ring.  The interrupt handler stores raw characters here. */
+  struct tty_ring tty_rawin;	/* chars not yet seen by the TTY task */
+  unsigned tty_overrun;		/* # chars lost because tty_rawin was full */
+
+  /* Input queue.  Typed characters are stored here until read by a program.
+   * The storage is provided by the driver, so its size may differ per line.
+   */
+  char *tty_inqueue;		/* array used to store the characters */
+  char *tty_inlimit;		/* end of tty_inqueue */
+  int tty_insize;		/* size of tty_inqueue */
   char *tty_inhead;		/* pointer to place where next char goes */
   char *tty_intail;		/* pointer to next char to be given to prog */
   int tty_incount;		/* # chars in tty_inqueue */
@@ -141,7 +178,18 @@ EXTERN struct tty_struct {
   /* Miscellaneous. */
   int tty_ioport;		/* I/O port number for this terminal */
 
-} tty_struct[NR_CONS+NR_RS_LINES];
+} tty_struct[NR_LINES];
+
+/* The lines in tty_struct[] are the consoles followed by the RS232 lines.
+ * Minor device numbers keep the first console at 0 and the RS232 lines at 1,
+ * 2, ...  so /dev/tty1 stays the first serial port; the other consoles come
+ * after the last RS232 line.
+ */
+#define minor_to_line(m) ((m) == 0 ? 0 : (m) <= NR_RS_LINES ? \
+				NR_CONS - 1 + (m) : (m) - NR_RS_LINES)
+#define in_queue_init(tp, buf, size) \
+	((tp)->tty_inqueue = (tp)->tty_inhead = (tp)->tty_intail = (buf), \
+	 (tp)->tty_inlimit = (buf) + (size), (tp)->tty_insize = (size))
 
 
 /* Values for the fields. */
@@ -157,10 +205,10 @@ EXTERN struct tty_struct {
 #define WAITING            1	/* an output process is waiting for a reply */
 #define COMPLETED          2	/* output done; send a completion message */
 
-EXTERN char tty_driver_buf[2*MAX_OVERRUN+4]; /* driver collects chars here */
-#define tty_buf_count(p) (((int *)(p))[0])
-#define tty_buf_max(p) (((int *)(p))[1])
-EXTERN char tty_copy_buf[2*MAX_OVERRUN];  /* copy buf used to avoid races */
+EXTERN char tty_kb_buf[NR_CONS][KB_IN_BYTES];	/* console input rings */
+EXTERN int cur_cons;		/* console that is shown and gets the keys */
+EXTERN struct tty_ring tty_oper;	/* CTRL-ALT-function keys (OPERATOR) */
+EXTERN char tty_oper_buf[OPER_BYTES];	/* operator ring storage */
 EXTERN char tty_buf[TTY_BUF_SIZE];	/* scratch buffer to/from user space */
 EXTERN int shift1, shift2, capslock, numlock;	/* keep track of shift keys */
 EXTERN int control, alt;	/* keep track of key statii */
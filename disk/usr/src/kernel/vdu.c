@@ -14,8 +14,19 @@
  * notes:
  * this driver assumes memory for videoram at about $07c180 - $07ffff
  *
- * This driver does not deal with multiple consoles and parameter passing
- * through tp. Also the tty struct fields row and column are not maintained
+ * Each of the NR_CONS virtual consoles has its own video ram and state in
+ * vduinfo[]; out_char() draws on the console tp belongs to, whether it is
+ * shown or not.  vduswitch() shows another console by pointing the copper
+ * list at its video ram.  The tty struct fields row and column are not
+ * maintained.
+ *
+ * Characters are not painted as they come in.  They go to a character and
+ * attribute grid, which remembers per line which columns have changed.
+ * flush() paints the changed runs at the end of a write, a scan line at a
+ * time.  Scrolling moves the screen origin through a video ram of twice the
+ * screen size instead of copying the screen; only when the origin runs off
+ * the end is the screen copied back to the start.  Operations that do move
+ * video ram, such as cpyline(), move the line's unpainted changes with it.
  */
 
 #include "kernel.h"
@@ -36,6 +47,7 @@
 #define RGB_DGREY	0x0444
 
 #define VIDEORAM        16000L  /* size of video ram */
+#define VIDEOBUF  (2*VIDEORAM)  /* video ram per console, for scrolling */
 #define NCOL            80      /* characters on a row */
 #define PIX_LIN         640     /* pixels per video line */
 #define PIX_CHR         8       /* pixels in char (width) */
@@ -43,11 +55,17 @@
 #define BYT_LIN         80      /* bytes in video line */
 #define NROW            25      /* 25 lines of text onscreen */
 #define BYTR            640     /* bytes per text line */
-u_long  VRAM=0;                 /* start of video ram */
 #define FONTH           8       /* 8 videolines per text line */
+#define FONTW           0xc0    /* bytes per scan line of the font */
+
+struct vline {                  /* one text line of a console */
+        char    ch[NCOL];       /* characters */
+        char    at[NCOL];       /* attribute byte of each character */
+        short   dfirst;         /* first changed column, not yet painted */
+        short   dlast;          /* last changed column, not yet painted */
+};
 
 PRIVATE struct vduinfo {
-        ptr_t	curs;           /* cursor position in video RAM */
         int	ccol;           /* current char column */
         int     crow;           /* current char row */
         char    attr;           /* current attribute byte */
@@ -56,12 +74,28 @@ PRIVATE struct vduinfo {
         int     savcrow;        /* saved char row */
         char    vbuf[20];       /* partial escape sequence */
         char    *next;          /* next char in vbuf[] */
-} vduinfo;
+        u_long  vram;           /* start of video ram of this console */
+        u_long  org;            /* offset of the screen in vram */
+        int     dirty;          /* some lines have unpainted changes */
+        struct vline *line[NROW];  /* text lines, top to bottom */
+        struct vline lines[NROW];  /* storage for the text lines */
+        struct tty_struct *tp;  /* tty line of this console */
+} vduinfo[NR_CONS];
+PRIVATE struct vduinfo *vdu = &vduinfo[0];  /* console being drawn on */
+#define VRAM    (vdu->vram + vdu->org)  /* start of screen being drawn on */
+
+/* note that column c of line lp has changed */
+#define mark(v, lp, c)  {\
+    if ((c) < (lp)->dfirst) (lp)->dfirst = (c);\
+    if ((c) > (lp)->dlast) (lp)->dlast = (c);\
+    (v)->dirty = TRUE;\
+}
 PRIVATE ptr_t fontbase;           /* start of fontdata in rom */
 PRIVATE long debuglvl;          /* debugging level you told to the loader */
 PRIVATE u_long spritemem[SPRITESZ+1]; /* cursorsprite data */
 PRIVATE u_long nospritemem[2];        /* data for other sprites */
 PRIVATE u_long coplistmem[32];        /* copperlist */
+PRIVATE u_short *copscreen;           /* screen pointer in the copperlist */
 PUBLIC  int  clipright;         /* boolean, clip text at right edge, see moveto */
 
 
@@ -73,20 +107,20 @@ register struct tty_struct *tp;
 {
   register char *rq;
 
-  if (tp->tty_rwords == 0)
+  if (tp - tty_struct >= NR_CONS)
 	return;
-  rq = (char *)tp->tty_ramqueue;
-  do {
-	if (tp->tty_inhibited == TRUE) {
-		vducursor();
-		return;
-	}
-	out_char(tp, *rq++);	/* write 1 byte to terminal */
-	tp->tty_phys++;		/* advance physical data pointer */
-	tp->tty_cum++;		/* number of characters printed */
-  } while (--tp->tty_rwords != 0);
+  if (tp->tty_rwords != 0) {
+	rq = (char *)tp->tty_ramqueue;
+	do {
+		if (tp->tty_inhibited == TRUE)
+			break;
+		out_char(tp, *rq++);	/* write 1 byte to terminal */
+		tp->tty_phys++;		/* advance physical data pointer */
+		tp->tty_cum++;		/* number of characters printed */
+	} while (--tp->tty_rwords != 0);
+  }
+  render(&vduinfo[tp - tty_struct]);	/* paint what has changed */
   vducursor();
-  return;
 }
 
 /*===========================================================================*
@@ -125,10 +159,7 @@ register struct tty_struct *tp;	/* tells which terminal is to be used */
 #endif
 	tp->tty_outleft--;	/* decrement count */
   }
-#if (CHIP == M68000)
-  vducursor();
-#endif
-  flush(tp);			/* clear out the pending characters */
+  flush(tp);			/* clear out the pending characters, paint */
 
   /* Update terminal data structure. */
 #if (CHIP != M68000)
@@ -148,10 +179,12 @@ register struct tty_struct *tp;	/* tells which terminal is to be used */
  * send character to VDU, collecting escape sequences
  */
 PUBLIC void out_char(tp, c)
-struct tty_struct *tp;	/* not yet used */
+struct tty_struct *tp;	/* selects the console */
 register char c;		/* character to be output */
 {
-  register struct vduinfo *v = &vduinfo;
+  register struct vduinfo *v;
+
+  v = vdu = &vduinfo[tp - tty_struct];
 
   if (c == 0x7F)
 	return;
@@ -166,7 +199,7 @@ register char c;		/* character to be output */
 	/*
 	 * normal character
 	 */
-	paint(c);
+	putchr(c);
 	moveto(v->crow, v->ccol + 1);
 	return;
   }
@@ -206,9 +239,9 @@ register char c;		/* character to be output */
  */
 PRIVATE vductrl(c)
 {
-  register struct vduinfo *v = &vduinfo;
+  register struct vduinfo *v = vdu;
   register i;
-  register struct tty_struct *tp = &tty_struct[CONSOLE];
+  register struct tty_struct *tp = v->tp;
   
   switch (c) {
   case 007: /* BEL */
@@ -228,15 +261,14 @@ PRIVATE vductrl(c)
 		out_char(tp, '\r');
   case 013: /* VT */
   case 014: /* FF */
-        while ( !(*PRAA & (1<<FIR0)));
+        if (!(*PRAA & (1<<FIR0))) {
                                 /* Left mouse button disables scrolling */
-        if (v->crow == NROW - 1) {
-               /*for (i = 0; i < NROW-1; i++)
-                        cpyline(i + 1, i);*/
-                long_copy((long *)(VRAM+BYTR), (long *)VRAM,
-                 (u_long)((NROW-1)*BYTR/4));
-                clrline(NROW-1);
-        } else
+                render(v);      /* show what is held up */
+                while ( !(*PRAA & (1<<FIR0)));
+        }
+        if (v->crow == NROW - 1)
+                scrollup();
+        else
                 moveto(v->crow + 1, v->ccol);
         return;
   case 015: /* CR */
@@ -260,7 +292,7 @@ PRIVATE vductrl(c)
  */
 PRIVATE vduansi(c)
 {
-  register struct vduinfo *v = &vduinfo;
+  register struct vduinfo *v = vdu;
   register i;
   register j;
 
@@ -404,7 +436,7 @@ PRIVATE vduansi(c)
 	 *	0: 25 lines if mono
 	 *	1: 50 lines if mono
 	 *   if a present:
-	 *	low 4 bits are attribute byte value (see paint())
+	 *	low 4 bits are attribute byte value (see render())
 	 *   if m present:
 	 *	interpret r;g;b as colors for map register m
 	 *	only assign color if r, g or b present
@@ -440,7 +472,7 @@ PRIVATE vduansi(c)
  */
 PRIVATE vduesc(c)
 {
-  register struct vduinfo *v = &vduinfo;
+  register struct vduinfo *v = vdu;
   register i;
 
   if (v->next >= &v->vbuf[sizeof(v->vbuf)-1])
@@ -471,15 +503,13 @@ PRIVATE vduesc(c)
 	vductrl(012);
 	return;
   case 'M': /* RI: reverse index */
-	if (v->crow == 0) {
-		for (i = NROW - 1; i > 0; i--)
-			cpyline(i - 1, i);
-		clrline(i);
-	} else
+	if (v->crow == 0)
+		scrolldown();
+	else
 		moveto(v->crow - 1, v->ccol);
 	return;
   case 'c': /* RIS: reset to initial state */
-	vduinit();
+	vdureset(v);
 	/* keypad = FALSE; */
 	/* app_mode = FALSE; */
 	return;
@@ -493,7 +523,7 @@ PRIVATE vduesc(c)
  */
 PRIVATE vduparam()
 {
-  register struct vduinfo *v = &vduinfo;
+  register struct vduinfo *v = vdu;
   register c;
   register i;
 
@@ -516,6 +546,54 @@ PRIVATE vduparam()
 /*===========================================================================*
  *                              manipulate videoram                          *
  *===========================================================================*/
+/*
+ * scroll the screen up one line by moving the screen origin down
+ */
+PRIVATE scrollup()
+{
+  register struct vduinfo *v = vdu;
+  register struct vline *lp;
+  register int i;
+
+  lp = v->line[0];
+  for (i = 0; i < NROW-1; i++)
+	v->line[i] = v->line[i+1];
+  v->line[NROW-1] = lp;
+  if (v->org + (NROW+1)*BYTR > VIDEOBUF) {
+	/* off the end of video ram: move the screen back to the start */
+	long_copy((long *)(VRAM+BYTR), (long *)v->vram,
+	 (u_long)((NROW-1)*BYTR/4));
+	v->org = 0;
+  } else
+	v->org += BYTR;
+  showscreen(v);
+  clrline(NROW-1);
+}
+
+/*
+ * scroll the screen down one line by moving the screen origin up
+ */
+PRIVATE scrolldown()
+{
+  register struct vduinfo *v = vdu;
+  register struct vline *lp;
+  register int i;
+
+  lp = v->line[NROW-1];
+  for (i = NROW-1; i > 0; i--)
+	v->line[i] = v->line[i-1];
+  v->line[0] = lp;
+  if (v->org < BYTR) {
+	/* off the start of video ram: move the screen to the end */
+	long_copy((long *)VRAM, (long *)(v->vram + VIDEOBUF - (NROW-1)*BYTR),
+	 (u_long)((NROW-1)*BYTR/4));
+	v->org = VIDEOBUF - NROW*BYTR;
+  } else
+	v->org -= BYTR;
+  showscreen(v);
+  clrline(0);
+}
+
 /*
  * copy line r1 to r2
  */
@@ -526,6 +604,7 @@ int r1, r2;
   register u_long *dst;
   register u_long i;
 
+  *vdu->line[r2] = *vdu->line[r1];    /* unpainted changes go along */
   src = (u_long*)(VRAM+r1 * BYTR);
   dst = (u_long*)(VRAM+r2 * BYTR);
   i = BYTR >> 2; 
@@ -537,21 +616,11 @@ int r1, r2;
  */
 PRIVATE cpychar(r1, c1, r2, c2)
 {
-  register char *src;           /* ptr into video memory */
-  register char *dst;           /* ptr into video memory */
-  register nl;                  /* scan lines per char */
-  register bl;                  /* bytes per scan line */
-
-  bl = BYT_LIN;
-  src = (char *)(VRAM+r1 * BYTR + c1);
-  dst = (char *)(VRAM+r2 * BYTR + c2);
-  nl = FONTH;
+  register struct vline *lp = vdu->line[r2];
 
-  do {
-        *dst = *src;
-        src += bl;
-        dst += bl;
-  } while (--nl != 0);
+  lp->ch[c2] = vdu->line[r1]->ch[c1];
+  lp->at[c2] = vdu->line[r1]->at[c1];
+  mark(vdu, lp, c2);
 }
 
 /*
@@ -577,34 +646,36 @@ PRIVATE clrarea(r1, c1, r2, c2)
 }
 
 /*
- * clear line r
+ * clear line r, in video ram as well
  */
 PRIVATE clrline(r)
 {
-  register long *src;
-  register long i;
+  register struct vline *lp = vdu->line[r];
+  register char *cp, *ap;
+  register i;
 
-  src = (long *)(VRAM + r*BYTR);
-  i = BYTR >> 2; 
-  long_clear(src, i);
- }
+  cp = lp->ch;
+  ap = lp->at;
+  i = NCOL;
+  do {
+        *cp++ = ' ';
+        *ap++ = 0;
+  } while (--i != 0);
+  lp->dfirst = NCOL;            /* nothing left to paint */
+  lp->dlast = -1;
+  long_clear((long *)(VRAM + r*BYTR), (long) (BYTR >> 2));
+}
 
 /*
  * clear char (r,c)
  */
 PRIVATE clrchar(r, c)
 {
-  register char *p;             /* ptr into video memory */
-  register nl;                  /* scan lines per char */
-  register bl;                  /* bytes per scan line */
+  register struct vline *lp = vdu->line[r];
 
-  bl = BYT_LIN;
-  p = (char *)(VRAM+r * BYTR + c);
-  nl = FONTH;
-  do {
-        *p = 0;
-        p += bl;
-  } while (--nl != 0);
+  lp->ch[c] = ' ';
+  lp->at[c] = 0;
+  mark(vdu, lp, c);
 }
 
 /*===========================================================================*
@@ -612,30 +683,24 @@ PRIVATE clrchar(r, c)
  *===========================================================================*/
 PRIVATE moveto(r, c)
 {
-  register struct vduinfo *v = &vduinfo;
+  register struct vduinfo *v = vdu;
 
   if (clipright) { /* the original ST routine, kept for compatibility */
 	if (r < 0 || r >= NROW || c < 0 || c > NCOL)
         	return;
   	v->crow = r;
-  	v->ccol = c;
-  	if (c == NCOL)
-        	c--;                    /* show cursor in last column */
-  	v->curs = (ptr_t) (VRAM + r * BYTR+ c);
+  	v->ccol = c;                    /* putchr() clips NCOL */
   } else { /* doesn't clip, continues on next line */
 	if (r < 0 || c < 0)
 		return;  		
 	while (c >= NCOL)
 		r++, c -= NCOL;
 	while (r >= NROW) {
-  		long_copy((long *)(VRAM+BYTR), (long *)VRAM, 
-		 (u_long)((NROW-1)*BYTR/4));
-                clrline(NROW-1);
+		scrollup();
 		r--;
 	}
 	v->crow = r;
 	v->ccol = c;
-	v->curs = (ptr_t)(VRAM + r * BYTR + c);
   }
 }
 
@@ -674,52 +739,102 @@ PUBLIC beepinit() {
 
 
 /*===========================================================================*
- *                              paint                                        *
+ *                              putchr                                       *
+ *===========================================================================*/
+/*
+ * put a character in the grid at the cursor position
+ */
+PRIVATE putchr(c)
+int c;
+{
+  register struct vduinfo *v = vdu;
+  register struct vline *lp;
+  register int col;
+
+  col = v->ccol;
+  if (col == NCOL)
+        col--;                  /* clipped: overwrite the last column */
+  lp = v->line[v->crow];
+  lp->ch[col] = c;
+  lp->at[col] = v->attr;
+  mark(v, lp, col);
+}
+
+/*===========================================================================*
+ *                              render                                       *
  * attributes:                                                               *
  *   0000xxx1: invert plane 0                                                *
  *===========================================================================*/
 /*
- * copy from font memory into video memory
+ * copy the changed runs of each line from font memory into video memory,
+ * a scan line at a time
  */
-PRIVATE paint(c)
-int c;
+PRIVATE render(v)
+register struct vduinfo *v;
 {
   register char *vp;            /* ptr into video memory */
-  register char *fp;            /* ptr into font */
-  register int fonth;           /* bytes per char */
-  register int dscreen;         /* bytes to skip in screendata */
-  register int dfont;           /* bytes to skip in fontdata */
-
-  fp = (char *) ((u_long) fontbase + c - 32); /* data starts with ascii code 32 */
-  dscreen = BYT_LIN;
-  dfont = 0xc0;
-  fonth = FONTH;
-  vp = (char *)(vduinfo.curs);
-  if (vduinfo.attr & 1) /* reverse-video */
-      do {
-          *vp = ~(*fp);
-          vp += dscreen;
-          fp += dfont;
-      } while (--fonth);
-  else                  /* normal */
-      do {
-          *vp = *fp;
-          vp += dscreen;
-          fp += dfont;
-      } while (--fonth);
+  register char *fp;            /* ptr into font scan line */
+  register unsigned char *cp;   /* ptr into the characters */
+  register char *ap;            /* ptr into the attributes */
+  register int n;
+  struct vline *lp;
+  int r, y, first, len;
+
+  if (!v->dirty)
+      return;
+  v->dirty = FALSE;
+  for (r = 0; r < NROW; r++) {
+      lp = v->line[r];
+      if (lp->dfirst > lp->dlast)
+          continue;
+      first = lp->dfirst;
+      len = lp->dlast - first + 1;
+      for (y = 0; y < FONTH; y++) {
+          /* data starts with ascii code 32 */
+          fp = (char *) ((u_long) fontbase + y*FONTW - 32);
+          vp = (char *) (v->vram + v->org + r*BYTR + y*BYT_LIN + first);
+          cp = (unsigned char *) &lp->ch[first];
+          ap = &lp->at[first];
+          n = len;
+          do {
+              if (*ap++ & 1)    /* reverse-video */
+                  *vp++ = ~fp[*cp++];
+              else              /* normal */
+                  *vp++ = fp[*cp++];
+          } while (--n != 0);
+      }
+      lp->dfirst = NCOL;
+      lp->dlast = -1;
+  }
+}
+
+/*===========================================================================*
+ *                              showscreen                                   *
+ *===========================================================================*/
+/* points the copper at the screen of console v, if it is the one shown */
+PRIVATE showscreen(v)
+register struct vduinfo *v;
+{
+  register u_long vram = v->vram + v->org;
+
+  if (v != &vduinfo[cur_cons])
+      return;
+  copscreen[0] = vram/0x10000;        /* the copper loads these into the */
+  copscreen[2] = vram%0x10000;        /* screen pointer at next vblank   */
 }
 
 /*===========================================================================*
  *                              vducursor                                    *
  *===========================================================================*/
-/* updates cursor sprite position to vduinfo->ccol, vduinfo->crow */
+/* updates cursor sprite position to ccol, crow of the console shown */
 PUBLIC void vducursor() {
     register u_long spr0all;      /* will be spr0pos and spr0ctl together*/
     register u_long vstart, vstop, hstart;
+    register struct vduinfo *v = &vduinfo[cur_cons];
 
     spr0all = 0;
-    hstart = ((vduinfo.ccol)<<2)+0x7a;
-    vstart = ((vduinfo.crow)<<3)+0x28;
+    hstart = ((v->ccol)<<2)+0x7a;
+    vstart = ((v->crow)<<3)+0x28;
     vstop = vstart+SPRITESZ;
     spr0all |= (vstart&0xff)<<24;
     spr0all |= (hstart&0x1fe)<<15;
@@ -736,14 +851,16 @@ PUBLIC void vducursor() {
 
 PUBLIC void vduinit()
 {
-  register struct vduinfo       *v = &vduinfo;
+  register struct vduinfo       *v;
+  register int i;
   struct transferdata *transdat;
   u_short *sys_alloc();
 
-  if (VRAM == 0) {
+  if (vduinfo[0].vram == 0) {
       transdat = *(struct transferdata **)0x0000; /* where the loader left it */
       fontbase = (ptr_t) transdat->args['f'-'a'];
-      VRAM = (u_long)sys_alloc(VIDEORAM);
+      for (v = &vduinfo[0]; v < &vduinfo[NR_CONS]; v++)
+          v->vram = (u_long)sys_alloc(VIDEOBUF);
       debuglvl = transdat->args['d'-'a'];
       initvducursor(transdat);    /* create sprite                   */
   }
@@ -756,19 +873,43 @@ PUBLIC void vduinit()
   *DIWSTRT=DIWSTRTH;
   *DIWSTOP=DIWSTOPH;
   initcopper();               /* create copperlist                   */
-  tty_struct[CONSOLE].tty_devstart=console;
-  moveto(0, 0);               /* move cursor to upper left corner */
   clipright = 1;
-  clrarea(0, 0, NROW-1, NCOL-1);
-  v->attr = 0;                /* clear the attribute byte */
-  v->next = 0;
-  vducursor();                /* init the cursor */
+  for (v = &vduinfo[0]; v < &vduinfo[NR_CONS]; v++) {
+      v->tp = &tty_struct[v - vduinfo];
+      for (i = 0; i < NROW; i++)
+          v->line[i] = &v->lines[i];
+      v->org = 0;
+      v->dirty = FALSE;
+      v->tp->tty_devstart=console;
+      vdureset(v);
+  }
+  vduswitch(CONSOLE);         /* show the first console, init the cursor */
   beepinit();                 /* init the sound stuff */
   *DMACON=WSET|BPLEN;         /* enable bitplane dma */
   *DMACON=WSET|COPEN;         /* enable copper dma */
   *DMACON=WSET|SPREN;         /* enable sprite dma */
 }
 
+/* vdureset - clears a console and puts its cursor in the upper left corner */
+PRIVATE vdureset(v)
+register struct vduinfo *v;
+{
+  vdu = v;
+  moveto(0, 0);               /* move cursor to upper left corner */
+  clrarea(0, 0, NROW-1, NCOL-1);
+  v->attr = 0;                /* clear the attribute byte */
+  v->next = 0;
+}
+
+/* vduswitch - shows console n; the keyboard goes to it as well        */
+PUBLIC void vduswitch(n)
+int n;
+{
+  cur_cons = n;
+  showscreen(&vduinfo[n]);
+  vducursor();
+}
+
 /* initvducursor - puts the data for the sprites in the right places    */
 initvducursor(transdat)
 struct transferdata *transdat; {
@@ -813,6 +954,7 @@ initcopper() {
     *(p++)=0x013a; *(p++)=(u_long)nospritemem%0x10000;
     *(p++)=0x013c; *(p++)=(u_long)nospritemem/0x10000;
     *(p++)=0x013e; *(p++)=(u_long)nospritemem%0x10000; /* 13c,13e are sprite 7 */
+    copscreen=p+1;              /* filled in by vduswitch()            */
     *(p++)=0x00e0; *(p++)=(u_long)VRAM/0x10000; /* these reset the screen pointer */
     *(p++)=0x00e2; *(p++)=(u_long)VRAM%0x10000;
     *(p++)=0xffff; *(p++)=0xfffe; /* this says: wait till forever (next vblank) */
@@ -829,7 +971,7 @@ u_short col;
   if (col)
 	*COLOR00 = col;
   out_char( &tty_struct[CONSOLE], ch);
-  vducursor();
+  flush(&tty_struct[CONSOLE]);
 }
 
 #endif /* (MACHINE == AMIGA) */
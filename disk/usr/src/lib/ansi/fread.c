@@ -1,6 +1,15 @@
 #include <lib.h>
+#include <string.h>
+#include <unistd.h>
 #include <stdio.h>
 
+/* Reads are done a buffer at a time, not a character at a time.  What is
+ * left in the stream's buffer is copied out first; whole buffers' worth
+ * go straight from the file to the caller; the tail goes through the buffer
+ * again so that it is refilled in the usual way.
+ */
+#define BIGREAD	(31 * BUFSIZ)	/* largest direct read; must fit an int */
+
 size_t fread(ptrfix, size, count, file)
 void *ptrfix;
 size_t size, count;
@@ -9,9 +18,14 @@ FILE *file;
   register int c;
   size_t ndone = 0, s;
   char *ptr = (char *) ptrfix;
+  long left, want;
+  int n;
+
+  if (size == 0 || count == 0) return(0);
 
-  ndone = 0;
-  if (size) while (ndone < count) {
+  if ((file->_flags & _RWMASK) != READMODE) {
+	/* Unbuffered or odd stream; leave it all to getc. */
+	while (ndone < count) {
 		s = size;
 		do {
 			if ((c = getc(file)) != EOF)
@@ -21,5 +35,30 @@ FILE *file;
 		} while (--s);
 		ndone++;
 	}
-  return(ndone);
+	return(ndone);
+  }
+
+  want = left = (long) size * count;
+  while (left > 0) {
+	if (file->_count > 0) {
+		n = left < file->_count ? (int) left : file->_count;
+		memcpy(ptr, file->_ptr, (size_t) n);
+		file->_ptr += n;
+		file->_count -= n;
+	} else if (left >= BUFSIZ) {
+		n = read(file->_fd, ptr, (unsigned) (left < BIGREAD ?
+				left - left % BUFSIZ : BIGREAD));
+		if (n <= 0) {
+			file->_flags |= (n == 0 ? _EOF : _ERR);
+			break;
+		}
+	} else {
+		if ((c = fgetc(file)) == EOF) break;	/* refills buffer */
+		*ptr = (char) c;
+		n = 1;
+	}
+	ptr += n;
+	left -= n;
+  }
+  return((size_t) ((want - left) / size));
 }
@@ -1,6 +1,18 @@
 #include <lib.h>
+#include <string.h>
+#include <unistd.h>
 #include <stdio.h>
 
+extern void (*__cleanup) ();
+extern void _cleanup();
+
+/* Writes are copied into the stream's buffer a piece at a time.  When the
+ * buffer fills it is flushed; data for whole buffers after that is written
+ * straight from the caller, so a large fwrite costs a few write calls and no
+ * copying.
+ */
+#define BIGWRITE (31 * BUFSIZ)	/* largest direct write; must fit an int */
+
 size_t fwrite(ptrfix, size, count, file)
 _CONST void *ptrfix;
 size_t size, count;
@@ -9,8 +21,14 @@ FILE *file;
   size_t s;
   size_t ndone = 0;
   _CONST char *ptr = (char *) ptrfix;
+  long left, want;
+  int n, w;
+
+  if (size == 0 || count == 0) return(0);
 
-  if (size) while (ndone < count) {
+  if ((file->_flags & (_RWMASK | STRINGS)) != WRITEMODE) {
+	/* Unbuffered, string or odd stream; leave it all to putc. */
+	while (ndone < count) {
 		s = size;
 		do {
 			putc(*ptr++, file);
@@ -19,5 +37,29 @@ FILE *file;
 		while (--s);
 		ndone++;
 	}
-  return(ndone);
+	return(ndone);
+  }
+
+  __cleanup = _cleanup;
+  want = left = (long) size * count;
+  while (left > 0) {
+	if (file->_count == 0 && left >= BUFSIZ) {
+		n = (int) (left < BIGWRITE ? left - left % BUFSIZ : BIGWRITE);
+		if ((w = write(file->_fd, ptr, (unsigned) n)) != n) {
+			file->_flags |= (w < 0 ? _ERR : _EOF);
+			if (w > 0) left -= w;
+			break;
+		}
+	} else {
+		n = BUFSIZ - file->_count;
+		if (left < n) n = (int) left;
+		memcpy(file->_ptr, ptr, (size_t) n);
+		file->_ptr += n;
+		file->_count += n;
+		if (file->_count >= BUFSIZ && fflush(file) == EOF) break;
+	}
+	ptr += n;
+	left -= n;
+  }
+  return((size_t) ((want - left) / size));
 }
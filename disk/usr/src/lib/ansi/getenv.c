@@ -7,17 +7,58 @@
 #include <stddef.h>
 #include <stdlib.h>
 
+/* Programs such as sh and make call getenv() over and over.  The first call
+ * makes a small hash index of the names in environ, and later calls find a
+ * name, or its absence, by probing the index instead of comparing it with
+ * every string.  The index is made again when environ is pointed at another
+ * array, which is what putenv() does to add a name, or when a string is put
+ * on or cleared off the end of the array.  Replacing a string by one with
+ * the same name, the other thing putenv() does, leaves the index right.  An
+ * environment too big for the index is searched string by string, as before.
+ */
+#define NHASH	128		/* slots in the index, a power of 2 */
+#define MAXENV	(NHASH / 2)	/* most strings indexed */
+
+#define envhash(c, h)	((h) = (h) * 31 + ((c) & 0377))
+
 extern char **environ;
 
+PRIVATE char **envsave;		/* the environ the index was made for */
+PRIVATE int envcount;		/* its strings then; 0 if there is no index */
+PRIVATE unsigned char envindex[NHASH];	/* 1 + position of a string, or 0 */
+
+PRIVATE _PROTOTYPE( void envmake, (void)				);
+
 char *getenv(name)
 _CONST char *name;
 {
   char **v;
   _CONST register char *n;
   register char *p;
+  register unsigned h;
+  int i;
 
   if (environ == (char **) NULL || name == (char *)NULL) return((char *)NULL);
 
+  if (environ != envsave || (envcount != 0 &&
+	(environ[envcount] != (char *)NULL || environ[envcount - 1] == (char *)NULL)))
+	envmake();
+
+  /* A name with '=' in it is left to the search below. */
+  h = 0;
+  for (n = name; *n != '\0' && *n != '='; n++) envhash(*n, h);
+  if (envcount != 0 && *n == '\0') {
+	for (h &= NHASH - 1; (i = envindex[h]) != 0; h = (h + 1) & (NHASH - 1)) {
+		n = name;
+		p = environ[i - 1];
+
+		while (*n == *p && *n != '\0') ++n, ++p;
+
+		if (*n == '\0' && *p == '=') return(p + 1);
+	}
+	return((char *)NULL);
+  }
+
   for (v = environ; *v != (char *)NULL; ++v) {
 	n = name;
 	p = *v;
@@ -29,3 +70,36 @@ _CONST char *name;
 
   return((char *)NULL);
 }
+
+PRIVATE void envmake()
+{
+/* Index the names in environ.  Of several strings with the same name, the
+ * first is the one getenv() finds, so only it goes in.
+ */
+
+  register char *n, *p;
+  register unsigned h;
+  int i, j;
+
+  envsave = environ;
+  for (envcount = 0; environ[envcount] != (char *)NULL; envcount++)
+	if (envcount == MAXENV) {
+		envcount = 0;
+		return;
+	}
+  for (h = 0; h < NHASH; h++) envindex[h] = 0;
+
+  for (i = 0; i < envcount; i++) {
+	h = 0;
+	for (n = environ[i]; *n != '\0' && *n != '='; n++) envhash(*n, h);
+	for (h &= NHASH - 1; (j = envindex[h]) != 0; h = (h + 1) & (NHASH - 1)) {
+		n = environ[i];
+		p = environ[j - 1];
+
+		while (*n == *p && *n != '\0' && *n != '=') ++n, ++p;
+
+		if (*n == *p) break;	/* the same name */
+	}
+	if (j == 0) envindex[h] = i + 1;
+  }
+}
@@ -2,10 +2,12 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <malloc.h>
 
 /* Replace undef by define */
-#define	 DEBUG			/* check assertions */
+#undef	 DEBUG			/* check assertions */
 #undef	 SLOWDEBUG		/* some extra test loops (requires DEBUG) */
+#undef	 TRACE			/* write every call on fd 2, for test23 -t */
 
 #ifdef DEBUG
 PRIVATE _PROTOTYPE( void assert_failed, (void));
@@ -23,11 +25,17 @@ PRIVATE _PROTOTYPE( void assert_failed, (void));
 #endif
 
 #define BRKSIZE		1024
+#define MAXGROW		4096	/* most the heap grows by beyond the need */
 #define	PTRSIZE		sizeof(char *)
 #define Align(x,a)	(((x) + (a - 1)) & ~(ptrint)(a - 1))
 #define NextSlot(p)	(* (char **) ((p) - PTRSIZE))
 #define NextFree(p)	(* (char **) (p))
 
+#define NBINS		16		/* number of small slot sizes */
+#define BINGRAIN	(2 * PTRSIZE)	/* step between them */
+#define SMALL		(NBINS * BINGRAIN)	/* largest small slot */
+#define Bin(len)	((len) / BINGRAIN - 1)	/* bin of a small slot */
+
 /* A short explanation of the data structure and algorithms.
  * An area returned by malloc() is called a slot. Each slot
  * contains the number of bytes requested, but preceeded by
@@ -39,24 +47,52 @@ PRIVATE _PROTOTYPE( void assert_failed, (void));
  * linked together by a pointer at the start of the
  * user visable part, so just after the next-slot pointer.
  * Free slots are merged together by free().
+ *
+ * Small slots, up to SMALL bytes including the next-slot pointer, come in
+ * NBINS sizes a BINGRAIN apart.  A small slot that is freed is not merged
+ * but pushed on '_bin' for its size, and malloc() pops it from there, so
+ * programs that allocate many small things get them in constant time.
+ * The bins are only given back to the free list when memory runs out.
+ * The heap grows by an eighth of its size at a time (at most MAXGROW more
+ * than needed), so that few brk() calls are made; the gap below the stack
+ * is small on MINIX, so it does not grow any faster than that.
  */
 
 extern char *sbrk(), *brk();
 PRIVATE char *_bottom, *_top, *_empty;
+PRIVATE char *_bin[NBINS];
 
 PRIVATE _PROTOTYPE( int grow, (unsigned len));
+PRIVATE _PROTOTYPE( void release, (char *p));
+PRIVATE _PROTOTYPE( int drain, (void));
+
+#ifdef TRACE
+PRIVATE _PROTOTYPE( void trace, (int c, char *p, unsigned n, char *q));
+PRIVATE int nested;		/* inside realloc: don't trace */
+#define TRACE1(c, p, n, q)	if (!nested) trace(c, p, n, q)
+#define NEST(i)			nested += (i)
+#else
+#define TRACE1(c, p, n, q)	/* empty */
+#define NEST(i)			/* empty */
+#endif
 
 PRIVATE int grow(len)
 unsigned len;
 {
   register char *p;
+  ptrint more;
 
   ASSERT(NextSlot(_top) == 0);
-  p = (char *) Align((ptrint) _top + len, BRKSIZE);
-  if (p < _top || brk(p) != 0) return(0);
+  more = (_top - _bottom) / 8;
+  if (more > MAXGROW) more = MAXGROW;
+  p = (char *) Align((ptrint) _top + len + more, BRKSIZE);
+  if (p < _top || brk(p) != 0) {
+	p = (char *) Align((ptrint) _top + len, BRKSIZE);
+	if (p < _top || brk(p) != 0) return(0);
+  }
   NextSlot(_top) = p;
   NextSlot(p) = 0;
-  free(_top);
+  release(_top);
   _top = p;
   return(1);
 }
@@ -68,9 +104,17 @@ unsigned size;
   register unsigned len, ntries;
 
   if (size == 0) size = PTRSIZE;/* avoid slots less that 2*PTRSIZE */
-  for (ntries = 0; ntries < 2; ntries++) {
-	if ((len = Align(size, PTRSIZE) + PTRSIZE) < 2 * PTRSIZE)
-		return(0);	/* overflow */
+  if ((len = Align(size, PTRSIZE) + PTRSIZE) < 2 * PTRSIZE)
+	return(0);	/* overflow */
+  if (len <= SMALL) {
+	len = Align(len, BINGRAIN);
+	if ((p = _bin[Bin(len)]) != 0) {
+		_bin[Bin(len)] = NextFree(p);
+		TRACE1('m', p, size, p);
+		return((void *)p);
+	}
+  }
+  for (ntries = 0; ntries < 3; ntries++) {
 	if (_bottom == 0) {
 		if ((p = sbrk(2 * PTRSIZE)) == (char *) -1) return(0);
 		p = (char *) Align((ptrint) p, PTRSIZE);
@@ -101,11 +145,11 @@ unsigned size;
 			NextFree(prev) = NextFree(p);
 		else
 			_empty = NextFree(p);
+		TRACE1('m', p, size, p);
 		return((void *)p);
 	}
-	if (grow(len) == 0) break;
+	if (grow(len) == 0 && drain() == 0) break;
   }
-  ASSERT(ntries != 2);
   return((void *)NULL);
 }
 
@@ -117,7 +161,10 @@ unsigned size;
   register unsigned len, n;
   char *old = (char *) oldfix;
 
+  if (old == 0) return(malloc(size));
   if (size > -2 * PTRSIZE) return(0);
+  if (size == 0) size = PTRSIZE;	/* no slots less than 2*PTRSIZE */
+  NEST(1);
   len = Align(size, PTRSIZE) + PTRSIZE;
   next = NextSlot(old);
   n = (int) (next - old);	/* old length */
@@ -144,34 +191,57 @@ unsigned size;
 		NextSlot(old) = new;
 		free(new);
 	}
+	NEST(-1);
+	TRACE1('r', old, size, old);
 	return((void *)old);
   }
-  if ((new = (char *)malloc(size)) == (char *)NULL)/* it didn't fit */
-	return((void *)NULL);
-  memcpy(new, old, (size_t)n);		/* n < size */
-  free(old);
+  new = (char *)malloc(size);
+  if (new != (char *)NULL) {		/* it didn't fit */
+	memcpy(new, old, (size_t)n);	/* n < size */
+	free(old);
+  }
+  NEST(-1);
+  if (new == (char *)NULL) return((void *)NULL);
+  TRACE1('r', old, size, new);
   return((void *)new);
 }
 
 void *calloc(n, size)
 unsigned n, size;
 {
-  register char *p, *cp;
+  register char *cp;
 
   n *= size;
   cp = (char *)malloc(n);
   if (cp == (char *) 0) return((void *) 0);
-  for (p = cp; n-- != 0;) *p++ = '\0';
+  memset(cp, 0, (size_t) n);
   return((void *)cp);
 }
 
 void free(pfix)
 void *pfix;
 {
-  register char *prev, *next;
-  char *p = (char *) pfix;
+  register char *p = (char *) pfix;
+  register unsigned len;
 
+  if (p == 0) return;
   ASSERT(NextSlot(p) > p);
+  TRACE1('f', p, 0, p);
+  if ((len = (unsigned) (NextSlot(p) - p)) <= SMALL) {
+	NextFree(p) = _bin[Bin(len)];
+	_bin[Bin(len)] = p;
+	return;
+  }
+  release(p);
+}
+
+PRIVATE void release(p)
+register char *p;
+{
+/* Put a slot on the free list, merging it with its free neighbours. */
+
+  register char *prev, *next;
+
   for (prev = 0, next = _empty; next != 0; prev = next, next = NextFree(next))
 	if (p < next) break;
   NextFree(p) = next;
@@ -195,6 +265,51 @@ void *pfix;
   }
 }
 
+PRIVATE int drain()
+{
+/* Out of memory: give the small slots back so they can be merged.  Returns
+ * 0 if there were none.
+ */
+
+  register char *p;
+  register int i, any;
+
+  any = 0;
+  for (i = 0; i < NBINS; i++) {
+	while ((p = _bin[i]) != 0) {
+		_bin[i] = NextFree(p);
+		release(p);
+		any = 1;
+	}
+  }
+  return(any);
+}
+
+struct mallinfo mallinfo()
+{
+/* Report on the heap.  Walks the free list and the bins. */
+
+  struct mallinfo mi;
+  register char *p;
+  register int i;
+
+  memset((char *) &mi, 0, sizeof(mi));
+  if (_bottom == 0) return(mi);
+  mi.arena = (long) (_top - _bottom);
+  for (p = _empty; p != 0; p = NextFree(p)) {
+	mi.ordblks++;
+	mi.fordblks += (long) (NextSlot(p) - p);
+  }
+  for (i = 0; i < NBINS; i++) {
+	for (p = _bin[i]; p != 0; p = NextFree(p)) {
+		mi.smblks++;
+		mi.fsmblks += (long) (NextSlot(p) - p);
+	}
+  }
+  mi.uordblks = mi.arena - mi.fordblks - mi.fsmblks;
+  return(mi);
+}
+
 #ifdef DEBUG
 PRIVATE void assert_failed()
 {
@@ -203,3 +318,36 @@ PRIVATE void assert_failed()
 }
 
 #endif
+
+#ifdef TRACE
+PRIVATE void trace(c, p, n, q)
+int c;
+char *p, *q;
+unsigned n;
+{
+/* Write "m size addr", "f addr" or "r addr size newaddr". */
+
+  char line[40];
+  register char *s;
+  register int i;
+  unsigned long a;
+
+  s = line;
+  *s++ = c;
+  if (c != 'm') {
+	*s++ = ' ';
+	for (a = (unsigned long) p, i = 28; i >= 0; i -= 4)
+		*s++ = "0123456789abcdef"[(a >> i) & 0xF];
+  }
+  if (c != 'f') {
+	*s++ = ' ';
+	for (i = 10000; i > 1 && n / i == 0; i /= 10) continue;
+	for (; i > 0; i /= 10) *s++ = '0' + (n / i) % 10;
+	*s++ = ' ';
+	for (a = (unsigned long) q, i = 28; i >= 0; i -= 4)
+		*s++ = "0123456789abcdef"[(a >> i) & 0xF];
+  }
+  *s++ = '\n';
+  write(2, line, (unsigned) (s - line));
+}
+#endif
@@ -3,6 +3,9 @@
  *
  * CHARBITS should be defined only if the compiler lacks "unsigned char".
  * It should be a mask, e.g. 0377 for an 8-bit machine.
+ *
+ * The aligned middle is searched a long at a time: a long holds the byte
+ * iff the long xor'ed with the byte in every position has a zero byte.
  */
 
 #include <string.h>
@@ -23,10 +26,26 @@ size_t size;
   register _CONST char *scan;
   register size_t n;
   register int uc;
+  register _CONST unsigned long *lscan;
+  register unsigned long pattern, x;
+  register int k;
 
   scan = (char *) s;
   uc = UNSCHAR(ucharwanted);
-  for (n = size; n > 0; n--) {
+  n = size;
+  if (n >= 2 * sizeof(long)) {
+	for (; (long) scan & _LMASK; n--, scan++)
+		if (UNSCHAR(*scan) == uc) return((void *) scan);
+	pattern = uc;
+	for (k = 8; k < 8 * sizeof(long); k <<= 1) pattern |= pattern << k;
+	lscan = (unsigned long *) scan;
+	for (; n >= sizeof(long); n -= sizeof(long), lscan++) {
+		x = *lscan ^ pattern;
+		if (_HASZERO(x)) break;
+	}
+	scan = (char *) lscan;
+  }
+  for (; n > 0; n--) {
 	if (UNSCHAR(*scan) == uc)
 		return( (void *) scan);
 	else
@@ -1,5 +1,9 @@
 #include <lib.h>
-/* memcmp - compare bytes */
+/* memcmp - compare bytes
+ *
+ * Equal stretches are skipped a long at a time when the two areas can be
+ * aligned together; the bytes of the first long that differs decide.
+ */
 
 #include <string.h>
 
@@ -11,10 +15,24 @@ size_t size;
   register _CONST char *scan1;
   register _CONST char *scan2;
   register size_t n;
+  register _CONST long *l1, *l2;
 
   scan1 = (char *) s1;
   scan2 = (char *) s2;
-  for (n = size; n > 0; n--)
+  n = size;
+  if (n >= 2 * sizeof(long) && (((long) scan1 ^ (long) scan2) & _LMASK) == 0) {
+	for (; (long) scan1 & _LMASK; n--, scan1++, scan2++)
+		if (*scan1 != *scan2) return(*scan1 - *scan2);
+	l1 = (long *) scan1;
+	l2 = (long *) scan2;
+	for (; n >= sizeof(long) && *l1 == *l2; n -= sizeof(long)) {
+		l1++;
+		l2++;
+	}
+	scan1 = (char *) l1;
+	scan2 = (char *) l2;
+  }
+  for (; n > 0; n--)
 	if (*scan1 == *scan2) {
 		scan1++;
 		scan2++;
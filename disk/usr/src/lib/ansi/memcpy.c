@@ -1,5 +1,11 @@
 #include <lib.h>
-/* memcpy - copy bytes */
+/* memcpy - copy bytes
+ *
+ * Copies a long at a time, four longs to a loop, when source and destination
+ * can be brought into alignment together; the ragged ends go a byte at a
+ * time.  Overlapping areas are copied in the safe direction, since memmove
+ * relies on it.
+ */
 
 #include <string.h>
 
@@ -11,18 +17,53 @@ size_t size;
   register char *d;
   register _CONST char *s;
   register size_t n;
+  register long *ld;
+  register _CONST long *ls;
+  register size_t k;
 
   if (size <= 0) return(dst);
 
   s = (char *) src;
   d = (char *) dst;
-  if (s <= d && s + (size - 1) >= d) {
+  n = size;
+  if (s < d && s + (size - 1) >= d) {
 	/* Overlap, must copy right-to-left. */
-	s += size - 1;
-	d += size - 1;
-	for (n = size; n > 0; n--) *d-- = *s--;
-  } else
-	for (n = size; n > 0; n--) *d++ = *s++;
+	s += n;
+	d += n;
+	if (n >= 4 * sizeof(long) && (((long) d ^ (long) s) & _LMASK) == 0) {
+		for (; (long) d & _LMASK; n--) *--d = *--s;
+		ld = (long *) d;
+		ls = (long *) s;
+		for (k = n / (4 * sizeof(long)); k > 0; k--) {
+			*--ld = *--ls;
+			*--ld = *--ls;
+			*--ld = *--ls;
+			*--ld = *--ls;
+		}
+		for (k = (n / sizeof(long)) & 3; k > 0; k--) *--ld = *--ls;
+		n &= sizeof(long) - 1;
+		d = (char *) ld;
+		s = (char *) ls;
+	}
+	for (; n > 0; n--) *--d = *--s;
+  } else {
+	if (n >= 4 * sizeof(long) && (((long) d ^ (long) s) & _LMASK) == 0) {
+		for (; (long) d & _LMASK; n--) *d++ = *s++;
+		ld = (long *) d;
+		ls = (long *) s;
+		for (k = n / (4 * sizeof(long)); k > 0; k--) {
+			*ld++ = *ls++;
+			*ld++ = *ls++;
+			*ld++ = *ls++;
+			*ld++ = *ls++;
+		}
+		for (k = (n / sizeof(long)) & 3; k > 0; k--) *ld++ = *ls++;
+		n &= sizeof(long) - 1;
+		d = (char *) ld;
+		s = (char *) ls;
+	}
+	for (; n > 0; n--) *d++ = *s++;
+  }
 
   return(dst);
 }
@@ -3,6 +3,8 @@
  *
  * CHARBITS should be defined only if the compiler lacks "unsigned char".
  * It should be a mask, e.g. 0377 for an 8-bit machine.
+ *
+ * The aligned middle is filled a long at a time, four to a loop.
  */
 
 #include <string.h>
@@ -21,10 +23,28 @@ size_t size;
   register char *scan;
   register size_t n;
   register int uc;
+  register unsigned long fill, *lscan;
+  register size_t k;
 
   scan = (char *) s;
   uc = UNSCHAR(ucharfill);
-  for (n = size; n > 0; n--) *scan++ = uc;
+  n = size;
+  if (n >= 4 * sizeof(long)) {
+	for (; (long) scan & _LMASK; n--) *scan++ = uc;
+	fill = uc;
+	for (k = 8; k < 8 * sizeof(long); k <<= 1) fill |= fill << k;
+	lscan = (unsigned long *) scan;
+	for (k = n / (4 * sizeof(long)); k > 0; k--) {
+		*lscan++ = fill;
+		*lscan++ = fill;
+		*lscan++ = fill;
+		*lscan++ = fill;
+	}
+	for (k = (n / sizeof(long)) & 3; k > 0; k--) *lscan++ = fill;
+	n &= sizeof(long) - 1;
+	scan = (char *) lscan;
+  }
+  for (; n > 0; n--) *scan++ = uc;
 
   return(s);
 }
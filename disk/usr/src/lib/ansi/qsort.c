@@ -1,122 +1,237 @@
 #include <lib.h>
-PRIVATE _PROTOTYPE( void qsort1, (char *a1, char *a2, int width)	);
+#include <stdlib.h>
+
+/* Introsort.  A partition is split three ways around the median of its
+ * first, middle and last elements, and the smaller part is sorted first so
+ * that the stack stays shallow.  Partitions of CUTOFF elements or less are
+ * left alone and put in order by one insertion sort over the whole array.
+ * A partition that is still being split after about 2 log2(nel) levels has
+ * met an input the pivots do badly on, and is heapsorted instead, so that no
+ * input takes quadratic time.
+ *
+ * Elements of the size of a short or a long (which is also the size of a
+ * pointer) are exchanged in one move, and larger ones a long at a time, when
+ * the base and the width allow it.
+ */
+
+#define CUTOFF		8	/* partitions this small are left for later */
+
+#define SWAPBYTES	0	/* how qexchange() moves an element */
+#define SWAPSHORT	1
+#define SWAPLONG	2
+#define SWAPLONGS	3
+
+#define exchange(p, q)	if (swaptype == SWAPLONG) { \
+				register long t = *(long *) (p); \
+				*(long *) (p) = *(long *) (q); \
+				*(long *) (q) = t; \
+			} else qexchange(p, q)
+
+PRIVATE _PROTOTYPE( void qsort1, (char *lo, char *hi, int depth)	);
+PRIVATE _PROTOTYPE( void qswapn, (char *p, char *q, long n)		);
+PRIVATE _PROTOTYPE( void qinsert, (char *lo, char *hi)			);
+PRIVATE _PROTOTYPE( void qheap, (char *lo, size_t n)			);
+PRIVATE _PROTOTYPE( void qsift, (char *lo, size_t root, size_t n)	);
 PRIVATE _PROTOTYPE( int (*qcompar), (const void *, const void *)	);
-PRIVATE _PROTOTYPE( void qexchange, (char *p, char *q, int n)		);
-PRIVATE _PROTOTYPE( void q3exchange, (char *p, char *q, char *r, int n)	);
+PRIVATE _PROTOTYPE( void qexchange, (char *p, char *q)			);
+
+PRIVATE size_t qwidth;
+PRIVATE int swaptype;
 
 void qsort(base, nel, width, compar)
 void *base;
 size_t nel, width;
 _PROTOTYPE( int (*compar), (const void *, const void *));
 {
+  register int depth;
+  register size_t n;
+
+  if (nel < 2 || width == 0) return;
   qcompar = compar;
-  if (nel > 0)
-  	qsort1((char *) base, (char *) base + (nel - 1) * width, width);
+  qwidth = width;
+  if ((long) base & _LMASK || width % sizeof(long) != 0)
+	swaptype = (width == sizeof(short) && ((long) base & 1) == 0) ?
+						SWAPSHORT : SWAPBYTES;
+  else
+	swaptype = width == sizeof(long) ? SWAPLONG : SWAPLONGS;
+  for (depth = 0, n = nel; n > 1; n >>= 1) depth += 2;
+  qsort1((char *) base, (char *) base + (long) (nel - 1) * width, depth);
+  qinsert((char *) base, (char *) base + (long) (nel - 1) * width);
 }
 
-PRIVATE void qsort1(a1, a2, width)
-char *a1, *a2;
-register int width;
+PRIVATE void qsort1(lo, hi, depth)
+register char *lo, *hi;
+int depth;
 {
-  register char *left, *right;
-  register char *lefteq, *righteq;
-  int cmp;
-
-  for (;;) {
-	if (a2 <= a1) return;
-	left = a1;
-	right = a2;
-	lefteq = righteq = a1 + width * (((a2 - a1) + width) / (2 * width));
-	/* Pick an element in the middle of the array. We will
-	 * collect the equals around it. "lefteq" and "righteq"
-	 * indicate the left and right bounds of the equals
-	 * respectively. Smaller elements end up left of it, larger
-	 * elements end up right of it. */
-again:
-	while (left < lefteq && (cmp = (*qcompar) (left, lefteq)) <= 0) {
-		if (cmp < 0) {
-			/* Leave it where it is */
-			left += width;
-		} else {
-			/* Equal, so exchange with the element to the
-			 * left of the "equal"-interval. */
-			lefteq -= width;
-			qexchange(left, lefteq, width);
-		}
+/* Split lo..hi (both inclusive) until the pieces are at most CUTOFF long.
+ * Elements equal to the pivot are collected at both ends while scanning
+ * and moved to the middle afterwards, where they stay; an array with few
+ * distinct values is then done in a few passes.
+ */
+
+  register char *b, *c;
+  char *a, *d, *m;
+  register size_t w = qwidth;
+  long n, s;
+  int r;
+
+  while ((n = (hi - lo) / w + 1) > CUTOFF) {
+	if (depth-- == 0) {
+		qheap(lo, (size_t) n);
+		return;
 	}
-	while (right > righteq) {
-		if ((cmp = (*qcompar) (right, righteq)) < 0) {
-			/* Smaller, should go to left part */
-			if (left < lefteq) {
-				/* Yes, we had a larger one at the
-				 * left, so we can just exchange */
-				qexchange(left, right, width);
-				left += width;
-				right -= width;
-				goto again;
-			}
 
-			/* No more room at the left part, so we move
-			 * the "equal-interval" one place to the
-			 * right, and the smaller element to the left
-			 * of it. This is best expressed as a
-			 * three-way exchange. */
-			righteq += width;
-			q3exchange(left, righteq, right, width);
-			lefteq += width;
-			left = lefteq;
-		} else if (cmp == 0) {
-			/* Equal, so exchange with the element to the
-			 * right of the "equal-interval" */
-			righteq += width;
-			qexchange(right, righteq, width);
-		} else		/* just leave it */
-			right -= width;
+	/* Put lo, the middle and hi in order, then swap the median to lo as
+	 * the pivot; the smallest goes to the middle and the largest stays
+	 * at hi.
+	 */
+	m = lo + (n >> 1) * w;
+	if ((*qcompar) (m, lo) < 0) { exchange(m, lo); }
+	if ((*qcompar) (hi, m) < 0) {
+		exchange(hi, m);
+		if ((*qcompar) (m, lo) < 0) { exchange(m, lo); }
 	}
-	if (left < lefteq) {
-		/* Larger element to the left, but no more room, so
-		 * move the "equal-interval" one place to the left,
-		 * and the larger element to the right of it. */
-		lefteq -= width;
-		q3exchange(right, lefteq, left, width);
-		righteq -= width;
-		right = righteq;
-		goto again;
+	exchange(lo, m);
+
+	/* Afterwards lo..a-w and d+w..hi are equal to the pivot, a..b-w are
+	 * smaller and c+w..d are larger.
+	 */
+	a = b = lo + w;
+	c = d = hi;
+	for (;;) {
+		while (b <= c && (r = (*qcompar) (b, lo)) <= 0) {
+			if (r == 0) {
+				exchange(a, b);
+				a += w;
+			}
+			b += w;
+		}
+		while (b <= c && (r = (*qcompar) (c, lo)) >= 0) {
+			if (r == 0) {
+				exchange(c, d);
+				d -= w;
+			}
+			c -= w;
+		}
+		if (b > c) break;
+		exchange(b, c);
+		b += w;
+		c -= w;
 	}
+	s = (a - lo < b - a) ? a - lo : b - a;
+	qswapn(lo, b - s, s);
+	s = (d - c < hi - d) ? d - c : hi - d;
+	qswapn(b, hi + w - s, s);
 
-	/* Now sort the "smaller" part */
-	qsort1(a1, lefteq - width, width);
-	/* And now the larger, saving a subroutine call because of
-	 * the for(;;) */
-	a1 = righteq + width;
+	/* Sort the smaller part, then loop on the larger one. */
+	s = b - a;			/* bytes smaller than the pivot */
+	n = d - c;			/* bytes larger */
+	if (s < n) {
+		if (s > w) qsort1(lo, lo + s - w, depth);
+		lo = hi + w - n;
+	} else {
+		if (n > w) qsort1(hi + w - n, hi, depth);
+		hi = lo + s - w;
+	}
   }
-
-  /* NOTREACHED */
 }
 
-PRIVATE void qexchange(p, q, n)
+PRIVATE void qswapn(p, q, n)
 register char *p, *q;
-register int n;
+long n;
 {
-  register int c;
+/* Exchange the n bytes of elements at p with those at q. */
 
-  while (n-- > 0) {
-	c = *p;
-	*p++ = *q;
-	*q++ = c;
+  for (; n > 0; n -= qwidth) {
+	exchange(p, q);
+	p += qwidth;
+	q += qwidth;
   }
 }
 
-PRIVATE void q3exchange(p, q, r, n)
-register char *p, *q, *r;
-register int n;
+PRIVATE void qinsert(lo, hi)
+char *lo, *hi;
 {
+/* Straight insertion.  No element is more than CUTOFF places from home. */
+
+  register char *p, *q;
+  register size_t w = qwidth;
+
+  for (p = lo + w; p <= hi; p += w)
+	for (q = p; q > lo && (*qcompar) (q - w, q) > 0; q -= w) {
+		exchange(q - w, q);
+	}
+}
+
+PRIVATE void qheap(lo, n)
+char *lo;
+size_t n;
+{
+/* Heapsort n elements from lo. */
+
+  register size_t i;
+
+  for (i = n / 2; i > 0; i--) qsift(lo, i - 1, n);
+  for (i = n - 1; i > 0; i--) {
+	exchange(lo, lo + (long) i * qwidth);
+	qsift(lo, (size_t) 0, i);
+  }
+}
+
+PRIVATE void qsift(lo, root, n)
+char *lo;
+register size_t root;
+size_t n;
+{
+/* Let the element at root sink to its place in the heap of n elements. */
+
+  register size_t child;
+  register char *p, *c;
+
+  p = lo + (long) root * qwidth;
+  while ((child = 2 * root + 1) < n) {
+	c = lo + (long) child * qwidth;
+	if (child + 1 < n && (*qcompar) (c, c + qwidth) < 0) {
+		child++;
+		c += qwidth;
+	}
+	if ((*qcompar) (p, c) >= 0) return;
+	exchange(p, c);
+	root = child;
+	p = c;
+  }
+}
+
+PRIVATE void qexchange(p, q)
+register char *p, *q;
+{
+  register size_t n;
   register int c;
+  register long t;
+
+  switch (swaptype) {
+    case SWAPSHORT:
+	c = *(short *) p;
+	*(short *) p = *(short *) q;
+	*(short *) q = c;
+	break;
 
-  while (n-- > 0) {
-	c = *p;
-	*p++ = *r;
-	*r++ = *q;
-	*q++ = c;
+    case SWAPLONGS:
+    case SWAPLONG:
+	for (n = qwidth / sizeof(long); n > 0; n--) {
+		t = *(long *) p;
+		*(long *) p = *(long *) q;
+		*(long *) q = t;
+		p += sizeof(long);
+		q += sizeof(long);
+	}
+	break;
+
+    default:
+	for (n = qwidth; n > 0; n--) {
+		c = *p;
+		*p++ = *q;
+		*q++ = c;
+	}
   }
 }
@@ -10,6 +10,7 @@ int args;
 
   _tempfile._fd = -1;
   _tempfile._flags = WRITEMODE + STRINGS;
+  _tempfile._count = 0;
   _tempfile._buf = buf;
   _tempfile._ptr = buf;
 
@@ -1,5 +1,9 @@
 #include <lib.h>
-/* strcmp - compare string s1 to s2 */
+/* strcmp - compare string s1 to s2
+ *
+ * When the strings can be aligned together, equal longs without a NUL in
+ * them are skipped at once.
+ */
 
 #include <string.h>
 
@@ -9,9 +13,26 @@ _CONST char *s2;
 {
   register _CONST char *scan1;
   register _CONST char *scan2;
+  register _CONST unsigned long *l1, *l2;
 
   scan1 = s1;
   scan2 = s2;
+  if ((((long) scan1 ^ (long) scan2) & _LMASK) == 0) {
+	while ((long) scan1 & _LMASK) {
+		if (*scan1 == '\0' || *scan1 != *scan2) goto bytes;
+		scan1++;
+		scan2++;
+	}
+	l1 = (unsigned long *) scan1;
+	l2 = (unsigned long *) scan2;
+	while (*l1 == *l2 && !_HASZERO(*l1)) {
+		l1++;
+		l2++;
+	}
+	scan1 = (char *) l1;
+	scan2 = (char *) l2;
+  }
+bytes:
   while (*scan1 != '\0' && *scan1 == *scan2) {
 	scan1++;
 	scan2++;
@@ -1,5 +1,9 @@
 #include <lib.h>
-/* strcpy - copy string src to dst  */
+/* strcpy - copy string src to dst
+ *
+ * When source and destination can be aligned together, whole longs without
+ * a NUL in them are copied at once.
+ */
 
 #include <string.h>
 
@@ -9,9 +13,20 @@ _CONST char *src;
 {
   register char *dscan;
   register _CONST char *sscan;
+  register unsigned long *ldst;
+  register _CONST unsigned long *lsrc;
 
   dscan = dst;
   sscan = src;
+  if ((((long) dscan ^ (long) sscan) & _LMASK) == 0) {
+	for (; (long) sscan & _LMASK; sscan++, dscan++)
+		if ((*dscan = *sscan) == '\0') return(dst);
+	ldst = (unsigned long *) dscan;
+	lsrc = (unsigned long *) sscan;
+	while (!_HASZERO(*lsrc)) *ldst++ = *lsrc++;
+	dscan = (char *) ldst;
+	sscan = (char *) lsrc;
+  }
   while ((*dscan++ = *sscan++) != '\0') continue;
   return(dst);
 }
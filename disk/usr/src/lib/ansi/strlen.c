@@ -1,5 +1,10 @@
 #include <lib.h>
-/* strlen - length of string (not including NUL) */
+/* strlen - length of string (not including NUL)
+ *
+ * Once aligned, the string is scanned a long at a time for a zero byte.
+ * The last long read may go up to three bytes past the NUL; that cannot
+ * fault, since MINIX has no memory protection within a process.
+ */
 
 #include <string.h>
 
@@ -7,10 +12,12 @@ size_t strlen(s)
 _CONST char *s;
 {
   register _CONST char *scan;
-  register size_t count;
+  register _CONST unsigned long *lscan;
 
-  count = 0;
-  scan = s;
-  while (*scan++ != '\0') count++;
-  return(count);
+  for (scan = s; (long) scan & _LMASK; scan++)
+	if (*scan == '\0') return(scan - s);
+  lscan = (unsigned long *) scan;
+  while (!_HASZERO(*lscan)) lscan++;
+  for (scan = (char *) lscan; *scan != '\0'; scan++) continue;
+  return(scan - s);
 }
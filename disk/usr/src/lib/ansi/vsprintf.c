@@ -11,10 +11,11 @@ va_list argp;
 
   _tempfile._fd = -1;
   _tempfile._flags = WRITEMODE + STRINGS;
+  _tempfile._count = 0;
   _tempfile._buf = buf;
   _tempfile._ptr = buf;
 
-  vfprintf(&_tempfile, format, argp);
+  _doprintf(&_tempfile, format, argp);
   putc('\0', &_tempfile);
 
   return(buf);
@@ -16,6 +16,7 @@
 /* #include <sys/ioctl.h>	- the ioctl calls seem to stop input */
 #include <sgtty.h>
 #include <stdlib.h>
+#include <string.h>
 #include <stdio.h>
 
 struct sgttyb old_tty, new_tty;
@@ -27,9 +28,11 @@ extern char *tgoto();		/* termcap goto (x, y) */
 #define COLS	80
 #define NORMAL	0x00
 #define BOLD	0x80
+#define BLANK	' '
+#define FAR	1000		/* cost of a motion that can't be made */
 
 char termcap[1024];		/* termcap buffer */
-char tc[100];			/* area to hold string capabilities */
+char tc[256];			/* area to hold string capabilities */
 char *ttytype;			/* terminal type from env */
 char *arp;			/* pointer for use in tgetstr */
 char *cp;			/* character pointer */
@@ -42,6 +45,43 @@ char *se;			/* end standout capability */
 char nscrn[ROWS][COLS], cscrn[ROWS][COLS], row, col, mode;
 char str[256];
 
+/* Refresh() only sends what changed.  Every line of nscrn and cscrn has a
+ * hash; a line of nscrn is hashed again only when it has been written to.
+ * When lines of the screen have moved up or down as a block, which happens
+ * whenever a program scrolls or inserts or deletes a line, the hashes find
+ * it and the terminal is made to move them with its scrolling region (cs,
+ * sf and sr) or its line insert and delete (al and dl).  What is left is
+ * sent line by line, skipping what is already there, clearing the end of a
+ * line with ce, and reaching each change by the cheapest of the cursor
+ * motions the terminal has.
+ */
+PRIVATE char *ce;		/* clear to end of line */
+PRIVATE char *al, *dl;		/* insert and delete a line */
+PRIVATE char *cs;		/* set the scrolling region */
+PRIVATE char *sf, *sr;		/* scroll forward and reverse */
+PRIVATE char *ho, *cr;		/* home, carriage return */
+PRIVATE char *up, *down;	/* one line up, one down */
+PRIVATE char *nd, *le;		/* one column right, one left */
+PRIVATE int lines;		/* lines on the terminal */
+PRIVATE int cmcost;		/* bytes in a typical cm */
+PRIVATE int cury, curx;		/* where the cursor is, cury < 0: unknown */
+PRIVATE int curmode;		/* mode the terminal is in */
+PRIVATE char touched[ROWS];	/* line of nscrn written to since hashed */
+PRIVATE unsigned nhash[ROWS], chash[ROWS];
+PRIVATE unsigned blankhash;	/* hash of an empty line */
+
+PRIVATE _PROTOTYPE( unsigned hash, (char *line)				);
+PRIVATE _PROTOTYPE( void setmode, (int m)				);
+PRIVATE _PROTOTYPE( void putcap, (char *s, int n)			);
+PRIVATE _PROTOTYPE( int len, (char *s)					);
+PRIVATE _PROTOTYPE( int across, (int y, int x0, int x)			);
+PRIVATE _PROTOTYPE( void go_across, (int y, int x0, int x)		);
+PRIVATE _PROTOTYPE( void gotoyx, (int y, int x)				);
+PRIVATE _PROTOTYPE( int scrollcost, (int n)				);
+PRIVATE _PROTOTYPE( void scroll, (int top, int bot, int n)		);
+PRIVATE _PROTOTYPE( void findscroll, (void)				);
+PRIVATE _PROTOTYPE( void putline, (int i)				);
+
 /*
  *	fatal - report error and die. Never returns
  */
@@ -75,6 +115,7 @@ void clrtoeol()
   int i;
 
   for (i = col; i < COLS; i++) nscrn[row][i] = ' ' | mode;
+  touched[row] = 1;
 }
 
 void printw(fmt, a1, a2, a3, a4, a5)
@@ -85,6 +126,7 @@ char *fmt, *a1, *a2, *a3, *a4, *a5;
   sprintf(str, fmt, a1, a2, a3, a4, a5);
   j = 0;
   k = row;
+  if (k < ROWS) touched[k] = 1;
   for (i = col; i < COLS && k < ROWS && str[j] != '\000'; i++)
 	if (str[j] != '\n')
 		nscrn[k][i] = str[j++] | mode;
@@ -92,6 +134,7 @@ char *fmt, *a1, *a2, *a3, *a4, *a5;
 		i = 0;
 		j++;
 		k++;
+		if (k < ROWS) touched[k] = 1;
 	}
   col = i;
   row = k;
@@ -102,8 +145,10 @@ void clrtobot()
   int i, j;
 
   clrtoeol();
-  for (i = row + 1; i < ROWS; i++) for (j = 0; j < COLS; j++)
-		nscrn[i][j] = ' ' | mode;
+  for (i = row + 1; i < ROWS; i++) {
+	for (j = 0; j < COLS; j++) nscrn[i][j] = ' ' | mode;
+	touched[i] = 1;
+  }
 }
 
 void standout()
@@ -141,13 +186,42 @@ void initscr()
   so = tgetstr("so", &arp);
   se = tgetstr("se", &arp);
   cm = tgetstr("cm", &arp);
+  ce = tgetstr("ce", &arp);
+  al = tgetstr("al", &arp);
+  dl = tgetstr("dl", &arp);
+  cs = tgetstr("cs", &arp);
+  sf = tgetstr("sf", &arp);
+  sr = tgetstr("sr", &arp);
+  ho = tgetstr("ho", &arp);
+  up = tgetstr("up", &arp);
+  down = tgetstr("do", &arp);
+  nd = tgetstr("nd", &arp);
+  le = tgetstr("le", &arp);
+  if (le == (char *)NULL) le = tgetstr("bc", &arp);
+  if (le == (char *)NULL && tgetflag("bs") == 1) le = "\b";
+  cr = tgetflag("nc") == 1 ? (char *)NULL : "\r";
+
+  /* A newline as "do" may come out as CR LF, so it is no use for moving
+   * straight down.  Insert and delete line are only used in pairs.
+   */
+  if (down != (char *)NULL && strcmp(down, "\n") == 0) down = (char *)NULL;
+  if (al == (char *)NULL || dl == (char *)NULL) al = dl = (char *)NULL;
+  if ((lines = tgetnum("li")) < ROWS) lines = ROWS;
+  cmcost = cm == (char *)NULL ? FAR : strlen(tgoto(cm, COLS / 2, ROWS / 2));
 
   row = 0;
   col = 0;
   mode = NORMAL;
   for (i = 0; i < ROWS; i++) for (j = 0; j < COLS; j++)
 		nscrn[i][j] = cscrn[i][j] = ' ';
+  blankhash = hash(cscrn[0]);
+  for (i = 0; i < ROWS; i++) {
+	nhash[i] = chash[i] = blankhash;
+	touched[i] = 0;
+  }
   tputs(cl, 1, outc);
+  cury = curx = 0;
+  curmode = NORMAL;
 }
 
 void clear()
@@ -166,39 +240,37 @@ void touchwin()
 {
   int i, j;
 
-  for (i = 0; i < ROWS; i++) for (j = 0; j < COLS; j++)
-		cscrn[i][j] = ' ';
+  for (i = 0; i < ROWS; i++) {
+	for (j = 0; j < COLS; j++) cscrn[i][j] = ' ';
+	chash[i] = blankhash;
+  }
   tputs(cl, 1, outc);
+  cury = curx = 0;
 }
 
 void refresh()
 {
-  int i, j, mode;
+  int i;
 
-  mode = NORMAL;
-  for (i = 0; i < ROWS; i++) {
-	for (j = 0; j < COLS; j++) {
-		if (nscrn[i][j] != cscrn[i][j]) {
-			cp = tgoto(cm, j + 1, i + 1);
-			tputs(cp, 1, outc);
-			while (nscrn[i][j] != cscrn[i][j]) {
-				if (mode == NORMAL && (nscrn[i][j] & BOLD) == BOLD) {
-					tputs(so, 1, outc);
-					mode = BOLD;
-				} else if (mode == BOLD && (nscrn[i][j] & BOLD) == NORMAL) {
-					tputs(se, 1, outc);
-					mode = NORMAL;
-				}
-				cscrn[i][j] = nscrn[i][j];
-				fputc(nscrn[i][j] & 0x7F, stdout);
-				j++;
-			}
-		}
+  for (i = 0; i < ROWS; i++)
+	if (touched[i]) {
+		nhash[i] = hash(nscrn[i]);
+		touched[i] = 0;
 	}
-  }
-  cp = tgoto(cm, col + 1, row + 1);
-  tputs(cp, 1, outc);
-  if (mode) tputs(se, 1, outc);
+
+  /* The program may have written to the terminal itself, or the tty may
+   * have echoed input, so start from a known place.
+   */
+  cury = -1;
+  curmode = NORMAL;
+
+  if (al != (char *)NULL || (cs != (char *)NULL && sf != (char *)NULL))
+	findscroll();
+  for (i = 0; i < ROWS; i++)
+	if (nhash[i] != chash[i] || memcmp(nscrn[i], cscrn[i], COLS) != 0)
+		putline(i);
+  gotoyx(row < ROWS ? row : ROWS - 1, col < COLS ? col : COLS - 1);
+  setmode(NORMAL);
   fflush(stdout);
 }
 
@@ -211,3 +283,310 @@ void endwin()
  */
 }
 
+
+/*
+ *	hash - a hash of one line of the screen.
+ */
+PRIVATE unsigned hash(line)
+register char *line;
+{
+  register unsigned h;
+  register char *end;
+
+  h = 0;
+  for (end = line + COLS; line < end; line++) h = (h << 3) + (h >> 13) + *line;
+  return(h);
+}
+
+
+PRIVATE void setmode(m)
+int m;
+{
+  if (m == curmode) return;
+  tputs(m == BOLD ? so : se, 1, outc);
+  curmode = m;
+}
+
+
+PRIVATE void putcap(s, n)
+char *s;
+int n;
+{
+  while (n-- > 0) tputs(s, 1, outc);
+}
+
+
+PRIVATE int len(s)
+char *s;
+{
+  return(s == (char *)NULL ? FAR : strlen(s));
+}
+
+
+/*
+ *	across - the cost of moving right or left on line y from column x0 to
+ *	column x.  Moving right may be done by sending again what is on the
+ *	screen, if it is all in the current mode.
+ */
+PRIVATE int across(y, x0, x)
+int y, x0, x;
+{
+  register int j, n;
+
+  if (x < x0) {
+	n = (x0 - x) * len(le);
+	return(n < FAR ? n : FAR);
+  }
+  for (j = x0; j < x; j++)
+	if ((cscrn[y][j] & BOLD) != curmode) break;
+  if (j == x) return(x - x0);
+  n = (x - x0) * len(nd);
+  return(n < FAR ? n : FAR);
+}
+
+
+PRIVATE void go_across(y, x0, x)
+int y, x0, x;
+{
+  register int j;
+
+  if (x < x0) {
+	putcap(le, x0 - x);
+	return;
+  }
+  for (j = x0; j < x; j++)
+	if ((cscrn[y][j] & BOLD) != curmode) break;
+  if (j == x)
+	for (j = x0; j < x; j++) putchar(cscrn[y][j] & 0x7F);
+  else
+	putcap(nd, x - x0);
+}
+
+
+/*
+ *	gotoyx - move the cursor to (y, x) the cheapest way: with cm, or from
+ *	where it is, or from the start of its line, or from home.
+ */
+PRIVATE void gotoyx(y, x)
+int y, x;
+{
+  int way, cost, c, v;
+
+  if (cury == y && curx == x) return;
+  way = 0;
+  cost = cmcost;
+  if (cury >= 0) {
+	v = y < cury ? (cury - y) * len(up) : (y - cury) * len(down);
+	if ((c = v + across(y, curx, x)) < cost) {
+		way = 1;
+		cost = c;
+	}
+	if ((c = len(cr) + v + across(y, 0, x)) < cost) {
+		way = 2;
+		cost = c;
+	}
+  }
+  if ((c = len(ho) + y * len(down) + across(y, 0, x)) < cost) {
+	way = 3;
+	cost = c;
+  }
+  if (cost >= FAR) way = 0;
+
+  switch (way) {
+    case 0:
+	tputs(tgoto(cm, x, y), 1, outc);
+	break;
+    case 1:
+    case 2:
+	if (way == 2) {
+		tputs(cr, 1, outc);
+		curx = 0;
+	}
+	if (y < cury) putcap(up, cury - y);
+	if (y > cury) putcap(down, y - cury);
+	go_across(y, curx, x);
+	break;
+    case 3:
+	tputs(ho, 1, outc);
+	putcap(down, y);
+	go_across(y, 0, x);
+	break;
+  }
+  cury = y;
+  curx = x;
+}
+
+
+/*
+ *	scrollcost - about what it costs to move a block of lines by n.
+ */
+PRIVATE int scrollcost(n)
+int n;
+{
+  if (cs != (char *)NULL && sf != (char *)NULL &&
+				(n > 0 || sr != (char *)NULL))
+	return(2 * (len(cs) + cmcost) + (n > 0 ? n * len(sf) : -n * len(sr)));
+  if (n < 0) n = -n;
+  if (al != (char *)NULL) return(2 * cmcost + n * (len(al) + len(dl)));
+  return(FAR);
+}
+
+
+/*
+ *	scroll - move lines top..bot of the screen up by n, or down by -n,
+ *	and blank the lines that are left.
+ */
+PRIVATE void scroll(top, bot, n)
+int top, bot, n;
+{
+  register int i;
+  int m;
+
+  m = n > 0 ? n : -n;
+  setmode(NORMAL);
+  if (cs != (char *)NULL && sf != (char *)NULL &&
+				(n > 0 || sr != (char *)NULL)) {
+	tputs(tgoto(cs, bot, top), 1, outc);
+	cury = -1;
+	if (n > 0) {
+		gotoyx(bot, 0);
+		putcap(sf, m);
+	} else {
+		gotoyx(top, 0);
+		putcap(sr, m);
+	}
+	tputs(tgoto(cs, lines - 1, 0), 1, outc);
+  } else if (n > 0) {
+	gotoyx(top, 0);
+	putcap(dl, m);
+	if (bot < lines - 1) {
+		gotoyx(bot - m + 1, 0);
+		putcap(al, m);
+	}
+  } else {
+	if (bot < lines - 1) {
+		gotoyx(bot - m + 1, 0);
+		putcap(dl, m);
+	}
+	gotoyx(top, 0);
+	putcap(al, m);
+  }
+  cury = -1;
+
+  /* Now do the same to cscrn. */
+  if (n > 0) {
+	for (i = top; i <= bot - m; i++) {
+		memcpy(cscrn[i], cscrn[i + m], COLS);
+		chash[i] = chash[i + m];
+	}
+	for (; i <= bot; i++) {
+		memset(cscrn[i], BLANK, COLS);
+		chash[i] = blankhash;
+	}
+  } else {
+	for (i = bot; i >= top + m; i--) {
+		memcpy(cscrn[i], cscrn[i - m], COLS);
+		chash[i] = chash[i - m];
+	}
+	for (; i >= top; i--) {
+		memset(cscrn[i], BLANK, COLS);
+		chash[i] = blankhash;
+	}
+  }
+}
+
+
+/*
+ *	findscroll - look for a block of lines of nscrn that are on the screen
+ *	but higher or lower, and move the biggest such block into place if it
+ *	saves sending them again.  Repeat while there is one.
+ */
+PRIVATE void findscroll()
+{
+  register int i, j;
+  int k, save, n, tries;
+  int best, btop, bn, bk;
+
+  for (tries = 0; tries < 4; tries++) {
+	best = 0;
+	for (k = 1 - ROWS; k < ROWS; k++) {
+		if (k == 0) continue;
+		/* Line i of nscrn is line i + k of cscrn for a run of i. */
+		for (i = (k < 0 ? -k : 0); i < ROWS && i + k < ROWS; i++) {
+			save = 0;
+			for (n = 0; i + n < ROWS && i + n + k < ROWS; n++) {
+				if (nhash[i + n] != chash[i + n + k]) break;
+				if (nhash[i + n] == chash[i + n]) break;
+				if (memcmp(nscrn[i + n], cscrn[i + n + k], COLS))
+					break;
+				for (j = 0; j < COLS; j++)
+					if (nscrn[i + n][j] != cscrn[i + n][j])
+						save++;
+			}
+			if (save > best) {
+				best = save;
+				btop = i;
+				bn = n;
+				bk = k;
+			}
+			if (n > 0) i += n - 1;
+		}
+	}
+	if (best <= scrollcost(bk)) return;
+	if (bk > 0)
+		scroll(btop, btop + bn - 1 + bk, bk);
+	else
+		scroll(btop + bk, btop + bn - 1, bk);
+  }
+}
+
+
+/*
+ *	putline - send the changes to line i.
+ */
+PRIVATE void putline(i)
+int i;
+{
+  register char *n, *c;
+  register int j;
+  int last, clr, nb, cnt;
+
+  n = nscrn[i];
+  c = cscrn[i];
+  for (last = COLS - 1; last >= 0 && n[last] == c[last]; last--);
+  if (last < 0) {
+	chash[i] = nhash[i];
+	return;
+  }
+
+  /* Blanks at the end of the new line may be cheaper to clear with ce. */
+  clr = COLS;
+  if (ce != (char *)NULL) {
+	for (nb = COLS; nb > 0 && n[nb - 1] == BLANK; nb--);
+	if (nb <= last) {
+		for (cnt = 0, j = nb; j <= last; j++)
+			if (c[j] != BLANK) cnt++;
+		if (cnt > len(ce)) clr = nb;
+	}
+  }
+
+  for (j = 0; j <= last && j < clr; j++) {
+	if (n[j] == c[j]) continue;
+	gotoyx(i, j);
+	while (j <= last && j < clr && n[j] != c[j]) {
+		setmode(n[j] & BOLD);
+		putchar(n[j] & 0x7F);
+		c[j] = n[j];
+		j++;
+	}
+	curx = j;
+	if (curx >= COLS) cury = -1;	/* wrapped, or not */
+  }
+  if (clr < COLS) {
+	gotoyx(i, clr);
+	setmode(NORMAL);
+	tputs(ce, 1, outc);
+	memset(c + clr, BLANK, COLS - clr);
+  }
+  chash[i] = nhash[i];
+}
@@ -1,5 +1,7 @@
 #include <lib.h>
 #include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
 #include <stdio.h>
 
 /* three compile time options:
@@ -15,57 +17,132 @@
 #define	MAXDIG		128	/* this must be enough */
 #endif
 
-PRIVATE _PROTOTYPE( char *_itoa, (char *p, unsigned num, int radix));
-#ifndef NO_LONGD
-PRIVATE _PROTOTYPE( char *ltoa, (char *p, unsigned long num, int radix));
-#endif
+#define	NPAD		16	/* fill characters put at a time */
+
+/* Numbers are converted from the right, two decimal digits at a time, with
+ * a division by 100 and a table lookup.  Only while a number is too big for
+ * an unsigned int does the arithmetic have to be done in longs; octal and
+ * hex need no division at all.  The characters of a field, and of the text
+ * between fields, are copied into the stdio buffer a run at a time, so putc
+ * and fputc are called only to flush it; an unbuffered stream gets each run
+ * with one write instead of one per character.
+ */
+PRIVATE char digits[] = "0123456789ABCDEF";
+PRIVATE char pairs[] = "\
+0001020304050607080910111213141516171819\
+2021222324252627282930313233343536373839\
+4041424344454647484950515253545556575859\
+6061626364656667686970717273747576777879\
+8081828384858687888990919293949596979899\
+";
+
+PRIVATE _PROTOTYPE( char *_ltoa, (char *p, unsigned long num, int radix));
+PRIVATE _PROTOTYPE( void _put, (FILE *iop, _CONST char *s, int n)	);
+PRIVATE _PROTOTYPE( void _pad, (FILE *iop, int c, int n)		);
 
-PRIVATE char *_itoa(p, num, radix)
+PRIVATE char *_ltoa(p, num, radix)
 register char *p;
-register unsigned int num;
-register radix;
+unsigned long num;
+int radix;
 {
-  register i;
-  register char *q;
+/* Convert num to the left of p, and return where it starts. */
+
+  register unsigned u, q;
+  register int d;
+  unsigned long lq;
 
-  q = p + MAXDIG;
-  do {
-        i = (int) (num % radix);
-        i += '0';
-        if (i > '9') i += 'A' - '0' - 10;
-        *--q = i;
-  } while (num = num / radix);
-  i = p + MAXDIG - q;
-  do
-        *p++ = *q++;
-  while (--i);
+  if (radix != 10) {
+	d = radix == 16 ? 4 : 3;
+	while (num > UINT_MAX) {
+		*--p = digits[(int) num & (radix - 1)];
+		num >>= d;
+	}
+	u = (unsigned) num;
+	do
+		*--p = digits[u & (radix - 1)];
+	while ((u >>= d) != 0);
+	return(p);
+  }
+  while (num > UINT_MAX) {
+	lq = num / 100;
+	d = (int) (num - lq * 100) << 1;
+	*--p = pairs[d + 1];
+	*--p = pairs[d];
+	num = lq;
+  }
+  u = (unsigned) num;
+  while (u >= 100) {
+	q = u / 100;
+	d = (u - q * 100) << 1;
+	*--p = pairs[d + 1];
+	*--p = pairs[d];
+	u = q;
+  }
+  if (u >= 10) {
+	u <<= 1;
+	*--p = pairs[u + 1];
+	*--p = pairs[u];
+  } else {
+	*--p = '0' + u;
+  }
   return(p);
 }
 
-#ifndef NO_LONGD
-PRIVATE char *ltoa(p, num, radix)
-register char *p;
-register unsigned long num;
-register radix;
+PRIVATE void _put(iop, s, n)
+register FILE *iop;
+register _CONST char *s;
+register int n;
 {
-  register i;
-  register char *q;
+/* Put n characters on iop.  As many as putc() would put in the buffer are
+ * copied there at once; a string takes any number.
+ */
 
-  q = p + MAXDIG;
-  do {
-	i = (int) (num % radix);
-	i += '0';
-	if (i > '9') i += 'A' - '0' - 10;
-	*--q = i;
-  } while (num = num / radix);
-  i = p + MAXDIG - q;
-  do
-	*p++ = *q++;
-  while (--i);
-  return(p);
+  register int m;
+
+  while (n > 0) {
+	switch (iop->_flags & (_RWMASK | STRINGS)) {
+	    case WRITEMODE | STRINGS:
+		m = n;
+		break;
+	    case WRITEMODE:
+		m = iop->_count > 0 ? BUFSIZ - 1 - iop->_count : 0;
+		break;
+	    case WRITEMODE | UNBUFF:
+		if ((m = write(iop->_fd, s, n)) != n)
+			iop->_flags |= m < 0 ? _ERR : _EOF;
+		iop->_count = 0;
+		return;
+	    default:
+		m = 0;
+		break;
+	}
+	if (m <= 0) {
+		if (fputc(*s++, iop) == EOF) return;
+		n--;
+		continue;
+	}
+	if (m > n) m = n;
+	memcpy(iop->_ptr, s, (size_t) m);
+	iop->_ptr += m;
+	iop->_count += m;
+	s += m;
+	n -= m;
+  }
 }
 
-#endif
+PRIVATE void _pad(iop, c, n)
+FILE *iop;
+int c;
+register int n;
+{
+/* Put n copies of c on iop. */
+
+  char fill[NPAD];
+
+  memset(fill, c, (size_t) (n < NPAD ? n : NPAD));
+  for (; n > NPAD; n -= NPAD) _put(iop, fill, NPAD);
+  _put(iop, fill, n);
+}
 
 #ifndef NO_FLOAT
 extern char *_ecvt();
@@ -97,13 +174,9 @@ va_list argsfix;
   register int *args = (int *) argsfix;
 
   for (;;) {
-	c = *fmt++;
-	if (c == 0) return;
-	if (c != '%') {
-		putc(c, iop);
-		continue;
-	}
-	p = buf;
+	for (s = (char *) fmt; *fmt != '%' && *fmt != 0; fmt++);
+	if (fmt != s) _put(iop, s, (int) (fmt - s));
+	if (*fmt++ == 0) return;
 	s = buf;
 	ljust = 0;
 	if (*fmt == '-') {
@@ -151,6 +224,10 @@ va_list argsfix;
 #endif
 		if (*fmt) c = *fmt++;
 	}
+	if (c == 0) return;		/* the format ended in the middle */
+
+	/* Numbers are converted to the left of the end of buf. */
+	p = &buf[MAXDIG + 1];
 	switch (c) {
 	    case 'X':
 #ifndef NO_LONGD
@@ -175,11 +252,11 @@ va_list argsfix;
   oxu:
 #ifndef NO_LONGD
 		if (lflag) {
-			p = ltoa(p, (unsigned long)GETARG(long), c);
+			s = _ltoa(p, (unsigned long)GETARG(long), c);
 			break;
 		}
 #endif
-		p = _itoa(p, (unsigned int)GETARG(int), c);
+		s = _ltoa(p, (unsigned long)(unsigned int)GETARG(int), c);
 		break;
 	    case 'D':
 #ifndef NO_LONGD
@@ -189,43 +266,47 @@ va_list argsfix;
 #ifndef NO_LONGD
 		if (lflag) {
 			if ((l = GETARG(long)) < 0) {
-				*p++ = '-';
-				l = -l;
+				s = _ltoa(p, -(unsigned long)l, 10);
+				*--s = '-';
+			} else {
+				s = _ltoa(p, (unsigned long)l, 10);
 			}
-			p = ltoa(p, (unsigned long)l, 10);
 			break;
 		}
 #endif
 		if ((i = GETARG(int)) < 0) {
-			*p++ = '-';
-			i = -i;
+			s = _ltoa(p, (unsigned long)-(unsigned int)i, 10);
+			*--s = '-';
+		} else {
+			s = _ltoa(p, (unsigned long)(unsigned int)i, 10);
 		}
-		p = _itoa(p, (unsigned int)i, 10);
 		break;
 #ifdef NO_FLOAT
 	    case 'e':
 	    case 'f':
 	    case 'g':
 		zfill = ' ';
+		p = buf;
 		*p++ = '?';
 		break;
 #else
 	    case 'e':
 		if (ndfnd == 0) ndigit = 6;
 		ndigit++;
-		p = _ecvt(p, GETARG(double), ndigit);
+		p = _ecvt(buf, GETARG(double), ndigit);
 		break;
 	    case 'f':
 		if (ndfnd == 0) ndigit = 6;
-		p = _fcvt(p, GETARG(double), ndigit);
+		p = _fcvt(buf, GETARG(double), ndigit);
 		break;
 	    case 'g':
 		if (ndfnd == 0) ndigit = 6;
-		p = _gcvt(p, GETARG(double), ndigit);
+		p = _gcvt(buf, GETARG(double), ndigit);
 		break;
 #endif
 	    case 'c':
 		zfill = ' ';
+		p = buf;
 		*p++ = GETARG(int);
 		break;
 	    case 's':
@@ -234,24 +315,22 @@ va_list argsfix;
 		if (ndigit == 0) ndigit = 32767;
 		for (p = s; *p && --ndigit >= 0; p++);
 		break;
-	    default:	*p++ = c;	  		break;
+	    default:
+		p = buf;
+		*p++ = c;
+		break;
 	}
 	i = p - s;
 	if ((width -= i) < 0) width = 0;
-	if (ljust == 0) width = -width;
-	if (width < 0) {
+	if (width != 0 && ljust == 0) {
 		if (*s == '-' && zfill == '0') {
-			putc(*s++, iop);
+			_put(iop, s++, 1);
 			i--;
 		}
-		do
-			putc(zfill, iop);
-		while (++width != 0);
-	}
-	while (--i >= 0) putc(*s++, iop);
-	while (width) {
-		putc(zfill, iop);
-		width--;
+		_pad(iop, zfill, width);
+		width = 0;
 	}
+	_put(iop, s, i);
+	if (width != 0) _pad(iop, zfill, width);
   }
 }
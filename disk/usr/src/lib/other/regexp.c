@@ -47,12 +47,13 @@
  *
  * Regstart and reganch permit very fast decisions on suitable starting points
  * for a match, cutting down the work a lot.  Regmust permits fast rejection
- * of lines that cannot possibly match.  The regmust tests are costly enough
- * that regcomp() supplies a regmust only if the r.e. contains something
- * potentially expensive (at present, the only such thing detected is * or +
- * at the start of the r.e., which can involve a lot of backup).  Regmlen is
- * supplied because the test in regexec() needs it and regcomp() is computing
- * it anyway.
+ * of lines that cannot possibly match; it is looked for with Boyer-Moore, so
+ * regcomp() supplies one whenever there is a literal string that every
+ * match must include.  Regmlen is supplied because the test in regexec()
+ * needs it and regcomp() is computing it anyway.
+ *
+ * regdfa	tables for the Boyer-Moore search and the DFA (see below), kept
+ *		after the program so that free() of the regexp frees them too
  */
 
 /* Structure for regexp "program".  This is essentially a linear encoding
@@ -169,6 +170,7 @@ STATIC _PROTOTYPE( void regc, (int b)					);
 STATIC _PROTOTYPE( void reginsert, (int op, char *opnd)			);
 STATIC _PROTOTYPE( void regtail, (char *p, char *val)			);
 STATIC _PROTOTYPE( void regoptail, (char *p, char *val)			);
+STATIC _PROTOTYPE( regexp *regdfacomp, (regexp *r)			);
 
 /*
  - regcomp - compile a regular expression into internal code
@@ -234,25 +236,25 @@ char *exp;
 	else if (OP(scan) == BOL)
 		r->reganch++;
 
-	/* If there's something expensive in the r.e., find the
-	 * longest literal string that must appear and make it the
-	 * regmust.  Resolve ties in favor of later strings, since
+	/* Find the longest literal string that must appear and make it
+	 * the regmust.  Resolve ties in favor of later strings, since
 	 * the regstart check works with the beginning of the r.e.
 	 * and avoiding duplication strengthens checking.  Not a
-	 * strong reason, but sufficient in the absence of others. */
-	if (flags & SPSTART) {
-		longest = (char *)NULL;
-		len = 0;
-		for (; scan != (char *)NULL; scan = regnext(scan))
-			if (OP(scan) == EXACTLY && strlen(OPERAND(scan)) >= len) {
-				longest = OPERAND(scan);
-				len = strlen(OPERAND(scan));
-			}
+	 * strong reason, but sufficient in the absence of others.  A
+	 * single character that is also the regstart is no help. */
+	longest = (char *)NULL;
+	len = 0;
+	for (; scan != (char *)NULL; scan = regnext(scan))
+		if (OP(scan) == EXACTLY && strlen(OPERAND(scan)) >= len) {
+			longest = OPERAND(scan);
+			len = strlen(OPERAND(scan));
+		}
+	if (len > 1 || (len == 1 && *longest != r->regstart)) {
 		r->regmust = longest;
 		r->regmlen = len;
 	}
   }
-  return(r);
+  return(regdfacomp(r));
 }
 
 /*
@@ -623,6 +625,309 @@ char *val;
   regtail(OPERAND(p), val);
 }
 
+/* The DFA.
+ *
+ * A regexp with few enough "positions" (a character of an EXACTLY, an ANY,
+ * ANYOF or ANYBUT node, or an EOL, which matches the '\0' at the end of the
+ * string) also gets a deterministic automaton, which regexec() runs first to
+ * find out whether there is a match at all; only if there is does the
+ * backtracking matcher run, to find where the match and the subexpressions
+ * are.  A state of the automaton is a set of positions the program could be
+ * at, plus a position ACCEPT for having got to END.  States are made as the
+ * strings searched call for them and at most NSTATE are kept; when more are
+ * needed, they are all thrown away and the making starts over.  Characters
+ * that nothing in the program tells apart are in one class, and a state has
+ * a transition for each class rather than for each character.
+ *
+ * The positions that may come after each position, and those a match may
+ * start with, are worked out by regcomp().  The start set (with ^ not
+ * matching) is added in at every step, so that a match may begin anywhere.
+ */
+#define MAXPOS		64	/* positions the DFA can have, with ACCEPT */
+#define MAXCLASS	64	/* character classes it can have */
+#define NSTATE		32	/* states it keeps */
+#define MAXVISIT	128	/* nodes met working out one set */
+#define SETLEN		(MAXPOS / 8)
+
+struct regdfa {
+  unsigned char skip[256];	/* Boyer-Moore shifts for regmust */
+  int npos;			/* positions, ACCEPT last; 0 = no DFA */
+  int nclass;			/* character classes */
+  int setlen;			/* bytes in a set of positions */
+  int nstate;			/* states made */
+  int shift;			/* log2 of the length of a row of trans */
+  unsigned char class[256];	/* class of each character */
+  unsigned char rep[MAXCLASS];	/* a character of each class */
+  short node[MAXPOS];		/* offset of the node of a position */
+  short where[MAXPOS];		/* offset of its character, or of the node */
+  short loop[MAXPOS];		/* offset of its STAR or PLUS, or 0 */
+  char accept[NSTATE];		/* does the state hold ACCEPT? */
+  char *follow;			/* what may come after each position */
+  char *first[2];		/* start sets, for ^ not matching and matching */
+  char *state;			/* the states */
+  unsigned char *trans;		/* next state + 1, or 0 if not made yet */
+};
+
+#define ACCEPT(d)	((d)->npos - 1)
+#define INSET(s, i)	((s)[(i) >> 3] & (1 << ((i) & 7)))
+#define ADDSET(s, i)	((s)[(i) >> 3] |= 1 << ((i) & 7))
+
+PRIVATE struct regdfa dfawork;	/* the tables, while they are made */
+PRIVATE char dfafollow[MAXPOS * SETLEN];
+PRIVATE char dfafirst[2 * SETLEN];
+PRIVATE struct regdfa *dfa;	/* the tables being made or used */
+PRIVATE char *dfaprog;		/* their program */
+PRIVATE char *dfaset;		/* set being made by regclose() */
+PRIVATE int dfabol;		/* does ^ match there? */
+PRIVATE char *visit[MAXVISIT];	/* nodes met by regclose() */
+PRIVATE int nvisit;
+
+STATIC _PROTOTYPE( int regdfamake, (void)				);
+STATIC _PROTOTYPE( int regrefine, (char *member)			);
+STATIC _PROTOTYPE( int regsets, (char *set, char *p, int bol)		);
+STATIC _PROTOTYPE( int regclose, (char *p)				);
+STATIC _PROTOTYPE( int regpos, (char *p)				);
+
+/*
+ - regdfacomp - add the tables for Boyer-Moore and, if it can be had, the DFA
+ *
+ * They go after the program, so the regexp grows and may move.
+ */
+PRIVATE regexp *regdfacomp(r)
+regexp *r;
+{
+  register struct regdfa *d = &dfawork;
+  register int i, n;
+  unsigned base, size;
+  long must;
+  regexp *nr;
+
+  /* Boyer-Moore (Horspool) shifts: how far the end of the regmust can move
+   * on past a character that does not end a match.
+   */
+  n = r->regmlen < 255 ? r->regmlen : 255;
+  for (i = 0; i < 256; i++) d->skip[i] = n;
+  for (i = 0; i < r->regmlen - 1; i++)
+	if (r->regmlen - 1 - i < n)
+		d->skip[UCHARAT(r->regmust + i)] = r->regmlen - 1 - i;
+
+  dfa = d;
+  dfaprog = r->program;
+  if (regdfamake())
+	size = sizeof(struct regdfa) + (d->npos + 1 + NSTATE) * d->setlen +
+							(NSTATE << d->shift);
+  else {
+	d->npos = 0;
+	size = sizeof(struct regdfa);
+  }
+
+  base = sizeof(regexp) + (unsigned) regsize;
+  base = (base + sizeof(long) - 1) & ~(sizeof(long) - 1);
+  must = r->regmust != (char *)NULL ? r->regmust - (char *) r : 0L;
+  if ((nr = (regexp *) realloc((char *) r, base + size)) == (regexp *)NULL) {
+	free((char *) r);
+	RFAIL("out of space");
+  }
+  r = nr;
+  if (r->regmust != (char *)NULL) r->regmust = (char *) r + must;
+  r->regdfa = (char *) r + base;
+  d = (struct regdfa *) r->regdfa;
+  memcpy((char *) d, (char *) &dfawork, sizeof(struct regdfa));
+  if (d->npos != 0) {
+	n = d->setlen;
+	d->follow = (char *) (d + 1);
+	memcpy(d->follow, dfafollow, (d->npos - 1) * n);
+	d->first[0] = d->follow + (d->npos - 1) * n;
+	d->first[1] = d->first[0] + n;
+	memcpy(d->first[0], dfafirst, 2 * n);
+	d->state = d->first[1] + n;
+	d->trans = (unsigned char *) (d->state + NSTATE * n);
+	memset((char *) d->trans, 0, NSTATE << d->shift);
+	d->nstate = 0;
+  }
+  return(r);
+}
+
+/*
+ - regdfamake - work out the positions, classes and sets; 0 if too many
+ */
+PRIVATE int regdfamake()
+{
+  register struct regdfa *d = dfa;
+  register char *s;
+  register int i, n;
+  char op, member[256];
+  int loop;
+
+  /* Number the positions, and split the characters into classes. */
+  for (i = 0; i < 256; i++) d->class[i] = (i != 0);
+  d->nclass = 2;
+  n = 0;
+  loop = 0;
+  for (s = dfaprog + 1; (op = OP(s)) != END; s = OPERAND(s)) {
+	if (op == STAR || op == PLUS) {
+		/* The operand, which is the next node, is one position. */
+		loop = s - dfaprog;
+		continue;
+	}
+	if (op == ANYOF || op == ANYBUT) {
+		memset(member, 0, sizeof(member));
+		for (i = 0; OPERAND(s)[i] != '\0'; i++)
+			member[UCHARAT(OPERAND(s) + i)] = 1;
+	}
+	if (op == EXACTLY) {
+		for (i = 0; OPERAND(s)[i] != '\0'; i++) {
+			if (n == MAXPOS - 1) return(0);
+			d->node[n] = s - dfaprog;
+			d->where[n] = OPERAND(s) + i - dfaprog;
+			d->loop[n++] = loop;
+			memset(member, 0, sizeof(member));
+			member[UCHARAT(OPERAND(s) + i)] = 1;
+			if (!regrefine(member)) return(0);
+		}
+	} else if (op == ANY || op == ANYOF || op == ANYBUT || op == EOL) {
+		if (n == MAXPOS - 1) return(0);
+		d->node[n] = d->where[n] = s - dfaprog;
+		d->loop[n++] = loop;
+		if ((op == ANYOF || op == ANYBUT) && !regrefine(member))
+			return(0);
+	}
+	loop = 0;
+	if (op == ANYOF || op == ANYBUT || op == EXACTLY)
+		s += strlen(OPERAND(s)) + 1;
+  }
+  d->npos = n + 1;
+  d->setlen = (d->npos + 7) / 8;
+  for (i = 255; i >= 0; i--) d->rep[d->class[i]] = i;
+  for (d->shift = 0; (1 << d->shift) < d->nclass; d->shift++)
+	;
+
+  /* What may come after each position, and what may come first. */
+  for (i = 0; i < n; i++) {
+	s = dfafollow + i * d->setlen;
+	memset(s, 0, d->setlen);
+	if (OP(dfaprog + d->node[i]) == EXACTLY &&
+					dfaprog[d->where[i] + 1] != '\0')
+		ADDSET(s, i + 1);	/* the next character of the string */
+	else if (d->loop[i] != 0) {
+		ADDSET(s, i);		/* the operand again */
+		if (!regsets(s, regnext(dfaprog + d->loop[i]), 0)) return(0);
+	} else
+		if (!regsets(s, regnext(dfaprog + d->node[i]), 0)) return(0);
+  }
+  d->first[0] = dfafirst;
+  d->first[1] = dfafirst + d->setlen;
+  memset(dfafirst, 0, 2 * d->setlen);
+  return(regsets(d->first[0], dfaprog + 1, 0) &&
+				regsets(d->first[1], dfaprog + 1, 1));
+}
+
+/*
+ - regrefine - split each character class into the part in a set and the rest
+ */
+PRIVATE int regrefine(member)
+char *member;
+{
+  register int c, k, key;
+  unsigned char map[2 * 256];
+
+  memset((char *) map, 0, sizeof(map));
+  k = 0;
+  for (c = 0; c < 256; c++) {
+	key = 2 * dfa->class[c] + (member[c] != 0);
+	if (map[key] == 0) {
+		if (k == MAXCLASS) return(0);
+		map[key] = ++k;
+	}
+	dfa->class[c] = map[key] - 1;
+  }
+  dfa->nclass = k;
+  return(1);
+}
+
+/*
+ - regsets - add to a set the positions that may be next from a node on
+ */
+PRIVATE int regsets(set, p, bol)
+char *set;
+char *p;
+int bol;
+{
+  dfaset = set;
+  dfabol = bol;
+  nvisit = 0;
+  return(regclose(p));
+}
+
+/*
+ - regclose - the work of regsets(), along the lines of regmatch()
+ */
+PRIVATE int regclose(p)
+register char *p;
+{
+  register int i;
+  char *next;
+
+  while (p != (char *)NULL) {
+	for (i = 0; i < nvisit; i++)
+		if (visit[i] == p) return(1);	/* been here */
+	if (nvisit == MAXVISIT) return(0);
+	visit[nvisit++] = p;
+	next = regnext(p);
+
+	switch (OP(p)) {
+	    case END:
+		ADDSET(dfaset, ACCEPT(dfa));
+		return(1);
+	    case BOL:
+		if (!dfabol) return(1);
+		break;
+	    case EXACTLY:
+	    case EOL:
+	    case ANY:
+	    case ANYOF:
+	    case ANYBUT:
+		ADDSET(dfaset, regpos(p));
+		return(1);
+	    case BRANCH:
+		if (OP(next) != BRANCH)		/* No choice. */
+			next = OPERAND(p);
+		else {
+			do {
+				if (!regclose(OPERAND(p))) return(0);
+				p = regnext(p);
+			} while (p != (char *)NULL && OP(p) == BRANCH);
+			return(1);
+		}
+		break;
+	    case STAR:
+		ADDSET(dfaset, regpos(OPERAND(p)));
+		break;
+	    case PLUS:
+		ADDSET(dfaset, regpos(OPERAND(p)));
+		return(1);
+	    default:			/* NOTHING, BACK, OPEN and CLOSE */
+		break;
+	}
+	p = next;
+  }
+  return(1);
+}
+
+/*
+ - regpos - the position of a node, or of the first character of an EXACTLY
+ */
+PRIVATE int regpos(p)
+char *p;
+{
+  register int i, where;
+
+  where = (OP(p) == EXACTLY ? OPERAND(p) : p) - dfaprog;
+  for (i = 0; dfa->where[i] != where; i++)
+	;
+  return(i);
+}
+
 /* regexec and friends
  */
 
@@ -638,6 +943,10 @@ PRIVATE char **regendp;		/* Ditto for endp. */
 STATIC _PROTOTYPE( int regtry, (regexp *prog, char *string)		);
 STATIC _PROTOTYPE( int regmatch, (char *prog)				);
 STATIC _PROTOTYPE( int regrepeat, (char *p)				);
+STATIC _PROTOTYPE( char *regfind, (regexp *prog, char *string)		);
+STATIC _PROTOTYPE( int regdfaexec, (regexp *prog, char *string, int bolflag));
+STATIC _PROTOTYPE( int regstep, (int s, int k)				);
+STATIC _PROTOTYPE( int regstate, (char *set)				);
 
 #ifdef DEBUG
 int regnarrate = 0;
@@ -668,16 +977,16 @@ int bolflag;
   }
 
   /* If there is a "must appear" string, look for it. */
-  if (prog->regmust != (char *)NULL) {
-	s = string;
-	while ((s = strchr(s, prog->regmust[0])) != (char *)NULL) {
-		if (strncmp(s, prog->regmust, prog->regmlen) == 0)
-			break;	/* Found it. */
-		s++;
-	}
-	if (s == (char *)NULL)		/* Not present. */
-		return(0);
-  }
+  if (prog->regmust != (char *)NULL &&
+				regfind(prog, string) == (char *)NULL)
+	return(0);			/* Not present. */
+
+  /* If there is a DFA, it can tell quickly whether there is a match.  (Not
+   * in an empty string, where ^ and $ both match, which it does not know.)
+   */
+  if (((struct regdfa *) prog->regdfa)->npos != 0 && *string != '\0' &&
+				!regdfaexec(prog, string, bolflag))
+	return(0);
 
   /* Mark beginning of line for ^ . */
   if (bolflag)
@@ -705,6 +1014,137 @@ int bolflag;
   return(0);
 }
 
+/*
+ - regfind - look for the regmust in a string, Boyer-Moore fashion
+ */
+PRIVATE char *regfind(prog, string)
+regexp *prog;
+char *string;
+{
+  register char *s, *end;
+  register unsigned char *skip;
+  register int last;
+  char *must;
+
+  must = prog->regmust;
+  last = prog->regmlen - 1;
+  if (last == 0) return(strchr(string, *must));
+  skip = ((struct regdfa *) prog->regdfa)->skip;
+  end = string + strlen(string) - last;
+  for (s = string; s < end; s += skip[UCHARAT(s + last)])
+	if (s[last] == must[last] && strncmp(s, must, last) == 0)
+		return(s);
+  return((char *)NULL);
+}
+
+/*
+ - regdfaexec - run the DFA over a string: is there a match anywhere?
+ */
+PRIVATE int regdfaexec(prog, string, bolflag)
+regexp *prog;
+register char *string;
+int bolflag;
+{
+  register struct regdfa *d;
+  register int s, t;
+  register unsigned char *class;
+  int k, i;
+
+  dfa = d = (struct regdfa *) prog->regdfa;
+  dfaprog = prog->program;
+  class = d->class;
+  s = regstate(d->first[bolflag != 0]);
+  while (!d->accept[s]) {
+	if (*string == '\0') {
+		/* The '\0' matches $; "$$" wants it more than once. */
+		for (i = 0; i < d->npos && !d->accept[s]; i++)
+			if ((t = d->trans[s << d->shift]) != 0)
+				s = t - 1;
+			else
+				s = regstep(s, 0);
+		return(d->accept[s]);
+	}
+	k = class[UCHARAT(string)];
+	string++;
+	if ((t = d->trans[(s << d->shift) + k]) != 0)
+		s = t - 1;
+	else
+		s = regstep(s, k);
+  }
+  return(1);
+}
+
+/*
+ - regstep - make the transition from a state on a class
+ */
+PRIVATE int regstep(s, k)
+int s, k;
+{
+  register struct regdfa *d = dfa;
+  register char *p;
+  register int i, j;
+  char *from, set[SETLEN];
+  int c, t, n;
+
+  c = d->rep[k];
+  n = d->setlen;
+  from = d->state + s * n;
+  memcpy(set, d->first[0], n);
+  for (i = 0; i < ACCEPT(d); i++) {
+	if (!INSET(from, i)) continue;
+	p = dfaprog + d->node[i];
+	switch (OP(p)) {
+	    case EXACTLY:
+		if (c != UCHARAT(dfaprog + d->where[i])) continue;
+		break;
+	    case EOL:
+		if (c != '\0') continue;
+		break;
+	    case ANY:
+		if (c == '\0') continue;
+		break;
+	    case ANYOF:
+		if (c == '\0' || strchr(OPERAND(p), c) == (char *)NULL)
+			continue;
+		break;
+	    case ANYBUT:
+		if (c == '\0' || strchr(OPERAND(p), c) != (char *)NULL)
+			continue;
+		break;
+	}
+	p = d->follow + i * n;
+	for (j = 0; j < n; j++) set[j] |= p[j];
+  }
+  t = d->nstate;
+  i = regstate(set);		/* if the states were thrown away, so was s */
+  if (d->nstate >= t) d->trans[(s << d->shift) + k] = i + 1;
+  return(i);
+}
+
+/*
+ - regstate - the number of a state, made if need be
+ *
+ * If all NSTATE are in use, they are thrown away first.
+ */
+PRIVATE int regstate(set)
+char *set;
+{
+  register struct regdfa *d = dfa;
+  register int s, n;
+
+  n = d->setlen;
+  for (s = 0; s < d->nstate; s++)
+	if (memcmp(d->state + s * n, set, n) == 0) return(s);
+  if (d->nstate == NSTATE) {
+	d->nstate = 0;
+	memset((char *) d->trans, 0, NSTATE << d->shift);
+  }
+  s = d->nstate++;
+  memcpy(d->state + s * n, set, n);
+  d->accept[s] = INSET(set, ACCEPT(d)) != 0;
+  return(s);
+}
+
 /*
  - regtry - try match at specific point
  */
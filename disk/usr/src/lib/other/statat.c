@@ -0,0 +1,11 @@
+#include <lib.h>
+#include <sys/stat.h>
+
+PUBLIC int statat(fd, name, buffer)
+int fd;
+_CONST char *name;
+struct stat *buffer;
+{
+  return(callm1(FS, STATAT, len(name), 0, fd,
+  		(char *)name, (char *)buffer, NIL_PTR));
+}
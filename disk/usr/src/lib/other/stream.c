@@ -0,0 +1,172 @@
+#include <lib.h>
+/* stream - copy data in large pieces, with the writing done by a child
+ *
+ * Streambuf() gets a buffer as big as memory allows, up to a limit.
+ * Streamopen() is given a file descriptor open for writing.  If it is a
+ * device or a pipe, a child process is forked that takes the data through a
+ * pipe and writes it in large pieces, so that the caller can read the next
+ * piece while the child waits for the device.  The child's buffer is got
+ * before the fork, so a child that cannot have one is never started.
+ * Streamclose() closes the pipe and returns -1 if the child could not write
+ * everything.  Streamcopy() copies from one descriptor to another until end
+ * of file.
+ */
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define STREAM_MAX	30720	/* largest buffer; three 10K tape records */
+#define STREAM_MIN	 1024	/* smallest buffer worth having */
+
+PRIVATE int pids[20];		/* writer of each pipe, as for popen() */
+
+char *streambuf(size)
+unsigned *size;
+{
+/* Allocate a buffer of *size bytes, or of STREAM_MAX if *size is 0.  If
+ * there is not that much memory, halve it until the malloc() succeeds.
+ * Returns the buffer and its size in *size, or NULL.
+ */
+  register unsigned n;
+  char *buf;
+
+  n = (*size == 0 || *size > STREAM_MAX) ? STREAM_MAX : *size;
+  while ((buf = malloc(n)) == NULL) {
+	if (n <= STREAM_MIN) return(NULL);
+	n >>= 1;
+  }
+  *size = n;
+  return(buf);
+}
+
+PRIVATE int fill(fd, buf, size)
+int fd;
+register char *buf;
+unsigned size;
+{
+/* Read from the pipe until buf is full or the pipe is at EOF. */
+  register unsigned got = 0;
+  int n;
+
+  while (got < size) {
+	if ((n = read(fd, buf + got, size - got)) <= 0) break;
+	got += n;
+  }
+  return(got);
+}
+
+PRIVATE int drain(in, out, buf, size, recsize, blkdev)
+int in, out;
+char *buf;
+unsigned size, recsize;
+int blkdev;
+{
+/* The child: take what comes through the pipe into buf, which holds size
+ * bytes, at least one record, and write it in records of recsize bytes, or
+ * in whole buffers if recsize is 0.  Only the last record can be short.  A
+ * block device is synced after each buffer, so the cache is emptied in one
+ * go rather than a block at a time.  The exit status is 0, or the errno of
+ * what went wrong.
+ */
+  register char *p;
+  unsigned n, chunk;
+
+  if (recsize != 0) size -= size % recsize;
+  do {
+	n = fill(in, buf, size);
+	for (p = buf; p < buf + n; p += chunk) {
+		chunk = (recsize == 0) ? n : recsize;
+		if (chunk > buf + n - p) chunk = buf + n - p;
+		if (write(out, p, chunk) != chunk) return(errno ? errno : EIO);
+	}
+	if (blkdev && n > 0) sync();
+  } while (n == size);
+  return(0);
+}
+
+int streamopen(fd, recsize)
+int fd;
+unsigned recsize;
+{
+/* If fd is a device or a pipe, start a writer for it and return the end of
+ * the pipe to write to; fd itself is then closed.  Otherwise, or if there is
+ * no memory for a buffer of at least one record, a pipe or a process, return
+ * fd, which the caller then writes itself.  Because a writer that fails
+ * exits, SIGPIPE is ignored from then on: the caller sees a failed write().
+ */
+  struct stat st;
+  int piped[2], pid, mode;
+  char *buf;
+  unsigned size = 0;
+
+  if (recsize > STREAM_MAX || fstat(fd, &st) < 0) return(fd);
+  mode = st.st_mode & S_IFMT;
+  if (mode != S_IFCHR && mode != S_IFBLK && mode != S_IFIFO) return(fd);
+  if ((buf = streambuf(&size)) != NULL && size < recsize) {
+	free(buf);
+	size = recsize;
+	buf = malloc(size);
+  }
+  if (buf == NULL) return(fd);
+  if (pipe(piped) < 0) {
+	free(buf);
+	return(fd);
+  }
+  if (piped[1] >= 20 || (pid = fork()) < 0) {
+	close(piped[0]);
+	close(piped[1]);
+	free(buf);
+	return(fd);
+  }
+  if (pid == 0) {
+	close(piped[1]);
+	_exit(drain(piped[0], fd, buf, size, recsize, mode == S_IFBLK));
+  }
+  free(buf);			/* the child has its own copy */
+  signal(SIGPIPE, SIG_IGN);
+  close(piped[0]);
+  close(fd);
+  pids[piped[1]] = pid;
+  return(piped[1]);
+}
+
+int streamclose(fd)
+int fd;
+{
+/* Close fd.  If it goes to a writer, wait for that to finish, and return -1
+ * unless it wrote everything, with errno set to what stopped it.
+ */
+  int status, wret;
+
+  close(fd);
+  if (fd < 0 || fd >= 20 || pids[fd] == 0) return(0);
+  while ((wret = wait(&status)) != -1)
+	if (wret == pids[fd]) break;
+  pids[fd] = 0;
+  if (wret == -1) return(-1);
+  if (status == 0) return(0);
+  errno = (status & 0377) == 0 ? (status >> 8) & 0377 : EINTR;
+  return(-1);
+}
+
+long streamcopy(in, out, buf, size)
+int in, out;
+char *buf;
+unsigned size;
+{
+/* Copy from in to out through buf until end of file.  Returns the number of
+ * bytes copied, or -1 if a read() or write() failed.
+ */
+  register int n;
+  long total = 0;
+
+  while ((n = read(in, buf, size)) > 0) {
+	if (write(out, buf, n) != n) return(-1L);
+	total += n;
+  }
+  return(n < 0 ? -1L : total);
+}
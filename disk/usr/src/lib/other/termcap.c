@@ -27,17 +27,31 @@
  *   - Incorporated Klamer's V1.2 fixes into V1.3
  *   - Added %d, (old %d is now %2)			 [tgoto]
  *   - Allow '#' comments in definition file		 [tgetent]
+ *
+ *   - Read the entry from the compiled termcap made by	 [tgetent]
+ *     tic(1), if there is one, and look capabilities	 [tgetnum/flag/str]
+ *     up in its table instead of parsing the text
  */
 
 #include <lib.h>
+#include <sys/stat.h>
+#include <fcntl.h>
 #include <termcap.h>
+#include <tcdb.h>
 #include <ctype.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 #include <stdio.h>
 
 char *capab = (char *)NULL;		/* the capability itself */
 
+PRIVATE char *tcbuf = (char *)NULL;	/* buffer holding a compiled entry */
+PRIVATE char *tccaps;			/* its table of capabilities */
+
+PRIVATE _PROTOTYPE( int tcdb, (char *bp, char *file, char *name)	);
+PRIVATE _PROTOTYPE( char *tclook, (char *id, int type)			);
+
 #if 0
 /*  The following are not yet used.  */
 extern short ospeed;		/* output speed */
@@ -62,6 +76,7 @@ char *name;
   short len = strlen(name);
 
   capab = bp;
+  tcbuf = (char *)NULL;
 
   /* If TERMCAP begins with a '/' then use TERMCAP as the path	 */
   /* Name of the termcap definitions file. If TERMCAP is a	 */
@@ -78,6 +93,11 @@ char *name;
 	} else
 		file = "/etc/termcap";
 
+  if (tcdb(bp, file, name)) {
+	tcbuf = bp;
+	return(1);
+  }
+
   if ((fp = fopen(file, "r")) == (FILE *) NULL) {
 	capab = (char *)NULL;		/* no valid termcap  */
 	return(-1);
@@ -116,6 +136,103 @@ char *name;
 }
 
 
+/*
+ *	tcdb - look name up in the compiled form of file, if there is one
+ *	and the file has not changed since it was made. Returns 1 and the
+ *	entry in bp if the name is there, 0 otherwise.
+ */
+
+PRIVATE int tcdb(bp, file, name)
+char *bp;
+char *file;
+char *name;
+{
+  char path[PATH_MAX + 1];
+  char head[TC_HSIZE];
+  char slots[4 * TC_SSIZE];	/* read this many at a time */
+  struct stat st;
+  register char *sp;
+  register int n;
+  unsigned h, nslot;
+  int fd, len;
+
+  if (strlen(name) > TC_NAMELEN || strlen(file) + 3 > PATH_MAX) return(0);
+  strcpy(path, file);
+  strcat(path, ".db");
+  if ((fd = open(path, O_RDONLY)) < 0) return(0);
+
+  if (read(fd, head, TC_HSIZE) != TC_HSIZE ||
+      tcget2(head + TC_HMAGIC) != TC_MAGIC ||
+      (stat(file, &st) == 0 && st.st_mtime != tcget4(head + TC_HMTIME))) {
+	close(fd);
+	return(0);
+  }
+  nslot = tcget2(head + TC_HNSLOT);
+  tchash(name, h);
+  h &= nslot - 1;
+
+  for (n = 0;; n--, sp += TC_SSIZE) {
+	if (n == 0) {
+		/* Read the next few slots, up to the end of the index. */
+		n = nslot - h < 4 ? nslot - h : 4;
+		if (lseek(fd, TC_HSIZE + (long) h * TC_SSIZE, SEEK_SET) < 0 ||
+		    read(fd, slots, n * TC_SSIZE) != n * TC_SSIZE)
+			break;
+		h = (h + n) & (nslot - 1);
+		sp = slots;
+	}
+	if (*sp == '\0') break;		/* not there */
+	if (strncmp(sp, name, TC_NAMELEN) == 0) {
+		len = tcget2(sp + TC_SLEN);
+		if (len <= 0 || len > TC_BUFSIZE) break;  /* only in the text */
+		if (lseek(fd, tcget4(sp + TC_SOFFSET), SEEK_SET) < 0 ||
+		    read(fd, bp, len) != len)
+			break;
+		close(fd);
+		tccaps = bp + strlen(bp) + 1;
+		return(1);
+	}
+  }
+  close(fd);
+  return(0);
+}
+
+
+/*
+ *	tclook - find the capability id of the given type (any type if it
+ *	is 0) in the table of the compiled entry. Returns its record, or
+ *	NULL if it is not there.
+ */
+
+PRIVATE char *tclook(id, type)
+char *id;
+int type;
+{
+  register char *rp;
+  register int lo, hi, mid;
+  int key, n;
+
+  key = tcget2(id);
+  n = *tccaps & 0377;
+  rp = tccaps + TC_CSIZE;
+
+  /* Find the first record with the id; there may be one of each type. */
+  lo = 0;
+  hi = n;
+  while (lo < hi) {
+	mid = (lo + hi) / 2;
+	if (tcget2(rp + mid * TC_RSIZE + TC_RID) < key)
+		lo = mid + 1;
+	else
+		hi = mid;
+  }
+  for (rp += lo * TC_RSIZE; lo < n && tcget2(rp + TC_RID) == key;
+						lo++, rp += TC_RSIZE)
+	if (type == 0 || rp[TC_RTYPE] == type) return(rp);
+  return((char *)NULL);
+}
+
+
 /*
  *	tgetnum - get the numeric terminal capability corresponding
  *	to id. Returns the value, -1 if invalid.
@@ -128,6 +245,11 @@ char *id;
 
   if (cp == (char *)NULL || id == (char *)NULL) return(-1);
 
+  if (cp == tcbuf) {
+	if ((cp = tclook(id, '#')) == (char *)NULL) return(-1);
+	return((short) tcget2(cp + TC_RVALUE));
+  }
+
   for (;;) {
 	while (*cp++ != ':')
 		if (cp[-1] == '\0') return(-1);
@@ -152,6 +274,8 @@ char *id;
 
   if (cp == (char *)NULL || id == (char *)NULL) return(-1);
 
+  if (cp == tcbuf) return(tclook(id, 0) != (char *)NULL);
+
   for (;;) {
 	while (*cp++ != ':')
 		if (cp[-1] == '\0') return(0);
@@ -178,6 +302,13 @@ char **area;
 
   if (cp == (char *)NULL || id == (char *)NULL) return((char *)NULL);
 
+  if (cp == tcbuf) {
+	if ((cp = tclook(id, '=')) == (char *)NULL) return((char *)NULL);
+	memcpy(wsp, tccaps + tcget2(cp + TC_RVALUE), cp[TC_RLEN] & 0377);
+	*area = wsp + (cp[TC_RLEN] & 0377);
+	return(wsp);
+  }
+
   for (;;) {
 	while (*cp++ != ':')
 		if (cp[-1] == '\0') return((char *)NULL);
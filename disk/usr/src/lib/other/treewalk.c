@@ -0,0 +1,278 @@
+#include <lib.h>
+/* treewalk - help for programs that walk a file tree
+ *
+ * Tw_read() reads a whole directory with getdents().  If asked, it also
+ * stats every entry with statat(), in the order of the inode numbers rather
+ * than that of the directory, so the inode table is read from front to back
+ * instead of at random.  The entries are handed back in directory order.
+ * Tw_seen() remembers the (device, inode) pairs it is given, so that a file
+ * with several links can be counted once.  Tw_user() and tw_group() give the
+ * names of user and group ids; the password and group files are read once,
+ * the first time a name is wanted.
+ */
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <grp.h>
+#include <limits.h>
+#include <pwd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <treewalk.h>
+
+#define SLOT_SIZE	  16	/* bytes per entry in a MINIX directory */
+#define NR_SEEN		 128	/* hash chains of seen pairs; a power of 2 */
+#define SEEN_CHUNK	  32	/* seen pairs allocated at a time */
+#define NR_IDS		  16	/* hash chains of id names; a power of 2 */
+
+struct seen {
+  struct seen *s_next;		/* next pair on the hash chain */
+  dev_t s_dev;
+  ino_t s_ino;
+};
+
+struct idname {
+  struct idname *id_next;	/* next name on the hash chain */
+  int id_id;			/* user or group id */
+  char id_name[1];		/* name plus a 0 byte */
+};
+
+PRIVATE char dirbuf[BLOCK_SIZE];	/* getdents() buffer */
+PRIVATE struct seen *seentab[NR_SEEN];
+PRIVATE struct seen *seenfree;		/* pairs not handed out yet */
+PRIVATE int nseenfree;
+PRIVATE struct idname *users[NR_IDS], *groups[NR_IDS];
+PRIVATE int users_read, groups_read;
+
+PRIVATE int inocmp(p1, p2)
+struct twent **p1, **p2;
+{
+  return((*p1)->tw_ino < (*p2)->tw_ino ? -1 : (*p1)->tw_ino > (*p2)->tw_ino);
+}
+
+PRIVATE int getents(fd, tdp, max, flags)
+int fd;
+struct twdir *tdp;
+unsigned max;
+int flags;
+{
+/* Fill tdp with the entries of directory fd, at most max of them. */
+  register struct dirent *dp;
+  register struct twent *tp;
+  register char *np = tdp->tw_names;
+  int n, k;
+
+  tp = tdp->tw_ent;
+  while ((n = getdents(fd, dirbuf, sizeof(dirbuf))) > 0) {
+	for (k = 0; k < n; k += dp->d_reclen) {
+		dp = (struct dirent *) &dirbuf[k];
+		if (dp->d_ino == 0) continue;
+		if (!(flags & TW_DOTS) && dp->d_name[0] == '.' &&
+		    (dp->d_name[1] == 0 ||
+		     (dp->d_name[1] == '.' && dp->d_name[2] == 0)))
+			continue;
+		if (tdp->tw_count == max) return(0);	/* it grew */
+		tp->tw_name = np;
+		tp->tw_ino = dp->d_ino;
+		tp->tw_errno = 0;
+		strcpy(np, dp->d_name);
+		np += strlen(np) + 1;
+		tp++;
+		tdp->tw_count++;
+	}
+  }
+  return(n);
+}
+
+PRIVATE int statents(fd, tdp)
+int fd;
+struct twdir *tdp;
+{
+/* Stat the entries of tdp in inode order. */
+  register struct twent **order;
+  register int i;
+
+  if (tdp->tw_count == 0) return(0);
+  order = (struct twent **) malloc(tdp->tw_count * sizeof(*order));
+  if (order == NULL) {
+	errno = ENOMEM;
+	return(-1);
+  }
+  for (i = 0; i < tdp->tw_count; i++) order[i] = &tdp->tw_ent[i];
+  qsort((void *) order, tdp->tw_count, sizeof(*order), inocmp);
+  for (i = 0; i < tdp->tw_count; i++)
+	if (statat(fd, order[i]->tw_name, &order[i]->tw_stat) < 0)
+		order[i]->tw_errno = errno;
+  free((void *) order);
+  return(0);
+}
+
+PRIVATE int readents(fd, tdp, flags)
+int fd;
+register struct twdir *tdp;
+int flags;
+{
+/* Read the directory open on fd into *tdp.  Its size says how many entries
+ * there can be at most.
+ */
+  struct stat st;
+  unsigned max;
+
+  if (fstat(fd, &st) < 0) return(-1);
+  if ((st.st_mode & S_IFMT) != S_IFDIR) {
+	errno = ENOTDIR;
+	return(-1);
+  }
+  if (st.st_size / SLOT_SIZE >= UINT_MAX / sizeof(struct twent)) {
+	errno = ENOMEM;
+	return(-1);
+  }
+  max = st.st_size / SLOT_SIZE;
+  tdp->tw_ent = (struct twent *) malloc((max + 1) * sizeof(struct twent));
+  tdp->tw_names = (char *) malloc((max + 1) * (NAME_MAX + 1));
+  if (tdp->tw_ent == NULL || tdp->tw_names == NULL) {
+	errno = ENOMEM;
+	return(-1);
+  }
+  if (getents(fd, tdp, max, flags) < 0) return(-1);
+  if ((flags & TW_STAT) && statents(fd, tdp) < 0) return(-1);
+  return(0);
+}
+
+int tw_read(tdp, path, flags)
+struct twdir *tdp;
+char *path;
+int flags;
+{
+/* Read directory path into *tdp.  Flags TW_DOTS and TW_STAT say whether "."
+ * and ".." are wanted and whether the entries are stat'ed.  An entry that
+ * cannot be stat'ed has the reason in tw_errno.  Returns the number of
+ * entries, or -1 with errno set if the directory cannot be read.
+ */
+  int fd, err;
+
+  tdp->tw_count = 0;
+  tdp->tw_ent = NULL;
+  tdp->tw_names = NULL;
+  if ((fd = open(path, O_RDONLY)) < 0) return(-1);
+  if (readents(fd, tdp, flags) < 0) {
+	err = errno;
+	close(fd);
+	tw_free(tdp);
+	errno = err;
+	return(-1);
+  }
+  close(fd);
+  return(tdp->tw_count);
+}
+
+void tw_free(tdp)
+struct twdir *tdp;
+{
+/* Give back the space of a directory read by tw_read(). */
+
+  if (tdp->tw_ent != NULL) free((void *) tdp->tw_ent);
+  if (tdp->tw_names != NULL) free((void *) tdp->tw_names);
+  tdp->tw_count = 0;
+  tdp->tw_ent = NULL;
+  tdp->tw_names = NULL;
+}
+
+int tw_seen(dev, ino)
+int dev, ino;
+{
+/* Return 1 if (dev, ino) has been seen before, else remember it and
+ * return 0.
+ */
+  register struct seen *sp, **hp;
+
+  hp = &seentab[(ino ^ dev) & (NR_SEEN - 1)];
+  for (sp = *hp; sp != NULL; sp = sp->s_next)
+	if (sp->s_ino == (ino_t) ino && sp->s_dev == (dev_t) dev) return(1);
+  if (nseenfree == 0) {
+	seenfree = (struct seen *) malloc(SEEN_CHUNK * sizeof(struct seen));
+	if (seenfree == NULL) return(0);
+	nseenfree = SEEN_CHUNK;
+  }
+  sp = &seenfree[--nseenfree];
+  sp->s_dev = dev;
+  sp->s_ino = ino;
+  sp->s_next = *hp;
+  *hp = sp;
+  return(0);
+}
+
+PRIVATE char *addname(tab, id, name)
+struct idname **tab;
+int id;
+char *name;
+{
+/* Enter the name of id, unless it has one already.  Returns the name. */
+  register struct idname *ip, **hp;
+
+  hp = &tab[id & (NR_IDS - 1)];
+  for (ip = *hp; ip != NULL; ip = ip->id_next)
+	if (ip->id_id == id) return(ip->id_name);
+  ip = (struct idname *) malloc(sizeof(struct idname) + strlen(name));
+  if (ip == NULL) return(NULL);
+  ip->id_id = id;
+  strcpy(ip->id_name, name);
+  ip->id_next = *hp;
+  *hp = ip;
+  return(ip->id_name);
+}
+
+PRIVATE char *idname(tab, id)
+struct idname **tab;
+int id;
+{
+/* Look id up.  An id without a name is given its number as one. */
+  PRIVATE char num[12];
+  register struct idname *ip;
+  register char *p;
+  char *name;
+  unsigned u = id;
+
+  for (ip = tab[id & (NR_IDS - 1)]; ip != NULL; ip = ip->id_next)
+	if (ip->id_id == id) return(ip->id_name);
+  p = &num[sizeof(num) - 1];
+  do {
+	*--p = '0' + u % 10;
+  } while ((u /= 10) != 0);
+  return((name = addname(tab, id, p)) != NULL ? name : p);
+}
+
+char *tw_user(uid)
+int uid;
+{
+/* Return the login name of uid. */
+  register struct passwd *pw;
+
+  if (!users_read) {
+	users_read = 1;
+	setpwent();
+	while ((pw = getpwent()) != NULL)
+		(void) addname(users, (int) pw->pw_uid, pw->pw_name);
+	endpwent();
+  }
+  return(idname(users, uid));
+}
+
+char *tw_group(gid)
+int gid;
+{
+/* Return the name of group gid. */
+  register struct group *gr;
+
+  if (!groups_read) {
+	groups_read = 1;
+	setgrent();
+	while ((gr = getgrent()) != NULL)
+		(void) addname(groups, (int) gr->gr_gid, gr->gr_name);
+	endgrent();
+  }
+  return(idname(groups, gid));
+}
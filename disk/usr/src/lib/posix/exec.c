@@ -6,6 +6,9 @@ extern char **environ;		/* environment pointer */
 
 #define	PTRSIZE	(sizeof(char *))
 
+PRIVATE _PROTOTYPE( char *frame, (char *stack, char **ap, char *hp,
+				char *limit, char **v, int n)		);
+
 PUBLIC int execl(name, arg0)
 char *name;
 char *arg0;
@@ -54,78 +57,89 @@ int nenvps;			/* number of environment strings */
 {
 /* This is split off from execve to be called from execvp, so execvp does not
  * have to allocate up to ARG_MAX bytes just to prepend "sh" to the arg array.
+ *
+ * The stack is built in one pass: ARG_MAX bytes are taken from the heap and
+ * the strings are copied straight in, their lengths found as they go.  The
+ * pointers are made relative to the start of the stack, and MM only has to
+ * add the address it puts the stack at.  Only if the break cannot be moved
+ * that far are the strings measured first, to take no more than is needed.
  */
 
-  char *hp, **ap, *p;
-  int i, stackbytes, npointers, overflow, temp;
+  char *hp, **ap, *limit;
+  int i, size, stackbytes, npointers, temp;
+  size_t slen;
   char *stack;
 
-  /* Decide how big a stack is needed. Be paranoid about overflow. */
+  /* Decide how many pointers are needed. Be paranoid about overflow. */
 #if ARG_MAX > INT_MAX
 #error /* overflow checks and sbrk depend on sizes being ints */
 #endif
-  overflow = FALSE;
-  npointers = 1 + nargs + 1 + nenvps + 1;	/* 1's for argc and NULLs */
-  stackbytes = nargs + nenvps;		/* for nulls in strings */
-  if (nargs < 0 || nenvps < 0 || stackbytes < nargs || npointers < stackbytes)
-	overflow = TRUE;
-  for (i = PTRSIZE; i != 0; i--) {
-	temp = stackbytes + npointers;
-	if (temp < stackbytes) overflow = TRUE;
-	stackbytes = temp;
-  }
-  for (i = 0, ap = argv; i < nargs; i++) {
-	temp = stackbytes + strlen(*ap++);
-	if (temp < stackbytes) overflow = TRUE;
-	stackbytes = temp;
-  }
-  for (i = 0, ap = envp; i < nenvps; i++) {
-	temp = stackbytes + strlen(*ap++);
-	if (temp < stackbytes) overflow = TRUE;
-	stackbytes = temp;
-  }
-  temp = stackbytes + PTRSIZE - 1;
-  if (temp < stackbytes) overflow = TRUE;
-  stackbytes = (temp / PTRSIZE) * PTRSIZE;
-
-  /* Check for overflow before committing sbrk. */
-  if (overflow || stackbytes > ARG_MAX) {
+  if (nargs < 0 || nenvps < 0 || nargs > ARG_MAX / PTRSIZE ||
+      nenvps > ARG_MAX / PTRSIZE ||
+      (npointers = 1 + nargs + 1 + nenvps + 1) > ARG_MAX / PTRSIZE) {
 	errno = E2BIG;
 	return(-1);
   }
 
   /* Allocate the stack. */
-  stack = sbrk(stackbytes);
-  if (stack == (char *) -1) {
-	errno = E2BIG;
-	return(-1);
+  size = ARG_MAX;
+  if ((stack = sbrk(size)) == (char *) -1) {
+	size = npointers * PTRSIZE;
+	for (i = 0; i < nargs + nenvps && size <= ARG_MAX; i++) {
+		slen = strlen(i < nargs ? argv[i] : envp[i - nargs]);
+		size = slen < ARG_MAX - size ? size + (int) slen + 1 : ARG_MAX + 1;
+	}
+	size = (size + PTRSIZE - 1) / PTRSIZE * PTRSIZE;
+	if (size > ARG_MAX || (stack = sbrk(size)) == (char *) -1) {
+		errno = E2BIG;
+		return(-1);
+	}
   }
+  limit = &stack[size];
 
-  /* Prepare the stack vector and argc. */
+  /* Prepare argc, the argument and environment pointers, and the strings. */
   ap = (char **) stack;
+  *ap = (char *) nargs;
   hp = &stack[npointers * PTRSIZE];
-  *ap++ = (char *) nargs;
-
-  /* Prepare the argument pointers and strings. */
-  for (i = 0; i < nargs; i++) {
-	*ap++ = (char *) (hp - stack);
-	p = *argv++;
-	while ((*hp++ = *p++) != 0)
-		;
-  }
-  *ap++ = (char *) NULL;
-
-  /* Prepare the environment pointers and strings. */
-  for (i = 0; i < nenvps; i++) {
-	*ap++ = (char *) (hp - stack);
-	p = *envp++;
-	while ((*hp++ = *p++) != 0)
-		;
+  hp = frame(stack, ap + 1, hp, limit, argv, nargs);
+  if (hp != (char *) NULL) hp = frame(stack, ap + 1 + nargs + 1, hp, limit,
+							envp, nenvps);
+  if (hp == (char *) NULL) {
+	sbrk(-size);
+	errno = E2BIG;
+	return(-1);
   }
-  *ap++ = (char *) NULL;
+  stackbytes = (hp - stack + PTRSIZE - 1) / PTRSIZE * PTRSIZE;
 
   /* Do the real work. */
   temp = callm1(MM, EXEC, len(path), stackbytes, 0, path, stack, NIL_PTR);
-  sbrk(-stackbytes);
+  sbrk(-size);
   return(temp);
 }
+
+
+PRIVATE char *frame(stack, ap, hp, limit, v, n)
+char *stack;			/* start of the stack being built */
+register char **ap;		/* where the pointers go */
+register char *hp;		/* where the strings go */
+char *limit;			/* end of the space for them */
+char **v;			/* the strings */
+int n;				/* how many there are */
+{
+/* Copy n strings to hp, putting their offsets from the stack at ap and a
+ * NULL after them.  Returns the end of the strings, or NULL if they do not
+ * fit.
+ */
+
+  register char *p;
+
+  while (n-- > 0) {
+	*ap++ = (char *) (hp - stack);
+	p = *v++;
+	do {
+		if (hp == limit) return((char *) NULL);
+	} while ((*hp++ = *p++) != 0);
+  }
+  *ap = (char *) NULL;
+  return(hp);
+}
@@ -6,7 +6,7 @@
 #include <dirent.h>
 #include <stddef.h>
 
-extern int getdents();		/* SVR3 system call, or emulation */
+extern int getdents();		/* system call; a batch of entries */
 
 #define DULL (DIR *) NULL
 #define CULL (char *) NULL
@@ -78,8 +78,8 @@ int (*call_vec[NCALLS])() = {
 	do_exec,	/* 59 = exece	*/
 	no_sys,		/* 60 = umask	*/
 	no_sys,		/* 61 = chroot	*/
-	no_sys,		/* 62 = unused	*/
-	no_sys,		/* 63 = unused	*/
+	no_sys,		/* 62 = getdents */
+	no_sys,		/* 63 = statat	*/
 
 	do_ksig,	/* 64 = KSIG: signals originating in the kernel	*/
 	no_sys,		/* 65 = UNPAUSE	*/
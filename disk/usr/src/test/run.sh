@@ -21,6 +21,16 @@ test18
 test19
 test20
 test21
+test22
+test23
+test24
+test25
+test26
+test27
+test28
+test29
+test30
+test31
 echo All system call tests completed.
 echo Try running sh1 and sh2.
 
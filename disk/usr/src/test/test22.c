@@ -0,0 +1,312 @@
+/* test 22 */
+
+/* The following library routines are tested:
+ *
+ *	memcpy()	memmove()	memset()	memcmp()
+ *	memchr()	strlen()	strcpy()	strcmp()
+ *
+ * They move and compare a long at a time in the middle of an area, so
+ * every combination of alignment and of length around a few longs is tried
+ * against a simple byte loop.  "test22 -b" also times each routine against
+ * the byte loop; the ratio is independent of the clock rate.
+ *
+ * The test also runs on a host, against the MINIX routines rather than the
+ * host's.  From this directory:
+ *
+ *	cc -c -fno-builtin -nostdinc -I../../include ../lib/ansi/mem*.c \
+ *		../lib/ansi/strlen.c ../lib/ansi/strcpy.c ../lib/ansi/strcmp.c
+ *	cc -fno-builtin -o test22 test22.c mem*.o str*.o
+ */
+
+#include <sys/types.h>
+#include <sys/times.h>
+#include <string.h>
+#include <stdio.h>
+
+#define MAX_ERROR 4
+#define AREA	  160		/* bytes in a test area */
+#define NALIGN	    8		/* alignments tried */
+#define NLEN	   72		/* lengths tried */
+#define BENCH	 4096		/* bytes per benchmark call */
+
+int errct;
+int subtest;
+
+char a[AREA + 2*NALIGN], b[AREA + 2*NALIGN];
+char ra[AREA + 2*NALIGN], rb[AREA + 2*NALIGN];
+char big1[BENCH + NALIGN], big2[BENCH + NALIGN];
+long sink;			/* keeps results of timed calls alive */
+
+main(argc, argv)
+int argc;
+char *argv[];
+{
+  printf("Test 22 ");
+  fflush(stdout);
+  test22a();
+  test22b();
+  test22c();
+  test22d();
+  if (errct == 0)
+	printf("ok\n");
+  else
+	printf(" %d errors\n", errct);
+  if (argc == 2 && strcmp(argv[1], "-b") == 0) bench();
+  exit(0);
+}
+
+fill(p, n, seed)
+char *p;
+int n, seed;
+{
+  while (n-- > 0) {
+	seed = seed * 13 + 7;
+	*p++ = (seed >> 3) | 1;		/* no NULs; some look negative */
+  }
+}
+
+sign(n)
+int n;
+{
+  return(n < 0 ? -1 : n > 0 ? 1 : 0);
+}
+
+test22a()
+{
+/* memcpy, memmove and memset against byte loops. */
+
+  int sa, da, len, i;
+  char *r;
+
+  subtest = 1;
+  for (sa = 0; sa < NALIGN; sa++)
+  for (da = 0; da < NALIGN; da++)
+  for (len = 0; len < NLEN; len++) {
+	fill(a, sizeof(a), len);
+	fill(b, sizeof(b), len + 1);
+	memcpy(rb, b, sizeof(b));
+	for (i = 0; i < len; i++) rb[da + i] = a[sa + i];
+	r = memcpy(b + da, a + sa, (size_t) len);
+	if (r != b + da) e(1);
+	if (memcmp(b, rb, sizeof(b)) != 0) e(2);
+
+	fill(b, sizeof(b), len + 2);
+	memset(rb, 0, sizeof(rb));
+	for (i = 0; i < sizeof(b); i++) rb[i] = b[i];
+	for (i = 0; i < len; i++) rb[da + i] = (char) (sa + 0x80);
+	r = memset(b + da, sa + 0x80, (size_t) len);
+	if (r != b + da) e(3);
+	for (i = 0; i < sizeof(b); i++) if (b[i] != rb[i]) e(4);
+  }
+
+  /* Overlapping moves in both directions. */
+  for (sa = 0; sa < 2*NALIGN; sa++)
+  for (da = 0; da < 2*NALIGN; da++)
+  for (len = 0; len < NLEN; len++) {
+	fill(a, sizeof(a), len);
+	memcpy(ra, a, sizeof(a));
+	for (i = 0; i < len; i++) rb[i] = a[sa + i];
+	for (i = 0; i < len; i++) ra[da + i] = rb[i];
+	memmove(a + da, a + sa, (size_t) len);
+	for (i = 0; i < sizeof(a); i++) if (a[i] != ra[i]) e(5);
+  }
+}
+
+test22b()
+{
+/* memcmp and strcmp. */
+
+  int sa, da, len, diff, i, r, s;
+
+  subtest = 2;
+  for (sa = 0; sa < NALIGN; sa++)
+  for (da = 0; da < NALIGN; da++)
+  for (len = 1; len < NLEN; len++)
+  for (diff = -1; diff < len; diff += 1 + len / 8) {
+	fill(a + sa, len, len);
+	fill(b + da, len, len);
+	if (diff >= 0) b[da + diff] = (diff & 1) ? 'A' : (char) 0xF0;
+	r = 0;
+	for (i = 0; i < len; i++)
+		if (a[sa + i] != b[da + i]) {
+			r = a[sa + i] - b[da + i];
+			break;
+		}
+	if (sign(memcmp(a + sa, b + da, (size_t) len)) != sign(r)) e(1);
+
+	a[sa + len] = 0;
+	b[da + len] = 0;
+	s = strcmp(a + sa, b + da);
+	if (sign(s) != sign(r)) e(2);
+	if (diff == -1 && len > 1) {
+		b[da + len - 1] = 0;	/* b is a prefix of a */
+		if (strcmp(a + sa, b + da) <= 0) e(3);
+		if (strcmp(b + da, a + sa) >= 0) e(4);
+	}
+  }
+}
+
+test22c()
+{
+/* strlen and strcpy. */
+
+  int sa, da, len, i;
+  char *r;
+
+  subtest = 3;
+  for (sa = 0; sa < NALIGN; sa++)
+  for (da = 0; da < NALIGN; da++)
+  for (len = 0; len < NLEN; len++) {
+	fill(a, sizeof(a), len);
+	a[sa + len] = 0;
+	if (strlen(a + sa) != len) e(1);
+	fill(b, sizeof(b), len + 3);
+	memcpy(rb, b, sizeof(b));
+	for (i = 0; i <= len; i++) rb[da + i] = a[sa + i];
+	r = strcpy(b + da, a + sa);
+	if (r != b + da) e(2);
+	for (i = 0; i < sizeof(b); i++) if (b[i] != rb[i]) e(3);
+  }
+}
+
+test22d()
+{
+/* memchr. */
+
+  int sa, len, pos;
+  char *r, *want;
+
+  subtest = 4;
+  for (sa = 0; sa < NALIGN; sa++)
+  for (len = 0; len < NLEN; len++)
+  for (pos = -1; pos < len + 2; pos++) {
+	fill(a, sizeof(a), len);
+	if (pos >= 0) a[sa + pos] = (char) 0x80;
+	if (pos >= 0) a[sa + pos + 1] = (char) 0x80;
+	want = (pos >= 0 && pos < len) ? a + sa + pos : (char *) NULL;
+	r = memchr(a + sa, 0x80, (size_t) len);
+	if (r != want) e(1);
+	r = memchr(a + sa, 0x180, (size_t) len);	/* only the byte counts */
+	if (r != want) e(2);
+  }
+}
+
+/* Benchmark.  Each routine is timed on BENCH bytes, aligned and not, against
+ * the byte loop the library used to have.
+ */
+long ticks()
+{
+  struct tms t;
+
+  times(&t);
+  return(t.tms_utime);
+}
+
+char *bytecpy(d, s, n)
+register char *d, *s;
+register int n;
+{
+  char *r = d;
+
+  while (n-- > 0) *d++ = *s++;
+  return(r);
+}
+
+char *byteset(d, c, n)
+register char *d;
+register int c, n;
+{
+  char *r = d;
+
+  while (n-- > 0) *d++ = c;
+  return(r);
+}
+
+int bytecmp(s1, s2, n)
+register char *s1, *s2;
+register int n;
+{
+  for (; n > 0; n--, s1++, s2++) if (*s1 != *s2) return(*s1 - *s2);
+  return(0);
+}
+
+int bytelen(s)
+register char *s;
+{
+  register int n = 0;
+
+  while (*s++ != 0) n++;
+  return(n);
+}
+
+report(what, fast, slow)
+char *what;
+long fast, slow;
+{
+  printf("%-16s %6ld %6ld", what, fast, slow);
+  if (fast > 0) printf("  %ld.%ldx", slow / fast, (slow * 10 / fast) % 10);
+  printf("\n");
+}
+
+bench()
+{
+  long t, fast, slow, reps;
+  int off, i;
+
+  reps = 200;
+  do {
+	reps *= 2;
+	t = ticks();
+	for (i = 0; i < reps; i++) bytecpy(big1, big2, BENCH);
+  } while (ticks() - t < 30);
+
+  printf("\n%ld calls on %d bytes, user ticks: library, byte loop\n",
+							reps, BENCH);
+  for (off = 0; off < 2; off++) {
+	printf("%s\n", off == 0 ? "aligned" : "source off by one");
+
+	t = ticks();
+	for (i = 0; i < reps; i++) memcpy(big1, big2 + off, BENCH);
+	fast = ticks() - t;
+	t = ticks();
+	for (i = 0; i < reps; i++) bytecpy(big1, big2 + off, BENCH);
+	slow = ticks() - t;
+	report("memcpy", fast, slow);
+
+	t = ticks();
+	for (i = 0; i < reps; i++) memset(big1 + off, 'x', BENCH);
+	fast = ticks() - t;
+	t = ticks();
+	for (i = 0; i < reps; i++) byteset(big1 + off, 'x', BENCH);
+	slow = ticks() - t;
+	report("memset", fast, slow);
+
+	memset(big2, 'x', sizeof(big2));
+	t = ticks();
+	for (i = 0; i < reps; i++) sink += memcmp(big1 + off, big2, BENCH);
+	fast = ticks() - t;
+	t = ticks();
+	for (i = 0; i < reps; i++) sink += bytecmp(big1 + off, big2, BENCH);
+	slow = ticks() - t;
+	report("memcmp", fast, slow);
+
+	big1[off + BENCH - 1] = 0;
+	t = ticks();
+	for (i = 0; i < reps; i++) sink += strlen(big1 + off);
+	fast = ticks() - t;
+	t = ticks();
+	for (i = 0; i < reps; i++) sink += bytelen(big1 + off);
+	slow = ticks() - t;
+	report("strlen", fast, slow);
+  }
+}
+
+e(n)
+int n;
+{
+  printf("Subtest %d,  error %d\n", subtest, n);
+  if (errct++ > MAX_ERROR) {
+	printf("Too many errors; test aborted\n");
+	exit(1);
+  }
+}
@@ -0,0 +1,294 @@
+/* test 23 */
+
+/* The following library routines are tested:
+ *
+ *	malloc()	free()		realloc()	calloc()
+ *	mallinfo()
+ *
+ * A pseudo-random mix of calls fills every block with a pattern and checks
+ * it is intact when the block is freed or resized, and that mallinfo() adds
+ * up.  With an argument, the allocator is timed instead:
+ *
+ *	test23 -b		replay the built-in workloads, which mimic
+ *				the calls made by make, sh and diff
+ *	test23 -t file		replay a trace written by a malloc.c compiled
+ *				with TRACE defined; other lines are skipped
+ *
+ * As with test 22, the test can be run on a host against the MINIX malloc.
+ * The host's <malloc.h> has its own struct mallinfo, so ours is copied:
+ *
+ *	cc -c -fno-builtin -nostdinc -I../../include ../lib/ansi/malloc.c \
+ *		../lib/ansi/memcpy.c ../lib/ansi/memset.c
+ *	mkdir h; cp ../../include/malloc.h ../../include/ansi.h h
+ *	cc -fno-builtin -Ih -o test23 test23.c malloc.o memcpy.o memset.o
+ */
+
+#include <sys/types.h>
+#include <sys/times.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <stdio.h>
+
+#define MAX_ERROR  4
+#define NSLOTS   200		/* blocks live at once */
+#define NCALLS  4000		/* calls in the mixed test */
+#define NTRACE   512		/* blocks live at once in a replay */
+
+int errct;
+int subtest;
+
+char *slot[NSLOTS];
+unsigned slotlen[NSLOTS];
+unsigned long seed = 1;
+
+char *live[NTRACE];		/* replay: the blocks */
+unsigned long addr[NTRACE];	/* replay: their addresses in the trace */
+long ncalls;
+long inuse;			/* bytes in use before the test */
+
+main(argc, argv)
+int argc;
+char *argv[];
+{
+  printf("Test 23 ");
+  fflush(stdout);
+  test23a();
+  test23b();
+  if (errct == 0)
+	printf("ok\n");
+  else
+	printf(" %d errors\n", errct);
+  if (argc == 2 && strcmp(argv[1], "-b") == 0) bench();
+  if (argc == 3 && strcmp(argv[1], "-t") == 0) replay(argv[2]);
+  exit(0);
+}
+
+unsigned rnd(n)
+unsigned n;
+{
+  seed = seed * 1103515245L + 12345;
+  return((unsigned) ((seed >> 16) & 0x7FFF) % n);
+}
+
+pattern(i)
+int i;
+{
+  return((i * 7 + 3) & 0xFF);
+}
+
+check(i)
+int i;
+{
+/* Is block i still intact? */
+
+  register unsigned k;
+
+  for (k = 0; k < slotlen[i]; k++)
+	if ((slot[i][k] & 0xFF) != pattern(i)) {
+		e(1);
+		return;
+	}
+}
+
+test23a()
+{
+/* Random malloc, free, realloc and calloc, small and large. */
+
+  int i, n;
+  unsigned len;
+
+  subtest = 1;
+  inuse = mallinfo().uordblks;
+  for (n = 0; n < NCALLS; n++) {
+	i = rnd(NSLOTS);
+	if (slot[i] != NULL) {
+		check(i);
+		if (rnd(4) == 0) {
+			len = rnd(3) == 0 ? rnd(2000) : rnd(100);
+			slot[i] = realloc(slot[i], len);
+			if (slot[i] == NULL) e(2);
+			if (len < slotlen[i]) slotlen[i] = len;
+			check(i);
+			memset(slot[i], pattern(i), len);
+			slotlen[i] = len;
+		} else {
+			free(slot[i]);
+			slot[i] = NULL;
+		}
+		continue;
+	}
+	len = rnd(8) == 0 ? rnd(3000) : rnd(120);
+	if (rnd(5) == 0) {
+		slot[i] = calloc(len, 1);
+		if (slot[i] == NULL) e(3);
+		for (slotlen[i] = 0; slotlen[i] < len; slotlen[i]++)
+			if (slot[i][slotlen[i]] != 0) e(4);
+	} else {
+		slot[i] = malloc(len);
+		if (slot[i] == NULL) e(5);
+	}
+	memset(slot[i], pattern(i), len);
+	slotlen[i] = len;
+  }
+  for (i = 0; i < NSLOTS; i++) {
+	if (slot[i] != NULL) check(i);
+	free(slot[i]);			/* also free(NULL) */
+	slot[i] = NULL;
+  }
+  free((char *) NULL);
+}
+
+test23b()
+{
+/* Mallinfo: what test23a allocated is free now, and the parts add up. */
+
+  struct mallinfo mi;
+  char *p;
+
+  subtest = 2;
+  mi = mallinfo();
+  if (mi.arena <= 0) e(1);
+  if (mi.uordblks + mi.fordblks + mi.fsmblks != mi.arena) e(2);
+  if (mi.uordblks != inuse) e(3);
+  p = malloc(10);
+  mi = mallinfo();
+  if (mi.uordblks < 10) e(4);
+  free(p);
+  if (mallinfo().smblks < 1) e(5);	/* kept in a bin */
+}
+
+/* Timing. */
+long ticks()
+{
+  struct tms t;
+
+  times(&t);
+  return(t.tms_utime);
+}
+
+report(what, t)
+char *what;
+long t;
+{
+  struct mallinfo mi;
+
+  mi = mallinfo();
+  printf("%-8s %7ld calls %5ld ticks  arena %6ld  free %6ld + %6ld in bins\n",
+	 what, ncalls, t, mi.arena, mi.fordblks, mi.fsmblks);
+  ncalls = 0;
+}
+
+bench()
+{
+  long t;
+  int round, i, j;
+  char *p, *names[NTRACE];
+
+  printf("\n");
+
+  /* make: names and dependency records, kept to the end. */
+  t = ticks();
+  for (round = 0; round < 20; round++) {
+	for (i = 0; i < NTRACE; i++) {
+		names[i] = malloc(8 + rnd(24));
+		p = malloc(12);
+		*(char **) p = names[i];
+		live[i] = p;
+		ncalls += 2;
+	}
+	for (i = 0; i < NTRACE; i++) {
+		free(names[i]);
+		free(live[i]);
+		ncalls += 2;
+	}
+  }
+  report("make", ticks() - t);
+
+  /* sh: words of a command line, freed when the command is done. */
+  t = ticks();
+  for (round = 0; round < 2000; round++) {
+	j = 2 + rnd(10);
+	for (i = 0; i < j; i++) live[i] = malloc(4 + rnd(60));
+	for (i = j - 1; i >= 0; i--) free(live[i]);
+	ncalls += 2 * j;
+  }
+  report("sh", ticks() - t);
+
+  /* diff: a growing line table and a small record per line. */
+  t = ticks();
+  for (round = 0; round < 10; round++) {
+	p = malloc(16 * sizeof(long));
+	for (i = 0; i < NTRACE; i++) {
+		if ((i & 15) == 15) {
+			p = realloc(p, (i + 17) * sizeof(long));
+			ncalls++;
+		}
+		live[i] = malloc(6 + rnd(70));
+	}
+	for (i = 0; i < NTRACE; i++) free(live[i]);
+	free(p);
+	ncalls += 2 * NTRACE + 2;
+  }
+  report("diff", ticks() - t);
+}
+
+replay(file)
+char *file;
+{
+/* Replay "m size addr", "f addr" and "r addr size newaddr" lines. */
+
+  FILE *f;
+  char line[80];
+  unsigned long a, b;
+  unsigned size;
+  int i, skipped;
+  long t;
+
+  if ((f = fopen(file, "r")) == NULL) {
+	perror(file);
+	return;
+  }
+  skipped = 0;
+  t = ticks();
+  while (fgets(line, sizeof(line), f) != NULL) {
+	if (line[0] == 'm' && sscanf(line + 1, "%u %lx", &size, &a) == 2) {
+		if ((i = find(0L)) < 0) { skipped++; continue; }
+		live[i] = malloc(size);
+		addr[i] = a;
+	} else if (line[0] == 'f' && sscanf(line + 1, "%lx", &a) == 1) {
+		if ((i = find(a)) < 0) { skipped++; continue; }
+		free(live[i]);
+		addr[i] = 0;
+	} else if (line[0] == 'r' &&
+		   sscanf(line + 1, "%lx %u %lx", &a, &size, &b) == 3) {
+		if ((i = find(a)) < 0) { skipped++; continue; }
+		live[i] = realloc(live[i], size);
+		addr[i] = b;
+	} else
+		continue;
+	ncalls++;
+  }
+  fclose(f);
+  report("trace", ticks() - t);
+  if (skipped != 0) printf("%d calls skipped\n", skipped);
+}
+
+int find(a)
+unsigned long a;
+{
+  register int i;
+
+  for (i = 0; i < NTRACE; i++) if (addr[i] == a) return(i);
+  return(-1);
+}
+
+e(n)
+int n;
+{
+  printf("Subtest %d,  error %d\n", subtest, n);
+  if (errct++ > MAX_ERROR) {
+	printf("Too many errors; test aborted\n");
+	exit(1);
+  }
+}
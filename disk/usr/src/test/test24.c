@@ -0,0 +1,364 @@
+/* test 24 */
+
+/* The following library routine is tested:
+ *
+ *	qsort()
+ *
+ * Arrays of every length up to a few partitions, in several orders and with
+ * elements of several widths and alignments, must come out sorted and still
+ * hold the same elements.  An adversary that decides the outcome of each
+ * comparison as late as it can must not drive the number of comparisons
+ * anywhere near quadratic.  "test24 -b" times qsort() against the library's
+ * previous qsort on sorted, reversed, random and few-valued input, and
+ * counts the comparisons made.
+ *
+ * As with test 22, the test can be run on a host against the MINIX qsort:
+ *
+ *	cc -c -fno-builtin -nostdinc -I../../include ../lib/ansi/qsort.c
+ *	cc -fno-builtin -o test24 test24.c qsort.o
+ */
+
+#include <sys/types.h>
+#include <sys/times.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#define MAX_ERROR 4
+#define MAXN	  300		/* longest array in the sorting test */
+#define MAXW	   12		/* widest element */
+#define NKILL	 2000		/* elements the adversary gets */
+#define NBENCH	 4000		/* elements in a timed sort */
+
+int errct;
+int subtest;
+
+char area[MAXN * MAXW + sizeof(long)];
+int count[256];
+long ncmp;			/* comparisons made */
+unsigned long seed = 1;
+
+int val[NKILL];			/* the adversary's values */
+int idx[NKILL];
+int gas, nsolid, candidate;
+
+long bench1[NBENCH], bench2[NBENCH];
+
+main(argc, argv)
+int argc;
+char *argv[];
+{
+  printf("Test 24 ");
+  fflush(stdout);
+  test24a();
+  test24b();
+  if (errct == 0)
+	printf("ok\n");
+  else
+	printf(" %d errors\n", errct);
+  if (argc == 2 && strcmp(argv[1], "-b") == 0) bench();
+  exit(0);
+}
+
+unsigned rnd(n)
+unsigned n;
+{
+  seed = seed * 1103515245L + 12345;
+  return((unsigned) ((seed >> 16) & 0x7FFF) % n);
+}
+
+/* An element of width w holding v has v in its first byte and a simple
+ * function of v in the rest, so that the whole element must move together.
+ */
+int width;
+
+cmpelem(a, b)
+char *a, *b;
+{
+  ncmp++;
+  return((*a & 0xFF) - (*b & 0xFF));
+}
+
+put(p, v)
+char *p;
+int v;
+{
+  int k;
+
+  for (k = 0; k < width; k++) p[k] = v + k * 37;
+}
+
+int get(p)
+char *p;
+{
+/* The value in the element at p, or -1 if its bytes do not agree. */
+
+  int k;
+
+  for (k = 1; k < width; k++)
+	if ((p[k] & 0xFF) != ((p[0] + k * 37) & 0xFF)) return(-1);
+  return(p[0] & 0xFF);
+}
+
+pick(order, i, n)
+int order, i, n;
+{
+/* Value i of n in the given order. */
+
+  switch (order) {
+    case 0:	return(rnd(256));			/* random */
+    case 1:	return(i * 255 / n);			/* sorted */
+    case 2:	return(255 - i * 255 / n);		/* reversed */
+    case 3:	return(rnd(3));				/* few values */
+    case 4:	return(i < n / 2 ? i : n - i);		/* organ pipe */
+    case 5:	return(i % 2 ? i & 0xFF : 17);		/* every other */
+    default:	return(42);				/* all equal */
+  }
+}
+
+test24a()
+{
+/* Sort and check. */
+
+  static int widths[] = { 1, 2, 3, sizeof(short), sizeof(long),
+			  sizeof(char *), 6, MAXW };
+  int wi, off, order, n, i, v;
+  char *base;
+
+  subtest = 1;
+  for (wi = 0; wi < sizeof(widths) / sizeof(widths[0]); wi++)
+  for (off = 0; off < 2; off++)
+  for (order = 0; order < 7; order++)
+  for (n = 0; n <= MAXN; n += (n < 40 ? 1 : 37)) {
+	width = widths[wi];
+	base = area + off;
+	memset((char *) count, 0, sizeof(count));
+	for (i = 0; i < n; i++) {
+		v = pick(order, i, n) & 0xFF;
+		put(base + i * width, v);
+		count[v]++;
+	}
+	qsort(base, (size_t) n, (size_t) width, cmpelem);
+	for (i = 0; i < n; i++) {
+		if ((v = get(base + i * width)) < 0) {
+			e(1);		/* element torn apart */
+			break;
+		}
+		if (--count[v] < 0) e(2);	/* not the same elements */
+		if (i > 0 && cmpelem(base + (i-1) * width, base + i * width) > 0)
+			e(3);		/* not sorted */
+	}
+  }
+}
+
+/* The adversary.  All values start as "gas", which compares high; when two
+ * gas values are compared, one of them, preferably the last pivot candidate,
+ * is frozen to the next solid value.  (M. D. McIlroy, "A killer adversary
+ * for quicksort", Software--Practice and Experience, 1999.)
+ */
+cmpkill(a, b)
+int *a, *b;
+{
+  int x = *a, y = *b;
+
+  ncmp++;
+  if (val[x] == gas && val[y] == gas)
+	if (x == candidate) val[x] = nsolid++; else val[y] = nsolid++;
+  if (val[x] == gas)
+	candidate = x;
+  else if (val[y] == gas)
+	candidate = y;
+  return(val[x] < val[y] ? -1 : val[x] > val[y] ? 1 : 0);
+}
+
+test24b()
+{
+/* No quadratic behaviour. */
+
+  int i, n, lg;
+
+  subtest = 2;
+  for (n = 100; n <= NKILL; n *= 2) {
+	gas = n;
+	nsolid = 0;
+	candidate = 0;
+	for (i = 0; i < n; i++) {
+		val[i] = gas;
+		idx[i] = i;
+	}
+	ncmp = 0;
+	qsort((char *) idx, (size_t) n, sizeof(int), cmpkill);
+	for (lg = 0, i = n; i > 1; i >>= 1) lg++;
+	if (ncmp > 4L * n * (lg + 1)) e(1);
+	for (i = 1; i < n; i++) if (val[idx[i-1]] > val[idx[i]]) e(2);
+  }
+}
+
+/* Benchmark. */
+long ticks()
+{
+  struct tms t;
+
+  times(&t);
+  return(t.tms_utime);
+}
+
+cmplong(a, b)
+long *a, *b;
+{
+  ncmp++;
+  return(*a < *b ? -1 : *a > *b ? 1 : 0);
+}
+
+report(what, n, fast, fcmp, slow, scmp)
+char *what;
+int n;
+long fast, fcmp, slow, scmp;
+{
+  printf("%-10s %5d %6ld %8ld %6ld %8ld\n", what, n, fast, fcmp, slow, scmp);
+}
+
+bench()
+{
+  static char *what[] = { "random", "sorted", "reversed", "few" };
+  long t, fast, fcmp, slow, scmp;
+  int order, i, n, rep, reps;
+
+  printf("\n%-10s %5s %6s %8s %6s %8s\n", "input", "n",
+	 "ticks", "compares", "old", "compares");
+  for (n = NBENCH / 16; n <= NBENCH; n *= 4) {
+	reps = NBENCH / n * 4;
+	for (order = 0; order < 4; order++) {
+		fast = slow = fcmp = scmp = 0;
+		for (rep = 0; rep < reps; rep++) {
+			for (i = 0; i < n; i++) switch (order) {
+			    case 0: bench1[i] = (long) rnd(32768) << 15 |
+								rnd(32768);
+				    break;
+			    case 1: bench1[i] = i; break;
+			    case 2: bench1[i] = n - i; break;
+			    case 3: bench1[i] = rnd(4); break;
+			}
+			memcpy((char *) bench2, (char *) bench1,
+						n * sizeof(long));
+			ncmp = 0;
+			t = ticks();
+			qsort((char *) bench1, (size_t) n, sizeof(long),
+								cmplong);
+			fast += ticks() - t;
+			fcmp += ncmp;
+			ncmp = 0;
+			t = ticks();
+			oldqsort((char *) bench2, (size_t) n, sizeof(long),
+								cmplong);
+			slow += ticks() - t;
+			scmp += ncmp;
+			if (memcmp((char *) bench1, (char *) bench2,
+						n * sizeof(long)) != 0) e(9);
+		}
+		report(what[order], n, fast, fcmp / reps, slow, scmp / reps);
+	}
+  }
+}
+
+/* The previous library qsort, for comparison. */
+int (*oqcompar)();
+
+oldqsort(base, nel, width, compar)
+char *base;
+size_t nel, width;
+int (*compar)();
+{
+  oqcompar = compar;
+  if (nel > 0)
+	oqsort1(base, base + (nel - 1) * width, (int) width);
+}
+
+oqsort1(a1, a2, width)
+char *a1, *a2;
+register int width;
+{
+  register char *left, *right;
+  register char *lefteq, *righteq;
+  int cmp;
+
+  for (;;) {
+	if (a2 <= a1) return;
+	left = a1;
+	right = a2;
+	lefteq = righteq = a1 + width * (((a2 - a1) + width) / (2 * width));
+again:
+	while (left < lefteq && (cmp = (*oqcompar) (left, lefteq)) <= 0) {
+		if (cmp < 0) {
+			left += width;
+		} else {
+			lefteq -= width;
+			oqexchange(left, lefteq, width);
+		}
+	}
+	while (right > righteq) {
+		if ((cmp = (*oqcompar) (right, righteq)) < 0) {
+			if (left < lefteq) {
+				oqexchange(left, right, width);
+				left += width;
+				right -= width;
+				goto again;
+			}
+			righteq += width;
+			oq3exchange(left, righteq, right, width);
+			lefteq += width;
+			left = lefteq;
+		} else if (cmp == 0) {
+			righteq += width;
+			oqexchange(right, righteq, width);
+		} else
+			right -= width;
+	}
+	if (left < lefteq) {
+		lefteq -= width;
+		oq3exchange(right, lefteq, left, width);
+		righteq -= width;
+		right = righteq;
+		goto again;
+	}
+	oqsort1(a1, lefteq - width, width);
+	a1 = righteq + width;
+  }
+}
+
+oqexchange(p, q, n)
+register char *p, *q;
+register int n;
+{
+  register int c;
+
+  while (n-- > 0) {
+	c = *p;
+	*p++ = *q;
+	*q++ = c;
+  }
+}
+
+oq3exchange(p, q, r, n)
+register char *p, *q, *r;
+register int n;
+{
+  register int c;
+
+  while (n-- > 0) {
+	c = *p;
+	*p++ = *r;
+	*r++ = *q;
+	*q++ = c;
+  }
+}
+
+e(n)
+int n;
+{
+  printf("Subtest %d,  error %d\n", subtest, n);
+  if (errct++ > MAX_ERROR) {
+	printf("Too many errors; test aborted\n");
+	exit(1);
+  }
+}
@@ -0,0 +1,464 @@
+/* test 25 */
+
+/* The following library routines are tested:
+ *
+ *	initscr()	refresh()	move()		addstr()
+ *	clrtoeol()	clrtobot()	standout()	standend()
+ *
+ * Editing sessions are played through curses on three terminals: the MINIX
+ * console, which can insert and delete lines; a vt100-like terminal with a
+ * scrolling region; and a terminal that can only clear the screen and move
+ * the cursor.  The output goes to a file and is run through a small ANSI
+ * terminal emulator, whose screen must match what curses was told to show
+ * after every refresh().  "test25 -b" prints the bytes sent for each
+ * session, next to what the earlier curses, which sent a cm for every
+ * changed run, would have sent.
+ *
+ * The test can be run on a host, against the MINIX curses, termcap and
+ * putc(); printf() and exit() are left to the host, which needs only the
+ * __cleanup hook of exit.c.  From this directory:
+ *
+ *	cc -c -fno-builtin -nostdinc -I../../include -D_MINIX -D_POSIX_SOURCE \
+ *		test25.c ../lib/other/curses.c ../lib/other/termcap.c \
+ *		../lib/ansi/fputc.c ../lib/ansi/fflush.c ../lib/ansi/ctype.c \
+ *		../lib/other/printdat.c ../lib/other/cleanup.c
+ *	echo 'void (*__cleanup)();' >hook.c
+ *	cc -o test25 *.o hook.c
+ */
+
+#include <sys/types.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <curses.h>
+#include <stdio.h>
+
+#define MAX_ERROR 4
+#define ROWS	24		/* as in curses */
+#define COLS	80
+#define LINES	25		/* most lines on an emulated terminal */
+#define NTEXT  200		/* lines in the text being looked at */
+#define TEXTW	72		/* longest of them */
+#define PAGE	(ROWS - 1)	/* text lines on the screen */
+
+extern char nscrn[ROWS][COLS];	/* what curses shows after refresh() */
+
+char *term[] = {
+  "mx|minix:li#25:co#80:bs:cl=\\E[H\\E[0J:cm=\\E[%i%d;%dH:so=\\E[7m:se=\\E[0m:\
+ce=\\E[K:al=\\E[L:dl=\\E[M:sr=\\EM:ho=\\E[H:up=\\E[A:do=\\E[B:nd=\\E[C:le=^H:",
+  "vt|vt100:li#24:co#80:cl=\\E[H\\E[0J:cm=\\E[%i%d;%dH:so=\\E[7m:se=\\E[0m:\
+ce=\\E[K:cs=\\E[%i%d;%dr:sf=^J:sr=\\EM:ho=\\E[H:up=\\E[A:do=^J:nd=\\E[C:le=^H:",
+  "cm|dumb:li#24:co#80:cl=\\E[H\\E[0J:cm=\\E[%i%d;%dH:so=\\E[7m:se=\\E[0m:",
+};
+#define NTERM	(sizeof(term) / sizeof(term[0]))
+
+char *session[] = { "more", "edit", "type" };
+#define NSESSION (sizeof(session) / sizeof(session[0]))
+
+int errct;
+int subtest;
+int err[MAX_ERROR], nerr;	/* errors in this session */
+int bench;
+
+char text[NTEXT][TEXTW + 1];
+char envterm[16], envcap[300];
+char tmpname[] = "/tmp/t25.XXXXXX";
+int savefd, rfd;
+long sent, oldsent;
+
+/* The emulator. */
+char scr[LINES][COLS];
+int ey, ex, etop, ebot, emode, elines;
+int state, npar, par[4];
+
+main(argc, argv)
+int argc;
+char *argv[];
+{
+  int t, s;
+
+  printf("Test 25 ");
+  fflush(stdout);
+  bench = (argc == 2 && strcmp(argv[1], "-b") == 0);
+  maketext();
+  mktemp(tmpname);
+  for (t = 0; t < NTERM; t++) {
+	subtest = t + 1;
+	for (s = 0; s < NSESSION; s++) {
+		start(t);
+		switch (s) {
+		    case 0:	more();		break;
+		    case 1:	edit();		break;
+		    case 2:	type();		break;
+		}
+		stop();
+		report();
+		if (bench) {
+			if (t == 0 && s == 0) printf("\n");
+			printf("%-6s %-6s %7ld bytes, was %7ld\n",
+				session[s], envterm + 5, sent, oldsent);
+		}
+		if (t < NTERM - 1 && sent > oldsent) e(1);
+		report();
+	}
+  }
+  unlink(tmpname);
+  if (errct == 0)
+	printf("ok\n");
+  else
+	printf(" %d errors\n", errct);
+  exit(0);
+}
+
+maketext()
+{
+  static char *word[] = { "the", "buffer", "cache", "is", "a", "list",
+	"of", "blocks", "and", "each", "inode", "has", "zones", "which",
+	"are", "read", "when", "needed", "by", "file", "system", "in",
+	"order", "to", "keep", "disk", "busy", "while", "process", "waits" };
+  unsigned long seed = 7;
+  int i, n, w;
+
+  for (i = 0; i < NTEXT; i++) {
+	text[i][0] = 0;
+	if (i % 9 == 8) continue;			/* some blank lines */
+	n = (i % 7 == 0) ? 8 : 0;			/* some indented */
+	memset(text[i], ' ', n);
+	text[i][n] = 0;
+	for (;;) {
+		seed = seed * 1103515245L + 12345;
+		w = (int) ((seed >> 16) & 0x7FFF) % 30;
+		if (strlen(text[i]) + strlen(word[w]) + 1 > TEXTW - i % 23)
+			break;
+		strcat(text[i], word[w]);
+		strcat(text[i], " ");
+	}
+  }
+}
+
+/* Start and stop a session on terminal t. */
+start(t)
+int t;
+{
+  char *p;
+  int k;
+
+  fflush(stdout);
+  strcpy(envterm, "TERM=");
+  for (p = term[t], k = 5; *p != '|'; ) envterm[k++] = *p++;
+  envterm[k] = 0;
+  strcpy(envcap, "TERMCAP=");
+  strcat(envcap, term[t]);
+  putenv(envterm);
+  putenv(envcap);
+  elines = (t == 0) ? 25 : 24;
+
+  savefd = dup(1);
+  close(1);
+  if (creat(tmpname, 0600) != 1) e(90);
+  if ((rfd = open(tmpname, O_RDONLY)) < 0) e(91);
+  memset(scr[0], ' ', sizeof(scr));
+  ey = ex = etop = emode = state = 0;
+  ebot = elines - 1;
+  sent = oldsent = 0;
+
+  initscr();
+  fflush(stdout);
+  emulate();
+  sent = 0;
+}
+
+stop()
+{
+  fflush(stdout);
+  close(1);
+  dup(savefd);
+  close(savefd);
+  close(rfd);
+}
+
+/* Refresh, check and count. */
+update()
+{
+  int i, j;
+  char newrow, newcol;
+
+  oldsent += oldcost();
+  newrow = row;
+  newcol = col;
+  refresh();
+  emulate();
+  for (i = 0; i < ROWS; i++)
+	for (j = 0; j < COLS; j++)
+		if (scr[i][j] != nscrn[i][j]) {
+			e(2);
+			return;
+		}
+  for (; i < elines; i++)
+	for (j = 0; j < COLS; j++) if (scr[i][j] != ' ') e(3);
+  if (ey != newrow || ex != newcol) e(4);
+}
+
+int oldcost()
+{
+/* The bytes the old refresh() sent: a cm for every run that changed. */
+
+  int i, j, n, m;
+
+  n = m = 0;
+  for (i = 0; i < ROWS; i++)
+	for (j = 0; j < COLS; j++) {
+		if (scr[i][j] == nscrn[i][j]) continue;
+		n += 4 + digits(i + 2) + digits(j + 2);	/* \E[%i%d;%dH */
+		while (j < COLS && scr[i][j] != nscrn[i][j]) {
+			if ((nscrn[i][j] & 0x80) != m) {
+				n += 4;			/* so or se */
+				m = nscrn[i][j] & 0x80;
+			}
+			n++;
+			j++;
+		}
+	}
+  return(n + 4 + digits(row + 2) + digits(col + 2) + (m ? 4 : 0));
+}
+
+int digits(n)
+int n;
+{
+  return(n < 10 ? 1 : n < 100 ? 2 : 3);
+}
+
+/* A screen of text from line first, and a status line. */
+show(first, status)
+int first;
+char *status;
+{
+  int i;
+
+  for (i = 0; i < PAGE; i++) {
+	move(i, 0);
+	addstr(first + i < NTEXT ? text[first + i] : "~");
+	clrtoeol();
+  }
+  move(PAGE, 0);
+  standout();
+  addstr(status);
+  standend();
+  clrtoeol();
+}
+
+more()
+{
+/* Page through the text a line, and then a screen, at a time. */
+
+  int first;
+
+  for (first = 0; first < 60; first++) {
+	show(first, "--More--");
+	move(PAGE, 8);
+	update();
+  }
+  for (; first < NTEXT - PAGE; first += PAGE) {
+	show(first, "--More--");
+	move(PAGE, 8);
+	update();
+  }
+}
+
+edit()
+{
+/* Open lines, type into them, delete lines, and scroll by half screens. */
+
+  int first, i, k, n;
+  char buf[TEXTW + 1];
+
+  first = 0;
+  show(first, "\"notes\" 200 lines");
+  update();
+  for (k = 0; k < 6; k++) {
+	/* Open a line below line 5 + k and type into it. */
+	for (i = NTEXT - 1; i > first + 6 + k; i--) strcpy(text[i], text[i-1]);
+	text[first + 6 + k][0] = 0;
+	for (n = 0; n < 24; n++) {
+		text[first + 6 + k][n] = "now is the time for all "[n];
+		text[first + 6 + k][n + 1] = 0;
+		show(first, "-- INSERT --");
+		move(6 + k, n + 1);
+		update();
+	}
+
+	/* Delete line 15. */
+	for (i = first + 15; i < NTEXT - 1; i++) strcpy(text[i], text[i+1]);
+	text[NTEXT - 1][0] = 0;
+	show(first, "");
+	move(15, 0);
+	update();
+
+	/* Change a word on line 3. */
+	strcpy(buf, text[first + 3]);
+	strcpy(text[first + 3], "changed ");
+	strncat(text[first + 3], buf + 4, TEXTW - 8);
+	show(first, "");
+	move(3, 6);
+	update();
+
+	/* Scroll down half a screen. */
+	first += PAGE / 2;
+	show(first, "");
+	move(0, 0);
+	update();
+  }
+}
+
+type()
+{
+/* Type a paragraph at the bottom of the text, with the line wrapping. */
+
+  static char para[] = "while the disk is busy the process waits for \
+the block it asked for and the scheduler runs another which fills the \
+cache with more blocks that nobody needs yet but will soon ";
+  int first, y, x, i;
+
+  first = NTEXT - PAGE;
+  for (y = 0; y < PAGE; y++) text[first + y][0] = 0;
+  y = x = 0;
+  for (i = 0; para[i] != 0; i++) {
+	text[first + y][x++] = para[i];
+	text[first + y][x] = 0;
+	if (x >= 60 && para[i] == ' ') {
+		y++;
+		x = 0;
+	}
+	show(first, "-- INSERT --");
+	move(y, x);
+	update();
+  }
+}
+
+/* Run what curses sent since the last call through the emulator. */
+emulate()
+{
+  char buf[512];
+  int n, i;
+
+  while ((n = read(rfd, buf, sizeof(buf))) > 0) {
+	sent += n;
+	for (i = 0; i < n; i++) eput(buf[i] & 0xFF);
+  }
+}
+
+eput(c)
+int c;
+{
+  int i;
+
+  switch (state) {
+    case 0:
+	if (c == '\033') {
+		state = 1;
+	} else if (c == '\r') {
+		ex = 0;
+	} else if (c == '\b') {
+		if (ex > 0) ex--;
+	} else if (c == '\n') {
+		if (ey == ebot) escroll(etop, ebot, 1); else ey++;
+	} else if (c >= ' ' && c < 0x7F) {
+		if (ex < COLS) scr[ey][ex] = c | emode;
+		if (ex < COLS - 1) ex++;
+	} else
+		e(10);
+	break;
+
+    case 1:
+	if (c == '[') {
+		state = 2;
+		npar = 0;
+		par[0] = -1;
+	} else if (c == 'M') {
+		if (ey == etop) escroll(etop, ebot, -1); else ey--;
+		state = 0;
+	} else {
+		e(11);
+		state = 0;
+	}
+	break;
+
+    case 2:
+	if (c >= '0' && c <= '9') {
+		if (par[npar] < 0) par[npar] = 0;
+		par[npar] = par[npar] * 10 + c - '0';
+		break;
+	}
+	if (c == ';') {
+		if (npar < 3) par[++npar] = -1;
+		break;
+	}
+	state = 0;
+	for (i = npar + 1; i < 4; i++) par[i] = -1;
+	switch (c) {
+	    case 'H':
+		ey = (par[0] > 0 ? par[0] : 1) - 1;
+		ex = (par[1] > 0 ? par[1] : 1) - 1;
+		break;
+	    case 'J':
+		memset(scr[ey] + ex, ' ', COLS - ex);
+		for (i = ey + 1; i < elines; i++) memset(scr[i], ' ', COLS);
+		break;
+	    case 'K':	memset(scr[ey] + ex, ' ', COLS - ex);	break;
+	    case 'L':	escroll(ey, ebot, -1);			break;
+	    case 'M':	escroll(ey, ebot, 1);			break;
+	    case 'A':	if (ey > 0) ey--;			break;
+	    case 'B':	if (ey < elines - 1) ey++;		break;
+	    case 'C':	if (ex < COLS - 1) ex++;		break;
+	    case 'm':	emode = (par[0] == 7) ? 0x80 : 0;	break;
+	    case 'r':
+		etop = par[0] - 1;
+		ebot = par[1] - 1;
+		ey = ex = 0;
+		break;
+	    default:	e(12);
+	}
+	break;
+  }
+  if (ey < 0 || ey >= elines || ex < 0 || ex >= COLS) e(13);
+}
+
+escroll(top, bot, n)
+int top, bot, n;
+{
+/* Scroll lines top..bot up by one (n = 1) or down (n = -1). */
+
+  int i;
+
+  if (n > 0) {
+	for (i = top; i < bot; i++) memcpy(scr[i], scr[i + 1], COLS);
+	memset(scr[bot], ' ', COLS);
+  } else {
+	for (i = bot; i > top; i--) memcpy(scr[i], scr[i - 1], COLS);
+	memset(scr[top], ' ', COLS);
+  }
+}
+
+e(n)
+int n;
+{
+/* Stdout is the terminal during a session, so errors are kept for later. */
+
+  if (nerr < MAX_ERROR) err[nerr] = n;
+  nerr++;
+}
+
+report()
+{
+  int i;
+
+  for (i = 0; i < nerr && i < MAX_ERROR; i++)
+	printf("Subtest %d,  error %d\n", subtest, err[i]);
+  errct += nerr;
+  nerr = 0;
+  if (errct > MAX_ERROR) {
+	printf("Too many errors; test aborted\n");
+	exit(1);
+  }
+}
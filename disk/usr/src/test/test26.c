@@ -0,0 +1,263 @@
+/* test 26 */
+
+/* The following library routines are tested:
+ *
+ *	regcomp()	regexec()
+ *
+ * A table of expressions and strings gives whether each should match and
+ * where.  Then random expressions are run over random strings twice: once
+ * as they are, and once with an alternative added that never matches but
+ * has too many characters for a DFA to be built, so that only the
+ * backtracking matcher is used.  The answers and the places of the matches
+ * must be the same.  "test26 -b" times a grep-like search of many lines,
+ * most of which do not match, with and without the DFA.
+ *
+ * As with test 22, the test can be run on a host against the MINIX regexp:
+ *
+ *	cc -c -fno-builtin -nostdinc -I../../include ../lib/other/regexp.c
+ *	mkdir h; cp ../../include/regexp.h ../../include/ansi.h h
+ *	cc -fno-builtin -Ih -o test26 test26.c regexp.o
+ */
+
+#include <sys/types.h>
+#include <sys/times.h>
+#include <stdlib.h>
+#include <string.h>
+#include <regexp.h>
+#include <stdio.h>
+
+#define MAX_ERROR 4
+#define NRANDOM	3000		/* random expressions */
+#define NLINES	 500		/* lines in the timed search */
+
+int errct;
+int subtest;
+
+char *errmsg;			/* last message from regcomp() */
+unsigned long seed = 1;
+
+/* No DFA can be built for this; no test string has a Z. */
+char nodfa[] =
+  "|ZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZ";
+
+struct {
+  char *exp;			/* expression */
+  char *str;			/* string */
+  int bol;			/* third argument of regexec() */
+  int start, end;		/* the match, or -1 if none */
+} table[] = {
+  "abc",	"xxabcxx",	1,  2,  5,
+  "abc",	"xxabxcx",	1, -1, -1,
+  "a*",		"bbb",		1,  0,  0,
+  "a+",		"bbaab",	1,  2,  4,
+  "^ab",	"abab",		1,  0,  2,
+  "^ab",	"abab",		0, -1, -1,
+  "b$",		"abab",		1,  3,  4,
+  "b$",		"abba",		1, -1, -1,
+  "$",		"abc",		1,  3,  3,
+  "$$",		"abc",		1,  3,  3,
+  "^$",		"",		1,  0,  0,
+  "^$",		"x",		1, -1, -1,
+  "a$b",	"a$b",		1, -1, -1,
+  "x^y",	"x^y",		1, -1, -1,
+  "a.c",	"abcadc",	1,  0,  3,
+  "a.c",	"a\nc",		1,  0,  3,
+  "[0-9]+x",	"ab123xy",	1,  2,  6,
+  "[^a-c]+",	"abcdefa",	1,  3,  6,
+  "(ab|cd)+e",	"abcdabe",	1,  0,  7,
+  "(ab|cd)+e",	"abcdabf",	1, -1, -1,
+  "a(b|c)*d",	"xabcbcbdx",	1,  1,  8,
+  "(a|ab)(c|bcd)", "abcd",	1,  0,  4,
+  "fo?o",	"afob",		1,  1,  3,
+  "((a))",	"bab",		1,  1,  2,
+  "a|b|c",	"xxc",		1,  2,  3,
+  "(^a|b)c",	"bcac",		1,  0,  2,
+  "(^a|b)c",	"acbc",		1,  0,  2,
+  "(^a|b)c",	"acbc",		0,  2,  4,
+  "ab*c",	"abbbbbbd abbbc", 1,  9, 14,
+  "\\.\\*",	"a.*b",		1,  1,  3,
+  "x*y*z*$",	"abc",		1,  3,  3,
+  "[\200-\377]a", "b\301a",	1,  1,  3,
+  "a[ab][ab][ab][ab][ab][ab]c",			/* more than NSTATE states */
+		"abbababbbaabbbababaabbbabababbbaababbaabababc", 1, 37, 45,
+  (char *) 0
+};
+
+main(argc, argv)
+int argc;
+char *argv[];
+{
+  printf("Test 26 ");
+  fflush(stdout);
+  test26a();
+  test26b();
+  if (errct == 0)
+	printf("ok\n");
+  else
+	printf(" %d errors\n", errct);
+  if (argc == 2 && strcmp(argv[1], "-b") == 0) bench();
+  exit(0);
+}
+
+void regerror(msg)
+char *msg;
+{
+  errmsg = msg;
+}
+
+unsigned rnd(n)
+unsigned n;
+{
+  seed = seed * 1103515245L + 12345;
+  return((unsigned) ((seed >> 16) & 0x7FFF) % n);
+}
+
+test26a()
+{
+/* The table. */
+
+  int i, r;
+  regexp *prog;
+
+  subtest = 1;
+  for (i = 0; table[i].exp != (char *) 0; i++) {
+	if ((prog = regcomp(table[i].exp)) == (regexp *) NULL) {
+		e(1);
+		continue;
+	}
+	r = regexec(prog, table[i].str, table[i].bol);
+	if (r != (table[i].start >= 0)) {
+		printf("\"%s\" on \"%s\": %d\n", table[i].exp, table[i].str, r);
+		e(2);
+	} else if (r && (prog->startp[0] - table[i].str != table[i].start ||
+			 prog->endp[0] - table[i].str != table[i].end)) {
+		e(3);
+	}
+	free((char *) prog);
+  }
+
+  /* A bad expression is reported. */
+  errmsg = (char *) 0;
+  if (regcomp("(a*)*") != (regexp *) NULL || errmsg == (char *) 0) e(4);
+}
+
+char *randexp(buf, depth)
+char *buf;
+int depth;
+{
+/* Append a random expression over a, b and c to buf. */
+
+  static char *atoms[] = { "a", "b", "c", "ab", ".", "[ab]", "[^a]", "^", "$" };
+  int n;
+
+  for (n = 1 + rnd(3); n > 0; n--) {
+	if (depth < 2 && rnd(4) == 0) {
+		*buf++ = '(';
+		buf = randexp(buf, depth + 1);
+		if (rnd(2)) {
+			*buf++ = '|';
+			buf = randexp(buf, depth + 1);
+		}
+		*buf++ = ')';
+	} else {
+		strcpy(buf, atoms[rnd(sizeof(atoms) / sizeof(atoms[0]))]);
+		buf += strlen(buf);
+	}
+	if (rnd(3) == 0) *buf++ = "*+?"[rnd(3)];
+  }
+  *buf = '\0';
+  return(buf);
+}
+
+test26b()
+{
+/* Random expressions, with and without the DFA. */
+
+  char exp[200], slow[300], str[20];
+  regexp *p1, *p2;
+  int n, i, len, r1, r2;
+
+  subtest = 2;
+  for (n = 0; n < NRANDOM; n++) {
+	randexp(exp, 0);
+	if ((p1 = regcomp(exp)) == (regexp *) NULL) continue;
+	sprintf(slow, "(%s)%s", exp, nodfa);
+	if ((p2 = regcomp(slow)) == (regexp *) NULL) {
+		free((char *) p1);	/* one parenthesis too many */
+		continue;
+	}
+	for (i = 0; i < 10; i++) {
+		len = rnd(12);
+		str[len] = '\0';
+		while (--len >= 0) str[len] = "abcd"[rnd(4)];
+		r1 = regexec(p1, str, i & 1);
+		r2 = regexec(p2, str, i & 1);
+		if (r1 != r2) {
+			printf("\"%s\" on \"%s\": %d, should be %d\n",
+							exp, str, r1, r2);
+			e(2);
+		} else if (r1 && (p1->startp[0] != p2->startp[0] ||
+					p1->endp[0] != p2->endp[0])) {
+			e(3);
+		}
+	}
+	free((char *) p1);
+	free((char *) p2);
+  }
+}
+
+/* Benchmark. */
+long ticks()
+{
+  struct tms t;
+
+  times(&t);
+  return(t.tms_utime);
+}
+
+char *lines[NLINES];
+
+bench()
+{
+  static char *exps[] = { "include", "[a-z]+_[a-z]+\\(", "(foo|bar|baz)x",
+			  "^#.*define", "a.*b.*c.*d.*e", (char *) 0 };
+  char exp[300];
+  regexp *p1, *p2;
+  long t, fast, slow;
+  int i, k, j, n1, n2;
+
+  for (i = 0; i < NLINES; i++) {
+	lines[i] = malloc(61);
+	for (j = 0; j < 60; j++) lines[i][j] = "abcdeeioos  _(#"[rnd(15)];
+	lines[i][60] = '\0';
+  }
+  printf("\n%-20s %8s %8s %6s\n", "expression", "ticks", "old", "lines");
+  for (k = 0; exps[k] != (char *) 0; k++) {
+	p1 = regcomp(exps[k]);
+	sprintf(exp, "(%s)%s", exps[k], nodfa);
+	p2 = regcomp(exp);
+	n1 = n2 = 0;
+	t = ticks();
+	for (j = 0; j < 20; j++)
+		for (i = 0; i < NLINES; i++) n1 += regexec(p1, lines[i], 1);
+	fast = ticks() - t;
+	t = ticks();
+	for (j = 0; j < 20; j++)
+		for (i = 0; i < NLINES; i++) n2 += regexec(p2, lines[i], 1);
+	slow = ticks() - t;
+	if (n1 != n2) e(9);
+	printf("%-20s %8ld %8ld %6d\n", exps[k], fast, slow, n1 / 20);
+	free((char *) p1);
+	free((char *) p2);
+  }
+}
+
+e(n)
+int n;
+{
+  printf("Subtest %d,  error %d\n", subtest, n);
+  if (errct++ > MAX_ERROR) {
+	printf("Too many errors; test aborted\n");
+	exit(1);
+  }
+}
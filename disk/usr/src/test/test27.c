@@ -0,0 +1,249 @@
+/* test 27 */
+
+/* The following library routines are tested:
+ *
+ *	tgetent()	tgetflag()	tgetnum()	tgetstr()
+ *
+ * A termcap file is written, every capability of every terminal in it is
+ * looked up, and then the file is compiled with tic(1) and everything is
+ * looked up again.  The answers, and the entry put in the buffer, must be
+ * the same both times.  The compiled file must not be used once the text
+ * file has changed.  "test27 -b" times tgetent() and a dozen lookups, from
+ * the text and from the compiled file.
+ *
+ * As with test 22, the test can be run on a host against the MINIX termcap
+ * routines and tic.  The host's struct stat is not MINIX's, so the library
+ * gets its modification times through a shim:
+ *
+ *	echo '#include <sys/stat.h>' >m.c
+ *	echo 'int stat(const char *n, struct stat *s)' >>m.c
+ *	echo '{ return(hstat(n, &s->st_mtime)); }' >>m.c
+ *	echo '#include <sys/stat.h>' >h.c
+ *	echo 'int hstat(char *n, long *t)' >>h.c
+ *	echo '{ struct stat s; int r = stat(n, &s); *t = s.st_mtime; return(r); }' >>h.c
+ *	cc -c -fno-builtin -nostdinc -I../../include -Dstat=mstat \
+ *		../lib/other/termcap.c ../lib/ansi/ctype.c m.c
+ *	mkdir h; cp ../../include/termcap.h ../../include/tcdb.h \
+ *		../../include/ansi.h h
+ *	cc -fno-builtin -Ih -o tic ../commands/tic.c termcap.o ctype.o m.o h.c
+ *	cc -fno-builtin -Ih -o test27 test27.c termcap.o ctype.o m.o h.c
+ *	PATH=.:$PATH ./test27
+ */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/times.h>
+#include <termcap.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <utime.h>
+#include <stdio.h>
+
+#define MAX_ERROR 4
+#define NLOOK	  24		/* lookups remembered per terminal */
+#define NBENCH	 200		/* tgetent() calls timed */
+
+int errct;
+int subtest;
+
+char file[] = "/tmp/T27.tc";
+char db[] = "/tmp/T27.tc.db";
+
+char *text[] = {
+  "# A comment line\n",
+  "aa|first|the first terminal:\\\n",
+  "\t:am:bs:co#80:li#24:\\\n",
+  "\t:cl=\\E[H\\E[J:cm=\\E[%i%d;%dH:\\\n",
+  "\t:up=^K:ce=\\E[K:nl=\\n:ta=\\t:oc=\\101\\102\\003:\\\n",
+  "\t:co#132:cl=second:bs@:xx:\n",
+  "   # indented comment\n",
+  "bb|second|a name that is far too long for the index:\\\n",
+  "\t:li#-1:kb=\\b:ff=\\f:cr=\\r:nu=^@x:sp=\\E\\^\\\\:\n",
+  "aa|dup|duplicate of the first:co#1:\n",
+  "cc|a-name-of-14c:co#0:ab=:\n",
+  "dd::\n",
+  (char *) 0
+};
+
+char last[] = "ee|the last:co#80:li#25:cl=\\E[H\\E[J:cm=\\E[%i%d;%dH:\\\n\
+\t:ce=\\E[K:so=\\E[7m:se=\\E[m:up=\\E[A:sr=\\EM:al=\\E[L:dl=\\E[M:\\\n\
+\t:cs=\\E[%i%d;%dr:ho=\\E[H:nd=\\E[C:\n";
+
+char *names[] = { "aa", "first", "the first terminal", "bb", "second",
+	"a name that is far too long for the index", "dup", "cc",
+	"a-name-of-14c", "dd", "ee", "zz", "fir", "firsts", (char *) 0 };
+
+char *ids[] = { "am", "bs", "co", "li", "cl", "cm", "up", "ce", "nl", "ta",
+	"oc", "xx", "kb", "ff", "cr", "nu", "sp", "ab", "zz", "c", "co#",
+	(char *) 0 };
+
+struct look {
+  int ent;			/* tgetent() */
+  char bp[1024];		/* what it put in the buffer */
+  int flag[NLOOK], num[NLOOK];	/* tgetflag(), tgetnum() */
+  char str[NLOOK][40];		/* tgetstr(), or "NULL" */
+  int len[NLOOK];		/* how far tgetstr() moved the area */
+} before[20], after[20];
+
+main(argc, argv)
+int argc;
+char *argv[];
+{
+  printf("Test 27 ");
+  fflush(stdout);
+  test27a();
+  if (errct == 0)
+	printf("ok\n");
+  else
+	printf(" %d errors\n", errct);
+  if (argc == 2 && strcmp(argv[1], "-b") == 0) bench();
+  unlink(file);
+  unlink(db);
+  exit(0);
+}
+
+lookall(l)
+struct look *l;
+{
+/* Look up every id of every name. */
+
+  int n, i;
+  char area[1024], *ap, *s;
+
+  for (n = 0; names[n] != (char *) 0; n++, l++) {
+	memset(l->bp, 0, sizeof(l->bp));
+	l->ent = tgetent(l->bp, names[n]);
+	for (i = 0; ids[i] != (char *) 0; i++) {
+		l->flag[i] = tgetflag(ids[i]);
+		l->num[i] = tgetnum(ids[i]);
+		ap = area;
+		if ((s = tgetstr(ids[i], &ap)) == (char *) NULL)
+			strcpy(l->str[i], "NULL");
+		else
+			memcpy(l->str[i], s, sizeof(l->str[i]));
+		l->len[i] = s == (char *) NULL ? -1 : ap - area;
+	}
+  }
+}
+
+compare(a, b)
+struct look *a, *b;
+{
+  int n, i;
+
+  for (n = 0; names[n] != (char *) 0; n++, a++, b++) {
+	if (a->ent != b->ent) e(1);
+	if (strcmp(a->bp, b->bp) != 0) e(2);
+	for (i = 0; ids[i] != (char *) 0; i++) {
+		if (a->flag[i] != b->flag[i]) e(3);
+		if (a->num[i] != b->num[i]) e(4);
+		if (a->len[i] != b->len[i] ||
+		    (a->len[i] > 0 && memcmp(a->str[i], b->str[i],
+						(size_t) a->len[i]) != 0)) {
+			printf("%s %s\n", names[n], ids[i]);
+			e(5);
+		}
+	}
+  }
+}
+
+test27a()
+{
+  char buf[1024], *ap;
+  struct utimbuf ut;
+
+  subtest = 1;
+  writetc((char *) 0, 0);
+  unlink(db);
+  putenv("TERMCAP=/tmp/T27.tc");
+
+  /* A few known answers from the text. */
+  if (tgetent(buf, "first") != 1) e(3);
+  if (tgetnum("co") != 80 || tgetnum("li") != 24 || tgetflag("bs") != 1) e(4);
+  ap = buf + 512;
+  if (strcmp(tgetstr("oc", &ap), "AB\003") != 0) e(5);
+  if (tgetent(buf, "nosuch") != 0) e(6);
+  lookall(before);
+
+  /* The same from the compiled file. */
+  subtest = 2;
+  if (system("tic /tmp/T27.tc") != 0) e(1);
+  if (access(db, 0) != 0) e(2);
+  lookall(after);
+  compare(before, after);
+
+  /* A changed text file is read, not the old compiled one. */
+  subtest = 3;
+  writetc("aa|first:co#7:\n", 0);
+  ut.actime = ut.modtime = time((time_t *) 0) + 10;
+  utime(file, &ut);
+  if (tgetent(buf, "first") != 1 || tgetnum("co") != 7) e(1);
+}
+
+writetc(first, fillers)
+char *first;
+int fillers;
+{
+/* Write the termcap file: an entry, the text, and many more entries. */
+
+  FILE *fp;
+  int i;
+
+  if ((fp = fopen(file, "w")) == (FILE *) NULL) {
+	e(8);
+	return;
+  }
+  if (first != (char *) 0) fputs(first, fp);
+  for (i = 0; text[i] != (char *) 0; i++) fputs(text[i], fp);
+  for (i = 0; i < fillers; i++) {
+	fprintf(fp, "f%d|filler %d:co#80:li#25:cl=\\E[H\\E[J:\\\n", i, i);
+	fprintf(fp, "\t:cm=\\E[%%i%%d;%%dH:ce=\\E[K:so=\\E[7m:se=\\E[m:\n");
+  }
+  fputs(last, fp);
+  fclose(fp);
+}
+
+/* Benchmark. */
+long ticks()
+{
+  struct tms t;
+
+  times(&t);
+  return(t.tms_utime);
+}
+
+bench()
+{
+  static char *caps[] = { "cl", "cm", "ce", "so", "se", "up", "sr", "al",
+			  "dl", "cs", "ho", "nd" };
+  long t;
+  int pass, n, i;
+  char buf[1024], area[1024], *ap;
+
+  printf("\n");
+  for (pass = 0; pass < 2; pass++) {
+	writetc((char *) 0, 60);
+	unlink(db);
+	if (pass == 1 && system("tic /tmp/T27.tc") != 0) e(9);
+	t = ticks();
+	for (n = 0; n < NBENCH; n++) {
+		tgetent(buf, "ee");
+		tgetnum("co");
+		tgetnum("li");
+		for (i = 0, ap = area; i < 12; i++) tgetstr(caps[i], &ap);
+	}
+	printf("%-10s %6ld ticks for %d tgetent()s and lookups\n",
+		pass == 0 ? "text" : "compiled", ticks() - t, NBENCH);
+  }
+}
+
+e(n)
+int n;
+{
+  printf("Subtest %d,  error %d\n", subtest, n);
+  if (errct++ > MAX_ERROR) {
+	printf("Too many errors; test aborted\n");
+	exit(1);
+  }
+}
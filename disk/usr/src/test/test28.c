@@ -0,0 +1,272 @@
+/* test 28 */
+
+/* The following library routines are tested:
+ *
+ *	getenv()	putenv()	execve()
+ *
+ * Names are looked up in environments that are changed in every way a
+ * program may change them: by putenv(), by pointing environ at a new array,
+ * by replacing a string in place, and by putting a string on or clearing
+ * one off the end of the array.  The answers must be those of a plain
+ * search.  Then the test runs itself with many arguments and environment
+ * strings, and checks that they arrive intact.  "test28 -b" times getenv()
+ * against a plain search.
+ *
+ * As with test 22, the lookups can be checked on a host against the MINIX
+ * getenv() and putenv():
+ *
+ *	cc -c -fno-builtin -nostdinc -I../../include ../lib/ansi/getenv.c \
+ *		../lib/other/putenv.c
+ *	cc -o test28 test28.c getenv.o putenv.o
+ */
+
+#include <sys/types.h>
+#include <sys/times.h>
+#include <sys/wait.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdio.h>
+
+#define MAX_ERROR 4
+#define NBIG	 200		/* strings in the big environment */
+#define NARGS	 100		/* arguments passed to the child */
+#define NENV	  50		/* environment strings passed to it */
+#define NBENCH	2000		/* rounds of lookups timed */
+
+extern char **environ;
+
+int errct;
+int subtest;
+
+char *names[] = { "A", "AB", "ABC", "B", "B=x", "C", "D", "E", "F", "G", "",
+		  "=", "V0", "V7", "V77", "V199", "V200", "PATH", (char *) 0 };
+
+char *env1[] = { "A=1", "AB=2", "B=x=y", "C", "C=3", "A=dup", "=z", "E=",
+		 (char *) 0, (char *) 0 };
+
+char *big[NBIG + 1];
+
+main(argc, argv)
+int argc;
+char *argv[];
+{
+  if (argc > 1 && strcmp(argv[1], "-c") == 0) exit(child(argc, argv));
+  printf("Test 28 ");
+  fflush(stdout);
+  test28a();
+  test28b(argv[0]);
+  if (errct == 0)
+	printf("ok\n");
+  else
+	printf(" %d errors\n", errct);
+  if (argc == 2 && strcmp(argv[1], "-b") == 0) bench();
+  exit(0);
+}
+
+char *oldgetenv(name)
+char *name;
+{
+/* The plain search that getenv() must agree with. */
+
+  char **v, *n, *p;
+
+  for (v = environ; *v != (char *) 0; ++v) {
+	for (n = name, p = *v; *n == *p && *n != '\0'; ++n, ++p);
+	if (*n == '\0' && *p == '=') return(p + 1);
+  }
+  return((char *) 0);
+}
+
+check(n)
+int n;
+{
+/* Look every name up, twice, and compare with the plain search. */
+
+  int i, k;
+  char *s, *t;
+
+  for (k = 0; k < 2; k++)
+	for (i = 0; names[i] != (char *) 0; i++) {
+		s = getenv(names[i]);
+		t = oldgetenv(names[i]);
+		if (s != t) {
+			printf("%s: %s, should be %s\n", names[i],
+				s == (char *) 0 ? "NULL" : s,
+				t == (char *) 0 ? "NULL" : t);
+			e(n);
+		}
+	}
+}
+
+test28a()
+{
+  char *s;
+  int i;
+
+  subtest = 1;
+  environ = env1;
+  check(1);
+  if ((s = getenv("A")) == (char *) 0 || strcmp(s, "1") != 0) e(2);
+  if ((s = getenv("B")) == (char *) 0 || strcmp(s, "x=y") != 0) e(3);
+  if ((s = getenv("B=x")) == (char *) 0 || strcmp(s, "y") != 0) e(4);
+  if ((s = getenv("E")) == (char *) 0 || *s != '\0') e(5);
+  if (getenv("D") != (char *) 0 || getenv("") == (char *) 0) e(6);
+
+  /* Changes in place. */
+  env1[1] = "AB=5";
+  check(7);
+  env1[7] = (char *) 0;
+  check(8);
+  env1[7] = "F=6";
+  check(9);
+  if ((s = getenv("F")) == (char *) 0 || strcmp(s, "6") != 0) e(10);
+
+  /* Changes by putenv(). */
+  putenv("G=7");
+  check(11);
+  putenv("A=9");
+  check(12);
+  if ((s = getenv("A")) == (char *) 0 || strcmp(s, "9") != 0) e(13);
+
+  /* An environment too big to index, and then one that is not. */
+  for (i = 0; i < NBIG; i++) {
+	big[i] = malloc(10);
+	sprintf(big[i], "V%d=%d", i, i * 3);
+  }
+  big[NBIG] = (char *) 0;
+  environ = big;
+  check(14);
+  big[20] = (char *) 0;
+  check(15);
+  environ = (char **) 0;
+  if (getenv("A") != (char *) 0) e(16);
+  environ = env1;
+  check(17);
+}
+
+test28b(prog)
+char *prog;
+{
+/* Run the test itself, with many arguments and environment strings. */
+
+  char *args[NARGS + 3], *envs[NENV + 1];
+  int i, pid, status;
+#ifdef ARG_MAX
+  char *huge;
+#endif
+
+  subtest = 2;
+  args[0] = prog;
+  args[1] = "-c";
+  for (i = 0; i < NARGS; i++) {
+	args[i + 2] = malloc(10);
+	sprintf(args[i + 2], i == 7 ? "" : "a%d", i);
+  }
+  args[NARGS + 2] = (char *) 0;
+  for (i = 0; i < NENV; i++) {
+	envs[i] = malloc(10);
+	sprintf(envs[i], "E%d=%d", i, i);
+  }
+  envs[NENV] = (char *) 0;
+
+  fflush(stdout);
+  if ((pid = fork()) < 0) {
+	e(1);
+	return;
+  }
+  if (pid == 0) {
+	execve(prog, args, envs);
+	exit(100);
+  }
+  if (wait(&status) != pid || status != 0) e(2);
+
+#ifdef ARG_MAX
+  /* Too much is refused, and the caller goes on. */
+  huge = malloc(ARG_MAX);
+  if (huge == (char *) 0) return;
+  memset(huge, 'x', (size_t) ARG_MAX - 1);
+  huge[ARG_MAX - 1] = '\0';
+  args[2] = huge;
+  if (execve(prog, args, envs) != -1 || errno != E2BIG) e(3);
+  args[2] = "a0";
+  args[3] = (char *) 0;
+  envs[0] = huge;
+  if (execve(prog, args, envs) != -1 || errno != E2BIG) e(4);
+  free(huge);
+#endif
+}
+
+int child(argc, argv)
+int argc;
+char *argv[];
+{
+/* The child checks what it was given. */
+
+  char buf[20], *s;
+  int i;
+
+  if (argc != NARGS + 2) return(1);
+  for (i = 0; i < NARGS; i++) {
+	sprintf(buf, i == 7 ? "" : "a%d", i);
+	if (strcmp(argv[i + 2], buf) != 0) return(2);
+  }
+  if (argv[argc] != (char *) 0) return(3);
+  for (i = 0; i < NENV; i++) {
+	sprintf(buf, "%d", i);
+	sprintf(buf + 10, "E%d", i);
+	if ((s = getenv(buf + 10)) == (char *) 0 || strcmp(s, buf) != 0)
+		return(4);
+  }
+  for (i = 0; environ[i] != (char *) 0; i++);
+  return(i == NENV ? 0 : 5);
+}
+
+/* Benchmark. */
+long ticks()
+{
+  struct tms t;
+
+  times(&t);
+  return(t.tms_utime);
+}
+
+bench()
+{
+  static char *look[] = { "HOME", "PATH", "TERM", "SHELL", "USER", "MAKEFLAGS",
+			  "TERMCAP", "COLUMNS", "LINES", "V129" };
+  char *env2[31];
+  long t;
+  int n, i;
+
+  printf("\n");
+  for (i = 0; i < 30; i++) env2[i] = big[i + 100];
+  env2[30] = (char *) 0;
+  env2[3] = "HOME=/usr/ast";
+  env2[11] = "PATH=:/bin:/usr/bin";
+  env2[17] = "TERM=minix";
+  env2[25] = "USER=ast";
+  environ = env2;
+  t = ticks();
+  for (n = 0; n < NBENCH; n++)
+	for (i = 0; i < 10; i++) getenv(look[i]);
+  printf("%-10s %6ld ticks for %d lookups\n", "getenv", ticks() - t,
+								NBENCH * 10);
+  t = ticks();
+  for (n = 0; n < NBENCH; n++)
+	for (i = 0; i < 10; i++) oldgetenv(look[i]);
+  printf("%-10s %6ld ticks for %d lookups\n", "plain", ticks() - t,
+								NBENCH * 10);
+}
+
+e(n)
+int n;
+{
+  printf("Subtest %d,  error %d\n", subtest, n);
+  if (errct++ > MAX_ERROR) {
+	printf("Too many errors; test aborted\n");
+	exit(1);
+  }
+}
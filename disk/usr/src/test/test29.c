@@ -0,0 +1,210 @@
+/* test 29 */
+
+/* The following library routines are tested:
+ *
+ *	printf()	fprintf()	sprintf()	vsprintf()
+ *
+ * A table of formats and values gives the string each must make.  Then
+ * numbers over the whole range of int and long are printed with sprintf()
+ * and compared with digits worked out one at a time, and many lines are
+ * written with fprintf() to a buffered and to an unbuffered stream and
+ * read back.  "test29 -b" times printing numbers to a file and to a string.
+ */
+
+#include <sys/types.h>
+#include <sys/times.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdio.h>
+
+#define MAX_ERROR 4
+#define NLINES	1000		/* lines written to the files */
+#define NBENCH	2000		/* lines timed */
+
+int errct;
+int subtest;
+
+char file[] = "/tmp/T29";
+char buf[4096];
+
+main(argc, argv)
+int argc;
+char *argv[];
+{
+  printf("Test 29 ");
+  fflush(stdout);
+  test29a();
+  test29b();
+  test29c();
+  if (errct == 0)
+	printf("ok\n");
+  else
+	printf(" %d errors\n", errct);
+  if (argc == 2 && strcmp(argv[1], "-b") == 0) bench();
+  unlink(file);
+  exit(0);
+}
+
+want(s, n)
+char *s;
+int n;
+{
+  if (strcmp(buf, s) != 0) {
+	printf("\"%s\", should be \"%s\"\n", buf, s);
+	e(n);
+  }
+}
+
+char *vs(fmt)
+char *fmt;
+{
+/* Format through vsprintf(). */
+
+  va_list ap;
+
+  va_start(ap, fmt);
+  vsprintf(buf, fmt, ap);
+  va_end(ap);
+  return(buf);
+}
+
+test29a()
+{
+/* Known answers. */
+
+  char big[600];
+
+  subtest = 1;
+  sprintf(buf, "%d", 0);			want("0", 1);
+  sprintf(buf, "%d %d", 32767, -32767 - 1);	want("32767 -32768", 2);
+  sprintf(buf, "[%5d][%-5d][%05d]", 42, 42, -42);
+						want("[   42][42   ][-0042]", 3);
+  sprintf(buf, "%u %o %x", 65535, 8, 255);	want("65535 10 FF", 4);
+  sprintf(buf, "%ld %ld", 2147483647L, -2147483647L - 1);
+						want("2147483647 -2147483648", 5);
+  sprintf(buf, "%lu %lo %lx", -1L, -1L, -1L);
+				want("4294967295 37777777777 FFFFFFFF", 6);
+  sprintf(buf, "%D %U %O %X", 100000L, 65536L, 65536L, 65536L);
+					want("100000 65536 200000 10000", 7);
+  sprintf(buf, "%ld %ld %ld %ld", 9L, 10L, 99L, 100L);
+						want("9 10 99 100", 8);
+  sprintf(buf, "[%8ld][%-8ld][%08ld]", 123456L, -12L, -12L);
+				want("[  123456][-12     ][-0000012]", 9);
+  sprintf(buf, "[%s][%8s][%-8s][%.2s]", "abc", "abc", "abc", "abc");
+				want("[abc][     abc][abc     ][ab]", 10);
+  sprintf(buf, "%s", (char *) 0);		want("(null)", 11);
+  sprintf(buf, "[%c][%3c]%%", 'a', 'b');	want("[a][  b]%", 12);
+  sprintf(buf, "[%*d]", 6, 7);			want("[     7]", 13);
+  sprintf(buf, "%d", 0, 1);			want("0", 14);
+  sprintf(buf, "no fields");			want("no fields", 15);
+  if (strcmp(vs("%d-%ld-%s", -1, 70000L, "x"), "-1-70000-x") != 0) e(16);
+
+  /* Fields longer than the fill copied at a time. */
+  memset(big, 'x', sizeof(big) - 1);
+  big[sizeof(big) - 1] = '\0';
+  sprintf(buf, "%s", big);
+  if (strcmp(buf, big) != 0) e(17);
+  sprintf(buf, "%50d|", 1);
+  if (strlen(buf) != 51 || buf[48] != ' ' || buf[49] != '1') e(18);
+  sprintf(buf, "%-50d|", 1);
+  if (strlen(buf) != 51 || buf[0] != '1' || buf[49] != ' ') e(19);
+}
+
+test29b()
+{
+/* Numbers over the whole range. */
+
+  char num[20], *p;
+  unsigned long v, w;
+  long l;
+  int i, n;
+
+  subtest = 2;
+  for (v = 1, n = 0; n < 2000; n++, v = v * 5 + n) {
+	for (p = &num[19], *p = '\0', w = v; p == &num[19] || w != 0; w /= 10)
+		*--p = '0' + (int) (w % 10);
+	sprintf(buf, "%lu", v);
+	if (strcmp(buf, p) != 0) e(1);
+	l = (long) v;
+	sprintf(buf, "%ld", l);
+	if (atol(buf) != l) e(2);
+	i = (int) v;
+	sprintf(buf, "%d", i);
+	if (atoi(buf) != i) e(3);
+	sprintf(buf, "%lx", v);
+	if (strtoul(buf, (char **) 0, 16) != v) e(4);
+	sprintf(buf, "%lo", v);
+	if (strtoul(buf, (char **) 0, 8) != v) e(5);
+  }
+}
+
+test29c()
+{
+/* Files, buffered and not. */
+
+  FILE *fp;
+  char line[100];
+  int k, pass;
+
+  subtest = 3;
+  for (pass = 0; pass < 2; pass++) {
+	if ((fp = fopen(file, "w")) == (FILE *) NULL) {
+		e(1);
+		return;
+	}
+	if (pass == 1) setbuf(fp, (char *) NULL);
+	for (k = 0; k < NLINES; k++)
+		fprintf(fp, "%5d %-10ld|%s\n", k, k * 70000L, "end");
+	fclose(fp);
+	if ((fp = fopen(file, "r")) == (FILE *) NULL) {
+		e(2);
+		return;
+	}
+	for (k = 0; fgets(line, sizeof(line), fp) != (char *) NULL; k++) {
+		sprintf(buf, "%5d %-10ld|%s\n", k, k * 70000L, "end");
+		if (strcmp(line, buf) != 0) e(3);
+	}
+	if (k != NLINES) e(4);
+	fclose(fp);
+  }
+}
+
+/* Benchmark. */
+long ticks()
+{
+  struct tms t;
+
+  times(&t);
+  return(t.tms_utime);
+}
+
+bench()
+{
+  FILE *fp;
+  long t;
+  int k;
+
+  printf("\n");
+  if ((fp = fopen(file, "w")) == (FILE *) NULL) return;
+  t = ticks();
+  for (k = 0; k < NBENCH; k++)
+	fprintf(fp, "%-10s %5d %8ld %6o %s\n", "name", k, k * 1234L, k, "x");
+  fclose(fp);
+  printf("%-10s %6ld ticks for %d lines\n", "fprintf", ticks() - t, NBENCH);
+  t = ticks();
+  for (k = 0; k < NBENCH; k++)
+	sprintf(buf, "%-10s %5d %8ld %6o %s\n", "name", k, k * 1234L, k, "x");
+  printf("%-10s %6ld ticks for %d lines\n", "sprintf", ticks() - t, NBENCH);
+}
+
+e(n)
+int n;
+{
+  printf("Subtest %d,  error %d\n", subtest, n);
+  if (errct++ > MAX_ERROR) {
+	printf("Too many errors; test aborted\n");
+	exit(1);
+  }
+}
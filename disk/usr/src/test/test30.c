@@ -0,0 +1,226 @@
+/* test 30 */
+
+/* The following system calls are tested:
+ *
+ *	getdents()	statat()	readdir()
+ *
+ * A directory is filled with files, some of which are removed again to
+ * leave free slots.  What getdents() returns, with buffers of several
+ * sizes, is compared with the entries read() finds in the directory itself.
+ * statat() is compared with stat() of the full path, and the error cases of
+ * both calls are tried.
+ */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/dir.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdio.h>
+
+#define MAX_ERROR 4
+#define NFILES	100		/* files made in the directory */
+
+int errct;
+int subtest;
+
+char dir[] = "/tmp/T30";
+char seen[NFILES + 2];		/* how often each name came back */
+char buf[2048];
+
+main()
+{
+  printf("Test 30 ");
+  fflush(stdout);
+  setup();
+  test30a();
+  test30b();
+  test30c();
+  cleanup();
+  if (errct == 0)
+	printf("ok\n");
+  else
+	printf(" %d errors\n", errct);
+  exit(0);
+}
+
+setup()
+{
+  char name[30];
+  int i, fd;
+
+  cleanup();
+  if (mkdir(dir, 0777) != 0) e(1);
+  for (i = 0; i < NFILES; i++) {
+	sprintf(name, "%s/f%d", dir, i);
+	if ((fd = creat(name, 0644)) < 0) e(2);
+	write(fd, name, i);
+	close(fd);
+  }
+  for (i = 0; i < NFILES; i += 7) {	/* leave some holes */
+	sprintf(name, "%s/f%d", dir, i);
+	if (unlink(name) != 0) e(3);
+  }
+  sprintf(name, "%s/sub", dir);
+  if (mkdir(name, 0755) != 0) e(4);
+}
+
+cleanup()
+{
+  char name[30];
+  int i;
+
+  for (i = 0; i < NFILES; i++) {
+	sprintf(name, "%s/f%d", dir, i);
+	unlink(name);
+  }
+  sprintf(name, "%s/sub", dir);
+  rmdir(name);
+  rmdir(dir);
+}
+
+int slot(name)
+char *name;
+{
+/* Map a name in the test directory to its place in seen[]. */
+
+  if (strcmp(name, "sub") == 0) return(NFILES);
+  if (name[0] == 'f') return(atoi(name + 1));
+  return(NFILES + 1);		/* "." and ".." */
+}
+
+test30a()
+{
+/* Batches of every size give back what is in the directory. */
+
+  static int sizes[] = { 2048, 512, 100, 32 };
+  struct direct d;
+  struct dirent *dp;
+  int fd, n, k, s, want, got;
+  off_t pos;
+
+  subtest = 1;
+  if ((fd = open(dir, O_RDONLY)) < 0) e(1);
+  want = 0;
+  while (read(fd, (char *) &d, sizeof(d)) == sizeof(d))
+	if (d.d_ino != 0) want++;
+  if (want != NFILES - (NFILES + 6) / 7 + 3) e(2);
+
+  for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+	memset(seen, 0, sizeof(seen));
+	if (lseek(fd, 0L, SEEK_SET) != 0) e(3);
+	got = 0;
+	pos = -1;
+	while ((n = getdents(fd, buf, sizes[s])) > 0) {
+		if (n > sizes[s]) e(4);
+		for (k = 0; k < n; k += dp->d_reclen) {
+			dp = (struct dirent *) &buf[k];
+			if (dp->d_reclen != _DIRENTSIZ(strlen(dp->d_name))) e(5);
+			if (dp->d_ino == 0) e(6);
+			if (dp->d_off <= pos) e(7);
+			if (dp->d_off % sizeof(d) != 0) e(8);
+			pos = dp->d_off;
+			seen[slot(dp->d_name)]++;
+			got++;
+		}
+		if (k != n) e(9);
+	}
+	if (n != 0) e(10);
+	if (got != want) e(11);
+	for (k = 0; k < NFILES; k++)
+		if (seen[k] != (k % 7 == 0 ? 0 : 1)) e(12);
+	if (seen[NFILES] != 1 || seen[NFILES + 1] != 2) e(13);
+	if (getdents(fd, buf, sizes[s]) != 0) e(14);	/* still EOF */
+  }
+
+  /* A buffer too small for even one entry. */
+  if (lseek(fd, 0L, SEEK_SET) != 0) e(15);
+  if (getdents(fd, buf, 4) != -1 || errno != EINVAL) e(16);
+  close(fd);
+
+  /* Readdir() gets the same entries. */
+  {
+	DIR *dirp;
+
+	memset(seen, 0, sizeof(seen));
+	if ((dirp = opendir(dir)) == (DIR *) 0) e(17);
+	got = 0;
+	while ((dp = readdir(dirp)) != (struct dirent *) 0) {
+		seen[slot(dp->d_name)]++;
+		got++;
+	}
+	closedir(dirp);
+	if (got != want) e(18);
+  }
+}
+
+test30b()
+{
+/* Statat() finds what stat() does. */
+
+  struct stat s1, s2;
+  char name[30];
+  int fd, i;
+
+  subtest = 2;
+  if ((fd = open(dir, O_RDONLY)) < 0) e(1);
+  for (i = 1; i < NFILES; i++) {
+	if (i % 7 == 0) continue;
+	sprintf(name, "%s/f%d", dir, i);
+	if (stat(name, &s1) != 0) e(2);
+	sprintf(name, "f%d", i);
+	if (statat(fd, name, &s2) != 0) e(3);
+	if (s1.st_ino != s2.st_ino || s1.st_size != s2.st_size) e(4);
+	if (s2.st_size != i) e(5);
+  }
+  if (statat(fd, "sub/..", &s2) != 0) e(6);
+  if (stat(dir, &s1) != 0) e(7);
+  if (s1.st_ino != s2.st_ino) e(8);
+  if (statat(fd, ".", &s2) != 0 || s2.st_ino != s1.st_ino) e(9);
+
+  /* Absolute paths do not depend on the directory. */
+  if (statat(fd, "/", &s2) != 0) e(10);
+  if (stat("/", &s1) != 0 || s1.st_ino != s2.st_ino) e(11);
+
+  /* The working directory is left alone. */
+  if (stat(".", &s1) != 0) e(12);
+  if (statat(fd, "sub", &s2) != 0) e(13);
+  if (stat(".", &s2) != 0 || s1.st_ino != s2.st_ino) e(14);
+  close(fd);
+}
+
+test30c()
+{
+/* Errors. */
+
+  struct stat s;
+  char name[30];
+  int fd;
+
+  subtest = 3;
+  if ((fd = open(dir, O_RDONLY)) < 0) e(1);
+  if (statat(fd, "f0", &s) != -1 || errno != ENOENT) e(2);
+  close(fd);
+  if (statat(fd, "f1", &s) != -1 || errno != EBADF) e(3);
+  if (getdents(fd, buf, sizeof(buf)) != -1 || errno != EBADF) e(4);
+
+  sprintf(name, "%s/f1", dir);
+  if ((fd = open(name, O_RDONLY)) < 0) e(5);
+  if (statat(fd, "x", &s) != -1 || errno != ENOTDIR) e(6);
+  if (getdents(fd, buf, sizeof(buf)) != -1 || errno != ENOTDIR) e(7);
+  close(fd);
+}
+
+e(n)
+int n;
+{
+  printf("Subtest %d,  error %d\n", subtest, n);
+  if (errct++ > MAX_ERROR) {
+	printf("Too many errors; test aborted\n");
+	exit(1);
+  }
+}
@@ -0,0 +1,218 @@
+/* test 31 */
+
+/* The following library routines are tested:
+ *
+ *	tw_read()	tw_free()	tw_seen()	tw_user()	tw_group()
+ *
+ * A directory with holes in it is read by tw_read(), which must give the
+ * entries that readdir() does, in the same order, with and without "." and
+ * "..".  The status it gets for each entry is compared with stat() of the
+ * full path.  Tw_seen() must remember exactly the pairs it was given, and
+ * the names from tw_user() and tw_group() must be those of getpwuid() and
+ * getgrgid().
+ */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <grp.h>
+#include <pwd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <treewalk.h>
+#include <stdio.h>
+
+#define MAX_ERROR 4
+#define NFILES	100		/* files made in the directory */
+
+int errct;
+int subtest;
+
+char dir[] = "/tmp/T31";
+char *names[NFILES + 3];	/* the entries as readdir() sees them */
+int nnames;
+
+main()
+{
+  printf("Test 31 ");
+  fflush(stdout);
+  setup();
+  test31a();
+  test31b();
+  test31c();
+  test31d();
+  cleanup();
+  if (errct == 0)
+	printf("ok\n");
+  else
+	printf(" %d errors\n", errct);
+  exit(0);
+}
+
+setup()
+{
+  char name[30];
+  int i, fd;
+  DIR *dirp;
+  struct dirent *dp;
+
+  cleanup();
+  if (mkdir(dir, 0777) != 0) e(1);
+  for (i = 0; i < NFILES; i++) {
+	sprintf(name, "%s/f%d", dir, i);
+	if ((fd = creat(name, 0644)) < 0) e(2);
+	write(fd, name, i);
+	close(fd);
+  }
+  for (i = 0; i < NFILES; i += 7) {	/* leave some holes */
+	sprintf(name, "%s/f%d", dir, i);
+	if (unlink(name) != 0) e(3);
+  }
+  sprintf(name, "%s/sub", dir);
+  if (mkdir(name, 0755) != 0) e(4);
+  sprintf(name, "%s/f3", dir);	/* refill a hole with a later inode */
+  unlink(name);
+  if ((fd = creat(name, 0600)) < 0) e(5);
+  close(fd);
+
+  if ((dirp = opendir(dir)) == (DIR *) 0) e(6);
+  while ((dp = readdir(dirp)) != (struct dirent *) 0)
+	if (nnames < NFILES + 3) {
+		names[nnames] = malloc(strlen(dp->d_name) + 1);
+		strcpy(names[nnames++], dp->d_name);
+	}
+  closedir(dirp);
+}
+
+cleanup()
+{
+  char name[30];
+  int i;
+
+  for (i = 0; i < NFILES; i++) {
+	sprintf(name, "%s/f%d", dir, i);
+	unlink(name);
+  }
+  sprintf(name, "%s/sub", dir);
+  rmdir(name);
+  rmdir(dir);
+}
+
+int isdot(name)
+char *name;
+{
+  return(strcmp(name, ".") == 0 || strcmp(name, "..") == 0);
+}
+
+test31a()
+{
+/* The entries come back in directory order. */
+
+  struct twdir td;
+  int i, j;
+
+  subtest = 1;
+  if (nnames != NFILES - (NFILES + 6) / 7 + 3) e(1);
+
+  if (tw_read(&td, dir, TW_DOTS) != nnames) e(2);
+  if (td.tw_count != nnames) e(3);
+  for (i = 0; i < td.tw_count && i < nnames; i++)
+	if (strcmp(td.tw_ent[i].tw_name, names[i]) != 0) e(4);
+  tw_free(&td);
+  if (td.tw_count != 0 || td.tw_ent != NULL || td.tw_names != NULL) e(5);
+
+  if (tw_read(&td, dir, 0) != nnames - 2) e(6);
+  for (i = j = 0; i < td.tw_count && j < nnames; i++, j++) {
+	while (j < nnames && isdot(names[j])) j++;
+	if (j == nnames || strcmp(td.tw_ent[i].tw_name, names[j]) != 0)
+		e(7);
+	if (td.tw_ent[i].tw_errno != 0) e(8);
+  }
+  tw_free(&td);
+
+  /* An empty directory, and one read twice. */
+  if (tw_read(&td, "/tmp/T31/sub", 0) != 0) e(9);
+  tw_free(&td);
+  if (tw_read(&td, "/tmp/T31/sub", TW_DOTS | TW_STAT) != 2) e(10);
+  tw_free(&td);
+}
+
+test31b()
+{
+/* The status of each entry is what stat() says. */
+
+  struct twdir td;
+  struct stat st;
+  register struct twent *tp;
+  char name[30];
+
+  subtest = 2;
+  if (tw_read(&td, dir, TW_DOTS | TW_STAT) != nnames) e(1);
+  for (tp = td.tw_ent; tp < td.tw_ent + td.tw_count; tp++) {
+	if (tp->tw_errno != 0) e(2);
+	sprintf(name, "%s/%s", dir, tp->tw_name);
+	if (stat(name, &st) != 0) e(3);
+	if (st.st_ino != tp->tw_stat.st_ino) e(4);
+	if (st.st_ino != tp->tw_ino) e(5);
+	if (st.st_mode != tp->tw_stat.st_mode) e(6);
+	if (st.st_size != tp->tw_stat.st_size) e(7);
+	if (st.st_nlink != tp->tw_stat.st_nlink) e(8);
+	if (st.st_mtime != tp->tw_stat.st_mtime) e(9);
+	if (tp->tw_name[0] == 'f' && strcmp(tp->tw_name, "f3") != 0 &&
+	    tp->tw_stat.st_size != atoi(tp->tw_name + 1))
+		e(10);
+  }
+  tw_free(&td);
+}
+
+test31c()
+{
+/* Errors. */
+
+  struct twdir td;
+
+  subtest = 3;
+  if (tw_read(&td, "/tmp/T31/nothere", 0) != -1 || errno != ENOENT) e(1);
+  if (td.tw_count != 0 || td.tw_ent != NULL) e(2);
+  if (tw_read(&td, "/tmp/T31/f1", TW_STAT) != -1 || errno != ENOTDIR) e(3);
+  if (td.tw_count != 0 || td.tw_ent != NULL) e(4);
+  tw_free(&td);			/* harmless on a failed read */
+}
+
+test31d()
+{
+/* Tw_seen(), tw_user() and tw_group(). */
+
+  struct passwd *pw;
+  struct group *gr;
+  int i;
+
+  subtest = 4;
+  for (i = 1; i <= 300; i++)
+	if (tw_seen(i % 3, i) != 0) e(1);
+  for (i = 1; i <= 300; i++)
+	if (tw_seen(i % 3, i) != 1) e(2);
+  if (tw_seen(4, 1) != 0) e(3);	/* same inode, other device */
+  if (tw_seen(1, 301) != 0) e(4);
+
+  if ((pw = getpwuid(0)) != NULL && strcmp(tw_user(0), pw->pw_name) != 0)
+	e(5);
+  if ((gr = getgrgid(0)) != NULL && strcmp(tw_group(0), gr->gr_name) != 0)
+	e(6);
+  if (getpwuid(12345) == NULL && strcmp(tw_user(12345), "12345") != 0) e(7);
+  if (getgrgid(123) == NULL && strcmp(tw_group(123), "123") != 0) e(8);
+  if (tw_user(0) != tw_user(0)) e(9);	/* looked up once */
+}
+
+e(n)
+int n;
+{
+  printf("Subtest %d,  error %d\n", subtest, n);
+  if (errct++ > MAX_ERROR) {
+	printf("Too many errors; test aborted\n");
+	exit(1);
+  }
+}